@@ -337,6 +337,7 @@ main(int argc, char** argv)
 	benchmark_cache();
 	benchmark_memory_chunk();
 	benchmark_message();
+	benchmark_reed_solomon();
 
 	// KV client
 	benchmark_kv();
@@ -51,6 +51,7 @@ void benchmark_background_operation(void);
 void benchmark_cache(void);
 void benchmark_memory_chunk(void);
 void benchmark_message(void);
+void benchmark_reed_solomon(void);
 
 void benchmark_kv(void);
 
@@ -55,8 +55,62 @@ benchmark_cache_get_release(BenchmarkRun* run)
 	run->operations = n * 2;
 }
 
+static gpointer
+benchmark_cache_thread(gpointer data)
+{
+	guint const n = 100000;
+
+	JCache* cache = data;
+
+	for (guint i = 0; i < n; i++)
+	{
+		gpointer buf;
+
+		// Mix different size classes.
+		buf = j_cache_get(cache, 1 << (i % 12));
+		j_cache_release(cache, buf);
+	}
+
+	return NULL;
+}
+
+static void
+benchmark_cache_get_release_threads(BenchmarkRun* run)
+{
+	guint const n = 100000;
+	guint const thread_count = g_get_num_processors();
+
+	JCache* cache;
+	g_autofree GThread** threads = NULL;
+
+	cache = j_cache_new(thread_count * 4096);
+	threads = g_new(GThread*, thread_count);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < thread_count; i++)
+		{
+			threads[i] = g_thread_new("benchmark-cache", benchmark_cache_thread, cache);
+		}
+
+		for (guint i = 0; i < thread_count; i++)
+		{
+			g_thread_join(threads[i]);
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	j_cache_free(cache);
+
+	run->operations = (guint64)n * thread_count * 2;
+}
+
 void
 benchmark_cache(void)
 {
 	j_benchmark_add("/cache/get-release", benchmark_cache_get_release);
+	j_benchmark_add("/cache/get-release-threads", benchmark_cache_get_release_threads);
 }
@@ -0,0 +1,141 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include <jreed-solomon.h>
+
+#include "benchmark.h"
+
+static guint const benchmark_reed_solomon_data_blocks = 4;
+static guint const benchmark_reed_solomon_parity_blocks = 2;
+static gsize const benchmark_reed_solomon_block_size = 1024 * 1024;
+
+static void
+benchmark_reed_solomon_encode(BenchmarkRun* run)
+{
+	guint const n = 100;
+	guint const k = benchmark_reed_solomon_data_blocks;
+	guint const m = benchmark_reed_solomon_parity_blocks;
+	gsize const block_size = benchmark_reed_solomon_block_size;
+
+	JReedSolomon* rs;
+	g_autofree guint8* buffer = NULL;
+	g_autofree guint8 const** data = NULL;
+	g_autofree guint8** parity = NULL;
+
+	rs = j_reed_solomon_new(k, m);
+	buffer = g_malloc((k + m) * block_size);
+	data = g_new(guint8 const*, k);
+	parity = g_new(guint8*, m);
+
+	for (guint i = 0; i < k * block_size; i++)
+	{
+		buffer[i] = g_random_int();
+	}
+
+	for (guint i = 0; i < k; i++)
+	{
+		data[i] = buffer + i * block_size;
+	}
+
+	for (guint i = 0; i < m; i++)
+	{
+		parity[i] = buffer + (k + i) * block_size;
+	}
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			j_reed_solomon_encode(rs, data, parity, block_size);
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	j_reed_solomon_free(rs);
+
+	run->operations = n;
+	run->bytes = n * k * block_size;
+}
+
+static void
+benchmark_reed_solomon_decode(BenchmarkRun* run)
+{
+	guint const n = 100;
+	guint const k = benchmark_reed_solomon_data_blocks;
+	guint const m = benchmark_reed_solomon_parity_blocks;
+	gsize const block_size = benchmark_reed_solomon_block_size;
+
+	JReedSolomon* rs;
+	g_autofree guint8* buffer = NULL;
+	g_autofree guint8** blocks = NULL;
+	g_autofree gboolean* present = NULL;
+
+	rs = j_reed_solomon_new(k, m);
+	buffer = g_malloc((k + m) * block_size);
+	blocks = g_new(guint8*, k + m);
+	present = g_new(gboolean, k + m);
+
+	for (guint i = 0; i < k * block_size; i++)
+	{
+		buffer[i] = g_random_int();
+	}
+
+	for (guint i = 0; i < k + m; i++)
+	{
+		blocks[i] = buffer + i * block_size;
+		// The first m data blocks are lost, which is the most expensive case.
+		present[i] = (i >= m);
+	}
+
+	j_reed_solomon_encode(rs, (guint8 const* const*)blocks, blocks + k, block_size);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			j_reed_solomon_decode(rs, blocks, present, block_size);
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	j_reed_solomon_free(rs);
+
+	run->operations = n;
+	run->bytes = n * k * block_size;
+}
+
+void
+benchmark_reed_solomon(void)
+{
+	j_benchmark_add("/reed-solomon/encode", benchmark_reed_solomon_encode);
+	j_benchmark_add("/reed-solomon/decode", benchmark_reed_solomon_decode);
+}
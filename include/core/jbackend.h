@@ -121,6 +121,19 @@ enum JBackendComponent
 
 typedef enum JBackendComponent JBackendComponent;
 
+/**
+ * A backend's state as reported by its server.
+ **/
+enum JBackendState
+{
+	J_BACKEND_STATE_UNKNOWN,
+	J_BACKEND_STATE_INITIALIZING,
+	J_BACKEND_STATE_READY,
+	J_BACKEND_STATE_FAILED
+};
+
+typedef enum JBackendState JBackendState;
+
 struct JBackend
 {
 	JBackendType type;
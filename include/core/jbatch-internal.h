@@ -38,6 +38,7 @@ G_GNUC_INTERNAL JBatch* j_batch_new_from_batch(JBatch*);
 G_GNUC_INTERNAL JList* j_batch_get_operations(JBatch*);
 
 G_GNUC_INTERNAL gboolean j_batch_execute_internal(JBatch*);
+G_GNUC_INTERNAL gboolean j_batch_execute_deferred(JBatch*);
 
 G_END_DECLS
 
@@ -44,6 +44,16 @@ G_END_DECLS
 
 G_BEGIN_DECLS
 
+typedef gboolean (*JBatchFlushFunc)(JSemantics*);
+
+enum JBatchStatisticsType
+{
+	J_BATCH_STATISTICS_OPERATIONS,
+	J_BATCH_STATISTICS_EXECUTIONS
+};
+
+typedef enum JBatchStatisticsType JBatchStatisticsType;
+
 JBatch* j_batch_new(JSemantics*);
 JBatch* j_batch_new_for_template(JSemanticsTemplate);
 JBatch* j_batch_ref(JBatch*);
@@ -60,6 +70,10 @@ gboolean j_batch_execute(JBatch*) G_GNUC_WARN_UNUSED_RESULT;
 void j_batch_execute_async(JBatch*, JBatchAsyncCallback, gpointer);
 void j_batch_wait(JBatch*);
 
+void j_batch_add_flush_func(JBatchFlushFunc);
+
+guint64 j_batch_get_statistics(JBatchStatisticsType);
+
 G_END_DECLS
 
 #endif
@@ -31,11 +31,20 @@
 
 G_BEGIN_DECLS
 
+enum JCacheFlags
+{
+	J_CACHE_NONE = 0,
+	J_CACHE_HUGEPAGES = 1 << 0
+};
+
+typedef enum JCacheFlags JCacheFlags;
+
 struct JCache;
 
 typedef struct JCache JCache;
 
 JCache* j_cache_new(guint64);
+JCache* j_cache_new_full(guint64, JCacheFlags);
 void j_cache_free(JCache*);
 
 gpointer j_cache_get(JCache*, guint64);
@@ -0,0 +1,59 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_COMPLETION_QUEUE_H
+#define JULEA_COMPLETION_QUEUE_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+struct JCompletionQueue;
+
+typedef struct JCompletionQueue JCompletionQueue;
+
+G_END_DECLS
+
+#include <core/jbatch.h>
+
+G_BEGIN_DECLS
+
+JCompletionQueue* j_completion_queue_new(void);
+JCompletionQueue* j_completion_queue_ref(JCompletionQueue*);
+void j_completion_queue_unref(JCompletionQueue*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JCompletionQueue, j_completion_queue_unref)
+
+void j_completion_queue_submit(JCompletionQueue*, JBatch*, gpointer);
+
+gboolean j_completion_queue_poll(JCompletionQueue*, JBatch**, gboolean*, gpointer*);
+gboolean j_completion_queue_wait(JCompletionQueue*, JBatch**, gboolean*, gpointer*);
+
+guint j_completion_queue_get_outstanding(JCompletionQueue*);
+
+G_END_DECLS
+
+#endif
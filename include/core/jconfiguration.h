@@ -58,6 +58,39 @@ guint64 j_configuration_get_max_operation_size(JConfiguration*);
 guint32 j_configuration_get_max_connections(JConfiguration*);
 guint64 j_configuration_get_stripe_size(JConfiguration*);
 
+guint64 j_configuration_get_write_back_size(JConfiguration*);
+guint32 j_configuration_get_write_back_threads(JConfiguration*);
+
+gboolean j_configuration_get_coalesce_replies(JConfiguration*);
+guint64 j_configuration_get_reply_window(JConfiguration*);
+guint32 j_configuration_get_reply_count(JConfiguration*);
+
+guint32 j_configuration_get_multiplex_connections(JConfiguration*);
+
+guint32 j_configuration_get_prewarm_connections(JConfiguration*);
+guint32 j_configuration_get_connect_attempts(JConfiguration*);
+
+guint32 j_configuration_get_stripe_streams(JConfiguration*);
+guint64 j_configuration_get_stripe_threshold(JConfiguration*);
+
+guint64 j_configuration_get_operation_cache_size(JConfiguration*);
+guint32 j_configuration_get_operation_cache_threads(JConfiguration*);
+
+guint64 j_configuration_get_buffer_pool_size(JConfiguration*);
+gboolean j_configuration_get_buffer_pool_hugepages(JConfiguration*);
+gboolean j_configuration_get_buffer_pool_lock(JConfiguration*);
+
+guint64 j_configuration_get_object_cache_size(JConfiguration*);
+guint32 j_configuration_get_object_cache_ttl(JConfiguration*);
+
+guint64 j_configuration_get_object_readahead_size(JConfiguration*);
+
+guint64 j_configuration_get_object_write_buffer_size(JConfiguration*);
+
+guint64 j_configuration_get_object_write_buffer_interval(JConfiguration*);
+
+guint32 j_configuration_get_completion_queue_threads(JConfiguration*);
+
 G_END_DECLS
 
 #endif
@@ -30,6 +30,7 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <core/jbackend.h>
 #include <core/jconfiguration.h>
 
 G_BEGIN_DECLS
@@ -37,6 +38,9 @@ G_BEGIN_DECLS
 G_GNUC_INTERNAL void j_connection_pool_init(JConfiguration*);
 G_GNUC_INTERNAL void j_connection_pool_fini(void);
 
+G_GNUC_INTERNAL gboolean j_connection_pool_wait_deferred(void);
+G_GNUC_INTERNAL gpointer j_connection_pool_take_held(JBackendType*, guint*);
+
 G_END_DECLS
 
 #endif
@@ -34,9 +34,23 @@
 
 G_BEGIN_DECLS
 
+enum JConnectionPoolStatisticsType
+{
+	J_CONNECTION_POOL_STATISTICS_CREATED,
+	J_CONNECTION_POOL_STATISTICS_CACHED,
+	J_CONNECTION_POOL_STATISTICS_STOLEN,
+	J_CONNECTION_POOL_STATISTICS_WAITED
+};
+
+typedef enum JConnectionPoolStatisticsType JConnectionPoolStatisticsType;
+
 gpointer j_connection_pool_pop(JBackendType, guint);
 void j_connection_pool_push(JBackendType, guint, gpointer);
 
+guint64 j_connection_pool_get_statistics(JConnectionPoolStatisticsType);
+
+JBackendState j_connection_pool_get_backend_state(JBackendType, guint);
+
 G_END_DECLS
 
 #endif
@@ -37,7 +37,10 @@ enum JDistributionType
 {
 	J_DISTRIBUTION_ROUND_ROBIN,
 	J_DISTRIBUTION_SINGLE_SERVER,
-	J_DISTRIBUTION_WEIGHTED
+	J_DISTRIBUTION_WEIGHTED,
+	J_DISTRIBUTION_CONSISTENT_HASH,
+	J_DISTRIBUTION_REPLICATED,
+	J_DISTRIBUTION_ERASURE
 };
 
 typedef enum JDistributionType JDistributionType;
@@ -63,13 +66,26 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JDistribution, j_distribution_unref)
 
 bson_t* j_distribution_serialize(JDistribution*);
 
+JDistributionType j_distribution_get_type(JDistribution*);
+
 void j_distribution_set_block_size(JDistribution*, guint64);
+void j_distribution_set_size_hint(JDistribution*, guint64);
+guint64 j_distribution_get_block_size(JDistribution*);
+
 void j_distribution_set(JDistribution*, gchar const*, guint64);
 void j_distribution_set2(JDistribution*, gchar const*, guint64, guint64);
 
 void j_distribution_reset(JDistribution*, guint64, guint64);
 gboolean j_distribution_distribute(JDistribution*, guint*, guint64*, guint64*, guint64*);
 
+GArray* j_distribution_get_servers(JDistribution*, guint64);
+
+guint j_distribution_get_replica_count(JDistribution*);
+guint j_distribution_get_replica(JDistribution*, guint64, guint);
+
+gboolean j_distribution_get_erasure_code(JDistribution*, guint*, guint*, guint64*);
+guint j_distribution_get_stripe_server(JDistribution*, guint64, guint);
+
 G_END_DECLS
 
 #endif
@@ -50,6 +50,7 @@ void j_list_prepend(JList*, gpointer);
 
 gpointer j_list_get_first(JList*);
 gpointer j_list_get_last(JList*);
+gpointer j_list_get_nth(JList*, guint);
 
 void j_list_delete_all(JList*);
 
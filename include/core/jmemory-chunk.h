@@ -36,6 +36,7 @@ struct JMemoryChunk;
 typedef struct JMemoryChunk JMemoryChunk;
 
 JMemoryChunk* j_memory_chunk_new(guint64);
+JMemoryChunk* j_memory_chunk_new_for_data(gpointer, guint64);
 void j_memory_chunk_free(JMemoryChunk*);
 
 gpointer j_memory_chunk_get(JMemoryChunk*, guint64);
@@ -54,15 +54,30 @@ enum JMessageType
 	J_MESSAGE_DB_INSERT,
 	J_MESSAGE_DB_UPDATE,
 	J_MESSAGE_DB_DELETE,
-	J_MESSAGE_DB_QUERY
+	J_MESSAGE_DB_QUERY,
+	J_MESSAGE_ACKNOWLEDGE
 };
 
 typedef enum JMessageType JMessageType;
 
+enum JMessageFlags
+{
+	J_MESSAGE_FLAGS_NONE = 0,
+	J_MESSAGE_FLAGS_DEFERRED_REPLY = 1 << 0,
+	// Objects are created on first write if they do not exist yet.
+	J_MESSAGE_FLAGS_CREATE = 1 << 1,
+	// The server could not handle the message, the reply does not contain any operations.
+	J_MESSAGE_FLAGS_FAILED = 1 << 2
+};
+
+typedef enum JMessageFlags JMessageFlags;
+
 struct JMessage;
 
 typedef struct JMessage JMessage;
 
+typedef gboolean (*JMessageReplyFunc)(JMessage*, guint32, gpointer);
+
 G_END_DECLS
 
 #include <core/jsemantics.h>
@@ -78,6 +93,8 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JMessage, j_message_unref)
 
 JMessageType j_message_get_type(JMessage const*);
 guint32 j_message_get_count(JMessage const*);
+JMessageFlags j_message_get_flags(JMessage const*);
+void j_message_add_flags(JMessage*, JMessageFlags);
 
 gboolean j_message_append_1(JMessage*, gconstpointer);
 gboolean j_message_append_4(JMessage*, gconstpointer);
@@ -93,6 +110,17 @@ gchar const* j_message_get_string(JMessage*);
 
 gboolean j_message_send(JMessage*, gpointer);
 gboolean j_message_receive(JMessage*, gpointer);
+gboolean j_message_receive_data(JMessage*, gpointer, gpointer, guint64);
+
+gboolean j_message_send_deferred(JMessage*, gpointer, JMessageReplyFunc, gpointer);
+gboolean j_message_receive_deferred(gpointer);
+gboolean j_message_flush_deferred(gpointer);
+gboolean j_message_receive_deferred_next(gpointer, gboolean*);
+guint j_message_get_deferred_count(gpointer);
+void j_message_add_reply(JMessage*, JMessage*);
+
+void j_message_mux_start(gpointer);
+void j_message_mux_stop(gpointer);
 
 gboolean j_message_read(JMessage*, GInputStream*);
 gboolean j_message_write(JMessage*, GOutputStream*);
@@ -30,10 +30,11 @@
 #include <glib.h>
 
 #include <core/jbatch.h>
+#include <core/jconfiguration.h>
 
 G_BEGIN_DECLS
 
-G_GNUC_INTERNAL void j_operation_cache_init(void);
+G_GNUC_INTERNAL void j_operation_cache_init(JConfiguration*);
 G_GNUC_INTERNAL void j_operation_cache_fini(void);
 
 G_GNUC_INTERNAL gboolean j_operation_cache_flush(void);
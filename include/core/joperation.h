@@ -37,6 +37,14 @@ G_BEGIN_DECLS
 typedef gboolean (*JOperationExecFunc)(JList*, JSemantics*);
 typedef void (*JOperationFreeFunc)(gpointer);
 
+/**
+ * Prepares an operation's data for being cached.
+ *
+ * If the buffer is NULL, returns the number of bytes required to cache the operation.
+ * Otherwise, copies all data owned by the caller into the buffer and returns the number of bytes used.
+ **/
+typedef guint64 (*JOperationCacheFunc)(gpointer, gpointer);
+
 /**
  * An operation.
  **/
@@ -45,8 +53,16 @@ struct JOperation
 	gconstpointer key;
 	gpointer data;
 
+	/**
+	 * Hash and compare keys, for example, by namespace and name.
+	 * Keys are compared by address if these are NULL.
+	 **/
+	GHashFunc key_hash;
+	GEqualFunc key_equal;
+
 	JOperationExecFunc exec_func;
 	JOperationFreeFunc free_func;
+	JOperationCacheFunc cache_func;
 };
 
 typedef struct JOperation JOperation;
@@ -1,6 +1,6 @@
 /*
  * JULEA - Flexible storage framework
- * Copyright (C) 2010-2020 Michael Kuhn
+ * Copyright (C) 2020 Michael Kuhn
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License as published by
@@ -20,8 +20,8 @@
  * \file
  **/
 
-#ifndef JULEA_LIST_INTERNAL_H
-#define JULEA_LIST_INTERNAL_H
+#ifndef JULEA_REED_SOLOMON_H
+#define JULEA_REED_SOLOMON_H
 
 #if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
 #error "Only <julea.h> can be included directly."
@@ -31,30 +31,15 @@
 
 G_BEGIN_DECLS
 
-/**
- * A JList element.
- **/
-struct JListElement
-{
-	/**
-	 * Pointer to the next element.
-	 **/
-	struct JListElement* next;
-	/**
-	 * Pointer to data.
-	 **/
-	gpointer data;
-};
-
-typedef struct JListElement JListElement;
+struct JReedSolomon;
 
-G_END_DECLS
+typedef struct JReedSolomon JReedSolomon;
 
-#include <core/jlist.h>
-
-G_BEGIN_DECLS
+JReedSolomon* j_reed_solomon_new(guint, guint);
+void j_reed_solomon_free(JReedSolomon*);
 
-G_GNUC_INTERNAL JListElement* j_list_head(JList*);
+void j_reed_solomon_encode(JReedSolomon*, guint8 const* const*, guint8**, gsize);
+gboolean j_reed_solomon_decode(JReedSolomon*, guint8**, gboolean const*, gsize);
 
 G_END_DECLS
 
@@ -25,6 +25,8 @@
 
 #include <object/jdistributed-object.h>
 #include <object/jobject.h>
+#include <object/jobject-cache.h>
+#include <object/jobject-write-buffer.h>
 #include <object/jobject-iterator.h>
 #include <object/jobject-uri.h>
 
@@ -37,6 +37,7 @@
 #include <core/jbackground-operation.h>
 #include <core/jbatch.h>
 #include <core/jcache.h>
+#include <core/jcompletion-queue.h>
 #include <core/jconfiguration.h>
 #include <core/jconnection-pool.h>
 #include <core/jcredentials.h>
@@ -47,6 +48,7 @@
 #include <core/jmemory-chunk.h>
 #include <core/jmessage.h>
 #include <core/joperation.h>
+#include <core/jreed-solomon.h>
 #include <core/jsemantics.h>
 #include <core/jstatistics.h>
 #include <core/jtrace.h>
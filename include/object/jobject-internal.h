@@ -35,6 +35,49 @@ G_BEGIN_DECLS
 
 G_GNUC_INTERNAL JBackend* j_object_get_backend(void);
 
+struct JObjectExtents;
+
+typedef struct JObjectExtents JObjectExtents;
+
+G_GNUC_INTERNAL JObjectExtents* j_object_extents_new(gboolean);
+G_GNUC_INTERNAL void j_object_extents_free(JObjectExtents*);
+
+G_GNUC_INTERNAL void j_object_extents_add_read(JObjectExtents*, gpointer, guint64, guint64, guint64*);
+G_GNUC_INTERNAL void j_object_extents_add_write(JObjectExtents*, gconstpointer, guint64, guint64, guint64*);
+
+G_GNUC_INTERNAL guint j_object_extents_get_count(JObjectExtents*);
+G_GNUC_INTERNAL guint64 j_object_extents_get_length(JObjectExtents*);
+
+G_GNUC_INTERNAL GPtrArray* j_object_extents_split(JObjectExtents*, guint);
+
+G_GNUC_INTERNAL void j_object_extents_append(JObjectExtents*, JMessage*);
+G_GNUC_INTERNAL gboolean j_object_extents_write_reply(JObjectExtents*, JMessage*);
+G_GNUC_INTERNAL gboolean j_object_extents_read_reply(JObjectExtents*, JMessage*, gpointer);
+
+G_GNUC_INTERNAL gchar* j_object_cache_key(guint32, gchar const*, gchar const*);
+G_GNUC_INTERNAL gboolean j_object_cache_enabled(JSemantics*);
+
+G_GNUC_INTERNAL gboolean j_object_cache_read(gchar const*, JSemantics*, gpointer, guint64, guint64, guint64*);
+G_GNUC_INTERNAL void j_object_cache_fill(gchar const*, gconstpointer, guint64, guint64, guint64);
+G_GNUC_INTERNAL void j_object_cache_write(gchar const*, gconstpointer, guint64, guint64);
+G_GNUC_INTERNAL void j_object_cache_remove(gchar const*);
+
+G_GNUC_INTERNAL gboolean j_object_cache_readahead(gchar const*, guint64, guint64, guint64*, guint64*, guint64*);
+G_GNUC_INTERNAL void j_object_cache_prefetched(gchar const*, guint64, gconstpointer, guint64, guint64, guint64);
+
+typedef gboolean (*JObjectWriteBufferFunc)(gpointer, JSemantics*, gconstpointer, guint64, guint64);
+typedef gpointer (*JObjectWriteBufferRefFunc)(gpointer);
+
+G_GNUC_INTERNAL gboolean j_object_write_buffer_enabled(JSemantics*);
+G_GNUC_INTERNAL guint64 j_object_write_buffer_get_size(void);
+G_GNUC_INTERNAL gboolean j_object_write_buffer_pending(void);
+
+G_GNUC_INTERNAL gboolean j_object_write_buffer_add(gchar const*, gpointer, JObjectWriteBufferFunc, JObjectWriteBufferRefFunc, GDestroyNotify, JSemantics*, gconstpointer, guint64, guint64);
+G_GNUC_INTERNAL gboolean j_object_write_buffer_flush(gchar const*);
+G_GNUC_INTERNAL void j_object_write_buffer_discard(gchar const*);
+G_GNUC_INTERNAL gboolean j_object_write_buffer_flush_all(void);
+G_GNUC_INTERNAL void j_object_write_buffer_fini(void);
+
 G_END_DECLS
 
 #endif
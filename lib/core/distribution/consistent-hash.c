@@ -0,0 +1,484 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <jconfiguration.h>
+#include <jhelper-internal.h>
+#include <jtrace.h>
+
+#include "distribution.h"
+
+/**
+ * \defgroup JDistribution Distribution
+ *
+ * Data structures and functions for managing distributions.
+ *
+ * @{
+ **/
+
+/**
+ * A distribution.
+ *
+ * Blocks are placed using rendezvous hashing:
+ * Every virtual node of every server computes a score for (object ID, block ID) and the server with the highest score stores the block.
+ * When servers are added, only the blocks won by the new servers move.
+ **/
+struct JDistributionConsistentHash
+{
+	/**
+	 * The server count.
+	 **/
+	guint server_count;
+
+	/**
+	 * The length.
+	 **/
+	guint64 length;
+
+	/**
+	 * The offset.
+	 **/
+	guint64 offset;
+
+	/**
+	 * The block size.
+	 */
+	guint64 block_size;
+
+	/**
+	 * The object ID.
+	 **/
+	guint64 object_id;
+
+	/**
+	 * The number of virtual nodes for servers without an explicit setting.
+	 **/
+	guint default_virtual_nodes;
+
+	/**
+	 * The number of virtual nodes per server.
+	 **/
+	guint* virtual_nodes;
+};
+
+typedef struct JDistributionConsistentHash JDistributionConsistentHash;
+
+/**
+ * Mixes a 64-bit value.
+ *
+ * \private
+ *
+ * \param value A value.
+ *
+ * \return The mixed value.
+ **/
+static guint64
+distribution_hash(guint64 value)
+{
+	// Finalizer of SplitMix64
+	value += G_GUINT64_CONSTANT(0x9e3779b97f4a7c15);
+	value = (value ^ (value >> 30)) * G_GUINT64_CONSTANT(0xbf58476d1ce4e5b9);
+	value = (value ^ (value >> 27)) * G_GUINT64_CONSTANT(0x94d049bb133111eb);
+
+	return value ^ (value >> 31);
+}
+
+/**
+ * Returns the server responsible for a block.
+ *
+ * \private
+ *
+ * \param distribution A distribution.
+ * \param block        A block ID.
+ *
+ * \return The server index.
+ **/
+static guint
+distribution_place(JDistributionConsistentHash* distribution, guint64 block)
+{
+	guint64 key;
+	guint64 best_score = 0;
+	guint best_index = 0;
+
+	key = distribution_hash(distribution_hash(distribution->object_id) ^ block);
+
+	for (guint i = 0; i < distribution->server_count; i++)
+	{
+		for (guint j = 0; j < distribution->virtual_nodes[i]; j++)
+		{
+			guint64 score;
+
+			score = distribution_hash(key ^ (((guint64)i << 32) | j));
+
+			if (score > best_score)
+			{
+				best_score = score;
+				best_index = i;
+			}
+		}
+	}
+
+	return best_index;
+}
+
+/**
+ * Distributes data using consistent hashing.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param index        A server index.
+ * \param new_length   A new length.
+ * \param new_offset   A new offset.
+ *
+ * \return TRUE on success, FALSE if the distribution is finished.
+ **/
+static gboolean
+distribution_distribute(gpointer data, guint* index, guint64* new_length, guint64* new_offset, guint64* block_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution = data;
+
+	guint64 block;
+	guint64 displacement;
+
+	if (distribution->length == 0)
+	{
+		return FALSE;
+	}
+
+	block = distribution->offset / distribution->block_size;
+	displacement = distribution->offset % distribution->block_size;
+
+	*index = distribution_place(distribution, block);
+	*new_length = MIN(distribution->length, distribution->block_size - displacement);
+	// Blocks keep their offset, so they can be moved between servers independently.
+	*new_offset = distribution->offset;
+	*block_id = block;
+
+	distribution->length -= *new_length;
+	distribution->offset += *new_length;
+
+	return TRUE;
+}
+
+static gpointer
+distribution_new(guint server_count, guint64 stripe_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution;
+
+	distribution = g_slice_new(JDistributionConsistentHash);
+	distribution->server_count = server_count;
+	distribution->length = 0;
+	distribution->offset = 0;
+	distribution->block_size = stripe_size;
+	distribution->object_id = ((guint64)g_random_int() << 32) | g_random_int();
+	distribution->default_virtual_nodes = 1;
+	distribution->virtual_nodes = g_new(guint, distribution->server_count);
+
+	for (guint i = 0; i < distribution->server_count; i++)
+	{
+		distribution->virtual_nodes[i] = distribution->default_virtual_nodes;
+	}
+
+	return distribution;
+}
+
+/**
+ * Decreases a distribution's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the distribution.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ **/
+static void
+distribution_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	g_free(distribution->virtual_nodes);
+
+	g_slice_free(JDistributionConsistentHash, distribution);
+}
+
+/**
+ * Sets the block size, object ID, virtual nodes or server count for the consistent hash distribution.
+ * Setting the server count allows reproducing the placement of an older configuration.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param key          A key.
+ * \param value        A value.
+ */
+static void
+distribution_set(gpointer data, gchar const* key, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		distribution->block_size = value;
+	}
+	else if (g_strcmp0(key, "object-id") == 0)
+	{
+		distribution->object_id = value;
+	}
+	else if (g_strcmp0(key, "virtual-nodes") == 0)
+	{
+		g_return_if_fail(value > 0);
+		g_return_if_fail(value < 65536);
+
+		distribution->default_virtual_nodes = value;
+
+		for (guint i = 0; i < distribution->server_count; i++)
+		{
+			distribution->virtual_nodes[i] = value;
+		}
+	}
+	else if (g_strcmp0(key, "server-count") == 0)
+	{
+		g_return_if_fail(value > 0);
+		g_return_if_fail(value <= G_MAXUINT32);
+
+		distribution->virtual_nodes = g_renew(guint, distribution->virtual_nodes, value);
+
+		for (guint i = distribution->server_count; i < value; i++)
+		{
+			distribution->virtual_nodes[i] = distribution->default_virtual_nodes;
+		}
+
+		distribution->server_count = value;
+	}
+}
+
+static void
+distribution_set2(gpointer data, gchar const* key, guint64 value1, guint64 value2)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	if (g_strcmp0(key, "virtual-nodes") == 0)
+	{
+		g_return_if_fail(value1 < distribution->server_count);
+		// Servers without virtual nodes would never be chosen, so they are not allowed.
+		g_return_if_fail(value2 > 0);
+		g_return_if_fail(value2 < 65536);
+
+		distribution->virtual_nodes[value1] = value2;
+	}
+}
+
+/**
+ * Serializes distribution.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution Credentials.
+ *
+ * \return A new BSON object. Should be freed with g_slice_free().
+ **/
+static void
+distribution_serialize(gpointer data, bson_t* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution = data;
+
+	bson_t b_array[1];
+	gchar numstr[16];
+
+	g_return_if_fail(distribution != NULL);
+
+	bson_append_int64(b, "block_size", -1, distribution->block_size);
+	bson_append_int64(b, "object_id", -1, distribution->object_id);
+	bson_append_int32(b, "default_virtual_nodes", -1, distribution->default_virtual_nodes);
+
+	bson_append_array_begin(b, "virtual_nodes", -1, b_array);
+
+	for (guint i = 0; i < distribution->server_count; i++)
+	{
+		j_helper_get_number_string(numstr, sizeof(numstr), i);
+		bson_append_int32(b_array, numstr, -1, distribution->virtual_nodes[i]);
+	}
+
+	bson_append_array_end(b, b_array);
+}
+
+/**
+ * Deserializes distribution.
+ * Servers that have been added since the distribution was serialized get the default number of virtual nodes.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution distribution.
+ * \param b           A BSON object.
+ **/
+static void
+distribution_deserialize(gpointer data, bson_t const* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution = data;
+	bson_iter_t iterator;
+
+	g_return_if_fail(distribution != NULL);
+	g_return_if_fail(b != NULL);
+
+	bson_iter_init(&iterator, b);
+
+	while (bson_iter_next(&iterator))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iterator);
+
+		if (g_strcmp0(key, "block_size") == 0)
+		{
+			distribution->block_size = bson_iter_int64(&iterator);
+		}
+		else if (g_strcmp0(key, "object_id") == 0)
+		{
+			distribution->object_id = bson_iter_int64(&iterator);
+		}
+		else if (g_strcmp0(key, "default_virtual_nodes") == 0)
+		{
+			distribution->default_virtual_nodes = bson_iter_int32(&iterator);
+		}
+		else if (g_strcmp0(key, "virtual_nodes") == 0)
+		{
+			bson_iter_t siterator;
+
+			bson_iter_recurse(&iterator, &siterator);
+
+			for (guint i = 0; bson_iter_next(&siterator) && i < distribution->server_count; i++)
+			{
+				distribution->virtual_nodes[i] = bson_iter_int32(&siterator);
+			}
+		}
+	}
+}
+
+/**
+ * Initializes a distribution.
+ *
+ * \code
+ * JDistribution* d;
+ *
+ * j_distribution_init(d, 0, 0);
+ * \endcode
+ *
+ * \param length A length.
+ * \param offset An offset.
+ *
+ * \return A new distribution. Should be freed with j_distribution_unref().
+ **/
+static void
+distribution_reset(gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionConsistentHash* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	distribution->length = length;
+	distribution->offset = offset;
+}
+
+/**
+ * Returns the number of blocks after which the distribution repeats itself.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return The number of blocks.
+ **/
+static guint64
+distribution_get_period(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Placement is not periodic, but every server has at least one virtual node and will eventually be chosen.
+	(void)data;
+
+	return G_MAXUINT64;
+}
+
+void
+j_distribution_consistent_hash_get_vtable(JDistributionVTable* vtable)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	vtable->distribution_new = distribution_new;
+	vtable->distribution_free = distribution_free;
+	vtable->distribution_set = distribution_set;
+	vtable->distribution_set2 = distribution_set2;
+	vtable->distribution_serialize = distribution_serialize;
+	vtable->distribution_deserialize = distribution_deserialize;
+	vtable->distribution_reset = distribution_reset;
+	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_get_period = distribution_get_period;
+	vtable->distribution_get_replica_count = NULL;
+	vtable->distribution_get_replica = NULL;
+	vtable->distribution_get_erasure_code = NULL;
+	vtable->distribution_get_stripe_server = NULL;
+}
+
+/**
+ * @}
+ **/
@@ -0,0 +1,392 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <jconfiguration.h>
+#include <jtrace.h>
+
+#include "distribution.h"
+
+/**
+ * \defgroup JDistribution Distribution
+ *
+ * Data structures and functions for managing distributions.
+ *
+ * @{
+ **/
+
+/**
+ * A distribution.
+ *
+ * Blocks are distributed in a round robin fashion and every block is additionally stored on the following servers.
+ **/
+struct JDistributionReplicated
+{
+	/**
+	 * The server count.
+	 **/
+	guint server_count;
+
+	/**
+	 * The length.
+	 **/
+	guint64 length;
+
+	/**
+	 * The offset.
+	 **/
+	guint64 offset;
+
+	/**
+	 * The block size.
+	 */
+	guint64 block_size;
+
+	/**
+	 * The number of replicas, including the first copy.
+	 **/
+	guint replicas;
+
+	guint start_index;
+};
+
+typedef struct JDistributionReplicated JDistributionReplicated;
+
+/**
+ * Distributes data in a round robin fashion.
+ * The returned index is the block's first replica.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param index        A server index.
+ * \param new_length   A new length.
+ * \param new_offset   A new offset.
+ *
+ * \return TRUE on success, FALSE if the distribution is finished.
+ **/
+static gboolean
+distribution_distribute(gpointer data, guint* index, guint64* new_length, guint64* new_offset, guint64* block_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	guint64 block;
+	guint64 displacement;
+
+	if (distribution->length == 0)
+	{
+		return FALSE;
+	}
+
+	block = distribution->offset / distribution->block_size;
+	displacement = distribution->offset % distribution->block_size;
+
+	*index = (distribution->start_index + block) % distribution->server_count;
+	*new_length = MIN(distribution->length, distribution->block_size - displacement);
+	// All replicas store a block at the same offset.
+	*new_offset = distribution->offset;
+	*block_id = block;
+
+	distribution->length -= *new_length;
+	distribution->offset += *new_length;
+
+	return TRUE;
+}
+
+static gpointer
+distribution_new(guint server_count, guint64 stripe_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution;
+
+	distribution = g_slice_new(JDistributionReplicated);
+	distribution->server_count = server_count;
+	distribution->length = 0;
+	distribution->offset = 0;
+	distribution->block_size = stripe_size;
+	distribution->replicas = MIN(2, server_count);
+
+	distribution->start_index = g_random_int_range(0, distribution->server_count);
+
+	return distribution;
+}
+
+/**
+ * Decreases a distribution's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the distribution.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ **/
+static void
+distribution_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	g_slice_free(JDistributionReplicated, distribution);
+}
+
+/**
+ * Sets the block size, start index or number of replicas for the replicated distribution.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param key          A key.
+ * \param value        A value.
+ */
+static void
+distribution_set(gpointer data, gchar const* key, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	if (g_strcmp0(key, "block-size") == 0)
+	{
+		distribution->block_size = value;
+	}
+	else if (g_strcmp0(key, "start-index") == 0)
+	{
+		g_return_if_fail(value < distribution->server_count);
+
+		distribution->start_index = value;
+	}
+	else if (g_strcmp0(key, "replicas") == 0)
+	{
+		g_return_if_fail(value > 0);
+		g_return_if_fail(value <= distribution->server_count);
+
+		distribution->replicas = value;
+	}
+}
+
+/**
+ * Serializes distribution.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution Credentials.
+ *
+ * \return A new BSON object. Should be freed with g_slice_free().
+ **/
+static void
+distribution_serialize(gpointer data, bson_t* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	bson_append_int64(b, "block_size", -1, distribution->block_size);
+	bson_append_int32(b, "start_index", -1, distribution->start_index);
+	bson_append_int32(b, "replicas", -1, distribution->replicas);
+}
+
+/**
+ * Deserializes distribution.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution distribution.
+ * \param b           A BSON object.
+ **/
+static void
+distribution_deserialize(gpointer data, bson_t const* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	bson_iter_t iterator;
+
+	g_return_if_fail(distribution != NULL);
+	g_return_if_fail(b != NULL);
+
+	bson_iter_init(&iterator, b);
+
+	while (bson_iter_next(&iterator))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iterator);
+
+		if (g_strcmp0(key, "block_size") == 0)
+		{
+			distribution->block_size = bson_iter_int64(&iterator);
+		}
+		else if (g_strcmp0(key, "start_index") == 0)
+		{
+			distribution->start_index = bson_iter_int32(&iterator) % distribution->server_count;
+		}
+		else if (g_strcmp0(key, "replicas") == 0)
+		{
+			distribution->replicas = MIN((guint)bson_iter_int32(&iterator), distribution->server_count);
+		}
+	}
+}
+
+/**
+ * Initializes a distribution.
+ *
+ * \code
+ * JDistribution* d;
+ *
+ * j_distribution_init(d, 0, 0);
+ * \endcode
+ *
+ * \param length A length.
+ * \param offset An offset.
+ *
+ * \return A new distribution. Should be freed with j_distribution_unref().
+ **/
+static void
+distribution_reset(gpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_if_fail(distribution != NULL);
+
+	distribution->length = length;
+	distribution->offset = offset;
+}
+
+/**
+ * Returns the number of blocks after which the distribution repeats itself.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return The number of blocks.
+ **/
+static guint64
+distribution_get_period(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, 0);
+
+	return distribution->server_count;
+}
+
+/**
+ * Returns the number of replicas.
+ *
+ * \private
+ *
+ * \param distribution A distribution.
+ *
+ * \return The number of replicas.
+ **/
+static guint
+distribution_get_replica_count(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, 1);
+
+	return distribution->replicas;
+}
+
+/**
+ * Returns the server storing a replica of a block.
+ *
+ * \private
+ *
+ * \param distribution A distribution.
+ * \param block_id     A block ID.
+ * \param replica      A replica.
+ *
+ * \return The server index.
+ **/
+static guint
+distribution_get_replica(gpointer data, guint64 block_id, guint replica)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributionReplicated* distribution = data;
+
+	g_return_val_if_fail(distribution != NULL, 0);
+
+	return (distribution->start_index + block_id + replica) % distribution->server_count;
+}
+
+void
+j_distribution_replicated_get_vtable(JDistributionVTable* vtable)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	vtable->distribution_new = distribution_new;
+	vtable->distribution_free = distribution_free;
+	vtable->distribution_set = distribution_set;
+	vtable->distribution_set2 = NULL;
+	vtable->distribution_serialize = distribution_serialize;
+	vtable->distribution_deserialize = distribution_deserialize;
+	vtable->distribution_reset = distribution_reset;
+	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_get_period = distribution_get_period;
+	vtable->distribution_get_replica_count = distribution_get_replica_count;
+	vtable->distribution_get_replica = distribution_get_replica;
+	vtable->distribution_get_erasure_code = NULL;
+	vtable->distribution_get_stripe_server = NULL;
+}
+
+/**
+ * @}
+ **/
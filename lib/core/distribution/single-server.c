@@ -276,6 +276,29 @@ distribution_reset(gpointer data, guint64 length, guint64 offset)
 	distribution->offset = offset;
 }
 
+/**
+ * Returns the number of blocks after which the distribution repeats itself.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return The number of blocks.
+ **/
+static guint64
+distribution_get_period(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// All blocks are stored on the same server.
+	(void)data;
+
+	return 1;
+}
+
 void
 j_distribution_single_server_get_vtable(JDistributionVTable* vtable)
 {
@@ -289,6 +312,11 @@ j_distribution_single_server_get_vtable(JDistributionVTable* vtable)
 	vtable->distribution_deserialize = distribution_deserialize;
 	vtable->distribution_reset = distribution_reset;
 	vtable->distribution_distribute = distribution_distribute;
+	vtable->distribution_get_period = distribution_get_period;
+	vtable->distribution_get_replica_count = NULL;
+	vtable->distribution_get_replica = NULL;
+	vtable->distribution_get_erasure_code = NULL;
+	vtable->distribution_get_stripe_server = NULL;
 }
 
 /**
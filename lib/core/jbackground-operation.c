@@ -37,6 +37,16 @@
  * @{
  **/
 
+/**
+ * The states of a background operation.
+ **/
+enum JBackgroundOperationState
+{
+	J_BACKGROUND_OPERATION_QUEUED,
+	J_BACKGROUND_OPERATION_RUNNING,
+	J_BACKGROUND_OPERATION_COMPLETED
+};
+
 /**
  * A background operation.
  **/
@@ -58,19 +68,15 @@ struct JBackgroundOperation
 	gpointer result;
 
 	/**
-	 * Whether the background operation has finished.
+	 * The state, see JBackgroundOperationState.
 	 **/
-	gboolean completed;
+	gint state;
 
 	/**
-	 * The mutex for #completed.
-	 */
-	GMutex mutex[1];
-
-	/**
-	 * The condition for #completed.
-	 */
-	GCond cond[1];
+	 * Bit 0 is held until the background operation has finished.
+	 * Waiting uses g_bit_lock(), which is futex-based and does not need a mutex or condition per operation.
+	 **/
+	gint completed;
 
 	/**
 	 * The reference count.
@@ -78,36 +84,210 @@ struct JBackgroundOperation
 	gint ref_count;
 };
 
-static GThreadPool* j_thread_pool = NULL;
+/**
+ * A worker thread executing background operations.
+ **/
+struct JBackgroundWorker
+{
+	/**
+	 * The worker's deque of background operations.
+	 * The worker takes operations from the tail, other workers steal from the head.
+	 **/
+	GQueue deque;
+
+	/**
+	 * The mutex protecting #deque.
+	 **/
+	GMutex mutex;
+
+	/**
+	 * The thread.
+	 **/
+	GThread* thread;
+};
+
+typedef struct JBackgroundWorker JBackgroundWorker;
 
 /**
- * Executes background operations.
+ * The executor.
+ **/
+struct JBackgroundExecutor
+{
+	/**
+	 * The workers.
+	 **/
+	JBackgroundWorker* workers;
+
+	/**
+	 * The number of workers.
+	 **/
+	guint worker_count;
+
+	/**
+	 * The worker to push the next operation submitted by a non-worker thread to.
+	 **/
+	guint next_worker;
+
+	/**
+	 * The number of queued operations.
+	 **/
+	gint pending;
+
+	/**
+	 * The number of idle workers.
+	 **/
+	gint idle;
+
+	/**
+	 * Whether the executor is shutting down.
+	 **/
+	gboolean shutdown;
+
+	/**
+	 * The mutex for idle workers.
+	 **/
+	GMutex idle_mutex;
+
+	/**
+	 * The condition for idle workers.
+	 **/
+	GCond idle_cond;
+};
+
+typedef struct JBackgroundExecutor JBackgroundExecutor;
+
+static JBackgroundExecutor* j_background_executor = NULL;
+
+/**
+ * The current thread's worker, NULL for non-worker threads.
+ **/
+static GPrivate j_background_worker = G_PRIVATE_INIT(NULL);
+
+/**
+ * Executes a background operation.
  *
  * \private
  *
  * \code
  * \endcode
  *
- * \param data A background operations.
- * \param user_data User data.
+ * \param background_operation A background operation.
  **/
 static void
-j_background_operation_thread(gpointer data, gpointer user_data)
+j_background_operation_run(JBackgroundOperation* background_operation)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JBackgroundOperation* background_operation = data;
+	background_operation->result = (*(background_operation->func))(background_operation->data);
 
-	(void)user_data;
+	g_atomic_int_set(&(background_operation->state), J_BACKGROUND_OPERATION_COMPLETED);
+	g_bit_unlock(&(background_operation->completed), 0);
+}
 
-	background_operation->result = (*(background_operation->func))(background_operation->data);
+/**
+ * Takes a background operation from a worker's deque or steals one from another worker.
+ *
+ * \private
+ *
+ * \param executor The executor.
+ * \param worker   The worker.
+ *
+ * \return A background operation, NULL if there is none.
+ **/
+static JBackgroundOperation*
+j_background_worker_take(JBackgroundExecutor* executor, JBackgroundWorker* worker)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackgroundOperation* background_operation;
+
+	g_mutex_lock(&(worker->mutex));
+	background_operation = g_queue_pop_tail(&(worker->deque));
+	g_mutex_unlock(&(worker->mutex));
+
+	for (guint i = 0; i < executor->worker_count && background_operation == NULL; i++)
+	{
+		JBackgroundWorker* victim = &(executor->workers[i]);
+
+		if (victim == worker)
+		{
+			continue;
+		}
+
+		g_mutex_lock(&(victim->mutex));
+		background_operation = g_queue_pop_head(&(victim->deque));
+		g_mutex_unlock(&(victim->mutex));
+	}
+
+	if (background_operation != NULL)
+	{
+		g_atomic_int_add(&(executor->pending), -1);
+	}
+
+	return background_operation;
+}
+
+/**
+ * Executes background operations.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param data A worker.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_background_operation_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackgroundWorker* worker = data;
+	JBackgroundExecutor* executor = j_background_executor;
+
+	g_private_set(&j_background_worker, worker);
+
+	while (TRUE)
+	{
+		JBackgroundOperation* background_operation;
+
+		background_operation = j_background_worker_take(executor, worker);
 
-	g_mutex_lock(background_operation->mutex);
-	background_operation->completed = TRUE;
-	g_cond_signal(background_operation->cond);
-	g_mutex_unlock(background_operation->mutex);
+		if (background_operation != NULL)
+		{
+			// The operation might already have been executed by a thread waiting for it.
+			if (g_atomic_int_compare_and_exchange(&(background_operation->state), J_BACKGROUND_OPERATION_QUEUED, J_BACKGROUND_OPERATION_RUNNING))
+			{
+				j_background_operation_run(background_operation);
+			}
 
-	j_background_operation_unref(background_operation);
+			j_background_operation_unref(background_operation);
+
+			continue;
+		}
+
+		g_mutex_lock(&(executor->idle_mutex));
+		g_atomic_int_inc(&(executor->idle));
+
+		while (g_atomic_int_get(&(executor->pending)) == 0 && !executor->shutdown)
+		{
+			g_cond_wait(&(executor->idle_cond), &(executor->idle_mutex));
+		}
+
+		g_atomic_int_add(&(executor->idle), -1);
+
+		if (g_atomic_int_get(&(executor->pending)) == 0 && executor->shutdown)
+		{
+			g_mutex_unlock(&(executor->idle_mutex));
+			break;
+		}
+
+		g_mutex_unlock(&(executor->idle_mutex));
+	}
+
+	return NULL;
 }
 
 /**
@@ -122,21 +302,42 @@ j_background_operation_init(guint count)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GThreadPool* thread_pool;
+	JBackgroundExecutor* executor;
 
-	g_return_if_fail(j_thread_pool == NULL);
+	g_return_if_fail(j_background_executor == NULL);
 
 	if (count == 0)
 	{
 		count = g_get_num_processors();
 	}
 
-	thread_pool = g_thread_pool_new(j_background_operation_thread, NULL, count, FALSE, NULL);
-	g_atomic_pointer_set(&j_thread_pool, thread_pool);
+	executor = g_slice_new(JBackgroundExecutor);
+	executor->workers = g_new(JBackgroundWorker, count);
+	executor->worker_count = count;
+	executor->next_worker = 0;
+	executor->pending = 0;
+	executor->idle = 0;
+	executor->shutdown = FALSE;
+	g_mutex_init(&(executor->idle_mutex));
+	g_cond_init(&(executor->idle_cond));
+
+	for (guint i = 0; i < count; i++)
+	{
+		g_queue_init(&(executor->workers[i].deque));
+		g_mutex_init(&(executor->workers[i].mutex));
+	}
+
+	g_atomic_pointer_set(&j_background_executor, executor);
+
+	for (guint i = 0; i < count; i++)
+	{
+		executor->workers[i].thread = g_thread_new("j-background-operation", j_background_operation_thread, &(executor->workers[i]));
+	}
 }
 
 /**
  * Shuts down the background operation framework.
+ * Operations that have already been queued are executed first.
  *
  * \code
  * j_background_operation_fini();
@@ -147,14 +348,30 @@ j_background_operation_fini(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GThreadPool* thread_pool;
+	JBackgroundExecutor* executor;
+
+	g_return_if_fail(j_background_executor != NULL);
 
-	g_return_if_fail(j_thread_pool != NULL);
+	executor = g_atomic_pointer_get(&j_background_executor);
 
-	thread_pool = g_atomic_pointer_get(&j_thread_pool);
-	g_atomic_pointer_set(&j_thread_pool, NULL);
+	g_mutex_lock(&(executor->idle_mutex));
+	executor->shutdown = TRUE;
+	g_cond_broadcast(&(executor->idle_cond));
+	g_mutex_unlock(&(executor->idle_mutex));
 
-	g_thread_pool_free(thread_pool, FALSE, TRUE);
+	for (guint i = 0; i < executor->worker_count; i++)
+	{
+		g_thread_join(executor->workers[i].thread);
+		g_mutex_clear(&(executor->workers[i].mutex));
+	}
+
+	g_atomic_pointer_set(&j_background_executor, NULL);
+
+	g_cond_clear(&(executor->idle_cond));
+	g_mutex_clear(&(executor->idle_mutex));
+
+	g_free(executor->workers);
+	g_slice_free(JBackgroundExecutor, executor);
 }
 
 guint
@@ -162,7 +379,7 @@ j_background_operation_get_num_threads(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return g_thread_pool_get_max_threads(j_thread_pool);
+	return j_background_executor->worker_count;
 }
 
 /**
@@ -191,7 +408,9 @@ j_background_operation_new(JBackgroundOperationFunc func, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JBackgroundExecutor* executor;
 	JBackgroundOperation* background_operation;
+	JBackgroundWorker* worker;
 
 	g_return_val_if_fail(func != NULL, NULL);
 
@@ -199,13 +418,33 @@ j_background_operation_new(JBackgroundOperationFunc func, gpointer data)
 	background_operation->func = func;
 	background_operation->data = data;
 	background_operation->result = NULL;
-	background_operation->completed = FALSE;
+	background_operation->state = J_BACKGROUND_OPERATION_QUEUED;
+	background_operation->completed = 0;
 	background_operation->ref_count = 2;
 
-	g_mutex_init(background_operation->mutex);
-	g_cond_init(background_operation->cond);
+	g_bit_lock(&(background_operation->completed), 0);
+
+	executor = j_background_executor;
+	worker = g_private_get(&j_background_worker);
+
+	// Operations submitted by workers stay local, others are distributed round-robin.
+	if (worker == NULL)
+	{
+		worker = &(executor->workers[(guint)g_atomic_int_add(&(executor->next_worker), 1) % executor->worker_count]);
+	}
+
+	g_mutex_lock(&(worker->mutex));
+	g_queue_push_tail(&(worker->deque), background_operation);
+	g_mutex_unlock(&(worker->mutex));
 
-	g_thread_pool_push(j_thread_pool, background_operation, NULL);
+	g_atomic_int_inc(&(executor->pending));
+
+	if (g_atomic_int_get(&(executor->idle)) > 0)
+	{
+		g_mutex_lock(&(executor->idle_mutex));
+		g_cond_signal(&(executor->idle_cond));
+		g_mutex_unlock(&(executor->idle_mutex));
+	}
 
 	return background_operation;
 }
@@ -256,15 +495,13 @@ j_background_operation_unref(JBackgroundOperation* background_operation)
 
 	if (g_atomic_int_dec_and_test(&(background_operation->ref_count)))
 	{
-		g_cond_clear(background_operation->cond);
-		g_mutex_clear(background_operation->mutex);
-
 		g_slice_free(JBackgroundOperation, background_operation);
 	}
 }
 
 /**
  * Waits for a background operation to finish.
+ * If the background operation has not been started yet, it is executed by the calling thread.
  *
  * \code
  * JBackgroundOperation* background_operation;
@@ -283,14 +520,16 @@ j_background_operation_wait(JBackgroundOperation* background_operation)
 
 	g_return_val_if_fail(background_operation != NULL, NULL);
 
-	g_mutex_lock(background_operation->mutex);
-
-	while (!background_operation->completed)
+	// Execute the operation directly if no worker has started it yet instead of blocking.
+	if (g_atomic_int_compare_and_exchange(&(background_operation->state), J_BACKGROUND_OPERATION_QUEUED, J_BACKGROUND_OPERATION_RUNNING))
 	{
-		g_cond_wait(background_operation->cond, background_operation->mutex);
+		j_background_operation_run(background_operation);
+	}
+	else if (g_atomic_int_get(&(background_operation->state)) != J_BACKGROUND_OPERATION_COMPLETED)
+	{
+		g_bit_lock(&(background_operation->completed), 0);
+		g_bit_unlock(&(background_operation->completed), 0);
 	}
-
-	g_mutex_unlock(background_operation->mutex);
 
 	return background_operation->result;
 }
@@ -29,6 +29,8 @@
 
 #include <jbackground-operation.h>
 #include <jcache.h>
+#include <jconnection-pool-internal.h>
+#include <jhelper.h>
 #include <jlist.h>
 #include <jlist-iterator.h>
 #include <joperation-cache-internal.h>
@@ -77,6 +79,33 @@ struct JBatchAsync
 
 typedef struct JBatchAsync JBatchAsync;
 
+/**
+ * The maximum number of flush functions.
+ **/
+#define J_BATCH_MAX_FLUSH_FUNCS 8
+
+/**
+ * The functions called after a batch has been executed.
+ **/
+static JBatchFlushFunc j_batch_flush_funcs[J_BATCH_MAX_FLUSH_FUNCS];
+
+/**
+ * The number of flush functions.
+ **/
+static gint j_batch_flush_func_count = 0;
+
+G_LOCK_DEFINE_STATIC(j_batch_flush_funcs);
+
+/**
+ * The number of executed operations.
+ **/
+static guint j_batch_statistics_operations = 0;
+
+/**
+ * The number of calls to exec functions, each one handling a group of operations.
+ **/
+static guint j_batch_statistics_executions = 0;
+
 static gpointer
 j_batch_background_operation(gpointer data)
 {
@@ -235,6 +264,9 @@ j_batch_execute_same(JBatch* batch, JOperationExecFunc exec_func, JList* list)
 
 	if (exec_func != NULL)
 	{
+		g_atomic_int_add(&j_batch_statistics_operations, j_list_length(list));
+		g_atomic_int_inc(&j_batch_statistics_executions);
+
 		ret = exec_func(list, batch->semantics);
 	}
 
@@ -325,6 +357,82 @@ j_batch_wait(JBatch* batch)
 	}
 }
 
+/**
+ * Adds a function that is called after each batch has been executed.
+ * Client libraries use this to send data they have buffered for the batch's operations.
+ *
+ * \code
+ * \endcode
+ *
+ * \param func A function, its return value is included in the batch's result.
+ **/
+void
+j_batch_add_flush_func(JBatchFlushFunc func)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint count;
+
+	g_return_if_fail(func != NULL);
+
+	G_LOCK(j_batch_flush_funcs);
+
+	count = g_atomic_int_get(&j_batch_flush_func_count);
+
+	for (gint i = 0; i < count; i++)
+	{
+		if (j_batch_flush_funcs[i] == func)
+		{
+			G_UNLOCK(j_batch_flush_funcs);
+			return;
+		}
+	}
+
+	if (count < J_BATCH_MAX_FLUSH_FUNCS)
+	{
+		j_batch_flush_funcs[count] = func;
+		// The function has to be visible before the count is increased.
+		g_atomic_int_set(&j_batch_flush_func_count, count + 1);
+	}
+	else
+	{
+		g_warning("Too many batch flush functions.");
+	}
+
+	G_UNLOCK(j_batch_flush_funcs);
+}
+
+/**
+ * Returns batch statistics.
+ *
+ * \code
+ * guint64 executions;
+ *
+ * executions = j_batch_get_statistics(J_BATCH_STATISTICS_EXECUTIONS);
+ * \endcode
+ *
+ * \param type A statistics type.
+ *
+ * \return The statistics value.
+ **/
+guint64
+j_batch_get_statistics(JBatchStatisticsType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	switch (type)
+	{
+		case J_BATCH_STATISTICS_OPERATIONS:
+			return (guint)g_atomic_int_get(&j_batch_statistics_operations);
+		case J_BATCH_STATISTICS_EXECUTIONS:
+			return (guint)g_atomic_int_get(&j_batch_statistics_executions);
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
 /* Internal */
 
 /**
@@ -426,50 +534,325 @@ j_batch_add(JBatch* batch, JOperation* operation)
 }
 
 /**
- * Executes the batch.
+ * A group of operations that are executed together.
+ **/
+struct JBatchGroup
+{
+	/** The exec function. **/
+	JOperationExecFunc exec_func;
+	/** The key. **/
+	gconstpointer key;
+	/** The key's hash function. **/
+	GHashFunc key_hash;
+	/** The key's equality function. **/
+	GEqualFunc key_equal;
+	/** The operations' data. **/
+	JList* list;
+	/** The group's position. **/
+	guint index;
+	/** The next group with the same key, which depends on this one. **/
+	struct JBatchGroup* next;
+	/** Whether the group depends on a previous group. **/
+	gboolean dependent;
+};
+
+typedef struct JBatchGroup JBatchGroup;
+
+/**
+ * A chain of dependent groups, executed in a background operation.
+ **/
+struct JBatchChain
+{
+	/** The batch. **/
+	JBatch* batch;
+	/** The first group. **/
+	JBatchGroup* group;
+	/** The result. **/
+	gboolean ret;
+};
+
+typedef struct JBatchChain JBatchChain;
+
+static guint
+j_batch_group_hash(gconstpointer data)
+{
+	JBatchGroup const* group = data;
+
+	if (group->key_hash != NULL)
+	{
+		return group->key_hash(group->key);
+	}
+
+	return g_direct_hash(group->key);
+}
+
+static gboolean
+j_batch_group_equal(gconstpointer a, gconstpointer b)
+{
+	JBatchGroup const* group_a = a;
+	JBatchGroup const* group_b = b;
+
+	// Keys of different types are never equal.
+	if (group_a->key_equal != group_b->key_equal)
+	{
+		return FALSE;
+	}
+
+	if (group_a->key_equal != NULL)
+	{
+		return group_a->key_equal(group_a->key, group_b->key);
+	}
+
+	return (group_a->key == group_b->key);
+}
+
+static void
+j_batch_group_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchGroup* group = data;
+
+	j_list_unref(group->list);
+	g_slice_free(JBatchGroup, group);
+}
+
+static gpointer
+j_batch_chain_execute(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchChain* chain = data;
+
+	for (JBatchGroup* group = chain->group; group != NULL; group = group->next)
+	{
+		chain->ret = j_batch_execute_same(chain->batch, group->exec_func, group->list) && chain->ret;
+	}
+
+	/* Collect coalesced replies that are still outstanding, the connections are held by this thread. */
+	chain->ret = j_connection_pool_wait_deferred() && chain->ret;
+
+	return chain;
+}
+
+/**
+ * Executes independent chains of groups concurrently.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ * \param heads The first group of each chain.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_batch_execute_chains(JBatch* batch, GPtrArray* heads)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree JBatchChain* chains = NULL;
+	g_autofree gpointer* data = NULL;
+	gboolean ret = TRUE;
+
+	chains = g_new(JBatchChain, heads->len);
+	data = g_new(gpointer, heads->len);
+
+	for (guint i = 0; i < heads->len; i++)
+	{
+		chains[i].batch = batch;
+		chains[i].group = g_ptr_array_index(heads, i);
+		chains[i].ret = TRUE;
+
+		data[i] = &(chains[i]);
+	}
+
+	// Runs the chains in background operations if there is more than one.
+	j_helper_execute_parallel(j_batch_chain_execute, data, heads->len);
+
+	for (guint i = 0; i < heads->len; i++)
+	{
+		ret = chains[i].ret && ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Executes a batch's operations out of order.
+ *
+ * Operations are grouped by their exec function and key across the whole batch.
+ * Keys are compared using the operations' key functions, so different handles for the same object share a key.
+ * Operations with the same key depend on each other and keep their order, that is, an operation is only merged into the most recent group for its key.
+ * For example, writes to an object are never moved in front of its creation.
+ * With semi-relaxed ordering, operations are additionally not moved past operations of a different type.
+ *
+ * Groups only depend on previous groups with the same key.
+ * With relaxed ordering, each chain of dependent groups is executed concurrently to all others.
+ * With semi-relaxed ordering, all groups of the same type are executed concurrently before moving on to the next type.
  *
  * \private
  *
  * \code
  * \endcode
  *
+ * \param batch        A batch.
+ * \param semi_relaxed Whether the order of operation types has to be kept.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_batch_execute_reordered(JBatch* batch, gboolean semi_relaxed)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) groups = NULL;
+	g_autoptr(GHashTable) last_groups = NULL;
+	g_autoptr(GPtrArray) heads = NULL;
+	guint run_start = 0;
+	gboolean ret = TRUE;
+
+	groups = g_ptr_array_new_with_free_func(j_batch_group_free);
+	// Contains the most recent group for each key.
+	last_groups = g_hash_table_new(j_batch_group_hash, j_batch_group_equal);
+
+	for (guint j = 0; j < j_list_length(batch->list); j++)
+	{
+		JOperation* operation = j_list_get_nth(batch->list, j);
+		JBatchGroup lookup;
+		JBatchGroup* group;
+
+		lookup.key = operation->key;
+		lookup.key_hash = operation->key_hash;
+		lookup.key_equal = operation->key_equal;
+		group = g_hash_table_lookup(last_groups, &lookup);
+
+		if (group == NULL || group->exec_func != operation->exec_func || (semi_relaxed && group->index < run_start))
+		{
+			JBatchGroup* previous = group;
+
+			if (groups->len > 0 && ((JBatchGroup*)g_ptr_array_index(groups, groups->len - 1))->exec_func != operation->exec_func)
+			{
+				run_start = groups->len;
+			}
+
+			group = g_slice_new(JBatchGroup);
+			group->exec_func = operation->exec_func;
+			group->key = operation->key;
+			group->key_hash = operation->key_hash;
+			group->key_equal = operation->key_equal;
+			group->list = j_list_new(NULL);
+			group->index = groups->len;
+			group->next = NULL;
+			group->dependent = (previous != NULL);
+
+			// With semi-relaxed ordering, groups are executed type by type and do not have to be chained.
+			if (previous != NULL && !semi_relaxed)
+			{
+				previous->next = group;
+			}
+
+			g_ptr_array_add(groups, group);
+			g_hash_table_add(last_groups, group);
+		}
+
+		j_list_append(group->list, operation->data);
+	}
+
+	heads = g_ptr_array_new();
+
+	for (guint i = 0; i < groups->len; i++)
+	{
+		JBatchGroup* group = g_ptr_array_index(groups, i);
+
+		if (semi_relaxed)
+		{
+			if (heads->len > 0 && ((JBatchGroup*)g_ptr_array_index(heads, 0))->exec_func != group->exec_func)
+			{
+				ret = j_batch_execute_chains(batch, heads) && ret;
+				g_ptr_array_set_size(heads, 0);
+			}
+
+			g_ptr_array_add(heads, group);
+		}
+		else if (!group->dependent)
+		{
+			g_ptr_array_add(heads, group);
+		}
+	}
+
+	if (heads->len > 0)
+	{
+		ret = j_batch_execute_chains(batch, heads) && ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Calls the flush functions for an executed batch.
+ *
+ * \private
+ *
  * \param batch A batch.
  *
  * \return TRUE on success, FALSE if an error occurred.
  **/
-gboolean
-j_batch_execute_internal(JBatch* batch)
+static gboolean
+j_batch_flush(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+	gint count;
+
+	count = g_atomic_int_get(&j_batch_flush_func_count);
+
+	for (gint i = 0; i < count; i++)
+	{
+		ret = j_batch_flush_funcs[i](batch->semantics) && ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Executes the batch's operations without receiving coalesced replies.
+ *
+ * \private
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_batch_execute_operations(JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JList) same_list = NULL;
-	g_autoptr(JListIterator) iterator = NULL;
 	JOperationExecFunc last_exec_func;
 	gconstpointer last_key;
+	JSemanticsOrdering ordering;
 	gboolean ret = TRUE;
 
-	iterator = j_list_iterator_new(batch->list);
 	same_list = j_list_new(NULL);
 	last_key = NULL;
 	last_exec_func = NULL;
 
-	if (j_semantics_get(batch->semantics, J_SEMANTICS_ORDERING) == J_SEMANTICS_ORDERING_RELAXED)
+	ordering = j_semantics_get(batch->semantics, J_SEMANTICS_ORDERING);
+
+	if (ordering == J_SEMANTICS_ORDERING_RELAXED || ordering == J_SEMANTICS_ORDERING_SEMI_RELAXED)
 	{
-		/* FIXME: perform some optimizations */
-		/**
-		 * It is important to consider dependencies:
-		 * - Operations have to be performed before their dependent ones.
-		 *   For example, a collection has to be created before items in it can be created.
-		 */
+		return j_batch_execute_reordered(batch, ordering == J_SEMANTICS_ORDERING_SEMI_RELAXED);
 	}
 
 	/**
 	 * Try to combine as many operations of the same type as possible.
 	 * These are temporarily stored in same_list.
 	 */
-	while (j_list_iterator_next(iterator))
+	for (guint i = 0; i < j_list_length(batch->list); i++)
 	{
-		JOperation* operation = j_list_iterator_get(iterator);
+		JOperation* operation = j_list_get_nth(batch->list, i);
 
 		/* We only combine operations with the same type and the same key. */
 		if ((operation->exec_func != last_exec_func || operation->key != last_key) && last_exec_func != NULL)
@@ -487,6 +870,77 @@ j_batch_execute_internal(JBatch* batch)
 	return ret;
 }
 
+/**
+ * Executes the batch.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_batch_execute_internal(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	ret = j_batch_execute_operations(batch);
+
+	/* Collect coalesced replies that are still outstanding. */
+	ret = j_connection_pool_wait_deferred() && ret;
+	ret = j_batch_flush(batch) && ret;
+
+	return ret;
+}
+
+/**
+ * Executes the batch without waiting for coalesced replies.
+ * Connections with outstanding replies are kept by the calling thread and have to be taken using j_connection_pool_take_held().
+ * The batch's operations are not deleted because the replies might still refer to them.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE on success, FALSE if an error occurred. Failures reported by the outstanding replies are not included.
+ **/
+gboolean
+j_batch_execute_deferred(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (j_list_length(batch->list) == 0)
+	{
+		return FALSE;
+	}
+
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_PERSISTENCY) == J_SEMANTICS_PERSISTENCY_EVENTUAL
+	    && j_operation_cache_add(batch))
+	{
+		return TRUE;
+	}
+
+	j_operation_cache_flush();
+
+	ret = j_batch_execute_operations(batch);
+	// Flushed writes use the connections kept by this thread, so they are ordered after the batch's operations.
+	ret = j_batch_flush(batch) && ret;
+
+	return ret;
+}
+
 /**
  * @}
  **/
@@ -20,38 +20,461 @@
  * \file
  **/
 
+// madvise() is not part of POSIX.
+#define _DEFAULT_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
 
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_MADV_HUGEPAGE
+#include <sys/mman.h>
+#endif
+
 #include <jcache.h>
 
 #include <jtrace.h>
 
 /**
  * \defgroup JCache Cache
+ *
+ * Caches hand out memory segments from an arena of slabs.
+ * Segments are grouped into size classes, each of which has its own free list.
+ * Threads keep a small magazine of free segments per size class, so most requests do not have to take any lock.
+ * Slabs stay with their size class, so the memory held by all slabs is limited to the cache's size and slabs are smaller for small caches.
+ * Segments larger than the biggest size class or a slab, as well as segments that do not fit into the slab limit, are allocated individually.
+ *
  * @{
  **/
 
+enum
+{
+	/**
+	 * The number of size classes.
+	 * Size class i holds segments of 64 << i bytes, including their header.
+	 */
+	J_CACHE_CLASSES = 15,
+
+	/**
+	 * The maximum size of a slab.
+	 */
+	J_CACHE_SLAB_SIZE = 2 * 1024 * 1024,
+
+	/**
+	 * The minimum number of slabs that fit into a cache.
+	 */
+	J_CACHE_SLAB_COUNT = 16,
+
+	/**
+	 * The number of segments a thread keeps per size class.
+	 */
+	J_CACHE_MAGAZINE_SIZE = 32,
+
+	/**
+	 * Marks segments that do not belong to a size class.
+	 */
+	J_CACHE_CLASS_LARGE = G_MAXUINT32,
+
+	/**
+	 * Used to detect invalid segments.
+	 */
+	J_CACHE_MAGIC = 0x4a434143
+};
+
+/**
+ * The header stored in front of every segment.
+ */
+struct JCacheHeader
+{
+	/**
+	 * The requested length.
+	 */
+	guint64 length;
+
+	/**
+	 * The size class, #J_CACHE_CLASS_LARGE for large segments.
+	 */
+	guint32 size_class;
+
+	/**
+	 * #J_CACHE_MAGIC while the segment is in use.
+	 */
+	guint32 magic;
+};
+
+typedef struct JCacheHeader JCacheHeader;
+
+G_STATIC_ASSERT(sizeof(JCacheHeader) == 16);
+
+/**
+ * A segment that does not belong to a size class.
+ */
+struct JCacheLarge
+{
+	/**
+	 * The previous large segment.
+	 */
+	struct JCacheLarge* prev;
+
+	/**
+	 * The next large segment.
+	 */
+	struct JCacheLarge* next;
+
+	/**
+	 * The segment's header, directly followed by its data.
+	 */
+	JCacheHeader header;
+};
+
+typedef struct JCacheLarge JCacheLarge;
+
+/**
+ * A size class.
+ */
+struct JCacheClass
+{
+	/**
+	 * The free segments, linked through their first bytes.
+	 */
+	gpointer free;
+
+	/**
+	 * The next unused byte of the current slab.
+	 */
+	gchar* position;
+
+	/**
+	 * The end of the current slab.
+	 */
+	gchar* end;
+
+	/**
+	 * The mutex.
+	 */
+	GMutex mutex[1];
+};
+
+typedef struct JCacheClass JCacheClass;
+
 /**
  * A cache.
  */
 struct JCache
 {
 	/**
-	* The size.
-	*/
+	 * The unique ID, used to find the thread's magazine.
+	 */
+	guint64 id;
+
+	/**
+	 * The size.
+	 */
 	guint64 size;
 
-	GHashTable* buffers;
+	/**
+	 * The number of bytes currently handed out.
+	 */
+	gsize used;
+
+	/**
+	 * The size of a slab.
+	 */
+	gsize slab_size;
+
+	/**
+	 * The memory held by all slabs, at most #size.
+	 */
+	gsize slabs_size;
+
+	/**
+	 * The flags.
+	 */
+	JCacheFlags flags;
+
+	/**
+	 * The size classes.
+	 */
+	JCacheClass classes[J_CACHE_CLASSES];
+
+	/**
+	 * The slabs.
+	 */
+	GPtrArray* slabs;
 
-	guint64 used;
+	/**
+	 * The large segments.
+	 */
+	JCacheLarge* large;
 
+	/**
+	 * The mutex for #slabs and #large.
+	 */
 	GMutex mutex[1];
 };
 
+/**
+ * A thread's free segments for one cache.
+ */
+struct JCacheMagazine
+{
+	/**
+	 * The cache's ID.
+	 */
+	guint64 id;
+
+	/**
+	 * The number of segments per size class.
+	 */
+	guint count[J_CACHE_CLASSES];
+
+	/**
+	 * The segments per size class.
+	 */
+	gpointer segments[J_CACHE_CLASSES][J_CACHE_MAGAZINE_SIZE];
+};
+
+typedef struct JCacheMagazine JCacheMagazine;
+
+static void j_cache_thread_free(gpointer);
+
+static GPrivate j_cache_magazines = G_PRIVATE_INIT(j_cache_thread_free);
+
+// The caches that are still alive, used to return magazines when threads exit.
+G_LOCK_DEFINE_STATIC(j_cache_caches);
+static GList* j_cache_caches = NULL;
+static guint64 j_cache_next_id = 0;
+
+static guint
+j_cache_get_class(guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 size = length + sizeof(JCacheHeader);
+
+	for (guint i = 0; i < J_CACHE_CLASSES; i++)
+	{
+		if (size <= (G_GUINT64_CONSTANT(64) << i))
+		{
+			return i;
+		}
+	}
+
+	return J_CACHE_CLASS_LARGE;
+}
+
+/**
+ * Returns segments from a magazine to their size classes.
+ *
+ * \private
+ *
+ * \param cache      A cache.
+ * \param magazine   A magazine.
+ * \param size_class A size class.
+ * \param count      The number of segments to return.
+ **/
+static void
+j_cache_magazine_drain(JCache* cache, JCacheMagazine* magazine, guint size_class, guint count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCacheClass* class = &(cache->classes[size_class]);
+
+	g_mutex_lock(class->mutex);
+
+	for (guint i = 0; i < count && magazine->count[size_class] > 0; i++)
+	{
+		gpointer segment = magazine->segments[size_class][--magazine->count[size_class]];
+
+		*(gpointer*)segment = class->free;
+		class->free = segment;
+	}
+
+	g_mutex_unlock(class->mutex);
+}
+
+static void
+j_cache_thread_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GList* magazines = data;
+
+	G_LOCK(j_cache_caches);
+
+	for (GList* l = magazines; l != NULL; l = l->next)
+	{
+		JCacheMagazine* magazine = l->data;
+
+		// Segments of caches that have already been freed must not be touched.
+		for (GList* c = j_cache_caches; c != NULL; c = c->next)
+		{
+			JCache* cache = c->data;
+
+			if (cache->id == magazine->id)
+			{
+				for (guint i = 0; i < J_CACHE_CLASSES; i++)
+				{
+					j_cache_magazine_drain(cache, magazine, i, J_CACHE_MAGAZINE_SIZE);
+				}
+
+				break;
+			}
+		}
+
+		g_slice_free(JCacheMagazine, magazine);
+	}
+
+	G_UNLOCK(j_cache_caches);
+
+	g_list_free(magazines);
+}
+
+static JCacheMagazine*
+j_cache_get_magazine(JCache* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GList* magazines;
+	JCacheMagazine* magazine;
+
+	magazines = g_private_get(&j_cache_magazines);
+
+	for (GList* l = magazines; l != NULL; l = l->next)
+	{
+		magazine = l->data;
+
+		if (magazine->id == cache->id)
+		{
+			return magazine;
+		}
+	}
+
+	magazine = g_slice_new0(JCacheMagazine);
+	magazine->id = cache->id;
+
+	g_private_set(&j_cache_magazines, g_list_prepend(magazines, magazine));
+
+	return magazine;
+}
+
+static gpointer
+j_cache_slab_new(JCache* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer slab = NULL;
+
+	// Slabs are never returned, so they must not use more memory than the cache's size.
+	g_mutex_lock(cache->mutex);
+
+	if (cache->slabs_size + cache->slab_size > cache->size)
+	{
+		g_mutex_unlock(cache->mutex);
+		return NULL;
+	}
+
+	cache->slabs_size += cache->slab_size;
+
+	g_mutex_unlock(cache->mutex);
+
+#ifdef HAVE_MADV_HUGEPAGE
+	if ((cache->flags & J_CACHE_HUGEPAGES) && cache->slab_size == J_CACHE_SLAB_SIZE)
+	{
+		if (posix_memalign(&slab, J_CACHE_SLAB_SIZE, J_CACHE_SLAB_SIZE) == 0)
+		{
+			// Huge pages are only a hint, the slab is usable either way.
+			madvise(slab, J_CACHE_SLAB_SIZE, MADV_HUGEPAGE);
+		}
+		else
+		{
+			slab = NULL;
+		}
+	}
+#endif
+
+	if (slab == NULL)
+	{
+		slab = malloc(cache->slab_size);
+	}
+
+	g_mutex_lock(cache->mutex);
+
+	if (slab != NULL)
+	{
+		g_ptr_array_add(cache->slabs, slab);
+	}
+	else
+	{
+		cache->slabs_size -= cache->slab_size;
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	return slab;
+}
+
+/**
+ * Refills a magazine from its size class.
+ *
+ * \private
+ *
+ * \param cache      A cache.
+ * \param magazine   A magazine.
+ * \param size_class A size class.
+ **/
+static void
+j_cache_magazine_fill(JCache* cache, JCacheMagazine* magazine, guint size_class)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCacheClass* class = &(cache->classes[size_class]);
+	gsize const segment_size = G_GUINT64_CONSTANT(64) << size_class;
+
+	if (segment_size > cache->slab_size)
+	{
+		return;
+	}
+
+	g_mutex_lock(class->mutex);
+
+	while (magazine->count[size_class] < J_CACHE_MAGAZINE_SIZE / 2)
+	{
+		gpointer segment;
+
+		if (class->free != NULL)
+		{
+			segment = class->free;
+			class->free = *(gpointer*)segment;
+		}
+		else
+		{
+			if (class->position == NULL || class->position + segment_size > class->end)
+			{
+				gchar* slab;
+
+				if ((slab = j_cache_slab_new(cache)) == NULL)
+				{
+					break;
+				}
+
+				class->position = slab;
+				class->end = slab + cache->slab_size;
+			}
+
+			segment = class->position;
+			class->position += segment_size;
+		}
+
+		magazine->segments[size_class][magazine->count[size_class]++] = segment;
+	}
+
+	g_mutex_unlock(class->mutex);
+}
+
 /**
  * Creates a new cache.
  *
@@ -70,22 +493,68 @@ j_cache_new(guint64 size)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	return j_cache_new_full(size, J_CACHE_NONE);
+}
+
+/**
+ * Creates a new cache.
+ *
+ * \code
+ * JCache* cache;
+ *
+ * cache = j_cache_new_full(1024, J_CACHE_HUGEPAGES);
+ * \endcode
+ *
+ * \param size  A size.
+ * \param flags Flags.
+ *
+ * \return A new cache. Should be freed with j_cache_free().
+ **/
+JCache*
+j_cache_new_full(guint64 size, JCacheFlags flags)
+{
+	J_TRACE_FUNCTION(NULL);
+
 	JCache* cache;
 
 	g_return_val_if_fail(size > 0, NULL);
 
 	cache = g_slice_new(JCache);
 	cache->size = size;
-	cache->buffers = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
 	cache->used = 0;
+	cache->slab_size = J_CACHE_SLAB_SIZE;
+	cache->slabs_size = 0;
+	cache->flags = flags;
+	cache->slabs = g_ptr_array_new_with_free_func(free);
+	cache->large = NULL;
+
+	// Small caches use smaller slabs, which are still large enough for the smallest size class.
+	while (cache->slab_size > 64 && cache->slab_size * J_CACHE_SLAB_COUNT > size)
+	{
+		cache->slab_size /= 2;
+	}
+
+	for (guint i = 0; i < J_CACHE_CLASSES; i++)
+	{
+		cache->classes[i].free = NULL;
+		cache->classes[i].position = NULL;
+		cache->classes[i].end = NULL;
+		g_mutex_init(cache->classes[i].mutex);
+	}
 
 	g_mutex_init(cache->mutex);
 
+	G_LOCK(j_cache_caches);
+	cache->id = j_cache_next_id++;
+	j_cache_caches = g_list_prepend(j_cache_caches, cache);
+	G_UNLOCK(j_cache_caches);
+
 	return cache;
 }
 
 /**
  * Frees the memory allocated for the cache.
+ * All segments handed out by the cache are freed, too.
  *
  * \code
  * JCache* cache;
@@ -102,20 +571,43 @@ j_cache_free(JCache* cache)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GHashTableIter iter[1];
-	gpointer key;
-	gpointer value;
+	GList* magazines;
 
 	g_return_if_fail(cache != NULL);
 
-	g_hash_table_iter_init(iter, cache->buffers);
+	G_LOCK(j_cache_caches);
+	j_cache_caches = g_list_remove(j_cache_caches, cache);
+	G_UNLOCK(j_cache_caches);
+
+	// Other threads' magazines are discarded when they exit.
+	magazines = g_private_get(&j_cache_magazines);
+
+	for (GList* l = magazines; l != NULL; l = l->next)
+	{
+		JCacheMagazine* magazine = l->data;
+
+		if (magazine->id == cache->id)
+		{
+			g_slice_free(JCacheMagazine, magazine);
+			g_private_set(&j_cache_magazines, g_list_delete_link(magazines, l));
+			break;
+		}
+	}
 
-	while (g_hash_table_iter_next(iter, &key, &value))
+	while (cache->large != NULL)
 	{
-		g_free(key);
+		JCacheLarge* large = cache->large;
+
+		cache->large = large->next;
+		g_free(large);
 	}
 
-	g_hash_table_unref(cache->buffers);
+	g_ptr_array_unref(cache->slabs);
+
+	for (guint i = 0; i < J_CACHE_CLASSES; i++)
+	{
+		g_mutex_clear(cache->classes[i].mutex);
+	}
 
 	g_mutex_clear(cache->mutex);
 
@@ -143,52 +635,163 @@ j_cache_get(JCache* cache, guint64 length)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gpointer ret = NULL;
+	JCacheHeader* header = NULL;
+	guint size_class;
+	gsize used;
 
 	g_return_val_if_fail(cache != NULL, NULL);
 
-	g_mutex_lock(cache->mutex);
+	do
+	{
+		used = g_atomic_pointer_get(&(cache->used));
 
-	if (cache->used + length > cache->size)
+		if (length > cache->size || used > cache->size - length)
+		{
+			return NULL;
+		}
+	} while (!g_atomic_pointer_compare_and_exchange(&(cache->used), used, used + length));
+
+	size_class = j_cache_get_class(length);
+
+	if (size_class != J_CACHE_CLASS_LARGE)
 	{
-		goto end;
+		JCacheMagazine* magazine;
+
+		magazine = j_cache_get_magazine(cache);
+
+		if (magazine->count[size_class] == 0)
+		{
+			j_cache_magazine_fill(cache, magazine, size_class);
+		}
+
+		if (magazine->count[size_class] > 0)
+		{
+			header = magazine->segments[size_class][--magazine->count[size_class]];
+		}
+		else
+		{
+			// No slab could be used, allocate the segment individually.
+			size_class = J_CACHE_CLASS_LARGE;
+		}
 	}
 
-	ret = g_malloc(length);
-	cache->used += length;
+	if (size_class == J_CACHE_CLASS_LARGE)
+	{
+		JCacheLarge* large;
 
-	g_hash_table_insert(cache->buffers, ret, GSIZE_TO_POINTER(length));
+		large = g_try_malloc(sizeof(JCacheLarge) + length);
 
-end:
-	g_mutex_unlock(cache->mutex);
+		if (large != NULL)
+		{
+			large->prev = NULL;
+
+			g_mutex_lock(cache->mutex);
+
+			large->next = cache->large;
+
+			if (cache->large != NULL)
+			{
+				cache->large->prev = large;
+			}
+
+			cache->large = large;
 
-	return ret;
+			g_mutex_unlock(cache->mutex);
+
+			header = &(large->header);
+		}
+	}
+
+	if (header == NULL)
+	{
+		g_atomic_pointer_add(&(cache->used), -(gssize)length);
+		return NULL;
+	}
+
+	header->length = length;
+	header->size_class = size_class;
+	header->magic = J_CACHE_MAGIC;
+
+	return header + 1;
 }
 
+/**
+ * Returns a segment to the cache.
+ *
+ * \code
+ * JCache* cache;
+ * gpointer segment;
+ *
+ * segment = j_cache_get(cache, 1024);
+ * ...
+ * j_cache_release(cache, segment);
+ * \endcode
+ *
+ * \param cache A cache.
+ * \param data  A segment returned by j_cache_get().
+ **/
 void
 j_cache_release(JCache* cache, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gpointer size;
+	JCacheHeader* header;
+	guint64 length;
 
 	g_return_if_fail(cache != NULL);
 	g_return_if_fail(data != NULL);
 
-	g_mutex_lock(cache->mutex);
+	header = (JCacheHeader*)data - 1;
 
-	if ((size = g_hash_table_lookup(cache->buffers, data)) == NULL)
+	if (header->magic != J_CACHE_MAGIC)
 	{
 		g_warn_if_reached();
 		return;
 	}
 
-	g_hash_table_remove(cache->buffers, data);
+	header->magic = 0;
+	length = header->length;
 
-	cache->used -= GPOINTER_TO_SIZE(size);
-	g_free(data);
+	if (header->size_class == J_CACHE_CLASS_LARGE)
+	{
+		JCacheLarge* large = (JCacheLarge*)((gchar*)header - G_STRUCT_OFFSET(JCacheLarge, header));
 
-	g_mutex_unlock(cache->mutex);
+		g_mutex_lock(cache->mutex);
+
+		if (large->prev != NULL)
+		{
+			large->prev->next = large->next;
+		}
+		else
+		{
+			cache->large = large->next;
+		}
+
+		if (large->next != NULL)
+		{
+			large->next->prev = large->prev;
+		}
+
+		g_mutex_unlock(cache->mutex);
+
+		g_free(large);
+	}
+	else
+	{
+		JCacheMagazine* magazine;
+		guint size_class = header->size_class;
+
+		magazine = j_cache_get_magazine(cache);
+
+		if (magazine->count[size_class] == J_CACHE_MAGAZINE_SIZE)
+		{
+			j_cache_magazine_drain(cache, magazine, size_class, J_CACHE_MAGAZINE_SIZE / 2);
+		}
+
+		magazine->segments[size_class][magazine->count[size_class]++] = header;
+	}
+
+	g_atomic_pointer_add(&(cache->used), -(gssize)length);
 }
 
 /**
@@ -26,6 +26,7 @@
 
 #include <jbackend.h>
 #include <jbackground-operation-internal.h>
+#include <jcompletion-queue-internal.h>
 #include <jconfiguration.h>
 #include <jconnection-pool-internal.h>
 #include <jdistribution-internal.h>
@@ -108,10 +109,11 @@ j_init(void)
 		goto error;
 	}
 
+	// The connection pool uses background operations to establish connections in parallel.
+	j_background_operation_init(0);
 	j_connection_pool_init(j_configuration());
 	j_distribution_init();
-	j_background_operation_init(0);
-	j_operation_cache_init();
+	j_operation_cache_init(j_configuration());
 
 	j_inited = TRUE;
 
@@ -142,6 +144,8 @@ j_fini(void)
 
 	trace = j_trace_enter(G_STRFUNC, NULL);
 
+	// Batches submitted to completion queues might still be running and use the operation cache and connection pool.
+	j_completion_queue_fini();
 	j_operation_cache_fini();
 	j_background_operation_fini();
 	j_connection_pool_fini();
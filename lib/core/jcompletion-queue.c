@@ -0,0 +1,624 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <jcompletion-queue.h>
+#include <jcompletion-queue-internal.h>
+
+#include <jbatch.h>
+#include <jbatch-internal.h>
+#include <jconfiguration.h>
+#include <jconnection-pool.h>
+#include <jconnection-pool-internal.h>
+#include <jlist.h>
+#include <jmessage.h>
+#include <jtrace.h>
+
+/**
+ * \defgroup JCompletionQueue Completion Queue
+ *
+ * Completion queues allow submitting many batches without waiting for them.
+ * Batches are sent by a dedicated thread pool shared by all completion queues, the number of threads can be configured using the completion-queue-threads option.
+ * Coalesced replies are not waited for by these threads.
+ * Instead, an event loop receives them whenever a connection becomes readable, so the number of batches waiting for replies is not limited by the number of threads.
+ * Operations that need their replies' contents, such as reads, and operations on multiplexed connections still wait for their replies on the sending thread.
+ * Completed batches can be polled or waited for.
+ *
+ * @{
+ **/
+
+/**
+ * A completion queue.
+ **/
+struct JCompletionQueue
+{
+	/**
+	 * The completed batches.
+	 * Contains JCompletionQueueEntry elements.
+	 **/
+	GAsyncQueue* completions;
+
+	/**
+	 * The number of batches that have been submitted but not retrieved yet.
+	 **/
+	gint outstanding;
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+/**
+ * A submitted batch.
+ **/
+struct JCompletionQueueEntry
+{
+	/**
+	 * The completion queue.
+	 **/
+	JCompletionQueue* queue;
+
+	/**
+	 * The batch.
+	 **/
+	JBatch* batch;
+
+	/**
+	 * The batch's result.
+	 **/
+	gboolean ret;
+
+	/**
+	 * Whether an outstanding reply reported a failure.
+	 **/
+	gint failed;
+
+	/**
+	 * The number of connections whose replies are still being received, plus one while the batch is being sent.
+	 **/
+	gint pending;
+
+	/**
+	 * User data given to j_completion_queue_submit().
+	 **/
+	gpointer user_data;
+};
+
+typedef struct JCompletionQueueEntry JCompletionQueueEntry;
+
+/**
+ * A connection whose outstanding replies are received by the event loop.
+ **/
+struct JCompletionQueueConnection
+{
+	/**
+	 * The submitted batch.
+	 **/
+	JCompletionQueueEntry* entry;
+
+	/**
+	 * The backend type.
+	 **/
+	JBackendType backend;
+
+	/**
+	 * The server index.
+	 **/
+	guint index;
+
+	/**
+	 * The connection.
+	 **/
+	gpointer connection;
+};
+
+typedef struct JCompletionQueueConnection JCompletionQueueConnection;
+
+/**
+ * The threads sending submitted batches.
+ * Batches are sent by their own threads because executing a batch might require background operations itself.
+ **/
+static GThreadPool* j_completion_queue_pool = NULL;
+
+/**
+ * The event loop receiving outstanding replies and the thread running it.
+ **/
+static GMainLoop* j_completion_queue_loop = NULL;
+static GThread* j_completion_queue_thread = NULL;
+
+/**
+ * The number of submitted batches that have not completed yet.
+ **/
+static guint j_completion_queue_running = 0;
+
+static GMutex j_completion_queue_running_mutex;
+static GCond j_completion_queue_running_cond;
+
+G_LOCK_DEFINE_STATIC(j_completion_queue_pool);
+
+static void
+j_completion_queue_entry_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueueEntry* entry = data;
+
+	j_batch_unref(entry->batch);
+
+	g_slice_free(JCompletionQueueEntry, entry);
+}
+
+/**
+ * Completes a batch once it has been sent and all of its replies have been received.
+ *
+ * \private
+ *
+ * \param entry A submitted batch.
+ **/
+static void
+j_completion_queue_complete(JCompletionQueueEntry* entry)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueue* queue = entry->queue;
+
+	if (!g_atomic_int_dec_and_test(&(entry->pending)))
+	{
+		return;
+	}
+
+	entry->ret = entry->ret && (g_atomic_int_get(&(entry->failed)) == 0);
+
+	// The replies might refer to the operations, so they can only be deleted now.
+	j_list_delete_all(j_batch_get_operations(entry->batch));
+
+	g_async_queue_push(queue->completions, entry);
+	j_completion_queue_unref(queue);
+
+	g_mutex_lock(&j_completion_queue_running_mutex);
+
+	j_completion_queue_running--;
+
+	if (j_completion_queue_running == 0)
+	{
+		g_cond_broadcast(&j_completion_queue_running_cond);
+	}
+
+	g_mutex_unlock(&j_completion_queue_running_mutex);
+}
+
+/**
+ * Receives replies when a connection becomes readable.
+ * Runs in the event loop's thread.
+ *
+ * \private
+ *
+ * \param socket    The connection's socket.
+ * \param condition The condition.
+ * \param data      A connection.
+ *
+ * \return Whether further replies are outstanding.
+ **/
+static gboolean
+j_completion_queue_receive(GSocket* socket, GIOCondition condition, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueueConnection* connection = data;
+	gboolean done = FALSE;
+
+	(void)socket;
+	(void)condition;
+
+	// Broken connections become readable, too. Receiving fails and discards the outstanding replies.
+	if (!j_message_receive_deferred_next(connection->connection, &done))
+	{
+		g_atomic_int_set(&(connection->entry->failed), 1);
+	}
+
+	if (!done)
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	j_connection_pool_push(connection->backend, connection->index, connection->connection);
+	j_completion_queue_complete(connection->entry);
+
+	g_slice_free(JCompletionQueueConnection, connection);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gpointer
+j_completion_queue_loop_func(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMainLoop* loop = data;
+
+	g_main_loop_run(loop);
+
+	return NULL;
+}
+
+static void
+j_completion_queue_execute(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueueEntry* entry = data;
+	JBackendType backend;
+	gpointer connection;
+	guint index;
+
+	(void)user_data;
+
+	entry->ret = j_batch_execute_deferred(entry->batch);
+
+	// Hand the connections with outstanding replies to the event loop instead of waiting for them.
+	while ((connection = j_connection_pool_take_held(&backend, &index)) != NULL)
+	{
+		JCompletionQueueConnection* queue_connection;
+		GSource* source;
+
+		if (!j_message_flush_deferred(connection))
+		{
+			g_atomic_int_set(&(entry->failed), 1);
+		}
+
+		queue_connection = g_slice_new(JCompletionQueueConnection);
+		queue_connection->entry = entry;
+		queue_connection->backend = backend;
+		queue_connection->index = index;
+		queue_connection->connection = connection;
+
+		g_atomic_int_inc(&(entry->pending));
+
+		source = g_socket_create_source(g_socket_connection_get_socket(connection), G_IO_IN | G_IO_ERR | G_IO_HUP, NULL);
+		g_source_set_callback(source, (GSourceFunc)(void (*)(void))j_completion_queue_receive, queue_connection, NULL);
+		g_source_attach(source, g_main_loop_get_context(j_completion_queue_loop));
+		g_source_unref(source);
+	}
+
+	j_completion_queue_complete(entry);
+}
+
+/**
+ * Returns the thread pool, creating it and the event loop on first use.
+ *
+ * \private
+ *
+ * \return The thread pool.
+ **/
+static GThreadPool*
+j_completion_queue_get_pool(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GThreadPool* pool;
+
+	pool = g_atomic_pointer_get(&j_completion_queue_pool);
+
+	if (pool != NULL)
+	{
+		return pool;
+	}
+
+	G_LOCK(j_completion_queue_pool);
+
+	pool = j_completion_queue_pool;
+
+	if (pool == NULL)
+	{
+		GMainContext* context;
+
+		context = g_main_context_new();
+		j_completion_queue_loop = g_main_loop_new(context, FALSE);
+		j_completion_queue_thread = g_thread_new("j-completion-queue", j_completion_queue_loop_func, j_completion_queue_loop);
+		g_main_context_unref(context);
+
+		pool = g_thread_pool_new(j_completion_queue_execute, NULL, j_configuration_get_completion_queue_threads(j_configuration()), FALSE, NULL);
+		g_atomic_pointer_set(&j_completion_queue_pool, pool);
+	}
+
+	G_UNLOCK(j_completion_queue_pool);
+
+	return pool;
+}
+
+static void
+j_completion_queue_take(JCompletionQueue* queue, JCompletionQueueEntry* entry, JBatch** batch, gboolean* ret, gpointer* user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_atomic_int_add(&(queue->outstanding), -1);
+
+	if (batch != NULL)
+	{
+		*batch = j_batch_ref(entry->batch);
+	}
+
+	if (ret != NULL)
+	{
+		*ret = entry->ret;
+	}
+
+	if (user_data != NULL)
+	{
+		*user_data = entry->user_data;
+	}
+
+	j_completion_queue_entry_free(entry);
+}
+
+/**
+ * Creates a new completion queue.
+ *
+ * \code
+ * JCompletionQueue* queue;
+ *
+ * queue = j_completion_queue_new();
+ * \endcode
+ *
+ * \return A new completion queue. Should be freed with j_completion_queue_unref().
+ **/
+JCompletionQueue*
+j_completion_queue_new(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueue* queue;
+
+	queue = g_slice_new(JCompletionQueue);
+	queue->completions = g_async_queue_new_full(j_completion_queue_entry_free);
+	queue->outstanding = 0;
+	queue->ref_count = 1;
+
+	return queue;
+}
+
+/**
+ * Increases a completion queue's reference count.
+ *
+ * \code
+ * \endcode
+ *
+ * \param queue A completion queue.
+ *
+ * \return #queue.
+ **/
+JCompletionQueue*
+j_completion_queue_ref(JCompletionQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(queue != NULL, NULL);
+
+	g_atomic_int_inc(&(queue->ref_count));
+
+	return queue;
+}
+
+/**
+ * Decreases a completion queue's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the completion queue.
+ * Batches that are still executing keep the completion queue alive.
+ *
+ * \code
+ * \endcode
+ *
+ * \param queue A completion queue.
+ **/
+void
+j_completion_queue_unref(JCompletionQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(queue != NULL);
+
+	if (g_atomic_int_dec_and_test(&(queue->ref_count)))
+	{
+		g_async_queue_unref(queue->completions);
+
+		g_slice_free(JCompletionQueue, queue);
+	}
+}
+
+/**
+ * Submits a batch for execution.
+ * Batches submitted to the same completion queue may be executed concurrently and complete in any order.
+ * At most completion-queue-threads batches are sent at the same time across all completion queues, further batches wait until a thread becomes available.
+ * Batches waiting for coalesced replies do not occupy a thread.
+ *
+ * \code
+ * \endcode
+ *
+ * \param queue     A completion queue.
+ * \param batch     A batch.
+ * \param user_data User data that is returned together with the completion.
+ **/
+void
+j_completion_queue_submit(JCompletionQueue* queue, JBatch* batch, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueueEntry* entry;
+
+	g_return_if_fail(queue != NULL);
+	g_return_if_fail(batch != NULL);
+
+	entry = g_slice_new(JCompletionQueueEntry);
+	entry->queue = j_completion_queue_ref(queue);
+	entry->batch = j_batch_ref(batch);
+	entry->ret = FALSE;
+	entry->failed = 0;
+	entry->pending = 1;
+	entry->user_data = user_data;
+
+	g_atomic_int_inc(&(queue->outstanding));
+
+	g_mutex_lock(&j_completion_queue_running_mutex);
+	j_completion_queue_running++;
+	g_mutex_unlock(&j_completion_queue_running_mutex);
+
+	g_thread_pool_push(j_completion_queue_get_pool(), entry, NULL);
+}
+
+/**
+ * Retrieves a completed batch without blocking.
+ *
+ * \code
+ * JBatch* batch;
+ * gboolean ret;
+ *
+ * while (j_completion_queue_poll(queue, &batch, &ret, NULL))
+ * {
+ *   j_batch_unref(batch);
+ * }
+ * \endcode
+ *
+ * \param queue     A completion queue.
+ * \param batch     Returns the batch, may be NULL. Should be freed with j_batch_unref().
+ * \param ret       Returns the batch's result, may be NULL.
+ * \param user_data Returns the user data given to j_completion_queue_submit(), may be NULL.
+ *
+ * \return TRUE if a completed batch has been retrieved, FALSE otherwise.
+ **/
+gboolean
+j_completion_queue_poll(JCompletionQueue* queue, JBatch** batch, gboolean* ret, gpointer* user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueueEntry* entry;
+
+	g_return_val_if_fail(queue != NULL, FALSE);
+
+	entry = g_async_queue_try_pop(queue->completions);
+
+	if (entry == NULL)
+	{
+		return FALSE;
+	}
+
+	j_completion_queue_take(queue, entry, batch, ret, user_data);
+
+	return TRUE;
+}
+
+/**
+ * Waits for a batch to complete.
+ *
+ * \code
+ * \endcode
+ *
+ * \param queue     A completion queue.
+ * \param batch     Returns the batch, may be NULL. Should be freed with j_batch_unref().
+ * \param ret       Returns the batch's result, may be NULL.
+ * \param user_data Returns the user data given to j_completion_queue_submit(), may be NULL.
+ *
+ * \return TRUE if a completed batch has been retrieved, FALSE if there are no outstanding batches.
+ **/
+gboolean
+j_completion_queue_wait(JCompletionQueue* queue, JBatch** batch, gboolean* ret, gpointer* user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JCompletionQueueEntry* entry;
+
+	g_return_val_if_fail(queue != NULL, FALSE);
+
+	if (g_atomic_int_get(&(queue->outstanding)) == 0)
+	{
+		return FALSE;
+	}
+
+	entry = g_async_queue_pop(queue->completions);
+	j_completion_queue_take(queue, entry, batch, ret, user_data);
+
+	return TRUE;
+}
+
+/**
+ * Returns the number of batches that have been submitted but not retrieved yet.
+ *
+ * \code
+ * \endcode
+ *
+ * \param queue A completion queue.
+ *
+ * \return The number of outstanding batches.
+ **/
+guint
+j_completion_queue_get_outstanding(JCompletionQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(queue != NULL, 0);
+
+	return g_atomic_int_get(&(queue->outstanding));
+}
+
+/**
+ * Shuts down completion queues.
+ * Waits for all submitted batches to complete because they use the connection pool.
+ *
+ * \private
+ **/
+void
+j_completion_queue_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (j_completion_queue_pool == NULL)
+	{
+		return;
+	}
+
+	// Batches are only handed to the event loop by the pool's threads, so no further connections are added afterwards.
+	g_thread_pool_free(j_completion_queue_pool, FALSE, TRUE);
+	j_completion_queue_pool = NULL;
+
+	g_mutex_lock(&j_completion_queue_running_mutex);
+
+	while (j_completion_queue_running > 0)
+	{
+		g_cond_wait(&j_completion_queue_running_cond, &j_completion_queue_running_mutex);
+	}
+
+	g_mutex_unlock(&j_completion_queue_running_mutex);
+
+	g_main_loop_quit(j_completion_queue_loop);
+	g_thread_join(j_completion_queue_thread);
+	g_main_loop_unref(j_completion_queue_loop);
+
+	j_completion_queue_thread = NULL;
+	j_completion_queue_loop = NULL;
+}
+
+/**
+ * @}
+ **/
@@ -142,6 +142,112 @@ struct JConfiguration
 	guint32 max_connections;
 	guint64 stripe_size;
 
+	/**
+	 * The size of the server's write-back buffer.
+	 */
+	guint64 write_back_size;
+
+	/**
+	 * The number of threads flushing the server's write-back buffer.
+	 */
+	guint32 write_back_threads;
+
+	/**
+	 * Whether clients should let servers coalesce replies, always FALSE if connections are multiplexed.
+	 */
+	gboolean coalesce_replies;
+
+	/**
+	 * The time in microseconds after which servers send coalesced replies.
+	 */
+	guint64 reply_window;
+
+	/**
+	 * The number of replies after which servers send coalesced replies.
+	 */
+	guint32 reply_count;
+
+	/**
+	 * The number of connections per server that are shared by all threads, 0 disables multiplexing.
+	 * Multiplexing disables reply coalescing.
+	 */
+	guint32 multiplex_connections;
+
+	/**
+	 * The number of connections per server that are established during initialization.
+	 */
+	guint32 prewarm_connections;
+
+	/**
+	 * The number of attempts to connect to a server.
+	 */
+	guint32 connect_attempts;
+
+	/**
+	 * The number of connections large transfers to a single server are striped across, 0 disables striping.
+	 */
+	guint32 stripe_streams;
+
+	/**
+	 * The minimum size of a transfer to be striped.
+	 */
+	guint64 stripe_threshold;
+
+	/**
+	 * The size of the client's operation cache.
+	 */
+	guint64 operation_cache_size;
+
+	/**
+	 * The number of threads flushing the client's operation cache.
+	 */
+	guint32 operation_cache_threads;
+
+	/**
+	 * The maximum size of the server's buffer pool.
+	 */
+	guint64 buffer_pool_size;
+
+	/**
+	 * Whether the server's buffer pool should use huge pages.
+	 */
+	gboolean buffer_pool_hugepages;
+
+	/**
+	 * Whether the server's buffer pool should be locked into memory.
+	 */
+	gboolean buffer_pool_lock;
+
+	/**
+	 * The maximum size of the client's object block cache, 0 disables it.
+	 */
+	guint64 object_cache_size;
+
+	/**
+	 * The time in milliseconds cached blocks stay valid for eventual consistency.
+	 */
+	guint32 object_cache_ttl;
+
+	/**
+	 * The maximum size of the read-ahead window for sequential object reads.
+	 */
+	guint64 object_readahead_size;
+
+	/**
+	 * The size of the client's per-object write buffers, 0 disables them.
+	 */
+	guint64 object_write_buffer_size;
+
+	/**
+	 * The time in milliseconds after which buffered writes are sent.
+	 */
+	guint64 object_write_buffer_interval;
+
+	/**
+	 * The number of threads executing batches submitted to completion queues.
+	 */
+	guint32 completion_queue_threads;
+
 	/**
 	 * The reference count.
 	 */
@@ -285,12 +391,54 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	guint64 max_operation_size;
 	guint32 max_connections;
 	guint64 stripe_size;
+	guint64 write_back_size;
+	guint32 write_back_threads;
+	gboolean coalesce_replies;
+	guint64 reply_window;
+	guint32 reply_count;
+	guint32 multiplex_connections;
+	guint32 prewarm_connections;
+	guint32 connect_attempts;
+	guint32 stripe_streams;
+	guint64 stripe_threshold;
+	guint64 operation_cache_size;
+	guint32 operation_cache_threads;
+	guint64 buffer_pool_size;
+	gboolean buffer_pool_hugepages;
+	gboolean buffer_pool_lock;
+	guint64 object_cache_size;
+	guint32 object_cache_ttl;
+	guint64 object_readahead_size;
+	guint64 object_write_buffer_size;
+	guint64 object_write_buffer_interval;
+	guint32 completion_queue_threads;
 
 	g_return_val_if_fail(key_file != NULL, FALSE);
 
 	max_operation_size = g_key_file_get_uint64(key_file, "core", "max-operation-size", NULL);
 	max_connections = g_key_file_get_integer(key_file, "clients", "max-connections", NULL);
 	stripe_size = g_key_file_get_uint64(key_file, "clients", "stripe-size", NULL);
+	write_back_size = g_key_file_get_uint64(key_file, "object", "write-back-size", NULL);
+	write_back_threads = g_key_file_get_integer(key_file, "object", "write-back-threads", NULL);
+	coalesce_replies = g_key_file_get_boolean(key_file, "clients", "coalesce-replies", NULL);
+	reply_window = g_key_file_get_uint64(key_file, "core", "reply-window", NULL);
+	reply_count = g_key_file_get_integer(key_file, "core", "reply-count", NULL);
+	multiplex_connections = g_key_file_get_integer(key_file, "clients", "multiplex-connections", NULL);
+	prewarm_connections = g_key_file_get_integer(key_file, "clients", "prewarm-connections", NULL);
+	connect_attempts = g_key_file_get_integer(key_file, "clients", "connect-attempts", NULL);
+	stripe_streams = g_key_file_get_integer(key_file, "clients", "stripe-streams", NULL);
+	stripe_threshold = g_key_file_get_uint64(key_file, "clients", "stripe-threshold", NULL);
+	operation_cache_size = g_key_file_get_uint64(key_file, "clients", "operation-cache-size", NULL);
+	operation_cache_threads = g_key_file_get_integer(key_file, "clients", "operation-cache-threads", NULL);
+	buffer_pool_size = g_key_file_get_uint64(key_file, "object", "buffer-pool-size", NULL);
+	buffer_pool_hugepages = g_key_file_get_boolean(key_file, "object", "buffer-pool-hugepages", NULL);
+	buffer_pool_lock = g_key_file_get_boolean(key_file, "object", "buffer-pool-lock", NULL);
+	object_cache_size = g_key_file_get_uint64(key_file, "clients", "object-cache-size", NULL);
+	object_cache_ttl = g_key_file_get_integer(key_file, "clients", "object-cache-ttl", NULL);
+	object_readahead_size = g_key_file_get_uint64(key_file, "clients", "object-readahead-size", NULL);
+	object_write_buffer_size = g_key_file_get_uint64(key_file, "clients", "object-write-buffer-size", NULL);
+	object_write_buffer_interval = g_key_file_get_uint64(key_file, "clients", "object-write-buffer-interval", NULL);
+	completion_queue_threads = g_key_file_get_integer(key_file, "clients", "completion-queue-threads", NULL);
 	servers_object = g_key_file_get_string_list(key_file, "servers", "object", NULL, NULL);
 	servers_kv = g_key_file_get_string_list(key_file, "servers", "kv", NULL, NULL);
 	servers_db = g_key_file_get_string_list(key_file, "servers", "db", NULL, NULL);
@@ -352,6 +500,27 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	configuration->max_operation_size = max_operation_size;
 	configuration->max_connections = max_connections;
 	configuration->stripe_size = stripe_size;
+	configuration->write_back_size = write_back_size;
+	configuration->write_back_threads = write_back_threads;
+	configuration->coalesce_replies = coalesce_replies;
+	configuration->reply_window = reply_window;
+	configuration->reply_count = reply_count;
+	configuration->multiplex_connections = multiplex_connections;
+	configuration->prewarm_connections = prewarm_connections;
+	configuration->connect_attempts = connect_attempts;
+	configuration->stripe_streams = stripe_streams;
+	configuration->stripe_threshold = stripe_threshold;
+	configuration->operation_cache_size = operation_cache_size;
+	configuration->operation_cache_threads = operation_cache_threads;
+	configuration->buffer_pool_size = buffer_pool_size;
+	configuration->buffer_pool_hugepages = buffer_pool_hugepages;
+	configuration->buffer_pool_lock = buffer_pool_lock;
+	configuration->object_cache_size = object_cache_size;
+	configuration->object_cache_ttl = object_cache_ttl;
+	configuration->object_readahead_size = object_readahead_size;
+	configuration->object_write_buffer_size = object_write_buffer_size;
+	configuration->object_write_buffer_interval = object_write_buffer_interval;
+	configuration->completion_queue_threads = completion_queue_threads;
 	configuration->ref_count = 1;
 
 	if (configuration->max_operation_size == 0)
@@ -369,6 +538,73 @@ j_configuration_new_for_data(GKeyFile* key_file)
 		configuration->stripe_size = 4 * 1024 * 1024;
 	}
 
+	if (configuration->write_back_threads == 0)
+	{
+		configuration->write_back_threads = 2;
+	}
+
+	if (configuration->reply_window == 0)
+	{
+		configuration->reply_window = 1000;
+	}
+
+	if (configuration->reply_count == 0)
+	{
+		configuration->reply_count = 64;
+	}
+
+	// Coalesced replies can not be assigned to their messages on shared connections.
+	// Multiplexing therefore takes precedence and silently disables reply coalescing.
+	if (configuration->multiplex_connections > 0)
+	{
+		configuration->coalesce_replies = FALSE;
+	}
+
+	if (configuration->connect_attempts == 0)
+	{
+		configuration->connect_attempts = 5;
+	}
+
+	if (configuration->stripe_threshold == 0)
+	{
+		configuration->stripe_threshold = 64 * 1024 * 1024;
+	}
+
+	if (configuration->operation_cache_size == 0)
+	{
+		configuration->operation_cache_size = 50 * 1024 * 1024;
+	}
+
+	if (configuration->operation_cache_threads == 0)
+	{
+		configuration->operation_cache_threads = 1;
+	}
+
+	if (configuration->buffer_pool_size == 0)
+	{
+		configuration->buffer_pool_size = 1024 * 1024 * 1024;
+	}
+
+	if (configuration->object_cache_ttl == 0)
+	{
+		configuration->object_cache_ttl = 1000;
+	}
+
+	if (configuration->object_readahead_size == 0)
+	{
+		configuration->object_readahead_size = 4 * 1024 * 1024;
+	}
+
+	if (configuration->object_write_buffer_interval == 0)
+	{
+		configuration->object_write_buffer_interval = 100;
+	}
+
+	if (configuration->completion_queue_threads == 0)
+	{
+		configuration->completion_queue_threads = g_get_num_processors();
+	}
+
 	return configuration;
 }
 
@@ -578,6 +814,216 @@ j_configuration_get_stripe_size(JConfiguration* configuration)
 	return configuration->stripe_size;
 }
 
+guint64
+j_configuration_get_write_back_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->write_back_size;
+}
+
+guint32
+j_configuration_get_write_back_threads(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->write_back_threads;
+}
+
+gboolean
+j_configuration_get_coalesce_replies(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->coalesce_replies;
+}
+
+guint64
+j_configuration_get_reply_window(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->reply_window;
+}
+
+guint32
+j_configuration_get_reply_count(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->reply_count;
+}
+
+guint32
+j_configuration_get_multiplex_connections(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->multiplex_connections;
+}
+
+guint32
+j_configuration_get_prewarm_connections(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->prewarm_connections;
+}
+
+guint32
+j_configuration_get_connect_attempts(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->connect_attempts;
+}
+
+guint32
+j_configuration_get_stripe_streams(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->stripe_streams;
+}
+
+guint64
+j_configuration_get_stripe_threshold(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->stripe_threshold;
+}
+
+guint64
+j_configuration_get_operation_cache_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->operation_cache_size;
+}
+
+guint32
+j_configuration_get_operation_cache_threads(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->operation_cache_threads;
+}
+
+guint64
+j_configuration_get_buffer_pool_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->buffer_pool_size;
+}
+
+gboolean
+j_configuration_get_buffer_pool_hugepages(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->buffer_pool_hugepages;
+}
+
+gboolean
+j_configuration_get_buffer_pool_lock(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->buffer_pool_lock;
+}
+
+guint64
+j_configuration_get_object_cache_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object_cache_size;
+}
+
+guint32
+j_configuration_get_object_cache_ttl(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object_cache_ttl;
+}
+
+guint64
+j_configuration_get_object_readahead_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object_readahead_size;
+}
+
+guint64
+j_configuration_get_object_write_buffer_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object_write_buffer_size;
+}
+
+guint64
+j_configuration_get_object_write_buffer_interval(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->object_write_buffer_interval;
+}
+
+guint32
+j_configuration_get_completion_queue_threads(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->completion_queue_threads;
+}
+
 /**
  * @}
  **/
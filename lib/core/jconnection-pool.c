@@ -43,10 +43,29 @@
  * @{
  **/
 
+/**
+ * The time in microseconds a cached connection can be idle before it is checked again.
+ **/
+#define J_CONNECTION_POOL_CHECK_IDLE G_USEC_PER_SEC
+
 struct JConnectionPoolQueue
 {
 	GAsyncQueue* queue;
+	/** The backend type. **/
+	JBackendType type;
 	guint count;
+	/** The number of threads waiting for a connection. **/
+	gint waiting;
+	/** The number of idle connections in the per-thread caches. **/
+	gint cached;
+	/** The shared connections, only used if multiplexing is enabled. **/
+	GSocketConnection** shared;
+	/** The index of the next shared connection to use. **/
+	guint shared_next;
+	/** The mutex protecting #shared. **/
+	GMutex shared_mutex;
+	/** The queue's slot in the per-thread caches. **/
+	guint slot;
 };
 
 typedef struct JConnectionPoolQueue JConnectionPoolQueue;
@@ -64,18 +83,614 @@ struct JConnectionPool
 	guint kv_len;
 	guint db_len;
 	guint max_count;
+	guint shared_count;
+	guint connect_attempts;
+	/** The per-thread caches, contains JConnectionPoolCache elements. **/
+	GPtrArray* caches;
+	/** The number of connections established. **/
+	guint statistics_created;
+	/** The number of connections taken from the current thread's cache. **/
+	guint statistics_cached;
+	/** The number of connections taken from other threads' caches. **/
+	guint statistics_stolen;
+	/** The number of times a thread had to wait for a connection. **/
+	guint statistics_waited;
 };
 
 typedef struct JConnectionPool JConnectionPool;
 
+/**
+ * A per-thread cache holding at most one idle connection per server.
+ * Other threads can steal connections from it if they run out of connections.
+ **/
+struct JConnectionPoolCache
+{
+	/** The cached connections, indexed by the queues' slots. **/
+	GSocketConnection** connections;
+	/** The times the connections have been cached, only accessed by the owning thread. **/
+	gint64* times;
+	/** Whether the cache belongs to a running thread. **/
+	gint owned;
+};
+
+typedef struct JConnectionPoolCache JConnectionPoolCache;
+
+/**
+ * The cache of the current thread.
+ * Caches belong to the pool, so this has to be invalidated if the pool is reinitialized.
+ **/
+struct JConnectionPoolThread
+{
+	/** The pool generation the cache belongs to. **/
+	guint generation;
+	/** The cache. **/
+	JConnectionPoolCache* cache;
+};
+
+typedef struct JConnectionPoolThread JConnectionPoolThread;
+
+/**
+ * A connection that still has outstanding deferred replies.
+ **/
+struct JConnectionPoolHeld
+{
+	/** The backend type. **/
+	JBackendType backend;
+	/** The server index. **/
+	guint index;
+	/** The connection. **/
+	GSocketConnection* connection;
+};
+
+typedef struct JConnectionPoolHeld JConnectionPoolHeld;
+
+/**
+ * A connection to establish during initialization.
+ **/
+struct JConnectionPoolPrewarm
+{
+	/** The server. **/
+	gchar const* server;
+	/** The backend type. **/
+	JBackendType type;
+	/** The number of connection attempts. **/
+	guint attempts;
+	/** The established connection, NULL on failure. **/
+	GSocketConnection* connection;
+};
+
+typedef struct JConnectionPoolPrewarm JConnectionPoolPrewarm;
+
 static JConnectionPool* j_connection_pool = NULL;
 
+/**
+ * Connections with deferred replies are kept by the thread that sent the messages.
+ * This preserves the order of operations on the same server.
+ **/
+static GPrivate j_connection_pool_held = G_PRIVATE_INIT(NULL);
+
+static void j_connection_pool_thread_free(gpointer);
+
+static GPrivate j_connection_pool_thread = G_PRIVATE_INIT(j_connection_pool_thread_free);
+
+/**
+ * Protects the list of caches and the generation.
+ **/
+G_LOCK_DEFINE_STATIC(j_connection_pool_caches);
+
+static guint j_connection_pool_generation = 0;
+
+/**
+ * Sends a PING to a connection and returns the state of the server's backends.
+ *
+ * \private
+ *
+ * \param connection A connection.
+ * \param states     Returns the backends' states, indexed by backend type.
+ *
+ * \return TRUE if the server replied, FALSE otherwise.
+ **/
+static gboolean
+j_connection_pool_ping(GSocketConnection* connection, JBackendState states[3])
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
+
+	guint op_count;
+
+	for (guint i = 0; i < 3; i++)
+	{
+		states[i] = J_BACKEND_STATE_UNKNOWN;
+	}
+
+	message = j_message_new(J_MESSAGE_PING, 0);
+
+	if (!j_message_send(message, connection))
+	{
+		return FALSE;
+	}
+
+	reply = j_message_new_reply(message);
+
+	if (!j_message_receive(reply, connection))
+	{
+		return FALSE;
+	}
+
+	op_count = j_message_get_count(reply);
+
+	for (guint i = 0; i < op_count; i++)
+	{
+		gchar const* backend;
+		JBackendState state;
+
+		// Servers accept connections while still initializing their backends, operations are delayed until the backend is ready.
+		backend = j_message_get_string(reply);
+		state = j_message_get_4(reply);
+
+		if (state != J_BACKEND_STATE_INITIALIZING && state != J_BACKEND_STATE_READY && state != J_BACKEND_STATE_FAILED)
+		{
+			state = J_BACKEND_STATE_UNKNOWN;
+		}
+
+		if (g_strcmp0(backend, "object") == 0)
+		{
+			states[J_BACKEND_TYPE_OBJECT] = state;
+		}
+		else if (g_strcmp0(backend, "kv") == 0)
+		{
+			states[J_BACKEND_TYPE_KV] = state;
+		}
+		else if (g_strcmp0(backend, "db") == 0)
+		{
+			states[J_BACKEND_TYPE_DB] = state;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Sends a PING to a newly established connection and checks the server's backends.
+ *
+ * \private
+ *
+ * \param connection A connection.
+ * \param type       The backend type the connection is used for.
+ *
+ * \return TRUE if the server replied and its backend has not failed, FALSE otherwise.
+ **/
+static gboolean
+j_connection_pool_handshake(GSocketConnection* connection, JBackendType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendState states[3];
+
+	j_helper_set_nodelay(connection, TRUE);
+
+	if (!j_connection_pool_ping(connection, states))
+	{
+		return FALSE;
+	}
+
+	// Backends that are still initializing can be used, their operations wait on the server.
+	if (states[type] == J_BACKEND_STATE_FAILED)
+	{
+		g_warning("Backend of type %d failed to initialize on the server.", type);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Connects to a server.
+ * Failed attempts are retried with an exponential backoff.
+ *
+ * \private
+ *
+ * \param server   A server.
+ * \param type     The backend type the connection is used for.
+ * \param attempts The number of attempts.
+ *
+ * \return A new connection, NULL if the server could not be reached.
+ **/
+static GSocketConnection*
+j_connection_pool_connect(gchar const* server, JBackendType type, guint attempts)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketClient) client = NULL;
+	gulong backoff = G_USEC_PER_SEC / 20;
+
+	client = g_socket_client_new();
+
+	for (guint i = 0; i < attempts; i++)
+	{
+		GSocketConnection* connection;
+		GError* error = NULL;
+
+		if (i > 0)
+		{
+			g_usleep(backoff);
+			backoff = MIN(backoff * 2, 2 * G_USEC_PER_SEC);
+		}
+
+		connection = g_socket_client_connect_to_host(client, server, 4711, NULL, &error);
+
+		if (error != NULL)
+		{
+			g_debug("Can not connect to %s (attempt %u of %u): %s", server, i + 1, attempts, error->message);
+			g_error_free(error);
+		}
+
+		if (connection == NULL)
+		{
+			continue;
+		}
+
+		if (j_connection_pool_handshake(connection, type))
+		{
+			return connection;
+		}
+
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
+	}
+
+	// Callers handle unreachable servers, erasure coded reads for instance reconstruct their blocks.
+	g_warning("Can not connect to %s after %u attempts.", server, attempts);
+
+	return NULL;
+}
+
+/**
+ * Checks whether an idle connection is still usable.
+ *
+ * \private
+ *
+ * \param connection An idle connection.
+ *
+ * \return TRUE if the connection is usable, FALSE otherwise.
+ **/
+static gboolean
+j_connection_pool_check(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocket* socket;
+
+	socket = g_socket_connection_get_socket(connection);
+
+	if (!g_socket_is_connected(socket))
+	{
+		return FALSE;
+	}
+
+	// Servers do not send anything on idle connections, so readability means the connection has been closed.
+	return (g_socket_condition_check(socket, G_IO_IN | G_IO_ERR | G_IO_HUP) == 0);
+}
+
+static void
+j_connection_pool_discard(GSocketConnection* connection, guint* count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_debug("Discarding broken connection.");
+
+	g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+	g_object_unref(connection);
+
+	g_atomic_int_add(count, -1);
+}
+
+static gpointer
+j_connection_pool_prewarm_func(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolPrewarm* prewarm = data;
+
+	prewarm->connection = j_connection_pool_connect(prewarm->server, prewarm->type, prewarm->attempts);
+
+	return prewarm;
+}
+
+/**
+ * Establishes connections to all servers in parallel.
+ *
+ * \private
+ *
+ * \param pool  A connection pool.
+ * \param count The number of connections per server.
+ **/
+static void
+j_connection_pool_prewarm(JConnectionPool* pool, guint count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendType const types[] = { J_BACKEND_TYPE_OBJECT, J_BACKEND_TYPE_KV, J_BACKEND_TYPE_DB };
+	JConnectionPoolQueue* const queues[] = { pool->object_queues, pool->kv_queues, pool->db_queues };
+	guint const lens[] = { pool->object_len, pool->kv_len, pool->db_len };
+
+	g_autofree JConnectionPoolPrewarm* prewarms = NULL;
+	g_autofree gpointer* data = NULL;
+	guint length = 0;
+	guint n = 0;
+
+	for (guint t = 0; t < G_N_ELEMENTS(types); t++)
+	{
+		length += lens[t] * count;
+	}
+
+	if (length == 0)
+	{
+		return;
+	}
+
+	prewarms = g_new(JConnectionPoolPrewarm, length);
+	data = g_new(gpointer, length);
+
+	for (guint t = 0; t < G_N_ELEMENTS(types); t++)
+	{
+		for (guint i = 0; i < lens[t]; i++)
+		{
+			for (guint j = 0; j < count; j++)
+			{
+				prewarms[n].server = j_configuration_get_server(pool->configuration, types[t], i);
+				prewarms[n].type = types[t];
+				prewarms[n].attempts = pool->connect_attempts;
+				prewarms[n].connection = NULL;
+				data[n] = &(prewarms[n]);
+				n++;
+			}
+		}
+	}
+
+	j_helper_execute_parallel(j_connection_pool_prewarm_func, data, length);
+
+	n = 0;
+
+	for (guint t = 0; t < G_N_ELEMENTS(types); t++)
+	{
+		for (guint i = 0; i < lens[t]; i++)
+		{
+			for (guint j = 0; j < count; j++)
+			{
+				JConnectionPoolQueue* queue = &(queues[t][i]);
+				GSocketConnection* connection = prewarms[n++].connection;
+
+				if (connection == NULL)
+				{
+					continue;
+				}
+
+				queue->count++;
+				pool->statistics_created++;
+
+				if (pool->shared_count > 0)
+				{
+					j_message_mux_start(connection);
+					queue->shared[j] = connection;
+				}
+				else
+				{
+					g_async_queue_push(queue->queue, connection);
+				}
+			}
+		}
+	}
+}
+
+static void
+j_connection_pool_queue_init(JConnectionPoolQueue* queue, JBackendType type, guint shared_count, guint slot)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	queue->queue = g_async_queue_new();
+	queue->type = type;
+	queue->slot = slot;
+	queue->count = 0;
+	queue->waiting = 0;
+	queue->cached = 0;
+	queue->shared = (shared_count > 0) ? g_new0(GSocketConnection*, shared_count) : NULL;
+	queue->shared_next = 0;
+	g_mutex_init(&(queue->shared_mutex));
+}
+
+static void
+j_connection_pool_queue_clear_shared(JConnectionPoolQueue* queue, guint shared_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < shared_count; i++)
+	{
+		GSocketConnection* connection = queue->shared[i];
+
+		if (connection == NULL)
+		{
+			continue;
+		}
+
+		j_message_mux_stop(connection);
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
+	}
+
+	g_free(queue->shared);
+	g_mutex_clear(&(queue->shared_mutex));
+}
+
+static void
+j_connection_pool_thread_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolThread* thread = data;
+
+	G_LOCK(j_connection_pool_caches);
+
+	// The cached connections remain available to other threads.
+	if (thread->generation == j_connection_pool_generation)
+	{
+		g_atomic_int_set(&(thread->cache->owned), FALSE);
+	}
+
+	G_UNLOCK(j_connection_pool_caches);
+
+	g_slice_free(JConnectionPoolThread, thread);
+}
+
+static void
+j_connection_pool_cache_free(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolCache* cache = data;
+	guint slot_count;
+
+	(void)user_data;
+
+	slot_count = j_connection_pool->object_len + j_connection_pool->kv_len + j_connection_pool->db_len;
+
+	for (guint i = 0; i < slot_count; i++)
+	{
+		if (cache->connections[i] != NULL)
+		{
+			g_io_stream_close(G_IO_STREAM(cache->connections[i]), NULL, NULL);
+			g_object_unref(cache->connections[i]);
+		}
+	}
+
+	g_free(cache->connections);
+	g_free(cache->times);
+	g_slice_free(JConnectionPoolCache, cache);
+}
+
+/**
+ * Returns the current thread's cache.
+ * Caches left behind by finished threads are reused.
+ *
+ * \private
+ *
+ * \return The cache.
+ **/
+static JConnectionPoolCache*
+j_connection_pool_get_cache(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolThread* thread;
+	JConnectionPoolCache* cache = NULL;
+
+	thread = g_private_get(&j_connection_pool_thread);
+
+	if (thread != NULL && thread->generation == (guint)g_atomic_int_get(&j_connection_pool_generation))
+	{
+		return thread->cache;
+	}
+
+	G_LOCK(j_connection_pool_caches);
+
+	for (guint i = 0; i < j_connection_pool->caches->len; i++)
+	{
+		JConnectionPoolCache* unowned = g_ptr_array_index(j_connection_pool->caches, i);
+
+		if (g_atomic_int_compare_and_exchange(&(unowned->owned), FALSE, TRUE))
+		{
+			cache = unowned;
+			break;
+		}
+	}
+
+	if (cache == NULL)
+	{
+		cache = g_slice_new(JConnectionPoolCache);
+		cache->connections = g_new0(GSocketConnection*, j_connection_pool->object_len + j_connection_pool->kv_len + j_connection_pool->db_len);
+		cache->times = g_new0(gint64, j_connection_pool->object_len + j_connection_pool->kv_len + j_connection_pool->db_len);
+		cache->owned = TRUE;
+
+		g_ptr_array_add(j_connection_pool->caches, cache);
+	}
+
+	if (thread == NULL)
+	{
+		thread = g_slice_new(JConnectionPoolThread);
+		g_private_set(&j_connection_pool_thread, thread);
+	}
+
+	thread->generation = j_connection_pool_generation;
+	thread->cache = cache;
+
+	G_UNLOCK(j_connection_pool_caches);
+
+	return cache;
+}
+
+static GSocketConnection*
+j_connection_pool_cache_take(JConnectionPoolCache* cache, JConnectionPoolQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocketConnection* connection;
+
+	do
+	{
+		connection = g_atomic_pointer_get(&(cache->connections[queue->slot]));
+	} while (connection != NULL && !g_atomic_pointer_compare_and_exchange(&(cache->connections[queue->slot]), connection, NULL));
+
+	if (connection != NULL)
+	{
+		g_atomic_int_add(&(queue->cached), -1);
+	}
+
+	return connection;
+}
+
+/**
+ * Steals an idle connection from another thread's cache.
+ * The caches are only searched if they contain idle connections for the queue, so that cache misses do not have to take the caches' lock.
+ *
+ * \private
+ *
+ * \param queue A connection queue.
+ *
+ * \return A connection, NULL if none is available.
+ **/
+static GSocketConnection*
+j_connection_pool_steal(JConnectionPoolQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocketConnection* connection = NULL;
+
+	if (g_atomic_int_get(&(queue->cached)) <= 0)
+	{
+		return NULL;
+	}
+
+	G_LOCK(j_connection_pool_caches);
+
+	for (guint i = 0; i < j_connection_pool->caches->len && connection == NULL; i++)
+	{
+		connection = j_connection_pool_cache_take(g_ptr_array_index(j_connection_pool->caches, i), queue);
+	}
+
+	G_UNLOCK(j_connection_pool_caches);
+
+	return connection;
+}
+
 void
 j_connection_pool_init(JConfiguration* configuration)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JConnectionPool* pool;
+	guint prewarm_count;
 
 	g_return_if_fail(j_connection_pool == NULL);
 
@@ -88,23 +703,34 @@ j_connection_pool_init(JConfiguration* configuration)
 	pool->db_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_DB);
 	pool->db_queues = g_new(JConnectionPoolQueue, pool->db_len);
 	pool->max_count = j_configuration_get_max_connections(configuration);
+	pool->shared_count = j_configuration_get_multiplex_connections(configuration);
+	pool->connect_attempts = j_configuration_get_connect_attempts(configuration);
+	pool->caches = g_ptr_array_new();
+	pool->statistics_created = 0;
+	pool->statistics_cached = 0;
+	pool->statistics_stolen = 0;
+	pool->statistics_waited = 0;
+	prewarm_count = j_configuration_get_prewarm_connections(configuration);
 
 	for (guint i = 0; i < pool->object_len; i++)
 	{
-		pool->object_queues[i].queue = g_async_queue_new();
-		pool->object_queues[i].count = 0;
+		j_connection_pool_queue_init(&(pool->object_queues[i]), J_BACKEND_TYPE_OBJECT, pool->shared_count, i);
 	}
 
 	for (guint i = 0; i < pool->kv_len; i++)
 	{
-		pool->kv_queues[i].queue = g_async_queue_new();
-		pool->kv_queues[i].count = 0;
+		j_connection_pool_queue_init(&(pool->kv_queues[i]), J_BACKEND_TYPE_KV, pool->shared_count, pool->object_len + i);
 	}
 
 	for (guint i = 0; i < pool->db_len; i++)
 	{
-		pool->db_queues[i].queue = g_async_queue_new();
-		pool->db_queues[i].count = 0;
+		j_connection_pool_queue_init(&(pool->db_queues[i]), J_BACKEND_TYPE_DB, pool->shared_count, pool->object_len + pool->kv_len + i);
+	}
+
+	if (prewarm_count > 0)
+	{
+		prewarm_count = MIN(prewarm_count, (pool->shared_count > 0) ? pool->shared_count : pool->max_count);
+		j_connection_pool_prewarm(pool, prewarm_count);
 	}
 
 	g_atomic_pointer_set(&j_connection_pool, pool);
@@ -120,6 +746,16 @@ j_connection_pool_fini(void)
 	g_return_if_fail(j_connection_pool != NULL);
 
 	pool = g_atomic_pointer_get(&j_connection_pool);
+
+	G_LOCK(j_connection_pool_caches);
+
+	// Invalidates all threads' references to the caches.
+	j_connection_pool_generation++;
+	g_ptr_array_foreach(pool->caches, j_connection_pool_cache_free, NULL);
+	g_ptr_array_unref(pool->caches);
+
+	G_UNLOCK(j_connection_pool_caches);
+
 	g_atomic_pointer_set(&j_connection_pool, NULL);
 
 	for (guint i = 0; i < pool->object_len; i++)
@@ -133,6 +769,7 @@ j_connection_pool_fini(void)
 		}
 
 		g_async_queue_unref(pool->object_queues[i].queue);
+		j_connection_pool_queue_clear_shared(&(pool->object_queues[i]), pool->shared_count);
 	}
 
 	for (guint i = 0; i < pool->kv_len; i++)
@@ -146,6 +783,7 @@ j_connection_pool_fini(void)
 		}
 
 		g_async_queue_unref(pool->kv_queues[i].queue);
+		j_connection_pool_queue_clear_shared(&(pool->kv_queues[i]), pool->shared_count);
 	}
 
 	for (guint i = 0; i < pool->db_len; i++)
@@ -159,6 +797,7 @@ j_connection_pool_fini(void)
 		}
 
 		g_async_queue_unref(pool->db_queues[i].queue);
+		j_connection_pool_queue_clear_shared(&(pool->db_queues[i]), pool->shared_count);
 	}
 
 	j_configuration_unref(pool->configuration);
@@ -171,103 +810,174 @@ j_connection_pool_fini(void)
 }
 
 static GSocketConnection*
-j_connection_pool_pop_internal(GAsyncQueue* queue, guint* count, gchar const* server)
+j_connection_pool_pop_internal(JConnectionPoolQueue* queue, gchar const* server)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JConnectionPoolCache* cache;
 	GSocketConnection* connection;
 
 	g_return_val_if_fail(queue != NULL, NULL);
-	g_return_val_if_fail(count != NULL, NULL);
 
-	connection = g_async_queue_try_pop(queue);
+	cache = j_connection_pool_get_cache();
+	connection = j_connection_pool_cache_take(cache, queue);
 
 	if (connection != NULL)
 	{
-		return connection;
+		// Checking requires a system call, connections that have just been used are assumed to be usable.
+		if (g_get_monotonic_time() - cache->times[queue->slot] < J_CONNECTION_POOL_CHECK_IDLE || j_connection_pool_check(connection))
+		{
+			g_atomic_int_inc(&(j_connection_pool->statistics_cached));
+			return connection;
+		}
+
+		j_connection_pool_discard(connection, &(queue->count));
 	}
 
-	if ((guint)g_atomic_int_get(count) < j_connection_pool->max_count)
+	while (TRUE)
 	{
-		if ((guint)g_atomic_int_add(count, 1) < j_connection_pool->max_count)
-		{
-			GError* error = NULL;
-			g_autoptr(GSocketClient) client = NULL;
-
-			g_autoptr(JMessage) message = NULL;
-			g_autoptr(JMessage) reply = NULL;
+		gboolean stolen = FALSE;
 
-			guint op_count;
+		// Idle connections are usually returned to the thread's own cache, so the shared queue is mostly empty.
+		connection = g_async_queue_try_pop(queue->queue);
 
-			client = g_socket_client_new();
-			connection = g_socket_client_connect_to_host(client, server, 4711, NULL, &error);
+		if (connection == NULL)
+		{
+			connection = j_connection_pool_steal(queue);
+			stolen = (connection != NULL);
+		}
 
-			if (error != NULL)
+		if (connection != NULL)
+		{
+			if (j_connection_pool_check(connection))
 			{
-				g_critical("%s", error->message);
-				g_error_free(error);
-			}
+				if (stolen)
+				{
+					g_atomic_int_inc(&(j_connection_pool->statistics_stolen));
+				}
 
-			if (connection == NULL)
-			{
-				g_critical("Can not connect to %s [%d].", server, g_atomic_int_get(count));
+				return connection;
 			}
 
-			j_helper_set_nodelay(connection, TRUE);
-
-			message = j_message_new(J_MESSAGE_PING, 0);
-			j_message_send(message, connection);
-
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, connection);
-
-			op_count = j_message_get_count(reply);
+			j_connection_pool_discard(connection, &(queue->count));
+			continue;
+		}
 
-			for (guint i = 0; i < op_count; i++)
+		if ((guint)g_atomic_int_get(&(queue->count)) < j_connection_pool->max_count)
+		{
+			if ((guint)g_atomic_int_add(&(queue->count), 1) < j_connection_pool->max_count)
 			{
-				gchar const* backend;
-
-				backend = j_message_get_string(reply);
+				connection = j_connection_pool_connect(server, queue->type, j_connection_pool->connect_attempts);
 
-				if (g_strcmp0(backend, "object") == 0)
-				{
-					//g_print("Server has object backend.\n");
-				}
-				else if (g_strcmp0(backend, "kv") == 0)
-				{
-					//g_print("Server has kv backend.\n");
-				}
-				else if (g_strcmp0(backend, "db") == 0)
+				if (connection != NULL)
 				{
-					//g_print("Server has db backend.\n");
+					g_atomic_int_inc(&(j_connection_pool->statistics_created));
+					return connection;
 				}
 			}
+
+			// Waiting for a connection would block forever if there are no other connections.
+			if (g_atomic_int_dec_and_test(&(queue->count)))
+			{
+				return NULL;
+			}
+		}
+
+		g_atomic_int_inc(&(j_connection_pool->statistics_waited));
+
+		// Connections might end up in other threads' caches while waiting, so check them periodically.
+		g_atomic_int_inc(&(queue->waiting));
+		connection = g_async_queue_timeout_pop(queue->queue, G_USEC_PER_SEC / 100);
+		g_atomic_int_add(&(queue->waiting), -1);
+
+		if (connection == NULL)
+		{
+			continue;
 		}
-		else
+
+		if (j_connection_pool_check(connection))
 		{
-			g_atomic_int_add(count, -1);
+			return connection;
 		}
+
+		j_connection_pool_discard(connection, &(queue->count));
 	}
+}
+
+/**
+ * Returns one of a server's shared connections.
+ * Connections are established on first use and handed out round-robin.
+ *
+ * \private
+ *
+ * \param queue  A connection queue.
+ * \param server A server.
+ *
+ * \return A multiplexed connection.
+ **/
+static GSocketConnection*
+j_connection_pool_pop_shared(JConnectionPoolQueue* queue, gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocketConnection* connection;
+	guint index;
+
+	g_return_val_if_fail(queue != NULL, NULL);
+
+	index = (guint)g_atomic_int_add(&(queue->shared_next), 1) % j_connection_pool->shared_count;
+	connection = g_atomic_pointer_get(&(queue->shared[index]));
 
 	if (connection != NULL)
 	{
 		return connection;
 	}
 
-	connection = g_async_queue_pop(queue);
+	g_mutex_lock(&(queue->shared_mutex));
+
+	connection = queue->shared[index];
+
+	if (connection == NULL)
+	{
+		connection = j_connection_pool_connect(server, queue->type, j_connection_pool->connect_attempts);
+
+		if (connection != NULL)
+		{
+			g_atomic_int_inc(&(queue->count));
+			g_atomic_int_inc(&(j_connection_pool->statistics_created));
+			j_message_mux_start(connection);
+			g_atomic_pointer_set(&(queue->shared[index]), connection);
+		}
+	}
+
+	g_mutex_unlock(&(queue->shared_mutex));
 
 	return connection;
 }
 
 static void
-j_connection_pool_push_internal(GAsyncQueue* queue, GSocketConnection* connection)
+j_connection_pool_push_internal(JConnectionPoolQueue* queue, GSocketConnection* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JConnectionPoolCache* cache;
+
 	g_return_if_fail(queue != NULL);
 	g_return_if_fail(connection != NULL);
 
-	g_async_queue_push(queue, connection);
+	cache = j_connection_pool_get_cache();
+
+	// Threads waiting for a connection are served first.
+	// The counter avoids taking the queue's lock, a thread starting to wait concurrently will steal the cached connection.
+	if (g_atomic_int_get(&(queue->waiting)) == 0 && g_atomic_pointer_compare_and_exchange(&(cache->connections[queue->slot]), NULL, connection))
+	{
+		// Only the current thread takes connections from its own cache without checking them.
+		cache->times[queue->slot] = g_get_monotonic_time();
+		g_atomic_int_inc(&(queue->cached));
+		return;
+	}
+
+	g_async_queue_push(queue->queue, connection);
 }
 
 gpointer
@@ -275,19 +985,56 @@ j_connection_pool_pop(JBackendType backend, guint index)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	GList* held;
+
 	g_return_val_if_fail(j_connection_pool != NULL, NULL);
 
+	held = g_private_get(&j_connection_pool_held);
+
+	for (GList* l = held; l != NULL; l = l->next)
+	{
+		JConnectionPoolHeld* entry = l->data;
+
+		if (entry->backend == backend && entry->index == index)
+		{
+			GSocketConnection* connection = entry->connection;
+
+			g_private_set(&j_connection_pool_held, g_list_delete_link(held, l));
+			g_slice_free(JConnectionPoolHeld, entry);
+
+			return connection;
+		}
+	}
+
 	switch (backend)
 	{
 		case J_BACKEND_TYPE_OBJECT:
 			g_return_val_if_fail(index < j_connection_pool->object_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->object_queues[index].queue, &(j_connection_pool->object_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_OBJECT, index));
+
+			if (j_connection_pool->shared_count > 0)
+			{
+				return j_connection_pool_pop_shared(&(j_connection_pool->object_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_OBJECT, index));
+			}
+
+			return j_connection_pool_pop_internal(&(j_connection_pool->object_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_OBJECT, index));
 		case J_BACKEND_TYPE_KV:
 			g_return_val_if_fail(index < j_connection_pool->kv_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->kv_queues[index].queue, &(j_connection_pool->kv_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_KV, index));
+
+			if (j_connection_pool->shared_count > 0)
+			{
+				return j_connection_pool_pop_shared(&(j_connection_pool->kv_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_KV, index));
+			}
+
+			return j_connection_pool_pop_internal(&(j_connection_pool->kv_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_KV, index));
 		case J_BACKEND_TYPE_DB:
 			g_return_val_if_fail(index < j_connection_pool->db_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->db_queues[index].queue, &(j_connection_pool->db_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_DB, index));
+
+			if (j_connection_pool->shared_count > 0)
+			{
+				return j_connection_pool_pop_shared(&(j_connection_pool->db_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_DB, index));
+			}
+
+			return j_connection_pool_pop_internal(&(j_connection_pool->db_queues[index]), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_DB, index));
 		default:
 			g_assert_not_reached();
 	}
@@ -303,25 +1050,199 @@ j_connection_pool_push(JBackendType backend, guint index, gpointer connection)
 	g_return_if_fail(j_connection_pool != NULL);
 	g_return_if_fail(connection != NULL);
 
+	// Shared connections stay with their queue and can be used by other threads all the time.
+	if (j_connection_pool->shared_count > 0)
+	{
+		return;
+	}
+
+	if (j_message_get_deferred_count(connection) > 0)
+	{
+		JConnectionPoolHeld* entry;
+
+		entry = g_slice_new(JConnectionPoolHeld);
+		entry->backend = backend;
+		entry->index = index;
+		entry->connection = connection;
+
+		g_private_set(&j_connection_pool_held, g_list_prepend(g_private_get(&j_connection_pool_held), entry));
+
+		return;
+	}
+
 	switch (backend)
 	{
 		case J_BACKEND_TYPE_OBJECT:
 			g_return_if_fail(index < j_connection_pool->object_len);
-			j_connection_pool_push_internal(j_connection_pool->object_queues[index].queue, connection);
+			j_connection_pool_push_internal(&(j_connection_pool->object_queues[index]), connection);
 			break;
 		case J_BACKEND_TYPE_KV:
 			g_return_if_fail(index < j_connection_pool->kv_len);
-			j_connection_pool_push_internal(j_connection_pool->kv_queues[index].queue, connection);
+			j_connection_pool_push_internal(&(j_connection_pool->kv_queues[index]), connection);
 			break;
 		case J_BACKEND_TYPE_DB:
 			g_return_if_fail(index < j_connection_pool->db_len);
-			j_connection_pool_push_internal(j_connection_pool->db_queues[index].queue, connection);
+			j_connection_pool_push_internal(&(j_connection_pool->db_queues[index]), connection);
 			break;
 		default:
 			g_assert_not_reached();
 	}
 }
 
+/**
+ * Returns connection pool statistics.
+ *
+ * \code
+ * guint64 created;
+ *
+ * created = j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_CREATED);
+ * \endcode
+ *
+ * \param type A statistics type.
+ *
+ * \return The statistics value.
+ **/
+guint64
+j_connection_pool_get_statistics(JConnectionPoolStatisticsType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(j_connection_pool != NULL, 0);
+
+	switch (type)
+	{
+		case J_CONNECTION_POOL_STATISTICS_CREATED:
+			return (guint)g_atomic_int_get(&(j_connection_pool->statistics_created));
+		case J_CONNECTION_POOL_STATISTICS_CACHED:
+			return (guint)g_atomic_int_get(&(j_connection_pool->statistics_cached));
+		case J_CONNECTION_POOL_STATISTICS_STOLEN:
+			return (guint)g_atomic_int_get(&(j_connection_pool->statistics_stolen));
+		case J_CONNECTION_POOL_STATISTICS_WAITED:
+			return (guint)g_atomic_int_get(&(j_connection_pool->statistics_waited));
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+/**
+ * Returns the state of a server's backend.
+ * Servers accept connections while their backends are still initializing, which allows using backends that are already ready.
+ *
+ * \code
+ * if (j_connection_pool_get_backend_state(J_BACKEND_TYPE_KV, 0) == J_BACKEND_STATE_READY)
+ * {
+ *   ...
+ * }
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ *
+ * \return The backend's state, J_BACKEND_STATE_UNKNOWN if the server could not be reached or does not handle the backend.
+ **/
+JBackendState
+j_connection_pool_get_backend_state(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendState states[3];
+	GSocketConnection* connection;
+	JBackendState state = J_BACKEND_STATE_UNKNOWN;
+
+	g_return_val_if_fail(j_connection_pool != NULL, J_BACKEND_STATE_UNKNOWN);
+	g_return_val_if_fail(backend == J_BACKEND_TYPE_OBJECT || backend == J_BACKEND_TYPE_KV || backend == J_BACKEND_TYPE_DB, J_BACKEND_STATE_UNKNOWN);
+
+	connection = j_connection_pool_pop(backend, index);
+
+	if (connection == NULL)
+	{
+		return J_BACKEND_STATE_UNKNOWN;
+	}
+
+	// Outstanding replies have to be received before the PING's reply.
+	if (j_message_get_deferred_count(connection) == 0 || j_message_receive_deferred(connection))
+	{
+		if (j_connection_pool_ping(connection, states))
+		{
+			state = states[backend];
+		}
+	}
+
+	j_connection_pool_push(backend, index, connection);
+
+	return state;
+}
+
+gboolean
+j_connection_pool_wait_deferred(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GList* held;
+	gboolean ret = TRUE;
+
+	held = g_private_get(&j_connection_pool_held);
+	g_private_set(&j_connection_pool_held, NULL);
+
+	for (GList* l = held; l != NULL; l = l->next)
+	{
+		JConnectionPoolHeld* entry = l->data;
+
+		ret = j_message_receive_deferred(entry->connection) && ret;
+		j_connection_pool_push(entry->backend, entry->index, entry->connection);
+
+		g_slice_free(JConnectionPoolHeld, entry);
+	}
+
+	g_list_free(held);
+
+	return ret;
+}
+
+/**
+ * Takes one of the connections with outstanding deferred replies kept by the calling thread.
+ * The caller has to receive the replies and return the connection using j_connection_pool_push().
+ *
+ * \private
+ *
+ * \param backend Returns the backend type.
+ * \param index   Returns the server index.
+ *
+ * \return A connection, NULL if the thread does not keep any connections.
+ **/
+gpointer
+j_connection_pool_take_held(JBackendType* backend, guint* index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolHeld* entry;
+	GList* held;
+	gpointer connection;
+
+	g_return_val_if_fail(backend != NULL, NULL);
+	g_return_val_if_fail(index != NULL, NULL);
+
+	held = g_private_get(&j_connection_pool_held);
+
+	if (held == NULL)
+	{
+		return NULL;
+	}
+
+	entry = held->data;
+	g_private_set(&j_connection_pool_held, g_list_delete_link(held, held));
+
+	*backend = entry->backend;
+	*index = entry->index;
+	connection = entry->connection;
+
+	g_slice_free(JConnectionPoolHeld, entry);
+
+	return connection;
+}
+
 /**
  * @}
  **/
@@ -58,13 +58,33 @@ struct JDistribution
 	 */
 	gpointer distribution;
 
+	/**
+	 * The server count.
+	 **/
+	guint server_count;
+
+	/**
+	 * The block size.
+	 **/
+	guint64 block_size;
+
+	/**
+	 * The configured stripe size, the smallest block size chosen for size hints.
+	 **/
+	guint64 stripe_size;
+
+	/**
+	 * The largest block size that can be transferred in one operation.
+	 **/
+	guint64 max_block_size;
+
 	/**
 	 * The reference count.
 	 **/
 	guint ref_count;
 };
 
-static JDistributionVTable j_distribution_vtables[3];
+static JDistributionVTable j_distribution_vtables[6];
 
 static JDistribution*
 j_distribution_new_common(JDistributionType type, JConfiguration* configuration)
@@ -81,6 +101,10 @@ j_distribution_new_common(JDistributionType type, JConfiguration* configuration)
 	distribution = g_slice_new(JDistribution);
 	distribution->type = type;
 	distribution->distribution = j_distribution_vtables[type].distribution_new(server_count, stripe_size);
+	distribution->server_count = server_count;
+	distribution->block_size = stripe_size;
+	distribution->stripe_size = stripe_size;
+	distribution->max_block_size = MAX(j_configuration_get_max_operation_size(configuration), stripe_size);
 	distribution->ref_count = 1;
 
 	return distribution;
@@ -176,6 +200,74 @@ j_distribution_set_block_size(JDistribution* distribution, guint64 block_size)
 	{
 		j_distribution_vtables[distribution->type].distribution_set(distribution->distribution, "block-size", block_size);
 	}
+
+	distribution->block_size = block_size;
+}
+
+/**
+ * Chooses the block size for the distribution based on the expected size of the data.
+ * Data that fits into one stripe per server is kept in a single block on a single server, so that it can be accessed using one message.
+ * Only larger data is spread across all servers, each one receiving one contiguous block if possible.
+ * The block size is rounded up to a power of two, is at least the configured stripe size and is limited by the maximum operation size.
+ * Should be called before the distribution is used for the first time.
+ *
+ * \code
+ * JDistribution* d;
+ *
+ * d = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+ * j_distribution_set_size_hint(d, 1024 * 1024 * 1024);
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param size         The expected size in bytes, 0 to keep the configured stripe size.
+ */
+void
+j_distribution_set_size_hint(JDistribution* distribution, guint64 size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 block;
+	guint64 block_size;
+
+	g_return_if_fail(distribution != NULL);
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	block = size;
+
+	if (size > distribution->stripe_size * distribution->server_count)
+	{
+		block = (size + distribution->server_count - 1) / distribution->server_count;
+	}
+
+	for (block_size = distribution->stripe_size; block_size < block && block_size < distribution->max_block_size; block_size *= 2)
+	{
+	}
+
+	j_distribution_set_block_size(distribution, MIN(block_size, distribution->max_block_size));
+}
+
+/**
+ * Returns the block size of the distribution.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return The block size.
+ */
+guint64
+j_distribution_get_block_size(JDistribution* distribution)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, 0);
+
+	return distribution->block_size;
 }
 
 /**
@@ -199,6 +291,11 @@ j_distribution_set(JDistribution* distribution, gchar const* key, guint64 value)
 	{
 		j_distribution_vtables[distribution->type].distribution_set(distribution->distribution, key, value);
 	}
+
+	if (g_strcmp0(key, "block-size") == 0 && value > 0)
+	{
+		distribution->block_size = value;
+	}
 }
 
 void
@@ -232,6 +329,7 @@ j_distribution_check_vtables(void)
 
 		g_return_if_fail(j_distribution_vtables[i].distribution_reset != NULL);
 		g_return_if_fail(j_distribution_vtables[i].distribution_distribute != NULL);
+		g_return_if_fail(j_distribution_vtables[i].distribution_get_period != NULL);
 	}
 }
 
@@ -243,6 +341,9 @@ j_distribution_init(void)
 	j_distribution_round_robin_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_ROUND_ROBIN]));
 	j_distribution_single_server_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_SINGLE_SERVER]));
 	j_distribution_weighted_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_WEIGHTED]));
+	j_distribution_consistent_hash_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_CONSISTENT_HASH]));
+	j_distribution_replicated_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_REPLICATED]));
+	j_distribution_erasure_get_vtable(&(j_distribution_vtables[J_DISTRIBUTION_ERASURE]));
 
 	j_distribution_check_vtables();
 }
@@ -296,6 +397,26 @@ j_distribution_new_for_configuration(JDistributionType type, JConfiguration* con
 	return distribution;
 }
 
+/**
+ * Returns a distribution's type.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return The type.
+ **/
+JDistributionType
+j_distribution_get_type(JDistribution* distribution)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, J_DISTRIBUTION_ROUND_ROBIN);
+
+	return distribution->type;
+}
+
 /**
  * Serializes distribution.
  *
@@ -320,7 +441,7 @@ j_distribution_serialize(JDistribution* distribution)
 	b = bson_new();
 
 	bson_append_int32(b, "type", -1, distribution->type);
-	//bson_append_int64(b, "BlockSize", -1, distribution->block_size);
+	// The block size is serialized by the actual distribution.
 
 	j_distribution_vtables[distribution->type].distribution_serialize(distribution->distribution, b);
 
@@ -346,10 +467,13 @@ j_distribution_deserialize(JDistribution* distribution, bson_t const* b)
 	J_TRACE_FUNCTION(NULL);
 
 	bson_iter_t iterator;
+	JDistributionType type;
 
 	g_return_if_fail(distribution != NULL);
 	g_return_if_fail(b != NULL);
 
+	type = distribution->type;
+
 	bson_iter_init(&iterator, b);
 
 	while (bson_iter_next(&iterator))
@@ -362,6 +486,17 @@ j_distribution_deserialize(JDistribution* distribution, bson_t const* b)
 		{
 			distribution->type = bson_iter_int32(&iterator);
 		}
+		else if (g_strcmp0(key, "block_size") == 0)
+		{
+			distribution->block_size = bson_iter_int64(&iterator);
+		}
+	}
+
+	// The actual distribution has to match the deserialized type.
+	if (distribution->type != type)
+	{
+		j_distribution_vtables[type].distribution_free(distribution->distribution);
+		distribution->distribution = j_distribution_vtables[distribution->type].distribution_new(distribution->server_count, j_configuration_get_stripe_size(j_configuration()));
 	}
 
 	j_distribution_vtables[distribution->type].distribution_deserialize(distribution->distribution, b);
@@ -417,6 +552,198 @@ j_distribution_distribute(JDistribution* distribution, guint* index, guint64* ne
 	return j_distribution_vtables[distribution->type].distribution_distribute(distribution->distribution, index, new_length, new_offset, block_id);
 }
 
+/**
+ * Returns the servers a distribution places data on.
+ * The servers are returned in the order of the blocks they store, that is, the first server stores the first block.
+ *
+ * \code
+ * g_autoptr(GArray) servers = NULL;
+ *
+ * servers = j_distribution_get_servers(distribution, 1024 * 1024);
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param length       A length, starting at offset 0.
+ *
+ * \return An array of server indices. Should be freed with g_array_unref().
+ **/
+GArray*
+j_distribution_get_servers(JDistribution* distribution, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GArray* servers;
+	g_autofree gboolean* used = NULL;
+	guint64 period;
+	guint replica_count;
+	guint data_blocks = 0;
+	guint parity_blocks = 0;
+	guint64 block_size;
+
+	g_return_val_if_fail(distribution != NULL, NULL);
+
+	servers = g_array_new(FALSE, FALSE, sizeof(guint));
+	used = g_new0(gboolean, distribution->server_count);
+
+	// Blocks are placed periodically, so there is no need to look at more than one period.
+	period = j_distribution_vtables[distribution->type].distribution_get_period(distribution->distribution);
+	replica_count = j_distribution_get_replica_count(distribution);
+	j_distribution_get_erasure_code(distribution, &data_blocks, &parity_blocks, &block_size);
+
+	j_distribution_reset(distribution, length, 0);
+
+	for (guint64 i = 0; i < period && servers->len < distribution->server_count; i++)
+	{
+		guint64 block_id;
+		guint64 new_length;
+		guint64 new_offset;
+		guint index;
+
+		if (!j_distribution_distribute(distribution, &index, &new_length, &new_offset, &block_id))
+		{
+			break;
+		}
+
+		if (!used[index])
+		{
+			used[index] = TRUE;
+			g_array_append_val(servers, index);
+		}
+
+		for (guint j = 1; j < replica_count; j++)
+		{
+			index = j_distribution_get_replica(distribution, block_id, j);
+
+			if (!used[index])
+			{
+				used[index] = TRUE;
+				g_array_append_val(servers, index);
+			}
+		}
+
+		for (guint j = 0; j < parity_blocks; j++)
+		{
+			index = j_distribution_get_stripe_server(distribution, block_id / data_blocks, data_blocks + j);
+
+			if (!used[index])
+			{
+				used[index] = TRUE;
+				g_array_append_val(servers, index);
+			}
+		}
+	}
+
+	return servers;
+}
+
+/**
+ * Returns the number of replicas a distribution stores of each block.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ *
+ * \return The number of replicas, 1 if the distribution does not replicate blocks.
+ **/
+guint
+j_distribution_get_replica_count(JDistribution* distribution)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, 1);
+
+	if (j_distribution_vtables[distribution->type].distribution_get_replica_count == NULL)
+	{
+		return 1;
+	}
+
+	return j_distribution_vtables[distribution->type].distribution_get_replica_count(distribution->distribution);
+}
+
+/**
+ * Returns the server storing a replica of a block.
+ * Replica 0 is stored on the server returned by j_distribution_distribute().
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param block_id     A block ID as returned by j_distribution_distribute().
+ * \param replica      A replica, smaller than j_distribution_get_replica_count().
+ *
+ * \return The server index.
+ **/
+guint
+j_distribution_get_replica(JDistribution* distribution, guint64 block_id, guint replica)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, 0);
+	g_return_val_if_fail(j_distribution_vtables[distribution->type].distribution_get_replica != NULL, 0);
+	g_return_val_if_fail(replica < j_distribution_get_replica_count(distribution), 0);
+
+	return j_distribution_vtables[distribution->type].distribution_get_replica(distribution->distribution, block_id, replica);
+}
+
+/**
+ * Returns the erasure code a distribution protects its blocks with.
+ * Every stripe of data_blocks consecutive blocks is protected by parity_blocks parity blocks of block_size bytes.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution  A distribution.
+ * \param data_blocks   Returns the number of data blocks per stripe.
+ * \param parity_blocks Returns the number of parity blocks per stripe.
+ * \param block_size    Returns the block size.
+ *
+ * \return TRUE if the distribution is erasure coded, FALSE otherwise.
+ **/
+gboolean
+j_distribution_get_erasure_code(JDistribution* distribution, guint* data_blocks, guint* parity_blocks, guint64* block_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, FALSE);
+	g_return_val_if_fail(data_blocks != NULL, FALSE);
+	g_return_val_if_fail(parity_blocks != NULL, FALSE);
+	g_return_val_if_fail(block_size != NULL, FALSE);
+
+	if (j_distribution_vtables[distribution->type].distribution_get_erasure_code == NULL)
+	{
+		return FALSE;
+	}
+
+	j_distribution_vtables[distribution->type].distribution_get_erasure_code(distribution->distribution, data_blocks, parity_blocks, block_size);
+
+	return TRUE;
+}
+
+/**
+ * Returns the server storing a block of a stripe.
+ * Positions below the number of data blocks refer to data blocks, the following ones to parity blocks.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param stripe       A stripe, that is, a block ID divided by the number of data blocks.
+ * \param position     A position within the stripe.
+ *
+ * \return The server index.
+ **/
+guint
+j_distribution_get_stripe_server(JDistribution* distribution, guint64 stripe, guint position)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(distribution != NULL, 0);
+	g_return_val_if_fail(j_distribution_vtables[distribution->type].distribution_get_stripe_server != NULL, 0);
+
+	return j_distribution_vtables[distribution->type].distribution_get_stripe_server(distribution->distribution, stripe, position);
+}
+
 /**
  * @}
  **/
@@ -120,7 +120,7 @@ j_helper_execute_parallel(JBackgroundOperationFunc func, gpointer* data, guint l
 	J_TRACE_FUNCTION(NULL);
 
 	JBackgroundOperation** operations;
-	guint data_count = 0;
+	guint first = length;
 
 	operations = g_new(JBackgroundOperation*, length);
 
@@ -128,33 +128,31 @@ j_helper_execute_parallel(JBackgroundOperationFunc func, gpointer* data, guint l
 	{
 		operations[i] = NULL;
 
-		if (data[i] != NULL)
+		if (data[i] != NULL && first == length)
 		{
-			data_count++;
+			first = i;
 		}
 	}
 
-	for (guint i = 0; i < length; i++)
+	// The calling thread executes the first share itself instead of only waiting.
+	for (guint i = first + 1; i < length; i++)
 	{
-		if (data[i] == NULL)
-		{
-			continue;
-		}
-
-		if (data_count > 1)
+		if (data[i] != NULL)
 		{
 			operations[i] = j_background_operation_new(func, data[i]);
 		}
-		else
-		{
-			data[i] = func(data[i]);
-		}
+	}
+
+	if (first < length)
+	{
+		data[first] = func(data[first]);
 	}
 
 	for (guint i = 0; i < length; i++)
 	{
 		if (operations[i] != NULL)
 		{
+			// Waiting executes operations that have not been picked up by a worker yet.
 			data[i] = j_background_operation_wait(operations[i]);
 			j_background_operation_unref(operations[i]);
 		}
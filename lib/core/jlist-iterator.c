@@ -27,7 +27,6 @@
 #include <jlist-iterator.h>
 
 #include <jlist.h>
-#include <jlist-internal.h>
 #include <jtrace.h>
 
 /**
@@ -45,13 +44,13 @@ struct JListIterator
 	 **/
 	JList* list;
 	/**
-	 * The current list element.
+	 * The current element.
 	 **/
-	JListElement* current;
+	gpointer current;
 	/**
-	 * Whether the current element is the first one.
+	 * The index of the next element.
 	 **/
-	gboolean first;
+	guint index;
 };
 
 /**
@@ -75,8 +74,8 @@ j_list_iterator_new(JList* list)
 
 	iterator = g_slice_new(JListIterator);
 	iterator->list = j_list_ref(list);
-	iterator->current = j_list_head(iterator->list);
-	iterator->first = TRUE;
+	iterator->current = NULL;
+	iterator->index = 0;
 
 	return iterator;
 }
@@ -118,13 +117,11 @@ j_list_iterator_next(JListIterator* iterator)
 
 	g_return_val_if_fail(iterator != NULL, FALSE);
 
-	if (G_UNLIKELY(iterator->first))
-	{
-		iterator->first = FALSE;
-	}
-	else
+	iterator->current = j_list_get_nth(iterator->list, iterator->index);
+
+	if (iterator->current != NULL)
 	{
-		iterator->current = iterator->current->next;
+		iterator->index++;
 	}
 
 	return (iterator->current != NULL);
@@ -148,7 +145,7 @@ j_list_iterator_get(JListIterator* iterator)
 	g_return_val_if_fail(iterator != NULL, NULL);
 	g_return_val_if_fail(iterator->current != NULL, NULL);
 
-	return iterator->current->data;
+	return iterator->current;
 }
 
 /**
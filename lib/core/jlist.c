@@ -24,8 +24,9 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <jlist.h>
-#include <jlist-internal.h>
 
 #include <jtrace.h>
 
@@ -34,26 +35,41 @@
  * @{
  **/
 
+enum
+{
+	/**
+	 * The number of elements allocated when the first element is added.
+	 **/
+	J_LIST_INITIAL_CAPACITY = 8
+};
+
 /**
- * A linked list which allows fast prepend and append operations.
+ * A list stored in a contiguous, growable array.
+ * Prepending and appending are amortized constant, iterating does not have to chase pointers.
  * Also allows querying the length of the list without iterating over it.
  **/
 struct JList
 {
 	/**
-	 * The first element.
+	 * The elements.
 	 **/
-	JListElement* head;
+	gpointer* elements;
+
 	/**
-	 * The last element.
+	 * The index of the first element within #elements.
 	 **/
-	JListElement* tail;
+	guint offset;
 
 	/**
 	 * The length.
 	 **/
 	guint length;
 
+	/**
+	 * The number of allocated elements.
+	 **/
+	guint capacity;
+
 	/**
 	 * The function used to free the list elements.
 	 **/
@@ -65,6 +81,62 @@ struct JList
 	gint ref_count;
 };
 
+/**
+ * Makes sure there is space for at least one more element at the end.
+ *
+ * \private
+ *
+ * \param list A list.
+ **/
+static void
+j_list_grow(JList* list)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (list->offset + list->length < list->capacity)
+	{
+		return;
+	}
+
+	list->capacity = (list->capacity == 0) ? J_LIST_INITIAL_CAPACITY : list->capacity * 2;
+	list->elements = g_renew(gpointer, list->elements, list->capacity);
+}
+
+/**
+ * Makes sure there is space for at least one more element at the beginning.
+ *
+ * \private
+ *
+ * \param list A list.
+ **/
+static void
+j_list_grow_front(JList* list)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer* elements;
+	guint extra;
+
+	if (list->offset > 0)
+	{
+		return;
+	}
+
+	extra = MAX(list->capacity, J_LIST_INITIAL_CAPACITY);
+	elements = g_new(gpointer, list->capacity + extra);
+
+	if (list->length > 0)
+	{
+		memcpy(elements + extra, list->elements, list->length * sizeof(gpointer));
+	}
+
+	g_free(list->elements);
+
+	list->elements = elements;
+	list->offset = extra;
+	list->capacity += extra;
+}
+
 /**
  * Creates a new list.
  *
@@ -83,9 +155,10 @@ j_list_new(JListFreeFunc free_func)
 	JList* list;
 
 	list = g_slice_new(JList);
-	list->head = NULL;
-	list->tail = NULL;
+	list->elements = NULL;
+	list->offset = 0;
 	list->length = 0;
+	list->capacity = 0;
 	list->free_func = free_func;
 	list->ref_count = 1;
 
@@ -131,6 +204,7 @@ j_list_unref(JList* list)
 	{
 		j_list_delete_all(list);
 
+		g_free(list->elements);
 		g_slice_free(JList, list);
 	}
 }
@@ -169,28 +243,13 @@ j_list_append(JList* list, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JListElement* element;
-
 	g_return_if_fail(list != NULL);
 	g_return_if_fail(data != NULL);
 
-	element = g_slice_new(JListElement);
-	element->next = NULL;
-	element->data = data;
+	j_list_grow(list);
 
+	list->elements[list->offset + list->length] = data;
 	list->length++;
-
-	if (list->tail != NULL)
-	{
-		list->tail->next = element;
-	}
-
-	list->tail = element;
-
-	if (list->head == NULL)
-	{
-		list->head = list->tail;
-	}
 }
 
 /**
@@ -207,22 +266,14 @@ j_list_prepend(JList* list, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JListElement* element;
-
 	g_return_if_fail(list != NULL);
 	g_return_if_fail(data != NULL);
 
-	element = g_slice_new(JListElement);
-	element->next = list->head;
-	element->data = data;
+	j_list_grow_front(list);
 
+	list->offset--;
+	list->elements[list->offset] = data;
 	list->length++;
-	list->head = element;
-
-	if (list->tail == NULL)
-	{
-		list->tail = list->head;
-	}
 }
 
 /**
@@ -241,9 +292,9 @@ j_list_get_first(JList* list)
 
 	g_return_val_if_fail(list != NULL, NULL);
 
-	if (list->head != NULL && list->tail != NULL)
+	if (list->length > 0)
 	{
-		data = list->head->data;
+		data = list->elements[list->offset];
 	}
 
 	return data;
@@ -265,71 +316,68 @@ j_list_get_last(JList* list)
 
 	g_return_val_if_fail(list != NULL, NULL);
 
-	if (list->head != NULL && list->tail != NULL)
+	if (list->length > 0)
 	{
-		data = list->tail->data;
+		data = list->elements[list->offset + list->length - 1];
 	}
 
 	return data;
 }
 
 /**
- * Deletes all list elements.
+ * Returns the list's n-th element.
+ * In contrast to list iterators, this does not allocate any memory.
  *
- * \param list A list.
+ * \code
+ * for (guint i = 0; i < j_list_length(list); i++)
+ * {
+ *   gpointer data = j_list_get_nth(list, i);
+ * }
+ * \endcode
+ *
+ * \param list  A list.
+ * \param index An index.
+ *
+ * \return The element's data, NULL if the index is out of bounds.
  **/
-void
-j_list_delete_all(JList* list)
+gpointer
+j_list_get_nth(JList* list, guint index)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JListElement* element;
-
-	g_return_if_fail(list != NULL);
-
-	element = list->head;
+	g_return_val_if_fail(list != NULL, NULL);
 
-	while (element != NULL)
+	if (index >= list->length)
 	{
-		JListElement* next;
-
-		if (list->free_func != NULL)
-		{
-			list->free_func(element->data);
-		}
-
-		next = element->next;
-		g_slice_free(JListElement, element);
-		element = next;
+		return NULL;
 	}
 
-	list->head = NULL;
-	list->tail = NULL;
-	list->length = 0;
+	return list->elements[list->offset + index];
 }
 
-/* Internal */
-
 /**
- * Returns the list's first element.
- *
- * \private
- *
- * \code
- * \endcode
- *
- * \param list A JList.
+ * Deletes all list elements.
  *
- * \return A JListElement.
+ * \param list A list.
  **/
-JListElement*
-j_list_head(JList* list)
+void
+j_list_delete_all(JList* list)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_return_val_if_fail(list != NULL, NULL);
+	g_return_if_fail(list != NULL);
 
-	return list->head;
+	if (list->free_func != NULL)
+	{
+		for (guint i = 0; i < list->length; i++)
+		{
+			list->free_func(list->elements[list->offset + i]);
+		}
+	}
+
+	// The elements are kept allocated, lists are often refilled.
+	list->offset = 0;
+	list->length = 0;
 }
 
 /**
@@ -54,6 +54,11 @@ struct JMemoryChunk
 	* The current position within #data.
 	*/
 	gchar* current;
+
+	/**
+	* Whether #data is owned by the memory chunk.
+	*/
+	gboolean owned;
 };
 
 /**
@@ -82,6 +87,42 @@ j_memory_chunk_new(guint64 size)
 	cache->size = size;
 	cache->data = g_malloc(cache->size);
 	cache->current = cache->data;
+	cache->owned = TRUE;
+
+	return cache;
+}
+
+/**
+ * Creates a new memory chunk for existing memory.
+ * The memory is not copied and has to stay valid until the memory chunk is freed.
+ *
+ * \code
+ * JMemoryChunk* cache;
+ * gchar buffer[1024];
+ *
+ * cache = j_memory_chunk_new_for_data(buffer, sizeof(buffer));
+ * \endcode
+ *
+ * \param data A pointer to the memory.
+ * \param size The memory's size.
+ *
+ * \return A new memory chunk. Should be freed with j_memory_chunk_free().
+ **/
+JMemoryChunk*
+j_memory_chunk_new_for_data(gpointer data, guint64 size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryChunk* cache;
+
+	g_return_val_if_fail(data != NULL, NULL);
+	g_return_val_if_fail(size > 0, NULL);
+
+	cache = g_slice_new(JMemoryChunk);
+	cache->size = size;
+	cache->data = data;
+	cache->current = cache->data;
+	cache->owned = FALSE;
 
 	return cache;
 }
@@ -106,7 +147,7 @@ j_memory_chunk_free(JMemoryChunk* cache)
 
 	g_return_if_fail(cache != NULL);
 
-	if (cache->data != NULL)
+	if (cache->owned && cache->data != NULL)
 	{
 		g_free(cache->data);
 	}
@@ -25,14 +25,12 @@
 #include <glib.h>
 #include <gio/gio.h>
 
-#include <math.h>
 #include <string.h>
 
 #include <jmessage.h>
 
+#include <jconfiguration.h>
 #include <jhelper-internal.h>
-#include <jlist.h>
-#include <jlist-iterator.h>
 #include <jsemantics.h>
 #include <jtrace.h>
 
@@ -86,6 +84,29 @@ struct JMessageData
 
 typedef struct JMessageData JMessageData;
 
+enum
+{
+	/**
+	 * The number of additional data segments stored inline in a message.
+	 **/
+	J_MESSAGE_SEND_INLINE = 4,
+
+	/**
+	 * The number of buffer size classes, ranging from 256 bytes to 32 KiB.
+	 **/
+	J_MESSAGE_BUFFER_CLASSES = 8,
+
+	/**
+	 * The maximum number of cached buffers per size class and thread.
+	 **/
+	J_MESSAGE_BUFFER_CACHED = 16,
+
+	/**
+	 * The maximum number of cached messages per thread.
+	 **/
+	J_MESSAGE_CACHED = 32
+};
+
 /**
  * A message header.
  **/
@@ -116,12 +137,143 @@ struct JMessageHeader
 	 * The operation count.
 	 **/
 	guint32 op_count;
+
+	/**
+	 * The flags.
+	 **/
+	guint32 flags;
+
+	/**
+	 * The length of the additional data sent after the message.
+	 **/
+	guint64 send_length;
 };
 #pragma pack()
 
 typedef struct JMessageHeader JMessageHeader;
 
-G_STATIC_ASSERT(sizeof(JMessageHeader) == 5 * sizeof(guint32));
+G_STATIC_ASSERT(sizeof(JMessageHeader) == 6 * sizeof(guint32) + sizeof(guint64));
+
+/**
+ * The number of outstanding deferred replies per connection, as a multiple of the reply count.
+ **/
+#define J_MESSAGE_DEFERRED_MAX_FACTOR 4
+
+/**
+ * A message whose reply has been deferred.
+ **/
+struct JMessageDeferred
+{
+	/**
+	 * The message ID.
+	 **/
+	guint32 id;
+
+	/**
+	 * The function to call for the reply.
+	 **/
+	JMessageReplyFunc func;
+
+	/**
+	 * User data to give to #func.
+	 **/
+	gpointer data;
+};
+
+typedef struct JMessageDeferred JMessageDeferred;
+
+/**
+ * The deferred messages of a connection.
+ **/
+struct JMessageDeferredState
+{
+	/**
+	 * The messages whose replies are outstanding.
+	 **/
+	GQueue* queue;
+
+	/**
+	 * The next message ID.
+	 * IDs are assigned sequentially per connection to prevent collisions.
+	 **/
+	guint32 id;
+
+	/**
+	 * Whether a reply reported a failure.
+	 **/
+	gboolean failed;
+
+	/**
+	 * Whether the reply to an acknowledgement request sent by j_message_flush_deferred() is outstanding.
+	 **/
+	gboolean requested;
+
+	/**
+	 * The acknowledgement request's ID.
+	 **/
+	guint32 request;
+};
+
+typedef struct JMessageDeferredState JMessageDeferredState;
+
+/**
+ * The key used to attach the state of deferred messages to a connection.
+ **/
+static gchar const* const j_message_deferred_key = "j-message-deferred";
+
+/**
+ * The state of a multiplexed connection.
+ **/
+struct JMessageMux
+{
+	/**
+	 * The mutex protecting #replies and #failed.
+	 **/
+	GMutex mutex;
+
+	/**
+	 * The condition signaled when a reply has been received.
+	 **/
+	GCond cond;
+
+	/**
+	 * The mutex serializing sends.
+	 **/
+	GMutex send_mutex;
+
+	/**
+	 * The received replies.
+	 * Maps message IDs to queues of JMessage elements.
+	 **/
+	GHashTable* replies;
+
+	/**
+	 * The connection.
+	 **/
+	GSocketConnection* connection;
+
+	/**
+	 * The thread receiving replies.
+	 **/
+	GThread* thread;
+
+	/**
+	 * Whether receiving has failed.
+	 **/
+	gboolean failed;
+
+	/**
+	 * The next message ID.
+	 **/
+	gint id;
+};
+
+typedef struct JMessageMux JMessageMux;
+
+/**
+ * The key used to attach the multiplexing state to a connection.
+ **/
+static gchar const* const j_message_mux_key = "j-message-mux";
 
 /**
  * A message.
@@ -149,10 +301,36 @@ struct JMessage
 	gchar* current;
 
 	/**
-	 * The list of additional data to send in j_message_write().
-	 * Contains JMessageData elements.
+	 * The additional data to send in j_message_write().
+	 * Points to #send_inline unless more segments are needed.
+	 **/
+	JMessageData* send_data;
+
+	/**
+	 * The number of elements in #send_data.
+	 **/
+	guint send_count;
+
+	/**
+	 * The capacity of #send_data.
+	 **/
+	guint send_size;
+
+	/**
+	 * Inline storage for additional data, avoids allocations for the common case.
 	 **/
-	JList* send_list;
+	JMessageData send_inline[J_MESSAGE_SEND_INLINE];
+
+	/**
+	 * The additional data received after the message.
+	 * Only set for messages received on multiplexed connections, NULL otherwise.
+	 **/
+	gchar* receive_data;
+
+	/**
+	 * The current position within #receive_data.
+	 **/
+	guint64 receive_position;
 
 	/**
 	 * The original message.
@@ -167,173 +345,416 @@ struct JMessage
 };
 
 /**
- * Returns a message's length.
- *
- * \private
- *
- * \code
- * \endcode
- *
- * \param message A message.
- *
- * \return The message's length.
+ * A per-thread cache of message buffers and messages.
+ * Free buffers and messages are linked through their first bytes.
  **/
-static gsize
-j_message_length(JMessage const* message)
+struct JMessageCache
+{
+	/**
+	 * The free buffers per size class.
+	 **/
+	gpointer buffers[J_MESSAGE_BUFFER_CLASSES];
+
+	/**
+	 * The number of free buffers per size class.
+	 **/
+	guint buffer_count[J_MESSAGE_BUFFER_CLASSES];
+
+	/**
+	 * The free messages.
+	 **/
+	gpointer messages;
+
+	/**
+	 * The number of free messages.
+	 **/
+	guint message_count;
+};
+
+typedef struct JMessageCache JMessageCache;
+
+static void
+j_message_cache_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	guint32 length;
+	JMessageCache* cache = data;
 
-	length = message->header.length;
+	for (guint i = 0; i < J_MESSAGE_BUFFER_CLASSES; i++)
+	{
+		while (cache->buffers[i] != NULL)
+		{
+			gpointer buffer = cache->buffers[i];
 
-	return GUINT32_FROM_LE(length);
+			cache->buffers[i] = *(gpointer*)buffer;
+			g_free(buffer);
+		}
+	}
+
+	while (cache->messages != NULL)
+	{
+		gpointer message = cache->messages;
+
+		cache->messages = *(gpointer*)message;
+		g_slice_free(JMessage, message);
+	}
+
+	g_slice_free(JMessageCache, cache);
 }
 
-static void
-j_message_data_free(gpointer data)
+static GPrivate j_message_cache = G_PRIVATE_INIT(j_message_cache_free);
+
+static JMessageCache*
+j_message_get_cache(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_slice_free(JMessageData, data);
+	JMessageCache* cache;
+
+	cache = g_private_get(&j_message_cache);
+
+	if (G_UNLIKELY(cache == NULL))
+	{
+		cache = g_slice_new0(JMessageCache);
+		g_private_set(&j_message_cache, cache);
+	}
+
+	return cache;
 }
 
 /**
- * Checks whether it is possible to append data to a message.
+ * Returns the size class for a buffer size.
  *
  * \private
  *
- * \code
- * \endcode
- *
- * \param message A message.
- * \param length  A length.
+ * \param size A buffer size.
  *
- * \return TRUE if it is possible, FALSE otherwise.
+ * \return The size class, J_MESSAGE_BUFFER_CLASSES if the size is too large.
  **/
-static gboolean
-j_message_can_append(JMessage const* message, gsize length)
+static guint
+j_message_buffer_class(gsize size)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return (message->current + length <= message->data + message->size);
+	guint buffer_class = 0;
+
+	while (buffer_class < J_MESSAGE_BUFFER_CLASSES && ((gsize)256 << buffer_class) < size)
+	{
+		buffer_class++;
+	}
+
+	return buffer_class;
 }
 
 /**
- * Checks whether it is possible to get data from a message.
+ * Allocates a message buffer.
+ * Small sizes are rounded up to their size class and served from the thread's cache.
  *
  * \private
  *
- * \code
- * \endcode
- *
- * \param message A message.
- * \param length  A length.
+ * \param size The requested size, will be set to the actual size.
  *
- * \return TRUE if it is possible, FALSE otherwise.
+ * \return A new buffer. Should be freed with j_message_buffer_free().
  **/
-static gboolean
-j_message_can_get(JMessage const* message, gsize length)
+static gchar*
+j_message_buffer_alloc(gsize* size)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return (message->current + length <= message->data + j_message_length(message));
+	JMessageCache* cache;
+	gpointer buffer;
+	guint buffer_class;
+
+	buffer_class = j_message_buffer_class(*size);
+
+	if (buffer_class == J_MESSAGE_BUFFER_CLASSES)
+	{
+		return g_malloc(*size);
+	}
+
+	*size = (gsize)256 << buffer_class;
+	cache = j_message_get_cache();
+	buffer = cache->buffers[buffer_class];
+
+	if (buffer == NULL)
+	{
+		return g_malloc(*size);
+	}
+
+	cache->buffers[buffer_class] = *(gpointer*)buffer;
+	cache->buffer_count[buffer_class]--;
+
+	return buffer;
 }
 
 static void
-j_message_extend(JMessage* message, gsize length)
+j_message_buffer_free(gchar* buffer, gsize size)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gsize factor = 1;
-	gsize current_length;
-	gsize position;
-	guint32 count;
+	JMessageCache* cache;
+	guint buffer_class;
 
-	if (length == 0)
+	if (buffer == NULL)
 	{
 		return;
 	}
 
-	current_length = j_message_length(message);
+	buffer_class = j_message_buffer_class(size);
 
-	if (current_length + length <= message->size)
+	// Buffers that have been resized with g_realloc() do not match their size class.
+	if (buffer_class == J_MESSAGE_BUFFER_CLASSES || ((gsize)256 << buffer_class) != size)
 	{
+		g_free(buffer);
 		return;
 	}
 
-	count = j_message_get_count(message);
+	cache = j_message_get_cache();
 
-	if (count > 10)
+	if (cache->buffer_count[buffer_class] >= J_MESSAGE_BUFFER_CACHED)
 	{
-		factor = pow(10, floor(log10(count)));
+		g_free(buffer);
+		return;
 	}
 
-	message->size += length * factor;
+	*(gpointer*)buffer = cache->buffers[buffer_class];
+	cache->buffers[buffer_class] = buffer;
+	cache->buffer_count[buffer_class]++;
+}
 
-	position = message->current - message->data;
-	message->data = g_realloc(message->data, message->size);
-	message->current = message->data + position;
+static JMessage*
+j_message_alloc(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageCache* cache;
+	JMessage* message;
+
+	cache = j_message_get_cache();
+	message = cache->messages;
+
+	if (message == NULL)
+	{
+		return g_slice_new(JMessage);
+	}
+
+	cache->messages = *(gpointer*)message;
+	cache->message_count--;
+
+	return message;
 }
 
 static void
-j_message_ensure_size(JMessage* message, gsize length)
+j_message_dealloc(JMessage* message)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gsize position;
+	JMessageCache* cache;
 
-	if (length <= message->size)
+	cache = j_message_get_cache();
+
+	if (cache->message_count >= J_MESSAGE_CACHED)
 	{
+		g_slice_free(JMessage, message);
 		return;
 	}
 
-	message->size = length;
-
-	position = message->current - message->data;
-	message->data = g_realloc(message->data, message->size);
-	message->current = message->data + position;
+	*(gpointer*)message = cache->messages;
+	cache->messages = message;
+	cache->message_count++;
 }
 
 /**
- * Creates a new message.
+ * Resizes a message's buffer.
  *
- * \code
- * \endcode
- *
- * \param op_type An operation type.
- * \param length  A length.
+ * \private
  *
- * \return A new message. Should be freed with j_message_unref().
+ * \param message A message.
+ * \param size    The new size.
  **/
-JMessage*
-j_message_new(JMessageType op_type, gsize length)
+static void
+j_message_resize(JMessage* message, gsize size)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JMessage* message;
-	guint32 rand;
+	gsize position;
 
-	//g_return_val_if_fail(op_type != J_MESSAGE_NONE, NULL);
+	position = message->current - message->data;
 
-	length = MAX(256, length);
-	rand = g_random_int();
+	if (j_message_buffer_class(size) < J_MESSAGE_BUFFER_CLASSES)
+	{
+		gchar* data;
 
-	message = g_slice_new(JMessage);
-	message->size = length;
-	message->data = g_malloc(message->size);
-	message->current = message->data;
-	message->send_list = j_list_new(j_message_data_free);
-	message->original_message = NULL;
-	message->ref_count = 1;
+		data = j_message_buffer_alloc(&size);
+		memcpy(data, message->data, MIN(message->size, size));
+		j_message_buffer_free(message->data, message->size);
 
-	message->header.length = GUINT32_TO_LE(0);
-	message->header.id = GUINT32_TO_LE(rand);
-	message->header.semantics = GUINT32_TO_LE(0);
-	message->header.op_type = GUINT32_TO_LE(op_type);
-	message->header.op_count = GUINT32_TO_LE(0);
+		message->data = data;
+	}
+	else
+	{
+		message->data = g_realloc(message->data, size);
+	}
 
-	return message;
+	message->size = size;
+	message->current = message->data + position;
+}
+
+static void
+j_message_init(JMessage* message, gsize size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	message->size = size;
+	message->data = j_message_buffer_alloc(&(message->size));
+	message->current = message->data;
+	message->send_data = message->send_inline;
+	message->send_count = 0;
+	message->send_size = J_MESSAGE_SEND_INLINE;
+	message->receive_data = NULL;
+	message->receive_position = 0;
+	message->original_message = NULL;
+	message->ref_count = 1;
+}
+
+/**
+ * Returns a message's length.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return The message's length.
+ **/
+static gsize
+j_message_length(JMessage const* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 length;
+
+	length = message->header.length;
+
+	return GUINT32_FROM_LE(length);
+}
+
+/**
+ * Checks whether it is possible to append data to a message.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param length  A length.
+ *
+ * \return TRUE if it is possible, FALSE otherwise.
+ **/
+static gboolean
+j_message_can_append(JMessage const* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return (message->current + length <= message->data + message->size);
+}
+
+/**
+ * Checks whether it is possible to get data from a message.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param length  A length.
+ *
+ * \return TRUE if it is possible, FALSE otherwise.
+ **/
+static gboolean
+j_message_can_get(JMessage const* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return (message->current + length <= message->data + j_message_length(message));
+}
+
+static void
+j_message_extend(JMessage* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize current_length;
+
+	if (length == 0)
+	{
+		return;
+	}
+
+	current_length = j_message_length(message);
+
+	if (current_length + length <= message->size)
+	{
+		return;
+	}
+
+	// Doubling keeps the number of resizes logarithmic and matches the buffers' size classes.
+	j_message_resize(message, MAX(current_length + length, 2 * message->size));
+}
+
+static void
+j_message_ensure_size(JMessage* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (length <= message->size)
+	{
+		return;
+	}
+
+	j_message_resize(message, length);
+}
+
+/**
+ * Creates a new message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param op_type An operation type.
+ * \param length  A length.
+ *
+ * \return A new message. Should be freed with j_message_unref().
+ **/
+JMessage*
+j_message_new(JMessageType op_type, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* message;
+	guint32 rand;
+
+	//g_return_val_if_fail(op_type != J_MESSAGE_NONE, NULL);
+
+	length = MAX(256, length);
+	rand = g_random_int();
+
+	message = j_message_alloc();
+	j_message_init(message, length);
+
+	message->header.length = GUINT32_TO_LE(0);
+	message->header.id = GUINT32_TO_LE(rand);
+	message->header.semantics = GUINT32_TO_LE(0);
+	message->header.op_type = GUINT32_TO_LE(op_type);
+	message->header.op_count = GUINT32_TO_LE(0);
+	message->header.flags = GUINT32_TO_LE(J_MESSAGE_FLAGS_NONE);
+	message->header.send_length = GUINT64_TO_LE(0);
+
+	return message;
 }
 
 /**
@@ -355,19 +776,17 @@ j_message_new_reply(JMessage* message)
 
 	g_return_val_if_fail(message != NULL, NULL);
 
-	reply = g_slice_new(JMessage);
-	reply->size = 256;
-	reply->data = g_malloc(reply->size);
-	reply->current = reply->data;
-	reply->send_list = j_list_new(j_message_data_free);
+	reply = j_message_alloc();
+	j_message_init(reply, 256);
 	reply->original_message = j_message_ref(message);
-	reply->ref_count = 1;
 
 	reply->header.length = GUINT32_TO_LE(0);
 	reply->header.id = message->header.id;
 	reply->header.semantics = GUINT32_TO_LE(0);
 	reply->header.op_type = message->header.op_type;
 	reply->header.op_count = GUINT32_TO_LE(0);
+	reply->header.flags = GUINT32_TO_LE(J_MESSAGE_FLAGS_NONE);
+	reply->header.send_length = GUINT64_TO_LE(0);
 
 	return reply;
 }
@@ -420,14 +839,15 @@ j_message_unref(JMessage* message)
 			j_message_unref(message->original_message);
 		}
 
-		if (message->send_list != NULL)
+		if (message->send_data != message->send_inline)
 		{
-			j_list_unref(message->send_list);
+			g_free(message->send_data);
 		}
 
-		g_free(message->data);
+		j_message_buffer_free(message->data, message->size);
+		g_free(message->receive_data);
 
-		g_slice_free(JMessage, message);
+		j_message_dealloc(message);
 	}
 }
 
@@ -481,6 +901,53 @@ j_message_get_count(JMessage const* message)
 	return op_count;
 }
 
+/**
+ * Returns a message's flags.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return The message's flags.
+ **/
+JMessageFlags
+j_message_get_flags(JMessage const* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 flags;
+
+	g_return_val_if_fail(message != NULL, J_MESSAGE_FLAGS_NONE);
+
+	flags = message->header.flags;
+	flags = GUINT32_FROM_LE(flags);
+
+	return flags;
+}
+
+/**
+ * Adds flags to a message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param flags   The flags to add.
+ **/
+void
+j_message_add_flags(JMessage* message, JMessageFlags flags)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 message_flags;
+
+	g_return_if_fail(message != NULL);
+
+	message_flags = GUINT32_FROM_LE(message->header.flags);
+	message->header.flags = GUINT32_TO_LE(message_flags | flags);
+}
+
 /**
  * Appends 1 byte to a message.
  *
@@ -543,292 +1010,1102 @@ j_message_append_4(JMessage* message, gconstpointer data)
 	new_length = j_message_length(message) + 4;
 	message->header.length = GUINT32_TO_LE(new_length);
 
-	return TRUE;
+	return TRUE;
+}
+
+/**
+ * Appends 8 bytes to a message.
+ * The bytes are converted to little endian automatically.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ * \param data    Data to append.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_message_append_8(JMessage* message, gconstpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64 new_data;
+	guint32 new_length;
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(j_message_can_append(message, 8), FALSE);
+
+	new_data = GINT64_TO_LE(*((gint64 const*)data));
+	memcpy(message->current, &new_data, 8);
+	message->current += 8;
+
+	new_length = j_message_length(message) + 8;
+	message->header.length = GUINT32_TO_LE(new_length);
+
+	return TRUE;
+}
+
+/**
+ * Appends a number of bytes to a message.
+ *
+ * \code
+ * gchar* str = "Hello world!";
+ * ...
+ * j_message_append_n(message, str, strlen(str) + 1);
+ * \endcode
+ *
+ * \param message A message.
+ * \param data    Data to append.
+ * \param length  Length of data.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_message_append_n(JMessage* message, gconstpointer data, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 new_length;
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(j_message_can_append(message, length), FALSE);
+
+	memcpy(message->current, data, length);
+	message->current += length;
+
+	new_length = j_message_length(message) + length;
+	message->header.length = GUINT32_TO_LE(new_length);
+
+	return TRUE;
+}
+
+/**
+ * Appends a string to a message.
+ *
+ * \code
+ * gchar* str = "Hello world!";
+ * ...
+ * j_message_append_string(message, str);
+ * \endcode
+ *
+ * \param message A message.
+ * \param str     String to append.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_message_append_string(JMessage* message, gchar const* str)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(str != NULL, FALSE);
+
+	return j_message_append_n(message, str, strlen(str) + 1);
+}
+
+/**
+ * Gets 1 byte from a message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return A character.
+ **/
+gchar
+j_message_get_1(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar ret;
+
+	g_return_val_if_fail(message != NULL, '\0');
+	g_return_val_if_fail(j_message_can_get(message, 1), '\0');
+
+	ret = *((gchar const*)(message->current));
+	message->current += 1;
+
+	return ret;
+}
+
+/**
+ * Gets 4 bytes from a message.
+ * The bytes are converted from little endian automatically.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return A 4-bytes integer.
+ **/
+gint32
+j_message_get_4(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint32 ret;
+
+	g_return_val_if_fail(message != NULL, 0);
+	g_return_val_if_fail(j_message_can_get(message, 4), 0);
+
+	memcpy(&ret, message->current, 4);
+	ret = GINT32_FROM_LE(ret);
+	message->current += 4;
+
+	return ret;
+}
+
+/**
+ * Gets 8 bytes from a message.
+ * The bytes are converted from little endian automatically.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return An 8-bytes integer.
+ **/
+gint64
+j_message_get_8(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64 ret;
+
+	g_return_val_if_fail(message != NULL, 0);
+	g_return_val_if_fail(j_message_can_get(message, 8), 0);
+
+	memcpy(&ret, message->current, 8);
+	ret = GINT64_FROM_LE(ret);
+	message->current += 8;
+
+	return ret;
+}
+
+/**
+ * Gets n bytes from a message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return A pointer to the data.
+ **/
+gpointer
+j_message_get_n(JMessage* message, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer ret;
+
+	g_return_val_if_fail(message != NULL, NULL);
+	g_return_val_if_fail(j_message_can_get(message, length), NULL);
+
+	ret = message->current;
+	message->current += length;
+
+	return ret;
+}
+
+/**
+ * Gets a string from a message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return A string.
+ **/
+gchar const*
+j_message_get_string(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* ret;
+
+	g_return_val_if_fail(message != NULL, NULL);
+
+	ret = message->current;
+	message->current += strlen(ret) + 1;
+
+	return ret;
+}
+
+static void
+j_message_deferred_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_slice_free(JMessageDeferred, data);
+}
+
+static void
+j_message_deferred_state_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageDeferredState* state = data;
+
+	g_queue_free_full(state->queue, j_message_deferred_free);
+	g_slice_free(JMessageDeferredState, state);
+}
+
+static JMessageDeferredState*
+j_message_get_deferred(gpointer connection, gboolean create)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageDeferredState* state;
+
+	state = g_object_get_data(G_OBJECT(connection), j_message_deferred_key);
+
+	if (state == NULL && create)
+	{
+		state = g_slice_new(JMessageDeferredState);
+		state->queue = g_queue_new();
+		state->id = g_random_int();
+		state->failed = FALSE;
+		state->requested = FALSE;
+		state->request = 0;
+
+		g_object_set_data_full(G_OBJECT(connection), j_message_deferred_key, state, j_message_deferred_state_free);
+	}
+
+	return state;
+}
+
+static gint
+j_message_deferred_compare(gconstpointer a, gconstpointer b)
+{
+	JMessageDeferred const* deferred = a;
+	guint32 const* id = b;
+
+	return (deferred->id == *id) ? 0 : 1;
+}
+
+/**
+ * Dispatches all replies contained in an acknowledgement message.
+ *
+ * \private
+ *
+ * \param message  An acknowledgement message.
+ * \param deferred The connection's deferred messages.
+ **/
+static void
+j_message_dispatch_deferred(JMessage* message, JMessageDeferredState* deferred)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 count;
+
+	count = j_message_get_count(message);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		GList* link;
+		gchar* next;
+		guint32 id;
+		guint32 op_count;
+		guint32 length;
+
+		id = j_message_get_4(message);
+		op_count = j_message_get_4(message);
+		length = j_message_get_4(message);
+		next = message->current + length;
+
+		// Replies usually arrive in order, so this is cheap.
+		link = g_queue_find_custom(deferred->queue, &id, j_message_deferred_compare);
+
+		if (link != NULL)
+		{
+			JMessageDeferred* message_deferred = link->data;
+
+			g_queue_delete_link(deferred->queue, link);
+
+			if (message_deferred->func != NULL && !message_deferred->func(message, op_count, message_deferred->data))
+			{
+				deferred->failed = TRUE;
+			}
+
+			j_message_deferred_free(message_deferred);
+		}
+		else
+		{
+			g_warning("Received reply for unknown message %u.", id);
+		}
+
+		message->current = next;
+	}
+}
+
+/**
+ * Reads acknowledgement messages until all deferred replies have been received.
+ *
+ * \private
+ *
+ * \param connection A connection.
+ * \param request    An acknowledgement request whose reply has to be waited for, may be NULL.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_receive_deferred_internal(gpointer connection, JMessage const* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) message = NULL;
+	GInputStream* stream;
+	JMessageDeferredState* deferred;
+
+	deferred = j_message_get_deferred(connection, FALSE);
+
+	if ((deferred == NULL || g_queue_is_empty(deferred->queue)) && request == NULL)
+	{
+		return TRUE;
+	}
+
+	stream = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+	message = j_message_new(J_MESSAGE_NONE, 0);
+
+	while ((deferred != NULL && !g_queue_is_empty(deferred->queue)) || request != NULL)
+	{
+		if (!j_message_read(message, stream))
+		{
+			return FALSE;
+		}
+
+		// Unexpected or corrupt replies are reported to the caller instead of aborting.
+		if (j_message_get_type(message) != J_MESSAGE_ACKNOWLEDGE)
+		{
+			g_warning("Received unexpected reply of type %d while waiting for acknowledgements.", j_message_get_type(message));
+			return FALSE;
+		}
+
+		if (deferred != NULL)
+		{
+			j_message_dispatch_deferred(message, deferred);
+		}
+
+		// Coalesced replies always contain at least one reply, the reply to the request does not.
+		if (request != NULL && message->header.id == request->header.id && j_message_get_count(message) == 0)
+		{
+			request = NULL;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Asks the server for its coalesced replies and receives them.
+ *
+ * \private
+ *
+ * \param connection A connection.
+ * \param deferred   The connection's deferred messages.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_request_deferred(gpointer connection, JMessageDeferredState* deferred)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) message = NULL;
+
+	if (g_queue_is_empty(deferred->queue))
+	{
+		return TRUE;
+	}
+
+	// Ask the server to send its coalesced replies right away.
+	message = j_message_new(J_MESSAGE_ACKNOWLEDGE, 0);
+	message->header.id = GUINT32_TO_LE(deferred->id++);
+
+	if (!j_message_send(message, connection))
+	{
+		return FALSE;
+	}
+
+	return j_message_receive_deferred_internal(connection, message);
+}
+
+static void
+j_message_mux_queue_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_queue_free_full(data, (GDestroyNotify)j_message_unref);
+}
+
+static JMessageMux*
+j_message_get_mux(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return g_object_get_data(G_OBJECT(connection), j_message_mux_key);
+}
+
+/**
+ * Receives replies on a multiplexed connection and routes them to their waiting messages.
+ *
+ * \private
+ *
+ * \param data The multiplexing state.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_message_mux_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMux* mux = data;
+	GInputStream* stream;
+
+	stream = g_io_stream_get_input_stream(G_IO_STREAM(mux->connection));
+
+	while (TRUE)
+	{
+		JMessage* message;
+		GQueue* queue;
+		guint64 send_length;
+		guint32 id;
+
+		message = j_message_new(J_MESSAGE_NONE, 0);
+
+		if (!j_message_read(message, stream))
+		{
+			j_message_unref(message);
+			break;
+		}
+
+		send_length = GUINT64_FROM_LE(message->header.send_length);
+
+		// The additional data has to be buffered, otherwise it would block the replies of other messages.
+		if (send_length > 0)
+		{
+			gsize bytes_read;
+
+			message->receive_data = g_malloc(send_length);
+
+			if (!g_input_stream_read_all(stream, message->receive_data, send_length, &bytes_read, NULL, NULL) || bytes_read != send_length)
+			{
+				j_message_unref(message);
+				break;
+			}
+		}
+
+		id = message->header.id;
+
+		g_mutex_lock(&(mux->mutex));
+
+		queue = g_hash_table_lookup(mux->replies, GUINT_TO_POINTER(id));
+
+		if (queue == NULL)
+		{
+			queue = g_queue_new();
+			g_hash_table_insert(mux->replies, GUINT_TO_POINTER(id), queue);
+		}
+
+		g_queue_push_tail(queue, message);
+		g_cond_broadcast(&(mux->cond));
+
+		g_mutex_unlock(&(mux->mutex));
+	}
+
+	g_mutex_lock(&(mux->mutex));
+	mux->failed = TRUE;
+	g_cond_broadcast(&(mux->cond));
+	g_mutex_unlock(&(mux->mutex));
+
+	return NULL;
+}
+
+/**
+ * Moves the contents of a received message into another message.
+ *
+ * \private
+ *
+ * \param message  A message.
+ * \param received A received message, will be freed.
+ **/
+static void
+j_message_take(JMessage* message, JMessage* received)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar* data;
+	gsize size;
+
+	data = message->data;
+	size = message->size;
+
+	message->header = received->header;
+	message->data = received->data;
+	message->size = received->size;
+	message->current = message->data;
+
+	g_free(message->receive_data);
+	message->receive_data = received->receive_data;
+	message->receive_position = 0;
+
+	received->data = data;
+	received->size = size;
+	received->current = data;
+	received->receive_data = NULL;
+
+	j_message_unref(received);
+}
+
+/**
+ * Waits for a reply on a multiplexed connection.
+ *
+ * \private
+ *
+ * \param message A reply.
+ * \param mux     The multiplexing state.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_mux_receive(JMessage* message, JMessageMux* mux)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* received = NULL;
+	guint32 id;
+
+	// The reply might have been created before its message was sent and got its ID.
+	id = (message->original_message != NULL) ? message->original_message->header.id : message->header.id;
+
+	g_mutex_lock(&(mux->mutex));
+
+	while (received == NULL)
+	{
+		GQueue* queue;
+
+		queue = g_hash_table_lookup(mux->replies, GUINT_TO_POINTER(id));
+
+		if (queue != NULL)
+		{
+			received = g_queue_pop_head(queue);
+
+			if (g_queue_is_empty(queue))
+			{
+				g_hash_table_remove(mux->replies, GUINT_TO_POINTER(id));
+			}
+		}
+		else if (mux->failed)
+		{
+			break;
+		}
+		else
+		{
+			g_cond_wait(&(mux->cond), &(mux->mutex));
+		}
+	}
+
+	g_mutex_unlock(&(mux->mutex));
+
+	if (received == NULL)
+	{
+		return FALSE;
+	}
+
+	j_message_take(message, received);
+
+	return TRUE;
+}
+
+/**
+ * Starts multiplexing messages on a connection.
+ * Afterwards, the connection can be used by multiple threads at the same time.
+ * A receiver thread routes replies to the messages waiting for them using the messages' IDs.
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ **/
+void
+j_message_mux_start(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMux* mux;
+
+	g_return_if_fail(connection != NULL);
+	g_return_if_fail(j_message_get_mux(connection) == NULL);
+
+	mux = g_slice_new(JMessageMux);
+	g_mutex_init(&(mux->mutex));
+	g_cond_init(&(mux->cond));
+	g_mutex_init(&(mux->send_mutex));
+	mux->replies = g_hash_table_new_full(NULL, NULL, NULL, j_message_mux_queue_free);
+	mux->connection = connection;
+	mux->failed = FALSE;
+	mux->id = (gint)g_random_int();
+
+	g_object_set_data(G_OBJECT(connection), j_message_mux_key, mux);
+
+	mux->thread = g_thread_new("j-message-mux", j_message_mux_thread, mux);
+}
+
+/**
+ * Stops multiplexing messages on a connection.
+ * There must not be any threads waiting for replies.
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ **/
+void
+j_message_mux_stop(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessageMux* mux;
+
+	g_return_if_fail(connection != NULL);
+
+	mux = j_message_get_mux(connection);
+
+	if (mux == NULL)
+	{
+		return;
+	}
+
+	// Wakes up the receiver thread.
+	g_socket_shutdown(g_socket_connection_get_socket(G_SOCKET_CONNECTION(connection)), TRUE, FALSE, NULL);
+	g_thread_join(mux->thread);
+
+	g_object_set_data(G_OBJECT(connection), j_message_mux_key, NULL);
+
+	g_hash_table_unref(mux->replies);
+	g_mutex_clear(&(mux->send_mutex));
+	g_cond_clear(&(mux->cond));
+	g_mutex_clear(&(mux->mutex));
+
+	g_slice_free(JMessageMux, mux);
 }
 
 /**
- * Appends 8 bytes to a message.
- * The bytes are converted to little endian automatically.
+ * Reads a message from the network.
  *
  * \code
  * \endcode
  *
  * \param message A message.
- * \param data    Data to append.
+ * \parem stream  A network stream.
  *
- * \return TRUE on success, FALSE if an error occurred.
+ * \return TRUE on success, FALSE if an error occurred or the server failed to handle the message.
  **/
 gboolean
-j_message_append_8(JMessage* message, gconstpointer data)
+j_message_receive(JMessage* message, gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gint64 new_data;
-	guint32 new_length;
+	GInputStream* stream;
+	JMessageMux* mux;
+	gboolean ret;
 
 	g_return_val_if_fail(message != NULL, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
-	g_return_val_if_fail(j_message_can_append(message, 8), FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
 
-	new_data = GINT64_TO_LE(*((gint64 const*)data));
-	memcpy(message->current, &new_data, 8);
-	message->current += 8;
+	mux = j_message_get_mux(connection);
 
-	new_length = j_message_length(message) + 8;
-	message->header.length = GUINT32_TO_LE(new_length);
+	if (mux != NULL)
+	{
+		ret = j_message_mux_receive(message, mux);
+	}
+	// Replies to deferred messages are always sent before other replies.
+	else if (message->original_message != NULL && !j_message_receive_deferred_internal(connection, NULL))
+	{
+		return FALSE;
+	}
+	else
+	{
+		stream = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+		ret = j_message_read(message, stream);
+	}
 
-	return TRUE;
+	// Servers reject messages they can not handle, for instance, if a backend failed to initialize.
+	return (ret && !(j_message_get_flags(message) & J_MESSAGE_FLAGS_FAILED));
 }
 
 /**
- * Appends a number of bytes to a message.
+ * Reads additional data sent after a message.
+ * On multiplexed connections, the data has already been received together with the message.
  *
  * \code
- * gchar* str = "Hello world!";
- * ...
- * j_message_append_n(message, str, strlen(str) + 1);
  * \endcode
  *
- * \param message A message.
- * \param data    Data to append.
- * \param length  Length of data.
+ * \param message    A received message.
+ * \param connection The connection the message was received on.
+ * \param data       A buffer to hold the data.
+ * \param length     Number of bytes to read.
  *
  * \return TRUE on success, FALSE if an error occurred.
  **/
 gboolean
-j_message_append_n(JMessage* message, gconstpointer data, gsize length)
+j_message_receive_data(JMessage* message, gpointer connection, gpointer data, guint64 length)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	guint32 new_length;
+	GInputStream* stream;
+	gsize bytes_read;
 
 	g_return_val_if_fail(message != NULL, FALSE);
-	g_return_val_if_fail(data != NULL, FALSE);
-	g_return_val_if_fail(j_message_can_append(message, length), FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(data != NULL || length == 0, FALSE);
 
-	memcpy(message->current, data, length);
-	message->current += length;
+	if (length == 0)
+	{
+		return TRUE;
+	}
 
-	new_length = j_message_length(message) + length;
-	message->header.length = GUINT32_TO_LE(new_length);
+	if (message->receive_data != NULL)
+	{
+		if (message->receive_position + length > GUINT64_FROM_LE(message->header.send_length))
+		{
+			return FALSE;
+		}
 
-	return TRUE;
+		memcpy(data, message->receive_data + message->receive_position, length);
+		message->receive_position += length;
+
+		return TRUE;
+	}
+
+	stream = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+
+	return (g_input_stream_read_all(stream, data, length, &bytes_read, NULL, NULL) && bytes_read == length);
 }
 
 /**
- * Appends a string to a message.
+ * Writes a message to the network.
  *
  * \code
- * gchar* str = "Hello world!";
- * ...
- * j_message_append_string(message, str);
  * \endcode
  *
  * \param message A message.
- * \param str     String to append.
+ * \parem stream  A network stream.
  *
  * \return TRUE on success, FALSE if an error occurred.
  **/
 gboolean
-j_message_append_string(JMessage* message, gchar const* str)
+j_message_send(JMessage* message, gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	gboolean ret;
+
+	GOutputStream* stream;
+	JMessageMux* mux;
+
 	g_return_val_if_fail(message != NULL, FALSE);
-	g_return_val_if_fail(str != NULL, FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
 
-	return j_message_append_n(message, str, strlen(str) + 1);
-}
+	mux = j_message_get_mux(connection);
 
-/**
- * Gets 1 byte from a message.
- *
- * \code
- * \endcode
- *
- * \param message A message.
- *
- * \return A character.
- **/
-gchar
-j_message_get_1(JMessage* message)
-{
-	J_TRACE_FUNCTION(NULL);
+	if (mux != NULL)
+	{
+		g_mutex_lock(&(mux->send_mutex));
 
-	gchar ret;
+		// Message IDs have to be unique among all messages in flight on the connection.
+		if (message->original_message == NULL)
+		{
+			message->header.id = GUINT32_TO_LE((guint32)g_atomic_int_add(&(mux->id), 1));
+		}
+	}
 
-	g_return_val_if_fail(message != NULL, '\0');
-	g_return_val_if_fail(j_message_can_get(message, 1), '\0');
+	j_helper_set_cork(connection, TRUE);
 
-	ret = *((gchar const*)(message->current));
-	message->current += 1;
+	stream = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+	ret = j_message_write(message, stream);
+
+	j_helper_set_cork(connection, FALSE);
+
+	if (mux != NULL)
+	{
+		g_mutex_unlock(&(mux->send_mutex));
+	}
 
 	return ret;
 }
 
 /**
- * Gets 4 bytes from a message.
- * The bytes are converted from little endian automatically.
+ * Writes a message to the network without waiting for its reply.
+ * The server may coalesce the reply with replies to other messages.
+ * The number of outstanding replies is bounded, outstanding replies are received when the limit is reached.
+ * j_message_receive_deferred() has to be called before the connection can be used by another thread.
  *
  * \code
  * \endcode
  *
- * \param message A message.
+ * \param message    A message.
+ * \param connection A connection.
+ * \param func       A function to call for the reply, may be NULL. It returns whether the reply reported success.
+ * \param data       User data to give to func.
  *
- * \return A 4-bytes integer.
+ * \return TRUE on success, FALSE if an error occurred.
  **/
-gint32
-j_message_get_4(JMessage* message)
+gboolean
+j_message_send_deferred(JMessage* message, gpointer connection, JMessageReplyFunc func, gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gint32 ret;
+	JMessageDeferred* message_deferred;
+	JMessageDeferredState* deferred;
+	guint32 max_deferred;
 
-	g_return_val_if_fail(message != NULL, 0);
-	g_return_val_if_fail(j_message_can_get(message, 4), 0);
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
 
-	memcpy(&ret, message->current, 4);
-	ret = GINT32_FROM_LE(ret);
-	message->current += 4;
+	deferred = j_message_get_deferred(connection, TRUE);
+	max_deferred = J_MESSAGE_DEFERRED_MAX_FACTOR * j_configuration_get_reply_count(j_configuration());
 
-	return ret;
+	// Unread acknowledgements fill the socket buffers and block the server eventually.
+	if (g_queue_get_length(deferred->queue) >= max_deferred && !j_message_request_deferred(connection, deferred))
+	{
+		return FALSE;
+	}
+
+	j_message_add_flags(message, J_MESSAGE_FLAGS_DEFERRED_REPLY);
+	message->header.id = GUINT32_TO_LE(deferred->id++);
+
+	message_deferred = g_slice_new(JMessageDeferred);
+	message_deferred->id = GUINT32_FROM_LE(message->header.id);
+	message_deferred->func = func;
+	message_deferred->data = data;
+
+	g_queue_push_tail(deferred->queue, message_deferred);
+
+	return j_message_send(message, connection);
 }
 
 /**
- * Gets 8 bytes from a message.
- * The bytes are converted from little endian automatically.
+ * Receives all outstanding replies to messages sent with j_message_send_deferred().
  *
  * \code
  * \endcode
  *
- * \param message A message.
+ * \param connection A connection.
  *
- * \return An 8-bytes integer.
+ * \return TRUE on success, FALSE if an error occurred or a reply reported a failure.
  **/
-gint64
-j_message_get_8(JMessage* message)
+gboolean
+j_message_receive_deferred(gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gint64 ret;
+	JMessageDeferredState* deferred;
+	gboolean ret;
 
-	g_return_val_if_fail(message != NULL, 0);
-	g_return_val_if_fail(j_message_can_get(message, 8), 0);
+	g_return_val_if_fail(connection != NULL, FALSE);
 
-	memcpy(&ret, message->current, 8);
-	ret = GINT64_FROM_LE(ret);
-	message->current += 8;
+	deferred = j_message_get_deferred(connection, FALSE);
+
+	if (deferred == NULL)
+	{
+		return TRUE;
+	}
+
+	ret = j_message_request_deferred(connection, deferred) && !deferred->failed;
+	deferred->failed = FALSE;
 
 	return ret;
 }
 
 /**
- * Gets n bytes from a message.
+ * Asks the server to send all outstanding replies to messages sent with j_message_send_deferred() without waiting for them.
+ * The replies have to be received using j_message_receive_deferred_next(), for example, when the connection becomes readable.
  *
  * \code
  * \endcode
  *
- * \param message A message.
+ * \param connection A connection.
  *
- * \return A pointer to the data.
+ * \return TRUE on success, FALSE if an error occurred.
  **/
-gpointer
-j_message_get_n(JMessage* message, gsize length)
+gboolean
+j_message_flush_deferred(gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gpointer ret;
+	g_autoptr(JMessage) message = NULL;
+	JMessageDeferredState* deferred;
 
-	g_return_val_if_fail(message != NULL, NULL);
-	g_return_val_if_fail(j_message_can_get(message, length), NULL);
+	g_return_val_if_fail(connection != NULL, FALSE);
 
-	ret = message->current;
-	message->current += length;
+	deferred = j_message_get_deferred(connection, FALSE);
 
-	return ret;
+	if (deferred == NULL || g_queue_is_empty(deferred->queue))
+	{
+		return TRUE;
+	}
+
+	g_return_val_if_fail(!deferred->requested, FALSE);
+
+	message = j_message_new(J_MESSAGE_ACKNOWLEDGE, 0);
+	message->header.id = GUINT32_TO_LE(deferred->id++);
+
+	deferred->request = GUINT32_FROM_LE(message->header.id);
+	deferred->requested = TRUE;
+
+	return j_message_send(message, connection);
 }
 
 /**
- * Gets a string from a message.
+ * Receives one acknowledgement message after j_message_flush_deferred() has been called.
+ * This only blocks until the message has been read completely, so it can be used to receive replies whenever the connection becomes readable.
  *
  * \code
+ * gboolean done = FALSE;
+ *
+ * j_message_flush_deferred(connection);
+ *
+ * while (!done && j_message_receive_deferred_next(connection, &done))
+ * {
+ * }
  * \endcode
  *
- * \param message A message.
+ * \param connection A connection.
+ * \param done       Returns whether all outstanding replies have been received.
  *
- * \return A string.
+ * \return TRUE on success, FALSE if an error occurred or a reply reported a failure.
  **/
-gchar const*
-j_message_get_string(JMessage* message)
+gboolean
+j_message_receive_deferred_next(gpointer connection, gboolean* done)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gchar const* ret;
+	g_autoptr(JMessage) message = NULL;
+	JMessageDeferredState* deferred;
+	gboolean ret;
 
-	g_return_val_if_fail(message != NULL, NULL);
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(done != NULL, FALSE);
 
-	ret = message->current;
-	message->current += strlen(ret) + 1;
+	deferred = j_message_get_deferred(connection, FALSE);
+	*done = TRUE;
+
+	if (deferred == NULL || (g_queue_is_empty(deferred->queue) && !deferred->requested))
+	{
+		return TRUE;
+	}
+
+	message = j_message_new(J_MESSAGE_NONE, 0);
+
+	if (!j_message_read(message, g_io_stream_get_input_stream(G_IO_STREAM(connection))) || j_message_get_type(message) != J_MESSAGE_ACKNOWLEDGE)
+	{
+		JMessageDeferred* message_deferred;
+
+		// The connection cannot be used anymore, so the outstanding replies will never arrive.
+		while ((message_deferred = g_queue_pop_head(deferred->queue)) != NULL)
+		{
+			j_message_deferred_free(message_deferred);
+		}
+
+		deferred->requested = FALSE;
+		deferred->failed = FALSE;
+
+		return FALSE;
+	}
+
+	j_message_dispatch_deferred(message, deferred);
+
+	// Coalesced replies always contain at least one reply, the reply to the request does not.
+	if (deferred->requested && GUINT32_FROM_LE(message->header.id) == deferred->request && j_message_get_count(message) == 0)
+	{
+		deferred->requested = FALSE;
+	}
+
+	*done = (g_queue_is_empty(deferred->queue) && !deferred->requested);
+
+	if (!*done)
+	{
+		return TRUE;
+	}
+
+	ret = !deferred->failed;
+	deferred->failed = FALSE;
 
 	return ret;
 }
 
 /**
- * Reads a message from the network.
+ * Returns the number of outstanding deferred replies.
  *
  * \code
  * \endcode
  *
- * \param message A message.
- * \parem stream  A network stream.
+ * \param connection A connection.
  *
- * \return TRUE on success, FALSE if an error occurred.
+ * \return The number of outstanding replies.
  **/
-gboolean
-j_message_receive(JMessage* message, gpointer connection)
+guint
+j_message_get_deferred_count(gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GInputStream* stream;
+	JMessageDeferredState* deferred;
 
-	g_return_val_if_fail(message != NULL, FALSE);
-	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(connection != NULL, 0);
 
-	stream = g_io_stream_get_input_stream(G_IO_STREAM(connection));
-	return j_message_read(message, stream);
+	deferred = j_message_get_deferred(connection, FALSE);
+
+	return (deferred != NULL) ? g_queue_get_length(deferred->queue) : 0;
 }
 
 /**
- * Writes a message to the network.
+ * Appends a reply to an acknowledgement message.
+ * This is used by the server to coalesce replies to deferred messages.
  *
  * \code
  * \endcode
  *
- * \param message A message.
- * \parem stream  A network stream.
- *
- * \return TRUE on success, FALSE if an error occurred.
+ * \param message An acknowledgement message.
+ * \param reply   A reply.
  **/
-gboolean
-j_message_send(JMessage* message, gpointer connection)
+void
+j_message_add_reply(JMessage* message, JMessage* reply)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
-
-	GOutputStream* stream;
-
-	g_return_val_if_fail(message != NULL, FALSE);
-	g_return_val_if_fail(connection != NULL, FALSE);
+	guint32 id;
+	guint32 op_count;
+	guint32 length;
 
-	j_helper_set_cork(connection, TRUE);
+	g_return_if_fail(message != NULL);
+	g_return_if_fail(reply != NULL);
+	g_return_if_fail(j_message_get_type(message) == J_MESSAGE_ACKNOWLEDGE);
+	g_return_if_fail(reply->send_count == 0);
 
-	stream = g_io_stream_get_output_stream(G_IO_STREAM(connection));
-	ret = j_message_write(message, stream);
+	id = GUINT32_FROM_LE(reply->header.id);
+	op_count = j_message_get_count(reply);
+	length = j_message_length(reply);
 
-	j_helper_set_cork(connection, FALSE);
+	j_message_add_operation(message, 3 * sizeof(guint32) + length);
+	j_message_append_4(message, &id);
+	j_message_append_4(message, &op_count);
+	j_message_append_4(message, &length);
 
-	return ret;
+	if (length > 0)
+	{
+		j_message_append_n(message, reply->data, length);
+	}
 }
 
 /**
@@ -904,13 +2181,22 @@ j_message_write(JMessage* message, GOutputStream* stream)
 
 	gboolean ret = FALSE;
 
-	g_autoptr(JListIterator) iterator = NULL;
 	GError* error = NULL;
 	gsize bytes_written;
 
+	guint64 send_length = 0;
+
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(stream != NULL, FALSE);
 
+	for (guint i = 0; i < message->send_count; i++)
+	{
+		send_length += message->send_data[i].length;
+	}
+
+	// Allows receivers to skip or buffer the additional data without interpreting the message.
+	message->header.send_length = GUINT64_TO_LE(send_length);
+
 	if (!g_output_stream_write_all(stream, &(message->header), sizeof(JMessageHeader), &bytes_written, NULL, &error) || bytes_written != sizeof(JMessageHeader))
 	{
 		goto end;
@@ -921,18 +2207,13 @@ j_message_write(JMessage* message, GOutputStream* stream)
 		goto end;
 	}
 
-	if (message->send_list != NULL)
+	for (guint i = 0; i < message->send_count; i++)
 	{
-		iterator = j_list_iterator_new(message->send_list);
+		JMessageData* message_data = &(message->send_data[i]);
 
-		while (j_list_iterator_next(iterator))
+		if (!g_output_stream_write_all(stream, message_data->data, message_data->length, &bytes_written, NULL, &error))
 		{
-			JMessageData* message_data = j_list_iterator_get(iterator);
-
-			if (!g_output_stream_write_all(stream, message_data->data, message_data->length, &bytes_written, NULL, &error))
-			{
-				goto end;
-			}
+			goto end;
 		}
 	}
 
@@ -971,11 +2252,26 @@ j_message_add_send(JMessage* message, gconstpointer data, guint64 length)
 	g_return_if_fail(data != NULL);
 	g_return_if_fail(length > 0);
 
-	message_data = g_slice_new(JMessageData);
+	if (message->send_count == message->send_size)
+	{
+		message->send_size *= 2;
+
+		if (message->send_data == message->send_inline)
+		{
+			message->send_data = g_new(JMessageData, message->send_size);
+			memcpy(message->send_data, message->send_inline, sizeof(message->send_inline));
+		}
+		else
+		{
+			message->send_data = g_renew(JMessageData, message->send_data, message->send_size);
+		}
+	}
+
+	message_data = &(message->send_data[message->send_count]);
 	message_data->data = data;
 	message_data->length = length;
 
-	j_list_append(message->send_list, message_data);
+	message->send_count++;
 }
 
 /**
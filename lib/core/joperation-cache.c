@@ -26,23 +26,45 @@
 
 #include <joperation-cache-internal.h>
 
-#include <jbackground-operation-internal.h>
+#include <jbatch.h>
+#include <jbatch-internal.h>
 #include <jcache.h>
 #include <jlist.h>
 #include <jlist-iterator.h>
-#include <jbatch.h>
-#include <jbatch-internal.h>
 #include <joperation-internal.h>
 #include <jtrace.h>
 
-#include <string.h>
-
 /**
  * \defgroup JOperationCache Operation Cache
  *
+ * The operation cache buffers batches that are executed with a persistency semantics of #J_SEMANTICS_PERSISTENCY_EVENTUAL.
+ * Data owned by the caller is copied into the cache, allowing j_batch_execute() to return immediately.
+ * Cached operations are flushed in the background, merging queued batches into as few executions as possible.
+ * Operations with the same key are always flushed by the same thread in the order they were cached.
+ * Batches with a strict ordering semantics are flushed as a whole by a single thread.
+ *
  * @{
  **/
 
+/**
+ * A flush thread.
+ */
+struct JOperationCacheThread
+{
+	/**
+	 * The queue of cached batches.
+	 * Contains JCachedBatch elements.
+	 */
+	GAsyncQueue* queue;
+
+	/**
+	 * The thread executing cached batches in the background.
+	 */
+	GThread* thread;
+};
+
+typedef struct JOperationCacheThread JOperationCacheThread;
+
 /**
  * An operation cache.
  */
@@ -54,171 +76,426 @@ struct JOperationCache
 	JCache* cache;
 
 	/**
-	 * The queue of operations.
+	 * The flush threads.
 	 */
-	GAsyncQueue* queue;
+	JOperationCacheThread* threads;
 
 	/**
-	 * The thread executing operations in the background.
+	 * The number of flush threads.
 	 */
-	GThread* thread;
+	guint thread_count;
+
+	/**
+	 * The number of cached batches that have not been executed yet.
+	 */
+	guint pending;
+
+	/**
+	 * Whether executing a cached batch has failed since the last flush.
+	 */
+	gboolean failed;
 
 	/**
-	 * Whether #thread is currently working.
+	 * The keys of cached operations that have not been executed yet.
+	 * Contains JOperationCacheKey elements.
 	 */
-	gboolean working;
+	GHashTable* keys;
 
 	/**
-	 * The mutex for #working.
+	 * The mutex for #pending, #failed and #keys.
 	 */
 	GMutex mutex[1];
 
 	/**
-	 * The condition for #working.
+	 * The condition for #pending.
 	 */
 	GCond cond[1];
 };
 
 typedef struct JOperationCache JOperationCache;
 
+/**
+ * A key with cached operations.
+ */
+struct JOperationCacheKey
+{
+	/**
+	 * The key.
+	 * This is the key of the most recently cached operation, which is executed last.
+	 */
+	gconstpointer key;
+
+	/**
+	 * The key's hash function, NULL to hash the key's address.
+	 */
+	GHashFunc key_hash;
+
+	/**
+	 * The key's equality function, NULL to compare the key's address.
+	 */
+	GEqualFunc key_equal;
+
+	/**
+	 * The thread the key's operations are flushed by.
+	 */
+	guint thread;
+
+	/**
+	 * The number of cached operations with this key.
+	 */
+	guint count;
+};
+
+typedef struct JOperationCacheKey JOperationCacheKey;
+
 struct JCachedBatch
 {
 	JBatch* batch;
 	gpointer data;
+
+	/**
+	 * The keys of the batch's operations, one per operation.
+	 * Contains JOperationCacheKey elements, only the key and its functions are set.
+	 */
+	GArray* keys;
 };
 
 typedef struct JCachedBatch JCachedBatch;
 
 static JOperationCache* j_operation_cache = NULL;
 
-static gpointer
-j_operation_cache_thread(gpointer data)
+// Set for flush threads, which must not wait for themselves.
+static GPrivate j_operation_cache_flushing;
+
+static void
+j_operation_cache_move(JOperation* operation, JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JOperationCache* cache = data;
-	JCachedBatch* cached_batch;
+	JOperation* new_operation;
+
+	new_operation = j_operation_new();
+	new_operation->key = operation->key;
+	new_operation->data = operation->data;
+	new_operation->key_hash = operation->key_hash;
+	new_operation->key_equal = operation->key_equal;
+	new_operation->exec_func = operation->exec_func;
+	new_operation->free_func = operation->free_func;
+	new_operation->cache_func = operation->cache_func;
 
-	while ((cached_batch = g_async_queue_pop(cache->queue)) != NULL)
+	// The data is now owned by the new operation.
+	operation->free_func = NULL;
+
+	j_batch_add(batch, new_operation);
+}
+
+static gboolean
+j_operation_cache_can_merge(JCachedBatch* cached_batch, JCachedBatch* other)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSemantics* semantics;
+	JSemantics* other_semantics;
+
+	JSemanticsType const types[] = {
+		J_SEMANTICS_ATOMICITY,
+		J_SEMANTICS_CONCURRENCY,
+		J_SEMANTICS_CONSISTENCY,
+		J_SEMANTICS_ORDERING,
+		J_SEMANTICS_PERSISTENCY,
+		J_SEMANTICS_SAFETY,
+		J_SEMANTICS_SECURITY
+	};
+
+	semantics = j_batch_get_semantics(cached_batch->batch);
+	other_semantics = j_batch_get_semantics(other->batch);
+
+	for (guint i = 0; i < G_N_ELEMENTS(types); i++)
 	{
-		/* data == cache, terminate */
-		if (cached_batch == data)
+		if (j_semantics_get(semantics, types[i]) != j_semantics_get(other_semantics, types[i]))
 		{
-			return NULL;
+			return FALSE;
 		}
+	}
 
-		j_batch_execute_internal(cached_batch->batch);
+	return TRUE;
+}
 
-		j_batch_unref(cached_batch->batch);
-		j_cache_release(j_operation_cache->cache, cached_batch->data);
-		g_slice_free(JCachedBatch, cached_batch);
+static void
+j_operation_cache_merge(JCachedBatch* cached_batch, JCachedBatch* other)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		g_mutex_lock(cache->mutex);
+	g_autoptr(JListIterator) iterator = NULL;
 
-		cache->working = (g_async_queue_length(cache->queue) > 0);
+	iterator = j_list_iterator_new(j_batch_get_operations(other->batch));
 
-		if (!cache->working)
-		{
-			g_cond_signal(cache->cond);
-		}
+	while (j_list_iterator_next(iterator))
+	{
+		j_operation_cache_move(j_list_iterator_get(iterator), cached_batch->batch);
+	}
+}
 
-		g_mutex_unlock(cache->mutex);
+static guint
+j_operation_cache_key_hash(gconstpointer data)
+{
+	JOperationCacheKey const* cache_key = data;
+
+	if (cache_key->key_hash != NULL)
+	{
+		return cache_key->key_hash(cache_key->key);
 	}
 
-	return NULL;
+	return g_direct_hash(cache_key->key);
 }
 
 static gboolean
-j_operation_cache_test(JOperation* operation)
+j_operation_cache_key_equal(gconstpointer a, gconstpointer b)
+{
+	JOperationCacheKey const* cache_key_a = a;
+	JOperationCacheKey const* cache_key_b = b;
+
+	// Keys of different types are never equal.
+	if (cache_key_a->key_equal != cache_key_b->key_equal)
+	{
+		return FALSE;
+	}
+
+	if (cache_key_a->key_equal != NULL)
+	{
+		return cache_key_a->key_equal(cache_key_a->key, cache_key_b->key);
+	}
+
+	return (cache_key_a->key == cache_key_b->key);
+}
+
+/**
+ * Initializes a key for looking up an operation's key.
+ *
+ * \private
+ *
+ * \param cache_key A key.
+ * \param operation An operation.
+ **/
+static void
+j_operation_cache_key_set(JOperationCacheKey* cache_key, JOperation const* operation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	cache_key->key = operation->key;
+	cache_key->key_hash = operation->key_hash;
+	cache_key->key_equal = operation->key_equal;
+	cache_key->thread = G_MAXUINT;
+	cache_key->count = 0;
+}
+
+static void
+j_operation_cache_key_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_slice_free(JOperationCacheKey, data);
+}
+
+/**
+ * Looks up a key.
+ * The cache's mutex has to be held.
+ *
+ * \private
+ *
+ * \param lookup The key to look up.
+ *
+ * \return The key's entry, NULL if the key does not have any cached operations.
+ **/
+static JOperationCacheKey*
+j_operation_cache_key_lookup(JOperationCacheKey const* lookup)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return g_hash_table_lookup(j_operation_cache->keys, lookup);
+}
+
+/**
+ * Returns the thread an operation's key is bound to.
+ * Unbound keys are assigned a thread based on their hash, so that equal keys are flushed by the same thread.
+ * The cache's mutex has to be held.
+ *
+ * \private
+ *
+ * \param operation The operation.
+ * \param bound     Returns whether the key is bound to the thread.
+ *
+ * \return The thread's index.
+ **/
+static guint
+j_operation_cache_key_get_thread(JOperation const* operation, gboolean* bound)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = FALSE;
+	JOperationCacheKey lookup;
+	JOperationCacheKey* cache_key;
 
-	(void)operation;
+	j_operation_cache_key_set(&lookup, operation);
+	cache_key = j_operation_cache_key_lookup(&lookup);
+	*bound = (cache_key != NULL);
 
-	/* FIXME
-	switch (operation->type)
+	if (cache_key != NULL)
 	{
-		case J_OPERATION_COLLECTION_CREATE:
-		case J_OPERATION_COLLECTION_DELETE:
-		case J_OPERATION_ITEM_CREATE:
-		case J_OPERATION_ITEM_DELETE:
-		case J_OPERATION_ITEM_WRITE:
-			ret = TRUE;
-			break;
+		return cache_key->thread;
+	}
 
-		case J_OPERATION_COLLECTION_GET:
-		case J_OPERATION_ITEM_GET:
-		case J_OPERATION_ITEM_GET_STATUS:
-		case J_OPERATION_ITEM_READ:
-			ret = FALSE;
-			break;
+	return j_operation_cache_key_hash(&lookup) % j_operation_cache->thread_count;
+}
+
+/**
+ * Releases the keys of executed operations, allowing them to be flushed by other threads again.
+ *
+ * \private
+ *
+ * \param cached_batch A cached batch.
+ **/
+static void
+j_operation_cache_unbind(JCachedBatch* cached_batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(j_operation_cache->mutex);
+
+	for (guint i = 0; i < cached_batch->keys->len; i++)
+	{
+		JOperationCacheKey* cache_key;
+
+		cache_key = j_operation_cache_key_lookup(&g_array_index(cached_batch->keys, JOperationCacheKey, i));
+		g_assert(cache_key != NULL);
+
+		cache_key->count--;
 
-		case J_OPERATION_NONE:
-		default:
-			g_warn_if_reached();
+		if (cache_key->count == 0)
+		{
+			g_hash_table_remove(j_operation_cache->keys, cache_key);
+		}
 	}
-	*/
 
-	return ret;
+	g_mutex_unlock(j_operation_cache->mutex);
 }
 
-static guint64
-j_operation_cache_get_required_size(JOperation* operation)
+static void
+j_operation_cache_release(JCachedBatch* cached_batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	guint64 ret = 0;
+	g_array_unref(cached_batch->keys);
 
-	(void)operation;
+	if (cached_batch->batch != NULL)
+	{
+		j_batch_unref(cached_batch->batch);
+	}
 
-	/* FIXME
-	switch (operation->type)
+	if (cached_batch->data != NULL)
 	{
-		case J_OPERATION_ITEM_WRITE:
-			ret = operation->item_write.length;
-			break;
+		j_cache_release(j_operation_cache->cache, cached_batch->data);
+	}
 
-		case J_OPERATION_COLLECTION_CREATE:
-		case J_OPERATION_COLLECTION_DELETE:
-		case J_OPERATION_ITEM_CREATE:
-		case J_OPERATION_ITEM_DELETE:
-		case J_OPERATION_COLLECTION_GET:
-		case J_OPERATION_ITEM_GET:
-		case J_OPERATION_ITEM_GET_STATUS:
-		case J_OPERATION_ITEM_READ:
-			ret = 0;
+	g_slice_free(JCachedBatch, cached_batch);
+}
+
+static gpointer
+j_operation_cache_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperationCacheThread* thread = data;
+	JCachedBatch* cached_batch;
+	JCachedBatch* next = NULL;
+
+	g_private_set(&j_operation_cache_flushing, GINT_TO_POINTER(TRUE));
+
+	while (TRUE)
+	{
+		g_autoptr(GPtrArray) merged = NULL;
+		gboolean ret;
+
+		cached_batch = (next != NULL) ? next : g_async_queue_pop(thread->queue);
+		next = NULL;
+
+		/* data == thread, terminate */
+		if (cached_batch == data)
+		{
 			break;
+		}
+
+		merged = g_ptr_array_new();
+		g_ptr_array_add(merged, cached_batch);
+
+		// Merge all queued batches that share the same semantics, they are executed together.
+		while ((next = g_async_queue_try_pop(thread->queue)) != NULL)
+		{
+			if (next == data || !j_operation_cache_can_merge(cached_batch, next))
+			{
+				break;
+			}
+
+			j_operation_cache_merge(cached_batch, next);
+			g_ptr_array_add(merged, next);
+		}
+
+		ret = j_batch_execute_internal(cached_batch->batch);
 
-		case J_OPERATION_NONE:
-		default:
-			g_warn_if_reached();
+		// Merged operations are owned by the first batch, so all keys have to be unbound before releasing it.
+		for (guint i = 0; i < merged->len; i++)
+		{
+			j_operation_cache_unbind(g_ptr_array_index(merged, i));
+		}
+
+		for (guint i = 0; i < merged->len; i++)
+		{
+			j_operation_cache_release(g_ptr_array_index(merged, i));
+		}
+
+		g_mutex_lock(j_operation_cache->mutex);
+
+		j_operation_cache->pending -= merged->len;
+		j_operation_cache->failed = j_operation_cache->failed || !ret;
+
+		if (j_operation_cache->pending == 0)
+		{
+			g_cond_broadcast(j_operation_cache->cond);
+		}
+
+		g_mutex_unlock(j_operation_cache->mutex);
 	}
-	*/
 
-	return ret;
+	return NULL;
 }
 
 void
-j_operation_cache_init(void)
+j_operation_cache_init(JConfiguration* configuration)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JOperationCache* cache;
 
 	g_return_if_fail(j_operation_cache == NULL);
+	g_return_if_fail(configuration != NULL);
 
 	cache = g_slice_new(JOperationCache);
-	cache->cache = j_cache_new(50 * 1024 * 1024);
-	cache->queue = g_async_queue_new_full(NULL);
-	cache->thread = g_thread_new("JOperationCache", j_operation_cache_thread, cache);
-	cache->working = FALSE;
+	cache->cache = j_cache_new(j_configuration_get_operation_cache_size(configuration));
+	cache->thread_count = j_configuration_get_operation_cache_threads(configuration);
+	cache->threads = g_new(JOperationCacheThread, cache->thread_count);
+	cache->pending = 0;
+	cache->failed = FALSE;
+	cache->keys = g_hash_table_new_full(j_operation_cache_key_hash, j_operation_cache_key_equal, j_operation_cache_key_free, NULL);
 
 	g_mutex_init(cache->mutex);
 	g_cond_init(cache->cond);
 
 	g_atomic_pointer_set(&j_operation_cache, cache);
+
+	for (guint i = 0; i < cache->thread_count; i++)
+	{
+		cache->threads[i].queue = g_async_queue_new_full(NULL);
+		cache->threads[i].thread = g_thread_new("JOperationCache", j_operation_cache_thread, &(cache->threads[i]));
+	}
 }
 
 void
@@ -233,14 +510,21 @@ j_operation_cache_fini(void)
 	j_operation_cache_flush();
 
 	cache = g_atomic_pointer_get(&j_operation_cache);
-	g_atomic_pointer_set(&j_operation_cache, NULL);
 
-	/* push fake cached batch */
-	g_async_queue_push(cache->queue, cache);
-	g_thread_join(cache->thread);
+	for (guint i = 0; i < cache->thread_count; i++)
+	{
+		/* push fake cached batch */
+		g_async_queue_push(cache->threads[i].queue, &(cache->threads[i]));
+		g_thread_join(cache->threads[i].thread);
+
+		g_async_queue_unref(cache->threads[i].queue);
+	}
+
+	g_atomic_pointer_set(&j_operation_cache, NULL);
 
-	g_async_queue_unref(cache->queue);
 	j_cache_free(cache->cache);
+	g_free(cache->threads);
+	g_hash_table_unref(cache->keys);
 
 	g_cond_clear(cache->cond);
 	g_mutex_clear(cache->mutex);
@@ -248,108 +532,248 @@ j_operation_cache_fini(void)
 	g_slice_free(JOperationCache, cache);
 }
 
+/**
+ * Waits for all cached batches to be executed.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \return TRUE if all cached batches have been executed successfully, FALSE otherwise.
+ **/
 gboolean
 j_operation_cache_flush(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
+	gboolean ret;
+
+	// Operations executed by flush threads may execute batches themselves.
+	if (g_private_get(&j_operation_cache_flushing) != NULL)
+	{
+		return TRUE;
+	}
 
 	g_mutex_lock(j_operation_cache->mutex);
 
-	while (j_operation_cache->working)
+	while (j_operation_cache->pending > 0)
 	{
 		g_cond_wait(j_operation_cache->cond, j_operation_cache->mutex);
 	}
 
+	ret = !j_operation_cache->failed;
+	j_operation_cache->failed = FALSE;
+
 	g_mutex_unlock(j_operation_cache->mutex);
 
 	return ret;
 }
 
+/**
+ * Adds a batch to the cache.
+ * With relaxed ordering semantics, the batch's operations are distributed to the flush threads according to their keys.
+ * With strict ordering semantics, the whole batch is flushed by a single thread to preserve the order of operations with different keys.
+ * Keys stay bound to their thread while they have cached operations, so operations with the same key are never reordered across batches.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param batch A batch.
+ *
+ * \return TRUE if the batch has been cached, FALSE if it has to be executed directly.
+ **/
 gboolean
 j_operation_cache_add(JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	guint const thread_count = j_operation_cache->thread_count;
+
 	gboolean ret = TRUE;
-	JCachedBatch* cached_batch;
 	JList* operations;
-	JListIterator* iterator;
-	gboolean can_cache = TRUE;
-	gchar* data;
-	gpointer buffer;
-	guint64 required_size = 0;
+	g_autoptr(JListIterator) iterator = NULL;
+	g_autofree guint* indices = NULL;
+	g_autofree guint64* required_sizes = NULL;
+	g_autofree JCachedBatch** cached_batches = NULL;
+	g_autofree gchar** positions = NULL;
+	gboolean strict;
+	guint count = 0;
+	guint i;
 
 	operations = j_batch_get_operations(batch);
+	strict = (j_semantics_get(j_batch_get_semantics(batch), J_SEMANTICS_ORDERING) == J_SEMANTICS_ORDERING_STRICT);
+	indices = g_new(guint, j_list_length(operations));
+	required_sizes = g_new0(guint64, thread_count);
+
+	// The mutex prevents keys from being bound to other threads until the batch has been queued.
+	g_mutex_lock(j_operation_cache->mutex);
+
+	if (strict)
+	{
+		guint thread = G_MAXUINT;
+
+		iterator = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(iterator))
+		{
+			JOperation* operation = j_list_iterator_get(iterator);
+			gboolean bound;
+			guint key_thread = j_operation_cache_key_get_thread(operation, &bound);
+
+			if (!bound)
+			{
+				continue;
+			}
+
+			// The batch's keys are bound to different threads, it can not be flushed by one of them without reordering.
+			if (thread != G_MAXUINT && thread != key_thread)
+			{
+				g_mutex_unlock(j_operation_cache->mutex);
+
+				return FALSE;
+			}
+
+			thread = key_thread;
+		}
+
+		if (thread == G_MAXUINT)
+		{
+			gboolean bound;
+
+			thread = j_operation_cache_key_get_thread(j_list_get_first(operations), &bound);
+		}
+
+		for (i = 0; i < j_list_length(operations); i++)
+		{
+			indices[i] = thread;
+		}
+
+		g_clear_pointer(&iterator, j_list_iterator_free);
+	}
+	else
+	{
+		iterator = j_list_iterator_new(operations);
+
+		for (i = 0; j_list_iterator_next(iterator); i++)
+		{
+			JOperation* operation = j_list_iterator_get(iterator);
+			gboolean bound;
+
+			indices[i] = j_operation_cache_key_get_thread(operation, &bound);
+		}
+
+		g_clear_pointer(&iterator, j_list_iterator_free);
+	}
+
 	iterator = j_list_iterator_new(operations);
 
-	while (j_list_iterator_next(iterator))
+	for (i = 0; j_list_iterator_next(iterator); i++)
 	{
 		JOperation* operation = j_list_iterator_get(iterator);
 
-		can_cache = j_operation_cache_test(operation) && can_cache;
-
-		if (!can_cache)
+		if (operation->cache_func == NULL)
 		{
-			ret = FALSE;
-			break;
+			g_mutex_unlock(j_operation_cache->mutex);
+
+			return FALSE;
 		}
 
-		required_size += j_operation_cache_get_required_size(operation);
+		required_sizes[indices[i]] += operation->cache_func(operation->data, NULL);
 	}
 
-	j_list_iterator_free(iterator);
+	cached_batches = g_new0(JCachedBatch*, thread_count);
+	positions = g_new0(gchar*, thread_count);
 
-	// FIXME never cleared
-	if ((buffer = j_cache_get(j_operation_cache->cache, required_size)) == NULL)
+	for (i = 0; i < thread_count; i++)
 	{
-		ret = FALSE;
+		cached_batches[i] = g_slice_new(JCachedBatch);
+		cached_batches[i]->batch = NULL;
+		cached_batches[i]->data = NULL;
+		cached_batches[i]->keys = g_array_new(FALSE, FALSE, sizeof(JOperationCacheKey));
+
+		if (required_sizes[i] > 0 && (cached_batches[i]->data = j_cache_get(j_operation_cache->cache, required_sizes[i])) == NULL)
+		{
+			ret = FALSE;
+		}
+
+		positions[i] = cached_batches[i]->data;
 	}
 
 	if (!ret)
 	{
+		g_mutex_unlock(j_operation_cache->mutex);
+
+		// The cache is full, release all segments that could be allocated.
+		for (i = 0; i < thread_count; i++)
+		{
+			j_operation_cache_release(cached_batches[i]);
+		}
+
 		return FALSE;
 	}
 
-	data = buffer;
+	g_clear_pointer(&iterator, j_list_iterator_free);
 	iterator = j_list_iterator_new(operations);
 
-	while (j_list_iterator_next(iterator))
+	for (i = 0; j_list_iterator_next(iterator); i++)
 	{
-		/* FIXME
 		JOperation* operation = j_list_iterator_get(iterator);
+		JOperationCacheKey lookup;
+		JOperationCacheKey* cache_key;
+		guint index = indices[i];
 
-		if (operation->type == J_OPERATION_ITEM_WRITE)
+		if (cached_batches[index]->batch == NULL)
 		{
-			memcpy(data, operation->item_write.data, operation->item_write.length);
+			cached_batches[index]->batch = j_batch_new(j_batch_get_semantics(batch));
+			count++;
+		}
 
-			operation->item_write.data = data;
-			*(operation->item_write.bytes_written) += operation->item_write.length;
-			operation->item_write.bytes_written = NULL;
+		j_operation_cache_key_set(&lookup, operation);
+		cache_key = j_operation_cache_key_lookup(&lookup);
 
-			data += operation->item_write.length;
+		if (cache_key == NULL)
+		{
+			cache_key = g_slice_new(JOperationCacheKey);
+			j_operation_cache_key_set(cache_key, operation);
+			cache_key->thread = index;
+
+			g_hash_table_add(j_operation_cache->keys, cache_key);
 		}
-		*/
-		(void)data;
+
+		// Keys might point into their operations, the most recent operation stays alive the longest.
+		cache_key->key = operation->key;
+		cache_key->count++;
+		g_array_append_val(cached_batches[index]->keys, lookup);
+
+		positions[index] += operation->cache_func(operation->data, positions[index]);
+		j_operation_cache_move(operation, cached_batches[index]->batch);
 	}
 
-	j_list_iterator_free(iterator);
+	j_list_delete_all(operations);
 
-	if (!ret)
+	j_operation_cache->pending += count;
+
+	// Queue while holding the mutex so that batches are queued in the order their keys have been bound.
+	for (i = 0; i < thread_count; i++)
 	{
-		return FALSE;
+		if (cached_batches[i]->batch != NULL)
+		{
+			g_async_queue_push(j_operation_cache->threads[i].queue, cached_batches[i]);
+		}
+		else
+		{
+			j_operation_cache_release(cached_batches[i]);
+		}
 	}
 
-	g_mutex_lock(j_operation_cache->mutex);
-	j_operation_cache->working = TRUE;
 	g_mutex_unlock(j_operation_cache->mutex);
 
-	cached_batch = g_slice_new(JCachedBatch);
-	cached_batch->batch = j_batch_new_from_batch(batch);
-	cached_batch->data = buffer;
-
-	g_async_queue_push(j_operation_cache->queue, cached_batch);
-
 	return ret;
 }
+
+/**
+ * @}
+ **/
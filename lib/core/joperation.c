@@ -52,8 +52,11 @@ j_operation_new(void)
 	operation = g_slice_new(JOperation);
 	operation->key = NULL;
 	operation->data = NULL;
+	operation->key_hash = NULL;
+	operation->key_equal = NULL;
 	operation->exec_func = NULL;
 	operation->free_func = NULL;
+	operation->cache_func = NULL;
 
 	return operation;
 }
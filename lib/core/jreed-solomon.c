@@ -0,0 +1,516 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include <jreed-solomon.h>
+
+#include <jtrace.h>
+
+/**
+ * \defgroup JReedSolomon Reed-Solomon
+ *
+ * Systematic Reed-Solomon erasure coding over GF(2^8).
+ *
+ * @{
+ **/
+
+/**
+ * A Reed-Solomon code with k data blocks and m parity blocks.
+ *
+ * Parity is computed using a Cauchy matrix, so any k of the k + m blocks suffice to reconstruct the data.
+ **/
+struct JReedSolomon
+{
+	/**
+	 * The number of data blocks.
+	 **/
+	guint data_blocks;
+
+	/**
+	 * The number of parity blocks.
+	 **/
+	guint parity_blocks;
+
+	/**
+	 * The parity matrix with parity_blocks rows and data_blocks columns.
+	 **/
+	guint8* matrix;
+};
+
+typedef void (*JReedSolomonMulAddFunc)(guint8*, guint8 const*, guint8, gsize);
+
+static guint8 j_reed_solomon_exp[512];
+static guint8 j_reed_solomon_log[256];
+
+static JReedSolomonMulAddFunc j_reed_solomon_mul_add = NULL;
+
+static guint8
+j_reed_solomon_mul(guint8 a, guint8 b)
+{
+	if (a == 0 || b == 0)
+	{
+		return 0;
+	}
+
+	return j_reed_solomon_exp[j_reed_solomon_log[a] + j_reed_solomon_log[b]];
+}
+
+static guint8
+j_reed_solomon_inv(guint8 a)
+{
+	g_return_val_if_fail(a != 0, 0);
+
+	return j_reed_solomon_exp[255 - j_reed_solomon_log[a]];
+}
+
+/**
+ * Computes dst ^= c * src.
+ *
+ * \private
+ *
+ * \param dst    The destination.
+ * \param src    The source.
+ * \param c      A coefficient.
+ * \param length The length.
+ **/
+static void
+j_reed_solomon_mul_add_scalar(guint8* dst, guint8 const* src, guint8 c, gsize length)
+{
+	guint8 table[256];
+
+	for (guint i = 0; i < 256; i++)
+	{
+		table[i] = j_reed_solomon_mul(c, i);
+	}
+
+	for (gsize i = 0; i < length; i++)
+	{
+		dst[i] ^= table[src[i]];
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+/**
+ * Computes dst ^= c * src using 128-bit table lookups.
+ * Products are split into the products of the low and high nibbles, which fit into 16-entry tables.
+ *
+ * \private
+ *
+ * \param dst    The destination.
+ * \param src    The source.
+ * \param c      A coefficient.
+ * \param length The length.
+ **/
+__attribute__((target("ssse3"))) static void
+j_reed_solomon_mul_add_ssse3(guint8* dst, guint8 const* src, guint8 c, gsize length)
+{
+	guint8 low[16];
+	guint8 high[16];
+	__m128i table_low;
+	__m128i table_high;
+	__m128i mask;
+	gsize i = 0;
+
+	for (guint j = 0; j < 16; j++)
+	{
+		low[j] = j_reed_solomon_mul(c, j);
+		high[j] = j_reed_solomon_mul(c, j << 4);
+	}
+
+	table_low = _mm_loadu_si128((__m128i const*)low);
+	table_high = _mm_loadu_si128((__m128i const*)high);
+	mask = _mm_set1_epi8(0x0f);
+
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i s;
+		__m128i d;
+		__m128i l;
+		__m128i h;
+
+		s = _mm_loadu_si128((__m128i const*)(src + i));
+		d = _mm_loadu_si128((__m128i const*)(dst + i));
+		l = _mm_shuffle_epi8(table_low, _mm_and_si128(s, mask));
+		h = _mm_shuffle_epi8(table_high, _mm_and_si128(_mm_srli_epi64(s, 4), mask));
+		d = _mm_xor_si128(d, _mm_xor_si128(l, h));
+		_mm_storeu_si128((__m128i*)(dst + i), d);
+	}
+
+	for (; i < length; i++)
+	{
+		dst[i] ^= low[src[i] & 0x0f] ^ high[src[i] >> 4];
+	}
+}
+
+/**
+ * Computes dst ^= c * src using 256-bit table lookups.
+ *
+ * \private
+ *
+ * \param dst    The destination.
+ * \param src    The source.
+ * \param c      A coefficient.
+ * \param length The length.
+ **/
+__attribute__((target("avx2"))) static void
+j_reed_solomon_mul_add_avx2(guint8* dst, guint8 const* src, guint8 c, gsize length)
+{
+	guint8 low[16];
+	guint8 high[16];
+	__m256i table_low;
+	__m256i table_high;
+	__m256i mask;
+	gsize i = 0;
+
+	for (guint j = 0; j < 16; j++)
+	{
+		low[j] = j_reed_solomon_mul(c, j);
+		high[j] = j_reed_solomon_mul(c, j << 4);
+	}
+
+	// The shuffle works on both 128-bit lanes separately, so the tables are duplicated.
+	table_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const*)low));
+	table_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const*)high));
+	mask = _mm256_set1_epi8(0x0f);
+
+	for (; i + 32 <= length; i += 32)
+	{
+		__m256i s;
+		__m256i d;
+		__m256i l;
+		__m256i h;
+
+		s = _mm256_loadu_si256((__m256i const*)(src + i));
+		d = _mm256_loadu_si256((__m256i const*)(dst + i));
+		l = _mm256_shuffle_epi8(table_low, _mm256_and_si256(s, mask));
+		h = _mm256_shuffle_epi8(table_high, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask));
+		d = _mm256_xor_si256(d, _mm256_xor_si256(l, h));
+		_mm256_storeu_si256((__m256i*)(dst + i), d);
+	}
+
+	for (; i < length; i++)
+	{
+		dst[i] ^= low[src[i] & 0x0f] ^ high[src[i] >> 4];
+	}
+}
+#endif
+
+static gpointer
+j_reed_solomon_init(gpointer data)
+{
+	guint x = 1;
+
+	(void)data;
+
+	// Generator 2 with the polynomial x^8 + x^4 + x^3 + x^2 + 1
+	for (guint i = 0; i < 255; i++)
+	{
+		j_reed_solomon_exp[i] = x;
+		j_reed_solomon_exp[i + 255] = x;
+		j_reed_solomon_log[x] = i;
+
+		x <<= 1;
+
+		if (x & 0x100)
+		{
+			x ^= 0x11d;
+		}
+	}
+
+	j_reed_solomon_mul_add = j_reed_solomon_mul_add_scalar;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+	{
+		j_reed_solomon_mul_add = j_reed_solomon_mul_add_avx2;
+	}
+	else if (__builtin_cpu_supports("ssse3"))
+	{
+		j_reed_solomon_mul_add = j_reed_solomon_mul_add_ssse3;
+	}
+#endif
+
+	return NULL;
+}
+
+/**
+ * Creates a new Reed-Solomon code.
+ *
+ * \code
+ * JReedSolomon* rs;
+ *
+ * rs = j_reed_solomon_new(4, 2);
+ * \endcode
+ *
+ * \param data_blocks   The number of data blocks.
+ * \param parity_blocks The number of parity blocks.
+ *
+ * \return A new Reed-Solomon code. Should be freed with j_reed_solomon_free().
+ **/
+JReedSolomon*
+j_reed_solomon_new(guint data_blocks, guint parity_blocks)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static GOnce init_once = G_ONCE_INIT;
+
+	JReedSolomon* rs;
+
+	g_return_val_if_fail(data_blocks > 0, NULL);
+	g_return_val_if_fail(data_blocks + parity_blocks <= 256, NULL);
+
+	g_once(&init_once, j_reed_solomon_init, NULL);
+
+	rs = g_slice_new(JReedSolomon);
+	rs->data_blocks = data_blocks;
+	rs->parity_blocks = parity_blocks;
+	rs->matrix = g_new(guint8, parity_blocks * data_blocks);
+
+	// Cauchy matrix with x_i = data_blocks + i and y_j = j
+	for (guint i = 0; i < parity_blocks; i++)
+	{
+		for (guint j = 0; j < data_blocks; j++)
+		{
+			rs->matrix[i * data_blocks + j] = j_reed_solomon_inv((data_blocks + i) ^ j);
+		}
+	}
+
+	return rs;
+}
+
+/**
+ * Frees the memory allocated for a Reed-Solomon code.
+ *
+ * \code
+ * \endcode
+ *
+ * \param rs A Reed-Solomon code.
+ **/
+void
+j_reed_solomon_free(JReedSolomon* rs)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(rs != NULL);
+
+	g_free(rs->matrix);
+
+	g_slice_free(JReedSolomon, rs);
+}
+
+/**
+ * Computes parity blocks.
+ *
+ * \code
+ * \endcode
+ *
+ * \param rs     A Reed-Solomon code.
+ * \param data   The data blocks.
+ * \param parity The parity blocks.
+ * \param length The length of each block.
+ **/
+void
+j_reed_solomon_encode(JReedSolomon* rs, guint8 const* const* data, guint8** parity, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(rs != NULL);
+	g_return_if_fail(data != NULL);
+	g_return_if_fail(parity != NULL || rs->parity_blocks == 0);
+
+	for (guint i = 0; i < rs->parity_blocks; i++)
+	{
+		memset(parity[i], 0, length);
+
+		for (guint j = 0; j < rs->data_blocks; j++)
+		{
+			j_reed_solomon_mul_add(parity[i], data[j], rs->matrix[i * rs->data_blocks + j], length);
+		}
+	}
+}
+
+/**
+ * Reconstructs missing data blocks.
+ * Missing parity blocks are not reconstructed, they can be computed with j_reed_solomon_encode().
+ *
+ * \code
+ * \endcode
+ *
+ * \param rs      A Reed-Solomon code.
+ * \param blocks  The data blocks followed by the parity blocks. Missing data blocks have to point to buffers that receive the data.
+ * \param present Whether the respective block is present.
+ * \param length  The length of each block.
+ *
+ * \return TRUE if all data blocks are available, FALSE if too many blocks are missing.
+ **/
+gboolean
+j_reed_solomon_decode(JReedSolomon* rs, guint8** blocks, gboolean const* present, gsize length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guint8* matrix = NULL;
+	g_autofree guint8* inverse = NULL;
+	g_autofree guint* rows = NULL;
+	guint count = 0;
+	guint k;
+	gboolean missing = FALSE;
+
+	g_return_val_if_fail(rs != NULL, FALSE);
+	g_return_val_if_fail(blocks != NULL, FALSE);
+	g_return_val_if_fail(present != NULL, FALSE);
+
+	k = rs->data_blocks;
+
+	for (guint i = 0; i < k; i++)
+	{
+		missing = missing || !present[i];
+	}
+
+	if (!missing)
+	{
+		return TRUE;
+	}
+
+	rows = g_new(guint, k);
+
+	// Prefer data blocks, since their rows of the encoding matrix are trivial.
+	for (guint i = 0; i < k + rs->parity_blocks && count < k; i++)
+	{
+		if (present[i])
+		{
+			rows[count] = i;
+			count++;
+		}
+	}
+
+	if (count < k)
+	{
+		return FALSE;
+	}
+
+	matrix = g_new0(guint8, k * k);
+	inverse = g_new0(guint8, k * k);
+
+	for (guint i = 0; i < k; i++)
+	{
+		if (rows[i] < k)
+		{
+			matrix[i * k + rows[i]] = 1;
+		}
+		else
+		{
+			memcpy(matrix + i * k, rs->matrix + (rows[i] - k) * k, k);
+		}
+
+		inverse[i * k + i] = 1;
+	}
+
+	// Gauss-Jordan elimination
+	for (guint col = 0; col < k; col++)
+	{
+		guint pivot = col;
+		guint8 factor;
+
+		while (pivot < k && matrix[pivot * k + col] == 0)
+		{
+			pivot++;
+		}
+
+		// Cannot happen for Cauchy matrices.
+		g_return_val_if_fail(pivot < k, FALSE);
+
+		if (pivot != col)
+		{
+			for (guint j = 0; j < k; j++)
+			{
+				guint8 tmp;
+
+				tmp = matrix[col * k + j];
+				matrix[col * k + j] = matrix[pivot * k + j];
+				matrix[pivot * k + j] = tmp;
+
+				tmp = inverse[col * k + j];
+				inverse[col * k + j] = inverse[pivot * k + j];
+				inverse[pivot * k + j] = tmp;
+			}
+		}
+
+		factor = j_reed_solomon_inv(matrix[col * k + col]);
+
+		for (guint j = 0; j < k; j++)
+		{
+			matrix[col * k + j] = j_reed_solomon_mul(matrix[col * k + j], factor);
+			inverse[col * k + j] = j_reed_solomon_mul(inverse[col * k + j], factor);
+		}
+
+		for (guint i = 0; i < k; i++)
+		{
+			guint8 f;
+
+			if (i == col || matrix[i * k + col] == 0)
+			{
+				continue;
+			}
+
+			f = matrix[i * k + col];
+
+			for (guint j = 0; j < k; j++)
+			{
+				matrix[i * k + j] ^= j_reed_solomon_mul(f, matrix[col * k + j]);
+				inverse[i * k + j] ^= j_reed_solomon_mul(f, inverse[col * k + j]);
+			}
+		}
+	}
+
+	// Missing data block i is row i of the inverse applied to the selected blocks.
+	for (guint i = 0; i < k; i++)
+	{
+		if (present[i])
+		{
+			continue;
+		}
+
+		memset(blocks[i], 0, length);
+
+		for (guint j = 0; j < k; j++)
+		{
+			j_reed_solomon_mul_add(blocks[i], blocks[rows[j]], inverse[i * k + j], length);
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * @}
+ **/
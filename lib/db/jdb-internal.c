@@ -51,6 +51,24 @@ j_db_error_quark(void)
 	return g_quark_from_static_string("j-db-error-quark");
 }
 
+static guint
+j_db_key_hash(gconstpointer key)
+{
+	JDBSchema const* schema = key;
+
+	return g_str_hash(schema->namespace) ^ g_str_hash(schema->name);
+}
+
+static gboolean
+j_db_key_equal(gconstpointer a, gconstpointer b)
+{
+	JDBSchema const* schema_a = a;
+	JDBSchema const* schema_b = b;
+
+	// Different schema objects referring to the same schema are equal.
+	return (g_str_equal(schema_a->namespace, schema_b->namespace) && g_str_equal(schema_a->name, schema_b->name));
+}
+
 static gboolean
 j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType type)
 {
@@ -59,8 +77,6 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 	JBackendOperation* data = NULL;
 	gboolean ret = TRUE;
 	GSocketConnection* db_connection;
-	g_autoptr(JListIterator) iter_send = NULL;
-	g_autoptr(JListIterator) iter_recieve = NULL;
 	g_autoptr(JMessage) message = NULL;
 	g_autoptr(JMessage) reply = NULL;
 	JBackend* db_backend = j_db_get_backend();
@@ -72,11 +88,9 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 		message = j_message_new(type, 0);
 	}
 
-	iter_send = j_list_iterator_new(operations);
-
-	while (j_list_iterator_next(iter_send))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		data = j_list_iterator_get(iter_send);
+		data = j_list_get_nth(operations, i);
 
 		if (db_backend != NULL)
 		{
@@ -119,13 +133,18 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 		db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, 0);
 		j_message_send(message, db_connection);
 		reply = j_message_new_reply(message);
-		j_message_receive(reply, db_connection);
-		iter_recieve = j_list_iterator_new(operations);
 
-		while (j_list_iterator_next(iter_recieve))
+		if (j_message_receive(reply, db_connection))
+		{
+			for (guint i = 0; i < j_list_length(operations); i++)
+			{
+				data = j_list_get_nth(operations, i);
+				ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
+			}
+		}
+		else
 		{
-			data = j_list_iterator_get(iter_recieve);
-			ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
+			ret = FALSE;
 		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_DB, 0, db_connection);
@@ -155,6 +174,21 @@ j_backend_db_func_free(gpointer _data)
 	}
 }
 
+static guint64
+j_backend_db_func_cache(gpointer _data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendOperation* data = _data;
+
+	(void)buffer;
+
+	// The caller's error can not be set anymore when the operation is executed later.
+	data->out_param[data->out_param_count - 1].ptr = NULL;
+
+	return 0;
+}
+
 static gboolean
 j_db_schema_create_exec(JList* operations, JSemantics* semantics)
 {
@@ -185,10 +219,13 @@ j_db_internal_schema_create(JDBSchema* j_db_schema, JBatch* batch, GError** erro
 	data->unref_values[0] = j_db_schema_ref(j_db_schema);
 
 	op = j_operation_new();
-	op->key = j_db_schema->namespace;
+	op->key = j_db_schema;
+	op->key_hash = j_db_key_hash;
+	op->key_equal = j_db_key_equal;
 	op->data = data;
 	op->exec_func = j_db_schema_create_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -225,7 +262,9 @@ j_db_internal_schema_get(JDBSchema* j_db_schema, JBatch* batch, GError** error)
 	data->unref_values[0] = j_db_schema_ref(j_db_schema);
 
 	op = j_operation_new();
-	op->key = j_db_schema->namespace;
+	op->key = j_db_schema;
+	op->key_hash = j_db_key_hash;
+	op->key_equal = j_db_key_equal;
 	op->data = data;
 	op->exec_func = j_db_schema_get_exec;
 	op->free_func = j_backend_db_func_free;
@@ -264,10 +303,13 @@ j_db_internal_schema_delete(JDBSchema* j_db_schema, JBatch* batch, GError** erro
 	data->unref_values[0] = j_db_schema_ref(j_db_schema);
 
 	op = j_operation_new();
-	op->key = j_db_schema->namespace;
+	op->key = j_db_schema;
+	op->key_hash = j_db_key_hash;
+	op->key_equal = j_db_key_equal;
 	op->data = data;
 	op->exec_func = j_db_schema_delete_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -305,10 +347,13 @@ j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** error)
 	data->unref_values[0] = j_db_entry_ref(j_db_entry);
 
 	op = j_operation_new();
-	op->key = j_db_entry->schema->namespace;
+	op->key = j_db_entry->schema;
+	op->key_hash = j_db_key_hash;
+	op->key_equal = j_db_key_equal;
 	op->data = data;
 	op->exec_func = j_db_insert_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -348,10 +393,13 @@ j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* b
 	data->unref_values[1] = j_db_selector_ref(j_db_selector);
 
 	op = j_operation_new();
-	op->key = j_db_entry->schema->namespace;
+	op->key = j_db_entry->schema;
+	op->key_hash = j_db_key_hash;
+	op->key_equal = j_db_key_equal;
 	op->data = data;
 	op->exec_func = j_db_update_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -390,10 +438,13 @@ j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* b
 	data->unref_values[1] = j_db_selector_ref(j_db_selector);
 
 	op = j_operation_new();
-	op->key = j_db_entry->schema->namespace;
+	op->key = j_db_entry->schema;
+	op->key_hash = j_db_key_hash;
+	op->key_equal = j_db_key_equal;
 	op->data = data;
 	op->exec_func = j_db_delete_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -441,7 +492,9 @@ j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBItera
 	data->unref_values[2] = j_db_iterator_ref(j_db_iterator);
 
 	op = j_operation_new();
-	op->key = j_db_schema->namespace;
+	op->key = j_db_schema;
+	op->key_hash = j_db_key_hash;
+	op->key_equal = j_db_key_equal;
 	op->data = data;
 	op->exec_func = j_db_query_exec;
 	op->free_func = j_backend_db_func_free;
@@ -1197,6 +1197,9 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 
 	dset->data_size = data_size;
 
+	// Small datasets should not be split into many blocks, large ones should be stored in large blocks.
+	j_distribution_set_size_hint(dset->distribution, data_size);
+
 	batch = j_batch_new(j_hdf5_semantics);
 
 	switch (loc_params->obj_type)
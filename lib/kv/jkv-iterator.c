@@ -256,7 +256,15 @@ j_kv_iterator_next(JKVIterator* iterator)
 	else
 	{
 	retry:
-		iterator->len = j_message_get_4(iterator->replies[iterator->replies_cur]);
+		// Rejected messages do not contain any data.
+		if (j_message_get_flags(iterator->replies[iterator->replies_cur]) & J_MESSAGE_FLAGS_FAILED)
+		{
+			iterator->len = 0;
+		}
+		else
+		{
+			iterator->len = j_message_get_4(iterator->replies[iterator->replies_cur]);
+		}
 
 		if (iterator->len > 0)
 		{
@@ -149,6 +149,23 @@ j_kv_fini(void)
 	}
 }
 
+static guint
+j_kv_key_hash(gconstpointer key)
+{
+	JKV const* kv = key;
+
+	return g_str_hash(kv->namespace) ^ g_str_hash(kv->key);
+}
+
+static gboolean
+j_kv_key_equal(gconstpointer a, gconstpointer b)
+{
+	JKV const* kv_a = a;
+	JKV const* kv_b = b;
+
+	return (kv_a->index == kv_b->index && g_str_equal(kv_a->namespace, kv_b->namespace) && g_str_equal(kv_a->key, kv_b->key));
+}
+
 static void
 j_kv_put_free(gpointer data)
 {
@@ -188,6 +205,67 @@ j_kv_get_free(gpointer data)
 	g_slice_free(JKVOperation, operation);
 }
 
+static guint64
+j_kv_put_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	// Values with a destroy function are owned by the operation and do not have to be copied.
+	if (operation->put.value_destroy != NULL)
+	{
+		return 0;
+	}
+
+	if (buffer != NULL)
+	{
+		memcpy(buffer, operation->put.value, operation->put.value_len);
+		operation->put.value = buffer;
+	}
+
+	return operation->put.value_len;
+}
+
+static guint64
+j_kv_delete_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+	(void)buffer;
+
+	return 0;
+}
+
+/**
+ * Checks the statuses contained in a reply to a put or delete message.
+ *
+ * \private
+ *
+ * \param reply A reply.
+ * \param count The number of operations contained in the reply.
+ * \param data  Unused.
+ *
+ * \return TRUE if all operations succeeded, FALSE otherwise.
+ **/
+static gboolean
+j_kv_modify_reply(JMessage* reply, guint32 count, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	(void)data;
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		ret = (j_message_get_4(reply) == 1) && ret;
+	}
+
+	return ret;
+}
+
 static gboolean
 j_kv_put_exec(JList* operations, JSemantics* semantics)
 {
@@ -196,7 +274,6 @@ j_kv_put_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* kv_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
 	JSemanticsSafety safety;
 	gchar const* namespace;
@@ -219,7 +296,6 @@ j_kv_put_exec(JList* operations, JSemantics* semantics)
 	}
 
 	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-	it = j_list_iterator_new(operations);
 	kv_backend = j_kv_get_backend();
 
 	if (kv_backend != NULL)
@@ -236,14 +312,24 @@ j_kv_put_exec(JList* operations, JSemantics* semantics)
 		 * - The second operation is executed first and fails because the item does not exist.
 		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
 		 **/
-		message = j_message_new(J_MESSAGE_KV_PUT, namespace_len);
+		gsize length = namespace_len;
+
+		// Precompute the exact message size to avoid resizing the message while appending operations.
+		for (guint i = 0; i < j_list_length(operations); i++)
+		{
+			JKVOperation* kop = j_list_get_nth(operations, i);
+
+			length += strlen(kop->put.kv->key) + 1 + 4 + kop->put.value_len;
+		}
+
+		message = j_message_new(J_MESSAGE_KV_PUT, length);
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JKVOperation* kop = j_list_iterator_get(it);
+		JKVOperation* kop = j_list_get_nth(operations, i);
 
 		if (kv_backend != NULL)
 		{
@@ -271,16 +357,31 @@ j_kv_put_exec(JList* operations, JSemantics* semantics)
 		gpointer kv_connection;
 
 		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		if ((safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE) && j_configuration_get_coalesce_replies(j_configuration()))
+		{
+			// Failures reported by the reply are returned when the batch collects its replies.
+			ret = j_message_send_deferred(message, kv_connection, j_kv_modify_reply, NULL) && ret;
+		}
+		else
 		{
-			g_autoptr(JMessage) reply = NULL;
+			ret = j_message_send(message, kv_connection) && ret;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				g_autoptr(JMessage) reply = NULL;
+
+				reply = j_message_new_reply(message);
 
-			/* FIXME do something with reply */
+				if (j_message_receive(reply, kv_connection))
+				{
+					ret = j_kv_modify_reply(reply, j_message_get_count(reply), NULL) && ret;
+				}
+				else
+				{
+					ret = FALSE;
+				}
+			}
 		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
@@ -297,7 +398,6 @@ j_kv_delete_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* kv_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
 	JSemanticsSafety safety;
 	gchar const* namespace;
@@ -320,7 +420,6 @@ j_kv_delete_exec(JList* operations, JSemantics* semantics)
 	}
 
 	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-	it = j_list_iterator_new(operations);
 	kv_backend = j_kv_get_backend();
 
 	if (kv_backend != NULL)
@@ -329,14 +428,24 @@ j_kv_delete_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
-		message = j_message_new(J_MESSAGE_KV_DELETE, namespace_len);
+		gsize length = namespace_len;
+
+		// Precompute the exact message size to avoid resizing the message while appending operations.
+		for (guint i = 0; i < j_list_length(operations); i++)
+		{
+			JKV* kv = j_list_get_nth(operations, i);
+
+			length += strlen(kv->key) + 1;
+		}
+
+		message = j_message_new(J_MESSAGE_KV_DELETE, length);
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JKV* kv = j_list_iterator_get(it);
+		JKV* kv = j_list_get_nth(operations, i);
 
 		if (kv_backend != NULL)
 		{
@@ -362,16 +471,31 @@ j_kv_delete_exec(JList* operations, JSemantics* semantics)
 		gpointer kv_connection;
 
 		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		if ((safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE) && j_configuration_get_coalesce_replies(j_configuration()))
+		{
+			// Failures reported by the reply are returned when the batch collects its replies.
+			ret = j_message_send_deferred(message, kv_connection, j_kv_modify_reply, NULL) && ret;
+		}
+		else
 		{
-			g_autoptr(JMessage) reply = NULL;
+			ret = j_message_send(message, kv_connection) && ret;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				g_autoptr(JMessage) reply = NULL;
 
-			/* FIXME do something with reply */
+				reply = j_message_new_reply(message);
+
+				if (j_message_receive(reply, kv_connection))
+				{
+					ret = j_kv_modify_reply(reply, j_message_get_count(reply), NULL) && ret;
+				}
+				else
+				{
+					ret = FALSE;
+				}
+			}
 		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
@@ -388,7 +512,6 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* kv_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
 	gchar const* namespace;
 	gpointer kv_batch = NULL;
@@ -409,7 +532,6 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 		index = kop->get.kv->index;
 	}
 
-	it = j_list_iterator_new(operations);
 	kv_backend = j_kv_get_backend();
 
 	if (kv_backend != NULL)
@@ -426,14 +548,24 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 		 * - The second operation is executed first and fails because the item does not exist.
 		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
 		 **/
-		message = j_message_new(J_MESSAGE_KV_GET, namespace_len);
+		gsize length = namespace_len;
+
+		// Precompute the exact message size to avoid resizing the message while appending operations.
+		for (guint i = 0; i < j_list_length(operations); i++)
+		{
+			JKVOperation* kop = j_list_get_nth(operations, i);
+
+			length += strlen(kop->get.kv->key) + 1;
+		}
+
+		message = j_message_new(J_MESSAGE_KV_GET, length);
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JKVOperation* kop = j_list_iterator_get(it);
+		JKVOperation* kop = j_list_get_nth(operations, i);
 
 		if (kv_backend != NULL)
 		{
@@ -472,7 +604,6 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
-		g_autoptr(JListIterator) iter = NULL;
 		g_autoptr(JMessage) reply = NULL;
 		gpointer kv_connection;
 
@@ -480,39 +611,43 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 		j_message_send(message, kv_connection);
 
 		reply = j_message_new_reply(message);
-		j_message_receive(reply, kv_connection);
 
-		iter = j_list_iterator_new(operations);
-
-		while (j_list_iterator_next(iter))
+		if (j_message_receive(reply, kv_connection))
 		{
-			JKVOperation* kop = j_list_iterator_get(iter);
-			guint32 len;
-
-			len = j_message_get_4(reply);
-			ret = (len > 0) && ret;
-
-			if (len > 0)
+			for (guint i = 0; i < j_list_length(operations); i++)
 			{
-				gconstpointer data;
-
-				data = j_message_get_n(reply, len);
+				JKVOperation* kop = j_list_get_nth(operations, i);
+				guint32 len;
 
-				if (kop->get.func != NULL)
-				{
-					gpointer value;
+				len = j_message_get_4(reply);
+				ret = (len > 0) && ret;
 
-					// data belongs to the message, create a copy for the callback
-					value = g_memdup(data, len);
-					kop->get.func(value, len, kop->get.data);
-				}
-				else
+				if (len > 0)
 				{
-					*(kop->get.value) = g_memdup(data, len);
-					*(kop->get.value_len) = len;
+					gconstpointer data;
+
+					data = j_message_get_n(reply, len);
+
+					if (kop->get.func != NULL)
+					{
+						gpointer value;
+
+						// data belongs to the message, create a copy for the callback
+						value = g_memdup(data, len);
+						kop->get.func(value, len, kop->get.data);
+					}
+					else
+					{
+						*(kop->get.value) = g_memdup(data, len);
+						*(kop->get.value_len) = len;
+					}
 				}
 			}
 		}
+		else
+		{
+			ret = FALSE;
+		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
 	}
@@ -666,11 +801,13 @@ j_kv_put(JKV* kv, gpointer value, guint32 value_len, GDestroyNotify value_destro
 	kop->put.value_destroy = value_destroy;
 
 	operation = j_operation_new();
-	// FIXME key = index + namespace
 	operation->key = kv;
+	operation->key_hash = j_kv_key_hash;
+	operation->key_equal = j_kv_key_equal;
 	operation->data = kop;
 	operation->exec_func = j_kv_put_exec;
 	operation->free_func = j_kv_put_free;
+	operation->cache_func = j_kv_put_cache;
 
 	j_batch_add(batch, operation);
 }
@@ -695,9 +832,12 @@ j_kv_delete(JKV* kv, JBatch* batch)
 
 	operation = j_operation_new();
 	operation->key = kv;
+	operation->key_hash = j_kv_key_hash;
+	operation->key_equal = j_kv_key_equal;
 	operation->data = j_kv_ref(kv);
 	operation->exec_func = j_kv_delete_exec;
 	operation->free_func = j_kv_delete_free;
+	operation->cache_func = j_kv_delete_cache;
 
 	j_batch_add(batch, operation);
 }
@@ -730,6 +870,8 @@ j_kv_get(JKV* kv, gpointer* value, guint32* value_len, JBatch* batch)
 
 	operation = j_operation_new();
 	operation->key = kv;
+	operation->key_hash = j_kv_key_hash;
+	operation->key_equal = j_kv_key_equal;
 	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
@@ -766,6 +908,8 @@ j_kv_get_callback(JKV* kv, JKVGetFunc func, gpointer data, JBatch* batch)
 
 	operation = j_operation_new();
 	operation->key = kv;
+	operation->key_hash = j_kv_key_hash;
+	operation->key_equal = j_kv_key_equal;
 	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
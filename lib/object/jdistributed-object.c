@@ -61,10 +61,19 @@ struct JDistributedObjectBackgroundData
 		struct
 		{
 			/**
-			 * The list of buffers to fill.
-			 * Contains #JDistributedObjectReadBuffer elements.
+			 * The extents to read into.
 			 */
-			JList* buffers;
+			JObjectExtents* extents;
+
+			/**
+			 * The number of blocks requested from the server.
+			 */
+			guint requests;
+
+			/**
+			 * Set if the server could not be reached, may be NULL.
+			 */
+			gboolean* failed;
 		} read;
 
 		/**
@@ -72,21 +81,21 @@ struct JDistributedObjectBackgroundData
 		 */
 		struct
 		{
-			JList* bytes_written;
+			/**
+			 * The extents that have been written.
+			 */
+			JObjectExtents* extents;
+
+			/**
+			 * The number of servers that failed to write.
+			 */
+			gint* failed;
 		} write;
 	};
 };
 
 typedef struct JDistributedObjectBackgroundData JDistributedObjectBackgroundData;
 
-struct JDistributedObjectReadBuffer
-{
-	gchar* data;
-	guint64* bytes_read;
-};
-
-typedef struct JDistributedObjectReadBuffer JDistributedObjectReadBuffer;
-
 struct JDistributedObjectOperation
 {
 	union
@@ -119,12 +128,86 @@ struct JDistributedObjectOperation
 			guint64 length;
 			guint64 offset;
 			guint64* bytes_written;
+			guint64 bytes_cached;
+			guint64 bytes_replicated;
 		} write;
 	};
 };
 
 typedef struct JDistributedObjectOperation JDistributedObjectOperation;
 
+/**
+ * A prefetch of sequentially read data.
+ **/
+struct JDistributedObjectPrefetch
+{
+	/** The object. **/
+	JDistributedObject* object;
+	/** The semantics of the triggering read. **/
+	JSemantics* semantics;
+	/** The object's cache key. **/
+	gchar* key;
+	/** The object's cache generation. **/
+	guint64 generation;
+	/** The buffer to read into. **/
+	gpointer data;
+	/** The length to read. **/
+	guint64 length;
+	/** The offset to read from. **/
+	guint64 offset;
+};
+
+typedef struct JDistributedObjectPrefetch JDistributedObjectPrefetch;
+
+/**
+ * A stripe of an erasure coded object.
+ **/
+struct JDistributedObjectStripe
+{
+	/**
+	 * The stripe ID, that is, the ID of the stripe's first block divided by the number of data blocks.
+	 **/
+	guint64 id;
+
+	/**
+	 * The data blocks followed by the parity blocks.
+	 **/
+	guint8* blocks;
+
+	/**
+	 * The number of valid bytes per block.
+	 **/
+	guint64* lengths;
+
+	/**
+	 * The operations reading the stripe's data blocks.
+	 **/
+	JDistributedObjectOperation* operations;
+
+	/**
+	 * Whether the stripe's data blocks could be reconstructed.
+	 **/
+	gboolean complete;
+};
+
+typedef struct JDistributedObjectStripe JDistributedObjectStripe;
+
+/**
+ * A part of a read that has to be reconstructed from its stripe.
+ **/
+struct JDistributedObjectPiece
+{
+	gpointer data;
+	guint64 length;
+	guint64 offset;
+	guint64* bytes_read;
+	guint64 block_id;
+	guint index;
+	guint64 nbytes;
+};
+
+typedef struct JDistributedObjectPiece JDistributedObjectPiece;
+
 /**
  * A JDistributedObject.
  **/
@@ -142,12 +225,213 @@ struct JDistributedObject
 
 	JDistribution* distribution;
 
+	/**
+	 * The highest extent known to this handle, G_MAXUINT64 if unknown.
+	 * Used to only contact the servers the object's stripes are placed on.
+	 **/
+	guint64 size;
+
 	/**
 	 * The reference count.
 	 **/
 	gint ref_count;
 };
 
+G_LOCK_DEFINE_STATIC(j_distributed_object_size);
+
+/**
+ * Returns the servers an object's stripes are placed on.
+ * If the object's size is unknown, all servers its distribution can place stripes on are returned.
+ *
+ * \private
+ *
+ * \param object An object.
+ *
+ * \return An array of server indices. Should be freed with g_array_unref().
+ **/
+static GArray*
+j_distributed_object_get_servers(JDistributedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 size;
+
+	G_LOCK(j_distributed_object_size);
+	size = object->size;
+	G_UNLOCK(j_distributed_object_size);
+
+	// Even empty objects have their first stripe.
+	return j_distribution_get_servers(object->distribution, MAX(size, 1));
+}
+
+/**
+ * Returns the number of outstanding read requests per server.
+ * Reads of replicated blocks are sent to the replica with the least outstanding requests.
+ *
+ * \private
+ *
+ * \return The outstanding requests, indexed by server.
+ **/
+static gint*
+j_distributed_object_get_outstanding(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static gint* outstanding = NULL;
+
+	if (g_once_init_enter(&outstanding))
+	{
+		gint* new_outstanding;
+
+		new_outstanding = g_new0(gint, j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT));
+
+		g_once_init_leave(&outstanding, new_outstanding);
+	}
+
+	return outstanding;
+}
+
+/**
+ * Adds an operation for an object to the messages of the given servers.
+ * Messages are created on demand, servers without operations keep a NULL message.
+ *
+ * \private
+ *
+ * \param messages  The messages, indexed by server.
+ * \param servers   The server indices.
+ * \param type      The message type.
+ * \param semantics The semantics.
+ * \param object    An object.
+ **/
+static void
+j_distributed_object_add_operation(JMessage** messages, GArray* servers, JMessageType type, JSemantics* semantics, JDistributedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize name_len;
+	gsize namespace_len;
+
+	name_len = strlen(object->name) + 1;
+	namespace_len = strlen(object->namespace) + 1;
+
+	for (guint i = 0; i < servers->len; i++)
+	{
+		guint index = g_array_index(servers, guint, i);
+
+		if (messages[index] == NULL)
+		{
+			messages[index] = j_message_new(type, namespace_len);
+			j_message_set_semantics(messages[index], semantics);
+			j_message_append_n(messages[index], object->namespace, namespace_len);
+		}
+
+		j_message_add_operation(messages[index], name_len);
+		j_message_append_n(messages[index], object->name, name_len);
+	}
+}
+
+/**
+ * Adds a read to the message of the given server.
+ * The message is created on demand.
+ *
+ * \private
+ *
+ * \param object     An object.
+ * \param semantics  The semantics.
+ * \param messages   The messages, indexed by server.
+ * \param extents    The extents, indexed by server.
+ * \param index      The server index.
+ * \param data       A buffer.
+ * \param length     A length.
+ * \param offset     An offset.
+ * \param bytes_read Number of bytes read.
+ **/
+static void
+j_distributed_object_add_read(JDistributedObject* object, JSemantics* semantics, JMessage** messages, JObjectExtents** extents, guint index, gpointer data, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (messages[index] == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		messages[index] = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+		j_message_set_semantics(messages[index], semantics);
+		j_message_append_n(messages[index], object->namespace, namespace_len);
+		j_message_append_n(messages[index], object->name, name_len);
+
+		extents[index] = j_object_extents_new(TRUE);
+	}
+
+	// Adjacent and overlapping reads are merged into a single operation.
+	j_object_extents_add_read(extents[index], data, length, offset, bytes_read);
+}
+
+/**
+ * Adds a write to the message of the given server.
+ * The message is created on demand.
+ *
+ * \private
+ *
+ * \param object        An object.
+ * \param semantics     The semantics.
+ * \param messages      The messages, indexed by server.
+ * \param extents       The extents, indexed by server.
+ * \param index         The server index.
+ * \param data          A buffer.
+ * \param length        A length.
+ * \param offset        An offset.
+ * \param bytes_written Number of bytes written.
+ **/
+static void
+j_distributed_object_add_write(JDistributedObject* object, JSemantics* semantics, JMessage** messages, JObjectExtents** extents, guint index, gconstpointer data, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (messages[index] == NULL)
+	{
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		messages[index] = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
+		j_message_set_semantics(messages[index], semantics);
+		j_message_append_n(messages[index], object->namespace, namespace_len);
+		j_message_append_n(messages[index], object->name, name_len);
+		// The stripe might be written for the first time.
+		j_message_add_flags(messages[index], J_MESSAGE_FLAGS_CREATE);
+
+		extents[index] = j_object_extents_new(FALSE);
+	}
+
+	// Adjacent writes are merged into a single operation.
+	j_object_extents_add_write(extents[index], data, length, offset, bytes_written);
+}
+
+static guint
+j_distributed_object_key_hash(gconstpointer key)
+{
+	JDistributedObject const* object = key;
+
+	return g_str_hash(object->namespace) ^ g_str_hash(object->name);
+}
+
+static gboolean
+j_distributed_object_key_equal(gconstpointer a, gconstpointer b)
+{
+	JDistributedObject const* object_a = a;
+	JDistributedObject const* object_b = b;
+
+	// Operations are distributed using the first object's distribution, so handles with different distributions must not be grouped.
+	return (object_a->distribution == object_b->distribution && g_str_equal(object_a->namespace, object_b->namespace) && g_str_equal(object_a->name, object_b->name));
+}
+
 static void
 j_distributed_object_create_free(gpointer data)
 {
@@ -216,6 +500,37 @@ j_distributed_object_write_free(gpointer data)
 	g_slice_free(JDistributedObjectOperation, operation);
 }
 
+static JDistributedObjectStripe*
+j_distributed_object_stripe_new(guint64 id, guint block_count, guint64 block_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectStripe* stripe;
+
+	stripe = g_slice_new(JDistributedObjectStripe);
+	stripe->id = id;
+	stripe->blocks = g_malloc0(block_count * block_size);
+	stripe->lengths = g_new0(guint64, block_count);
+	stripe->operations = g_new0(JDistributedObjectOperation, block_count);
+	stripe->complete = TRUE;
+
+	return stripe;
+}
+
+static void
+j_distributed_object_stripe_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectStripe* stripe = data;
+
+	g_free(stripe->blocks);
+	g_free(stripe->lengths);
+	g_free(stripe->operations);
+
+	g_slice_free(JDistributedObjectStripe, stripe);
+}
+
 /**
  * Executes create operations in a background operation.
  *
@@ -239,20 +554,22 @@ j_distributed_object_create_background_operation(gpointer data)
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
 
-	j_message_send(background_data->message, object_connection);
-
-	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	if (object_connection != NULL)
 	{
-		g_autoptr(JMessage) reply = NULL;
+		if (j_message_send(background_data->message, object_connection) && (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE))
+		{
+			g_autoptr(JMessage) reply = NULL;
 
-		reply = j_message_new_reply(background_data->message);
-		j_message_receive(reply, object_connection);
+			reply = j_message_new_reply(background_data->message);
+			j_message_receive(reply, object_connection);
 
-		/* FIXME do something with reply */
+			/* FIXME do something with reply */
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 	}
 
 	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -282,20 +599,22 @@ j_distributed_object_delete_background_operation(gpointer data)
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
 
-	j_message_send(background_data->message, object_connection);
-
-	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	if (object_connection != NULL)
 	{
-		g_autoptr(JMessage) reply = NULL;
+		if (j_message_send(background_data->message, object_connection) && (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE))
+		{
+			g_autoptr(JMessage) reply = NULL;
 
-		reply = j_message_new_reply(background_data->message);
-		j_message_receive(reply, object_connection);
+			reply = j_message_new_reply(background_data->message);
+			j_message_receive(reply, object_connection);
 
-		/* FIXME do something with reply */
+			/* FIXME do something with reply */
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 	}
 
 	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -318,65 +637,29 @@ j_distributed_object_read_background_operation(gpointer data)
 
 	JDistributedObjectBackgroundData* background_data = data;
 
-	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) reply = NULL;
 	gpointer object_connection;
-	guint32 operations_done;
-	guint32 operation_count;
-
-	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
-	j_message_send(background_data->message, object_connection);
-
-	reply = j_message_new_reply(background_data->message);
 
-	operations_done = 0;
-	operation_count = j_message_get_count(background_data->message);
+	gboolean ret = FALSE;
 
-	it = j_list_iterator_new(background_data->read.buffers);
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
 
-	/**
-	 * This extra loop is necessary because the server might send multiple
-	 * replies per message. The same reply object can be used to receive
-	 * multiple times.
-	 */
-	while (operations_done < operation_count)
+	if (object_connection != NULL)
 	{
-		guint32 reply_operation_count;
-
-		j_message_receive(reply, object_connection);
-
-		reply_operation_count = j_message_get_count(reply);
-
-		for (guint i = 0; i < reply_operation_count && j_list_iterator_next(it); i++)
-		{
-			JDistributedObjectReadBuffer* buffer = j_list_iterator_get(it);
-			gchar* read_data = buffer->data;
-			guint64* bytes_read = buffer->bytes_read;
-
-			guint64 nbytes;
-
-			nbytes = j_message_get_8(reply);
-			j_helper_atomic_add(bytes_read, nbytes);
-
-			if (nbytes > 0)
-			{
-				GInputStream* input;
-
-				input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
-				g_input_stream_read_all(input, read_data, nbytes, NULL, NULL, NULL);
-			}
+		ret = j_message_send(background_data->message, object_connection) && j_object_extents_read_reply(background_data->read.extents, background_data->message, object_connection);
 
-			g_slice_free(JDistributedObjectReadBuffer, buffer);
-		}
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
-		operations_done += reply_operation_count;
+	if (!ret && background_data->read.failed != NULL)
+	{
+		*(background_data->read.failed) = TRUE;
 	}
 
-	j_message_unref(background_data->message);
+	g_atomic_int_add(&(j_distributed_object_get_outstanding()[background_data->index]), -(gint)background_data->read.requests);
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	j_message_unref(background_data->message);
 
-	j_list_unref(background_data->read.buffers);
+	j_object_extents_free(background_data->read.extents);
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -403,35 +686,34 @@ j_distributed_object_write_background_operation(gpointer data)
 
 	gpointer object_connection;
 
+	gboolean ret = FALSE;
+
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
-	j_message_send(background_data->message, object_connection);
 
-	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	if (object_connection != NULL)
 	{
-		g_autoptr(JListIterator) it = NULL;
-		g_autoptr(JMessage) reply = NULL;
-		guint64 nbytes;
+		ret = j_message_send(background_data->message, object_connection);
 
-		reply = j_message_new_reply(background_data->message);
-		j_message_receive(reply, object_connection);
-
-		it = j_list_iterator_new(background_data->write.bytes_written);
-
-		while (j_list_iterator_next(it))
+		if (ret && (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE))
 		{
-			guint64* bytes_written = j_list_iterator_get(it);
+			g_autoptr(JMessage) reply = NULL;
 
-			nbytes = j_message_get_8(reply);
-			j_helper_atomic_add(bytes_written, nbytes);
+			reply = j_message_new_reply(background_data->message);
+			ret = j_message_receive(reply, object_connection) && j_object_extents_write_reply(background_data->write.extents, reply);
 		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 	}
 
-	j_message_unref(background_data->message);
+	if (!ret)
+	{
+		g_atomic_int_inc(background_data->write.failed);
+	}
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	j_message_unref(background_data->message);
 
-	j_list_unref(background_data->write.bytes_written);
+	j_object_extents_free(background_data->write.extents);
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -454,44 +736,59 @@ j_distributed_object_status_background_operation(gpointer data)
 
 	JDistributedObjectBackgroundData* background_data = data;
 
-	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) reply = NULL;
 	gpointer object_connection;
 
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
-	j_message_send(background_data->message, object_connection);
-
 	reply = j_message_new_reply(background_data->message);
-	j_message_receive(reply, object_connection);
-
-	it = j_list_iterator_new(background_data->operations);
 
-	while (j_list_iterator_next(it))
+	// Unreachable servers and rejected messages do not contain any results.
+	if (object_connection != NULL && j_message_send(background_data->message, object_connection) && j_message_receive(reply, object_connection))
 	{
-		JDistributedObjectOperation* operation = j_list_iterator_get(it);
-		gint64* modification_time = operation->status.modification_time;
-		guint64* size = operation->status.size;
-		gint64 modification_time_;
-		guint64 size_;
+		for (guint i = 0; i < j_list_length(background_data->operations); i++)
+		{
+			JDistributedObjectOperation* operation = j_list_get_nth(background_data->operations, i);
+			gint64* modification_time = operation->status.modification_time;
+			guint64* size = operation->status.size;
+			gint64 modification_time_;
+			guint64 size_;
 
-		modification_time_ = j_message_get_8(reply);
-		size_ = j_message_get_8(reply);
+			modification_time_ = j_message_get_8(reply);
+			size_ = j_message_get_8(reply);
 
-		if (modification_time != NULL)
-		{
-			// FIXME max?
-			*modification_time = modification_time_;
-		}
+			if (modification_time != NULL)
+			{
+				// FIXME max?
+				*modification_time = modification_time_;
+			}
 
-		if (size != NULL)
-		{
-			j_helper_atomic_add(size, size_);
+			if (size != NULL)
+			{
+				JDistributionType type;
+
+				type = j_distribution_get_type(operation->status.object->distribution);
+
+				// Some distributions keep the blocks' offsets, so the largest stripe determines the size.
+				if (type == J_DISTRIBUTION_CONSISTENT_HASH || type == J_DISTRIBUTION_REPLICATED || type == J_DISTRIBUTION_ERASURE)
+				{
+					G_LOCK(j_distributed_object_size);
+					*size = MAX(*size, size_);
+					G_UNLOCK(j_distributed_object_size);
+				}
+				else
+				{
+					j_helper_atomic_add(size, size_);
+				}
+			}
 		}
 	}
 
 	j_message_unref(background_data->message);
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -519,82 +816,211 @@ j_distributed_object_sync_background_operation(gpointer data)
 
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
-	j_message_send(background_data->message, object_connection);
 
-	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	if (object_connection != NULL)
 	{
-		g_autoptr(JMessage) reply = NULL;
+		if (j_message_send(background_data->message, object_connection) && (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE))
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(background_data->message);
+			j_message_receive(reply, object_connection);
 
-		reply = j_message_new_reply(background_data->message);
-		j_message_receive(reply, object_connection);
+			// FIXME do something with reply
+		}
 
-		// FIXME do something with reply
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 	}
 
 	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
 	return NULL;
 }
 
-static gboolean
-j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
+/**
+ * Sends read messages to their servers in parallel and frees them.
+ *
+ * \private
+ *
+ * \param messages     The messages, indexed by server. Servers without reads have a NULL message.
+ * \param extents      The extents, indexed by server.
+ * \param requests     The number of blocks requested per server, or NULL.
+ * \param failed       Returns whether a server could not be reached, indexed by server, or NULL.
+ * \param semantics    The semantics.
+ * \param server_count The server count.
+ **/
+static void
+j_distributed_object_execute_reads(JMessage** messages, JObjectExtents** extents, guint const* requests, gboolean* failed, JSemantics* semantics, guint server_count)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
-	gboolean ret = TRUE;
-
-	JBackend* object_backend;
-	g_autoptr(JListIterator) it = NULL;
-	g_autofree JMessage** messages = NULL;
-	gchar const* namespace = NULL;
-	gsize namespace_len = 0;
-	guint32 server_count = 0;
+	g_autofree gpointer* background_data = NULL;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	background_data = g_new(gpointer, server_count);
 
+	for (guint i = 0; i < server_count; i++)
 	{
-		JDistributedObject* object;
+		JDistributedObjectBackgroundData* data;
 
-		object = j_list_get_first(operations);
-		g_assert(object != NULL);
+		if (messages[i] == NULL)
+		{
+			background_data[i] = NULL;
+			continue;
+		}
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
+		j_object_extents_append(extents[i], messages[i]);
+
+		data = g_slice_new(JDistributedObjectBackgroundData);
+		data->index = i;
+		data->message = messages[i];
+		data->operations = NULL;
+		data->semantics = semantics;
+		data->read.extents = extents[i];
+		data->read.requests = (requests != NULL) ? requests[i] : 0;
+		data->read.failed = (failed != NULL) ? &(failed[i]) : NULL;
+
+		background_data[i] = data;
 	}
 
-	it = j_list_iterator_new(operations);
-	object_backend = j_object_get_backend();
+	j_helper_execute_parallel(j_distributed_object_read_background_operation, background_data, server_count);
+}
 
-	if (object_backend == NULL)
+/**
+ * Sends write messages to their servers in parallel and frees them.
+ *
+ * \private
+ *
+ * \param messages     The messages, indexed by server. Servers without writes have a NULL message.
+ * \param extents      The extents, indexed by server.
+ * \param semantics    The semantics.
+ * \param server_count The server count.
+ *
+ * \return TRUE if all servers have been written to successfully, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_execute_writes(JMessage** messages, JObjectExtents** extents, JSemantics* semantics, guint server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gpointer* background_data = NULL;
+	gint failed = 0;
+
+	background_data = g_new(gpointer, server_count);
+
+	for (guint i = 0; i < server_count; i++)
 	{
-		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
-		messages = g_new(JMessage*, server_count);
+		JDistributedObjectBackgroundData* data;
 
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
+		if (messages[i] == NULL)
 		{
-			/**
-			 * Force safe semantics to make the server send a reply.
-			 * Otherwise, nasty races can occur when using unsafe semantics:
-			 * - The client creates the object and sends its first write.
-			 * - The client sends another operation using another connection from the pool.
-			 * - The second operation is executed first and fails because the object does not exist.
-			 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
-			 **/
-			messages[i] = j_message_new(J_MESSAGE_OBJECT_CREATE, namespace_len);
-			j_message_set_semantics(messages[i], semantics);
-			j_message_append_n(messages[i], namespace, namespace_len);
+			background_data[i] = NULL;
+			continue;
 		}
+
+		j_object_extents_append(extents[i], messages[i]);
+
+		data = g_slice_new(JDistributedObjectBackgroundData);
+		data->index = i;
+		data->message = messages[i];
+		data->operations = NULL;
+		data->semantics = semantics;
+		data->write.extents = extents[i];
+		data->write.failed = &failed;
+
+		background_data[i] = data;
 	}
 
-	while (j_list_iterator_next(it))
+	j_helper_execute_parallel(j_distributed_object_write_background_operation, background_data, server_count);
+
+	return (g_atomic_int_get(&failed) == 0);
+}
+
+static guint64
+j_distributed_object_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+	(void)buffer;
+
+	// The operation only references the object, which is kept alive by the operation itself.
+	return 0;
+}
+
+static guint64
+j_distributed_object_write_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	if (buffer != NULL)
 	{
-		JDistributedObject* object = j_list_iterator_get(it);
+		memcpy(buffer, operation->write.data, operation->write.length);
+		operation->write.data = buffer;
+
+		// The caller is told that all data has been written, the actual result is discarded.
+		*(operation->write.bytes_written) += operation->write.length;
+		operation->write.bytes_cached = 0;
+		operation->write.bytes_written = &(operation->write.bytes_cached);
+	}
+
+	return operation->write.length;
+}
+
+/**
+ * Writes an object's buffered data.
+ *
+ * \private
+ *
+ * \param object An object.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_flush_buffered(JDistributedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+
+	if (!j_object_write_buffer_pending())
+	{
+		return TRUE;
+	}
+
+	key = j_object_cache_key(G_MAXUINT32, object->namespace, object->name);
+
+	return j_object_write_buffer_flush(key);
+}
+
+static gboolean
+j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autofree JMessage** messages = NULL;
+	guint32 server_count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new0(JMessage*, server_count);
+	}
+
+	for (guint j = 0; j < j_list_length(operations); j++)
+	{
+		JDistributedObject* object = j_list_get_nth(operations, j);
 
 		if (object_backend != NULL)
 		{
@@ -605,16 +1031,18 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 		}
 		else
 		{
-			gsize name_len;
+			g_autoptr(GArray) servers = NULL;
 
-			name_len = strlen(object->name) + 1;
+			G_LOCK(j_distributed_object_size);
+			object->size = 0;
+			G_UNLOCK(j_distributed_object_size);
 
-			// FIXME use actual distribution
-			for (guint i = 0; i < server_count; i++)
-			{
-				j_message_add_operation(messages[i], name_len);
-				j_message_append_n(messages[i], object->name, name_len);
-			}
+			/**
+			 * Only the server storing the first stripe is contacted, so that empty objects exist.
+			 * All other stripes are created by the servers on first write.
+			 **/
+			servers = j_distributed_object_get_servers(object);
+			j_distributed_object_add_operation(messages, servers, J_MESSAGE_OBJECT_CREATE, semantics, object);
 		}
 	}
 
@@ -624,11 +1052,16 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 
 		background_data = g_new(gpointer, server_count);
 
-		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			if (messages[i] == NULL)
+			{
+				background_data[i] = NULL;
+				continue;
+			}
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
@@ -653,45 +1086,28 @@ j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autofree JMessage** messages = NULL;
-	gchar const* namespace = NULL;
-	gsize namespace_len = 0;
 	guint32 server_count = 0;
 
 	g_return_val_if_fail(operations != NULL, FALSE);
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
-	{
-		JDistributedObject* object;
-
-		object = j_list_get_first(operations);
-		g_assert(object != NULL);
-
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-	}
-
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend == NULL)
 	{
 		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
-		messages = g_new(JMessage*, server_count);
-
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
-		{
-			messages[i] = j_message_new(J_MESSAGE_OBJECT_DELETE, namespace_len);
-			j_message_set_semantics(messages[i], semantics);
-			j_message_append_n(messages[i], namespace, namespace_len);
-		}
+		messages = g_new0(JMessage*, server_count);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint j = 0; j < j_list_length(operations); j++)
 	{
-		JDistributedObject* object = j_list_iterator_get(it);
+		JDistributedObject* object = j_list_get_nth(operations, j);
+		g_autofree gchar* key = NULL;
+
+		key = j_object_cache_key(G_MAXUINT32, object->namespace, object->name);
+		j_object_cache_remove(key);
+		j_object_write_buffer_discard(key);
 
 		if (object_backend != NULL)
 		{
@@ -702,16 +1118,10 @@ j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
 		}
 		else
 		{
-			gsize name_len;
+			g_autoptr(GArray) servers = NULL;
 
-			name_len = strlen(object->name) + 1;
-
-			// FIXME use actual distribution
-			for (guint i = 0; i < server_count; i++)
-			{
-				j_message_add_operation(messages[i], name_len);
-				j_message_append_n(messages[i], object->name, name_len);
-			}
+			servers = j_distributed_object_get_servers(object);
+			j_distributed_object_add_operation(messages, servers, J_MESSAGE_OBJECT_DELETE, semantics, object);
 		}
 	}
 
@@ -721,11 +1131,16 @@ j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
 
 		background_data = g_new(gpointer, server_count);
 
-		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			if (messages[i] == NULL)
+			{
+				background_data[i] = NULL;
+				continue;
+			}
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
@@ -741,8 +1156,342 @@ j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+/**
+ * Determines which servers do not store an erasure coded object.
+ * This is the case if the server cannot be reached, has lost the object's stripes or the stripes have not been written yet.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param failed    Servers already known to be unreachable, indexed by server. They are not contacted again.
+ * \param semantics The semantics.
+ * \param size      Returns the object's size as reported by the remaining servers.
+ *
+ * \return An array indexed by server. Should be freed with g_free().
+ **/
+static gboolean*
+j_distributed_object_get_missing(JDistributedObject* object, gboolean const* failed, JSemantics* semantics, guint64* size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GArray) servers = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree JList** server_operations = NULL;
+	g_autofree JDistributedObjectOperation* operations = NULL;
+	g_autofree gint64* modification_times = NULL;
+	g_autofree gpointer* background_data = NULL;
+	gboolean* missing;
+	guint32 server_count;
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+	missing = g_new0(gboolean, server_count);
+	messages = g_new0(JMessage*, server_count);
+	server_operations = g_new0(JList*, server_count);
+	operations = g_new0(JDistributedObjectOperation, server_count);
+	modification_times = g_new0(gint64, server_count);
+	background_data = g_new0(gpointer, server_count);
+
+	*size = 0;
+
+	servers = j_distributed_object_get_servers(object);
+	j_distributed_object_add_operation(messages, servers, J_MESSAGE_OBJECT_STATUS, semantics, object);
+
+	// Every server gets its own operation to be able to tell the replies apart.
+	for (guint i = 0; i < servers->len; i++)
+	{
+		JDistributedObjectBackgroundData* data;
+		guint index = g_array_index(servers, guint, i);
+
+		if (failed[index])
+		{
+			j_message_unref(messages[index]);
+			continue;
+		}
+
+		operations[index].status.object = object;
+		operations[index].status.modification_time = &(modification_times[index]);
+		operations[index].status.size = size;
+
+		server_operations[index] = j_list_new(NULL);
+		j_list_append(server_operations[index], &(operations[index]));
+
+		data = g_slice_new(JDistributedObjectBackgroundData);
+		data->index = index;
+		data->message = messages[index];
+		data->operations = server_operations[index];
+		data->semantics = semantics;
+
+		background_data[index] = data;
+	}
+
+	j_helper_execute_parallel(j_distributed_object_status_background_operation, background_data, server_count);
+
+	for (guint i = 0; i < servers->len; i++)
+	{
+		guint index = g_array_index(servers, guint, i);
+
+		// Servers reply with a modification time of 0 if they do not know the object.
+		// Unreachable servers do not reply, so their modification time stays 0.
+		missing[index] = (modification_times[index] == 0);
+
+		if (server_operations[index] != NULL)
+		{
+			j_list_unref(server_operations[index]);
+		}
+	}
+
+	return missing;
+}
+
+/**
+ * Reads from an erasure coded object.
+ * Blocks are read from their servers first. Only if a read comes back short or a server cannot be reached, the servers that do not have the object are determined
+ * and their blocks are reconstructed from the remaining blocks of their stripes.
+ *
+ * \private
+ *
+ * \param object     An object.
+ * \param operations The read operations.
+ * \param semantics  The semantics.
+ *
+ * \return TRUE on success, FALSE if too many blocks of a stripe are missing.
+ **/
 static gboolean
-j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_read_erasure(JDistributedObject* object, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(GHashTable) stripes = NULL;
+	g_autoptr(GArray) pieces = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree JObjectExtents** extents = NULL;
+	g_autofree gboolean* missing = NULL;
+	g_autofree gboolean* failed = NULL;
+	GHashTableIter iter;
+	JDistributedObjectStripe* stripe;
+	guint32 server_count;
+	guint data_blocks;
+	guint parity_blocks;
+	guint64 block_size;
+	guint64 size;
+	gboolean degraded = FALSE;
+
+	j_distribution_get_erasure_code(object->distribution, &data_blocks, &parity_blocks, &block_size);
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+	messages = g_new0(JMessage*, server_count);
+	extents = g_new0(JObjectExtents*, server_count);
+	failed = g_new0(gboolean, server_count);
+
+	stripes = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, j_distributed_object_stripe_free);
+	pieces = g_array_new(FALSE, FALSE, sizeof(JDistributedObjectPiece));
+
+	for (guint j = 0; j < j_list_length(operations); j++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
+		gchar* new_data;
+		guint32 index;
+		guint64 block_id;
+		guint64 new_length;
+		guint64 new_offset;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+
+		j_distribution_reset(object->distribution, operation->read.length, operation->read.offset);
+		new_data = operation->read.data;
+
+		while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+		{
+			JDistributedObjectPiece piece;
+
+			piece.data = new_data;
+			piece.length = new_length;
+			piece.offset = new_offset;
+			piece.bytes_read = operation->read.bytes_read;
+			piece.block_id = block_id;
+			piece.index = index;
+			piece.nbytes = 0;
+
+			g_array_append_val(pieces, piece);
+
+			new_data += new_length;
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_READ, operation->read.length, operation->read.offset);
+	}
+
+	// The pieces are not modified anymore, so pointers to them remain valid.
+	for (guint i = 0; i < pieces->len; i++)
+	{
+		JDistributedObjectPiece* piece = &g_array_index(pieces, JDistributedObjectPiece, i);
+
+		j_distributed_object_add_read(object, semantics, messages, extents, piece->index, piece->data, piece->length, piece->offset, &(piece->nbytes));
+	}
+
+	j_distributed_object_execute_reads(messages, extents, NULL, failed, semantics, server_count);
+
+	// Pieces stored on unreachable servers have not been read at all, so they come back short, too.
+	for (guint i = 0; i < pieces->len; i++)
+	{
+		JDistributedObjectPiece* piece = &g_array_index(pieces, JDistributedObjectPiece, i);
+
+		if (piece->nbytes < piece->length)
+		{
+			degraded = TRUE;
+			break;
+		}
+	}
+
+	// Short reads are also caused by holes and the object's end, so the servers have to be asked whether they lost the object.
+	if (degraded)
+	{
+		missing = j_distributed_object_get_missing(object, failed, semantics, &size);
+	}
+
+	for (guint i = 0; i < pieces->len; i++)
+	{
+		JDistributedObjectPiece* piece = &g_array_index(pieces, JDistributedObjectPiece, i);
+		guint64 stripe_id = piece->block_id / data_blocks;
+
+		if (missing == NULL || !missing[piece->index])
+		{
+			j_helper_atomic_add(piece->bytes_read, piece->nbytes);
+			continue;
+		}
+
+		if (!g_hash_table_contains(stripes, &stripe_id))
+		{
+			stripe = j_distributed_object_stripe_new(stripe_id, data_blocks + parity_blocks, block_size);
+			g_hash_table_insert(stripes, &(stripe->id), stripe);
+		}
+	}
+
+	if (g_hash_table_size(stripes) == 0)
+	{
+		return ret;
+	}
+
+	// The messages have been freed by j_distributed_object_execute_reads().
+	memset(messages, 0, server_count * sizeof(JMessage*));
+	memset(extents, 0, server_count * sizeof(JObjectExtents*));
+	memset(failed, 0, server_count * sizeof(gboolean));
+
+	// The remaining blocks of degraded stripes are read in a second round.
+	g_hash_table_iter_init(&iter, stripes);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&stripe))
+	{
+		guint64 stripe_offset = stripe->id * data_blocks * block_size;
+
+		for (guint i = 0; i < data_blocks + parity_blocks; i++)
+		{
+			guint index;
+
+			index = j_distribution_get_stripe_server(object->distribution, stripe->id, i);
+
+			if (!missing[index])
+			{
+				// Parity blocks are stored at the offset of their stripe.
+				j_distributed_object_add_read(object, semantics, messages, extents, index, stripe->blocks + i * block_size, block_size, (i < data_blocks) ? stripe_offset + i * block_size : stripe_offset, &(stripe->lengths[i]));
+			}
+		}
+	}
+
+	// Servers might become unreachable between both rounds, their blocks have to be reconstructed, too.
+	j_distributed_object_execute_reads(messages, extents, NULL, failed, semantics, server_count);
+
+	{
+		JReedSolomon* rs;
+		g_autofree guint8** blocks = NULL;
+		g_autofree gboolean* present = NULL;
+
+		rs = j_reed_solomon_new(data_blocks, parity_blocks);
+		blocks = g_new(guint8*, data_blocks + parity_blocks);
+		present = g_new(gboolean, data_blocks + parity_blocks);
+
+		g_hash_table_iter_init(&iter, stripes);
+
+		while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&stripe))
+		{
+			guint64 length = 0;
+
+			for (guint i = 0; i < data_blocks + parity_blocks; i++)
+			{
+				guint index;
+
+				index = j_distribution_get_stripe_server(object->distribution, stripe->id, i);
+				present[i] = !missing[index] && !failed[index];
+				blocks[i] = stripe->blocks + i * block_size;
+
+				if (present[i])
+				{
+					length = MAX(length, stripe->lengths[i]);
+				}
+			}
+
+			// None of the remaining blocks contain data, so the stripe has not been written yet.
+			if (length == 0)
+			{
+				continue;
+			}
+
+			if (!j_reed_solomon_decode(rs, blocks, present, length))
+			{
+				stripe->complete = FALSE;
+				ret = FALSE;
+				continue;
+			}
+
+			for (guint i = 0; i < data_blocks; i++)
+			{
+				guint64 block_offset = (stripe->id * data_blocks + i) * block_size;
+
+				if (present[i])
+				{
+					continue;
+				}
+
+				// Parity servers record the object's end, so the size covers blocks stored on missing servers.
+				// Blocks within the object that have not been written are holes.
+				stripe->lengths[i] = (block_offset < size) ? MIN(length, size - block_offset) : 0;
+			}
+		}
+
+		j_reed_solomon_free(rs);
+	}
+
+	for (guint i = 0; i < pieces->len; i++)
+	{
+		JDistributedObjectPiece* piece = &g_array_index(pieces, JDistributedObjectPiece, i);
+		guint64 stripe_id = piece->block_id / data_blocks;
+		guint position = piece->block_id % data_blocks;
+		guint64 displacement = piece->offset - piece->block_id * block_size;
+		guint64 nbytes;
+
+		if (!missing[piece->index])
+		{
+			continue;
+		}
+
+		stripe = g_hash_table_lookup(stripes, &stripe_id);
+
+		if (!stripe->complete || stripe->lengths[position] <= displacement)
+		{
+			continue;
+		}
+
+		nbytes = MIN(piece->length, stripe->lengths[position] - displacement);
+		memcpy(piece->data, stripe->blocks + position * block_size + displacement, nbytes);
+		j_helper_atomic_add(piece->bytes_read, nbytes);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_distributed_object_read_fetch(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -750,14 +1499,17 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	g_autofree JList** br_lists = NULL;
-	g_autoptr(JListIterator) it = NULL;
+	g_autofree JObjectExtents** extents = NULL;
 	g_autofree JMessage** messages = NULL;
 	JDistributedObject* object = NULL;
 	gpointer object_handle;
-	gsize name_len = 0;
-	gsize namespace_len = 0;
+	g_autofree guint* requests = NULL;
+	gint* outstanding = NULL;
 	guint32 server_count = 0;
+	guint replica_count = 1;
+	guint data_blocks;
+	guint parity_blocks;
+	guint64 block_size;
 
 	// FIXME
 	//JLock* lock = NULL;
@@ -773,9 +1525,15 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 		g_assert(object != NULL);
 	}
 
-	it = j_list_iterator_new(operations);
+	ret = j_distributed_object_flush_buffered(object) && ret;
+
 	object_backend = j_object_get_backend();
 
+	if (object_backend == NULL && j_distribution_get_erasure_code(object->distribution, &data_blocks, &parity_blocks, &block_size))
+	{
+		return j_distributed_object_read_erasure(object, operations, semantics);
+	}
+
 	if (object_backend != NULL)
 	{
 		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
@@ -784,16 +1542,17 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 	{
 		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
 		messages = g_new(JMessage*, server_count);
-		br_lists = g_new(JList*, server_count);
-
-		namespace_len = strlen(object->namespace) + 1;
-		name_len = strlen(object->name) + 1;
+		extents = g_new(JObjectExtents*, server_count);
+		requests = g_new0(guint, server_count);
 
 		for (guint i = 0; i < server_count; i++)
 		{
 			messages[i] = NULL;
-			br_lists[i] = NULL;
+			extents[i] = NULL;
 		}
+
+		replica_count = j_distribution_get_replica_count(object->distribution);
+		outstanding = j_distributed_object_get_outstanding();
 	}
 
 	/*
@@ -803,120 +1562,469 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 	}
 	*/
 
-	while (j_list_iterator_next(it))
-	{
-		JDistributedObjectOperation* operation = j_list_iterator_get(it);
-		gpointer data = operation->read.data;
-		guint64 length = operation->read.length;
-		guint64 offset = operation->read.offset;
-		guint64* bytes_read = operation->read.bytes_read;
+	for (guint j = 0; j < j_list_length(operations); j++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
+		gpointer data = operation->read.data;
+		guint64 length = operation->read.length;
+		guint64 offset = operation->read.offset;
+		guint64* bytes_read = operation->read.bytes_read;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+
+		if (object_backend != NULL)
+		{
+			guint64 nbytes = 0;
+
+			ret = j_backend_object_read(object_backend, object_handle, data, length, offset, &nbytes) && ret;
+			j_helper_atomic_add(bytes_read, nbytes);
+		}
+		else
+		{
+			gchar* new_data;
+			guint32 index;
+			guint64 block_id;
+			guint64 new_length;
+			guint64 new_offset;
+
+			j_distribution_reset(object->distribution, length, offset);
+			new_data = data;
+
+			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+			{
+				// Replicated blocks are read from the replica with the least outstanding requests.
+				for (guint i = 1; i < replica_count; i++)
+				{
+					guint replica;
+
+					replica = j_distribution_get_replica(object->distribution, block_id, i);
+
+					if (g_atomic_int_get(&(outstanding[replica])) < g_atomic_int_get(&(outstanding[index])))
+					{
+						index = replica;
+					}
+				}
+
+				g_atomic_int_inc(&(outstanding[index]));
+				requests[index]++;
+
+				j_distributed_object_add_read(object, semantics, messages, extents, index, new_data, new_length, new_offset, bytes_read);
+
+				/*
+				if (lock != NULL)
+				{
+					j_lock_add(lock, block_id);
+				}
+				*/
+
+				new_data += new_length;
+			}
+		}
+
+		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
+	}
+
+	if (object_backend != NULL)
+	{
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+	else
+	{
+		j_distributed_object_execute_reads(messages, extents, requests, NULL, semantics, server_count);
+	}
+
+	/*
+	if (lock != NULL)
+	{
+		// FIXME busy wait
+		while (!j_lock_acquire(lock));
+
+		j_lock_free(lock);
+	}
+	*/
+
+	return ret;
+}
+
+/**
+ * Reads prefetched data in the background and stores it in the object cache.
+ *
+ * \private
+ *
+ * \param data A prefetch.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_distributed_object_prefetch_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectPrefetch* prefetch = data;
+	JDistributedObjectOperation operation;
+	g_autoptr(JList) operations = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	operation.read.object = prefetch->object;
+	operation.read.data = prefetch->data;
+	operation.read.length = prefetch->length;
+	operation.read.offset = prefetch->offset;
+	operation.read.bytes_read = &nbytes;
+
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
+
+	// Failed prefetches still have to be reported to release their share of the prefetch limit.
+	ret = j_distributed_object_read_fetch(operations, prefetch->semantics);
+	j_object_cache_prefetched(prefetch->key, prefetch->generation, (ret) ? prefetch->data : NULL, prefetch->length, prefetch->offset, (ret) ? nbytes : 0);
+
+	j_distributed_object_unref(prefetch->object);
+	j_semantics_unref(prefetch->semantics);
+	g_free(prefetch->key);
+	g_free(prefetch->data);
+
+	g_slice_free(JDistributedObjectPrefetch, prefetch);
+
+	return NULL;
+}
+
+static gboolean
+j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JList) misses = NULL;
+	g_autoptr(GPtrArray) bytes_read = NULL;
+	g_autofree gchar* key = NULL;
+	g_autofree guint64* nbytes = NULL;
+	JDistributedObject* object;
+	guint i;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	if (!j_object_cache_enabled(semantics))
+	{
+		return j_distributed_object_read_fetch(operations, semantics);
+	}
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		g_assert(operation != NULL);
+
+		object = operation->read.object;
+		g_assert(object != NULL);
+	}
+
+	key = j_object_cache_key(G_MAXUINT32, object->namespace, object->name);
+	misses = j_list_new(NULL);
+	bytes_read = g_ptr_array_new();
+
+	for (guint j = 0; j < j_list_length(operations); j++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
+		guint64 prefetch_length;
+		guint64 prefetch_offset;
+		guint64 generation;
+
+		// Sequential reads prefetch the following blocks in the background, there is no benefit with a local backend.
+		if (j_object_get_backend() == NULL && j_object_cache_readahead(key, operation->read.length, operation->read.offset, &prefetch_length, &prefetch_offset, &generation))
+		{
+			JDistributedObjectPrefetch* prefetch;
+			JBackgroundOperation* background_operation;
+
+			prefetch = g_slice_new(JDistributedObjectPrefetch);
+			prefetch->object = j_distributed_object_ref(object);
+			prefetch->semantics = j_semantics_ref(semantics);
+			prefetch->key = g_strdup(key);
+			prefetch->generation = generation;
+			prefetch->data = g_malloc(prefetch_length);
+			prefetch->length = prefetch_length;
+			prefetch->offset = prefetch_offset;
+
+			background_operation = j_background_operation_new(j_distributed_object_prefetch_background_operation, prefetch);
+			j_background_operation_unref(background_operation);
+		}
+
+		if (!j_object_cache_read(key, semantics, operation->read.data, operation->read.length, operation->read.offset, operation->read.bytes_read))
+		{
+			j_list_append(misses, operation);
+			g_ptr_array_add(bytes_read, operation->read.bytes_read);
+		}
+	}
+
+	if (j_list_length(misses) == 0)
+	{
+		return ret;
+	}
+
+	// Count the bytes per operation to know which parts of the buffers are valid.
+	nbytes = g_new0(guint64, j_list_length(misses));
+
+	for (i = 0; i < j_list_length(misses); i++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(misses, i);
+
+		operation->read.bytes_read = &(nbytes[i]);
+	}
+
+	ret = j_distributed_object_read_fetch(misses, semantics);
+
+	for (i = 0; i < j_list_length(misses); i++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(misses, i);
+
+		if (ret)
+		{
+			j_object_cache_fill(key, operation->read.data, operation->read.length, operation->read.offset, nbytes[i]);
+		}
+
+		operation->read.bytes_read = g_ptr_array_index(bytes_read, i);
+		j_helper_atomic_add(operation->read.bytes_read, nbytes[i]);
+	}
+
+	return ret;
+}
+
+/**
+ * Writes to an erasure coded object.
+ * Stripes that are only partially overwritten are read first, parity is then computed for each modified stripe.
+ *
+ * \private
+ *
+ * \param object     An object.
+ * \param operations The write operations.
+ * \param semantics  The semantics.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_write_erasure(JDistributedObject* object, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JReedSolomon* rs;
+	g_autoptr(JList) reads = NULL;
+	g_autoptr(GHashTable) stripes = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree JObjectExtents** extents = NULL;
+	g_autofree guint8 const** data_blocks_ = NULL;
+	g_autofree guint8** parity_blocks_ = NULL;
+	GHashTableIter iter;
+	JDistributedObjectStripe* stripe;
+	guint32 server_count;
+	guint data_blocks;
+	guint parity_blocks;
+	guint64 block_size;
+	guint64 stripe_size;
+	guint64 bytes_parity = 0;
+	guint64 last_stripe_id = 0;
+	guint8 const zero = 0;
+
+	j_distribution_get_erasure_code(object->distribution, &data_blocks, &parity_blocks, &block_size);
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+	messages = g_new0(JMessage*, server_count);
+	extents = g_new0(JObjectExtents*, server_count);
+
+	stripe_size = data_blocks * block_size;
+	stripes = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, j_distributed_object_stripe_free);
+	reads = j_list_new(NULL);
+
+	for (guint j = 0; j < j_list_length(operations); j++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
+		guint64 offset = operation->write.offset;
+		guint64 end = offset + operation->write.length;
+
+		if (end > 0)
+		{
+			last_stripe_id = MAX(last_stripe_id, (end - 1) / stripe_size);
+		}
+
+		for (guint64 stripe_id = offset / stripe_size; stripe_id * stripe_size < end; stripe_id++)
+		{
+			guint64 stripe_offset = stripe_id * stripe_size;
+
+			if (g_hash_table_contains(stripes, &stripe_id))
+			{
+				continue;
+			}
+
+			stripe = j_distributed_object_stripe_new(stripe_id, data_blocks + parity_blocks, block_size);
+			g_hash_table_insert(stripes, &(stripe->id), stripe);
+
+			// The stripe's current contents are required to compute its parity.
+			if (offset > stripe_offset || end < stripe_offset + stripe_size)
+			{
+				for (guint i = 0; i < data_blocks; i++)
+				{
+					JDistributedObjectOperation* read_operation = &(stripe->operations[i]);
+
+					read_operation->read.object = object;
+					read_operation->read.data = stripe->blocks + i * block_size;
+					read_operation->read.length = block_size;
+					read_operation->read.offset = stripe_offset + i * block_size;
+					read_operation->read.bytes_read = &(stripe->lengths[i]);
+
+					j_list_append(reads, read_operation);
+				}
+			}
+		}
+	}
+
+	if (j_list_length(reads) > 0)
+	{
+		// The cache must not be filled with the data that is about to be overwritten.
+		ret = j_distributed_object_read_fetch(reads, semantics) && ret;
+	}
+
+	for (guint j = 0; j < j_list_length(operations); j++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
+		guint64 length = operation->write.length;
+		guint64 offset = operation->write.offset;
+		guint64* bytes_written = operation->write.bytes_written;
+		gchar const* new_data;
+		guint32 index;
+		guint64 block_id;
+		guint64 new_length;
+		guint64 new_offset;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
 
-		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+		j_distribution_reset(object->distribution, length, offset);
+		new_data = operation->write.data;
 
-		if (object_backend != NULL)
+		while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
 		{
-			guint64 nbytes = 0;
+			guint64 stripe_id = block_id / data_blocks;
+			guint position = block_id % data_blocks;
+			guint64 displacement = new_offset - block_id * block_size;
+			guint8* block;
 
-			ret = j_backend_object_read(object_backend, object_handle, data, length, offset, &nbytes) && ret;
-			j_helper_atomic_add(bytes_read, nbytes);
+			stripe = g_hash_table_lookup(stripes, &stripe_id);
+			block = stripe->blocks + position * block_size;
+
+			// Data is sent from the stripe, later operations might modify it again.
+			memcpy(block + displacement, new_data, new_length);
+			stripe->lengths[position] = MAX(stripe->lengths[position], displacement + new_length);
+
+			j_distributed_object_add_write(object, semantics, messages, extents, index, block + displacement, new_length, new_offset, bytes_written);
+
+			new_data += new_length;
 		}
-		else
+
+		// Fake bytes_written here instead of doing another loop further down
+		if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE)
 		{
-			gchar* new_data;
-			guint32 index;
-			guint64 block_id;
-			guint64 new_length;
-			guint64 new_offset;
+			j_helper_atomic_add(bytes_written, length);
+		}
 
-			j_distribution_reset(object->distribution, length, offset);
-			new_data = data;
+		G_LOCK(j_distributed_object_size);
 
-			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
-			{
-				JDistributedObjectReadBuffer* buffer;
+		if (object->size != G_MAXUINT64)
+		{
+			object->size = MAX(object->size, offset + length);
+		}
 
-				if (messages[index] == NULL && br_lists[index] == NULL)
-				{
-					messages[index] = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
-					j_message_set_semantics(messages[index], semantics);
-					j_message_append_n(messages[index], object->namespace, namespace_len);
-					j_message_append_n(messages[index], object->name, name_len);
+		G_UNLOCK(j_distributed_object_size);
 
-					br_lists[index] = j_list_new(NULL);
-				}
+		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
+	}
 
-				j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
-				j_message_append_8(messages[index], &new_length);
-				j_message_append_8(messages[index], &new_offset);
+	rs = j_reed_solomon_new(data_blocks, parity_blocks);
+	data_blocks_ = g_new(guint8 const*, data_blocks);
+	parity_blocks_ = g_new(guint8*, parity_blocks + 1);
 
-				buffer = g_slice_new(JDistributedObjectReadBuffer);
-				buffer->data = new_data;
-				buffer->bytes_read = bytes_read;
+	g_hash_table_iter_init(&iter, stripes);
 
-				j_list_append(br_lists[index], buffer);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&stripe))
+	{
+		guint64 length = 0;
 
-				/*
-				if (lock != NULL)
-				{
-					j_lock_add(lock, block_id);
-				}
-				*/
+		for (guint i = 0; i < data_blocks; i++)
+		{
+			data_blocks_[i] = stripe->blocks + i * block_size;
+			length = MAX(length, stripe->lengths[i]);
+		}
 
-				new_data += new_length;
-			}
+		for (guint i = 0; i < parity_blocks; i++)
+		{
+			parity_blocks_[i] = stripe->blocks + (data_blocks + i) * block_size;
 		}
 
-		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
-	}
+		// Parity only has to cover the longest data block, missing data counts as zeros.
+		j_reed_solomon_encode(rs, data_blocks_, parity_blocks_, length);
 
-	if (object_backend != NULL)
-	{
-		ret = j_backend_object_close(object_backend, object_handle) && ret;
-	}
-	else
-	{
-		g_autofree gpointer* background_data = NULL;
+		for (guint i = 0; i < parity_blocks && length > 0; i++)
+		{
+			guint index;
 
-		background_data = g_new(gpointer, server_count);
+			index = j_distribution_get_stripe_server(object->distribution, stripe->id, data_blocks + i);
+			j_distributed_object_add_write(object, semantics, messages, extents, index, parity_blocks_[i], length, stripe->id * stripe_size, &bytes_parity);
+		}
 
-		for (guint i = 0; i < server_count; i++)
+		if (stripe->id == last_stripe_id)
 		{
-			JDistributedObjectBackgroundData* data;
+			guint64 end = 0;
 
-			if (messages[i] == NULL)
+			for (guint i = 0; i < data_blocks; i++)
 			{
-				background_data[i] = NULL;
-				continue;
+				if (stripe->lengths[i] > 0)
+				{
+					end = i * block_size + stripe->lengths[i];
+				}
 			}
 
-			data = g_slice_new(JDistributedObjectBackgroundData);
-			data->index = i;
-			data->message = messages[i];
-			data->operations = NULL;
-			data->semantics = semantics;
-			data->read.buffers = br_lists[i];
+			/**
+			 * The end of the stripe's data is recorded on the parity servers by writing a zero byte there.
+			 * This way, their size covers the object's end even if the server storing the last block is lost.
+			 * The stripe's other blocks are not stored on the parity servers, so the byte does not overwrite anything.
+			 **/
+			for (guint i = 0; i < parity_blocks && end > length; i++)
+			{
+				guint index;
 
-			background_data[i] = data;
+				index = j_distribution_get_stripe_server(object->distribution, stripe->id, data_blocks + i);
+				j_distributed_object_add_write(object, semantics, messages, extents, index, &zero, 1, stripe->id * stripe_size + end - 1, &bytes_parity);
+			}
 		}
-
-		j_helper_execute_parallel(j_distributed_object_read_background_operation, background_data, server_count);
 	}
 
-	/*
-	if (lock != NULL)
-	{
-		// FIXME busy wait
-		while (!j_lock_acquire(lock));
+	j_reed_solomon_free(rs);
 
-		j_lock_free(lock);
-	}
-	*/
+	ret = j_distributed_object_execute_writes(messages, extents, semantics, server_count) && ret;
 
 	return ret;
 }
 
+/**
+ * Removes an object's cached blocks.
+ * Cached blocks are updated before sending, so they have to be removed if a write fails.
+ *
+ * \private
+ *
+ * \param object An object.
+ **/
+static void
+j_distributed_object_cache_invalidate(JDistributedObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+
+	key = j_object_cache_key(G_MAXUINT32, object->namespace, object->name);
+	j_object_cache_remove(key);
+}
+
 static gboolean
-j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_write_send(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -924,14 +2032,15 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	g_autofree JList** bw_lists = NULL;
-	g_autoptr(JListIterator) it = NULL;
+	g_autofree JObjectExtents** extents = NULL;
 	g_autofree JMessage** messages = NULL;
 	JDistributedObject* object = NULL;
 	gpointer object_handle;
-	gsize name_len = 0;
-	gsize namespace_len = 0;
 	guint32 server_count = 0;
+	guint replica_count = 1;
+	guint data_blocks;
+	guint parity_blocks;
+	guint64 block_size;
 
 	// FIXME
 	//JLock* lock = NULL;
@@ -947,9 +2056,20 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 		g_assert(object != NULL);
 	}
 
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
+	if (object_backend == NULL && j_distribution_get_erasure_code(object->distribution, &data_blocks, &parity_blocks, &block_size))
+	{
+		ret = j_distributed_object_write_erasure(object, operations, semantics);
+
+		if (!ret)
+		{
+			j_distributed_object_cache_invalidate(object);
+		}
+
+		return ret;
+	}
+
 	if (object_backend != NULL)
 	{
 		ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
@@ -958,16 +2078,15 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	{
 		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
 		messages = g_new(JMessage*, server_count);
-		bw_lists = g_new(JList*, server_count);
-
-		namespace_len = strlen(object->namespace) + 1;
-		name_len = strlen(object->name) + 1;
+		extents = g_new(JObjectExtents*, server_count);
 
 		for (guint i = 0; i < server_count; i++)
 		{
 			messages[i] = NULL;
-			bw_lists[i] = NULL;
+			extents[i] = NULL;
 		}
+
+		replica_count = j_distribution_get_replica_count(object->distribution);
 	}
 
 	/*
@@ -977,9 +2096,9 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	}
 	*/
 
-	while (j_list_iterator_next(it))
+	for (guint j = 0; j < j_list_length(operations); j++)
 	{
-		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
 		gconstpointer data = operation->write.data;
 		guint64 length = operation->write.length;
 		guint64 offset = operation->write.offset;
@@ -1007,22 +2126,16 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 
 			while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
 			{
-				if (messages[index] == NULL && bw_lists[index] == NULL)
+				// Replicated blocks are written to all replicas in parallel.
+				for (guint i = 0; i < replica_count; i++)
 				{
-					messages[index] = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
-					j_message_set_semantics(messages[index], semantics);
-					j_message_append_n(messages[index], object->namespace, namespace_len);
-					j_message_append_n(messages[index], object->name, name_len);
-
-					bw_lists[index] = j_list_new(NULL);
-				}
+					guint replica;
 
-				j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
-				j_message_append_8(messages[index], &new_length);
-				j_message_append_8(messages[index], &new_offset);
-				j_message_add_send(messages[index], new_data, new_length);
+					replica = (i == 0) ? index : j_distribution_get_replica(object->distribution, block_id, i);
 
-				j_list_append(bw_lists[index], bytes_written);
+					// Only the first replica counts towards bytes_written.
+					j_distributed_object_add_write(object, semantics, messages, extents, replica, new_data, new_length, new_offset, (i == 0) ? bytes_written : &(operation->write.bytes_replicated));
+				}
 
 				/*
 				if (lock != NULL)
@@ -1039,6 +2152,15 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 					j_helper_atomic_add(bytes_written, new_length);
 				}
 			}
+
+			G_LOCK(j_distributed_object_size);
+
+			if (object->size != G_MAXUINT64)
+			{
+				object->size = MAX(object->size, offset + length);
+			}
+
+			G_UNLOCK(j_distributed_object_size);
 		}
 
 		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
@@ -1050,31 +2172,12 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
-		g_autofree gpointer* background_data = NULL;
-
-		background_data = g_new(gpointer, server_count);
-
-		for (guint i = 0; i < server_count; i++)
-		{
-			JDistributedObjectBackgroundData* data;
-
-			if (messages[i] == NULL)
-			{
-				background_data[i] = NULL;
-				continue;
-			}
-
-			data = g_slice_new(JDistributedObjectBackgroundData);
-			data->index = i;
-			data->message = messages[i];
-			data->operations = NULL;
-			data->semantics = semantics;
-			data->write.bytes_written = bw_lists[i];
-
-			background_data[i] = data;
-		}
+		ret = j_distributed_object_execute_writes(messages, extents, semantics, server_count) && ret;
+	}
 
-		j_helper_execute_parallel(j_distributed_object_write_background_operation, background_data, server_count);
+	if (!ret)
+	{
+		j_distributed_object_cache_invalidate(object);
 	}
 
 	/*
@@ -1090,59 +2193,153 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+/**
+ * Writes buffered data.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param semantics The semantics.
+ * \param data      The buffered data.
+ * \param length    A length.
+ * \param offset    An offset.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_write_buffered(gpointer object, JSemantics* semantics, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation operation;
+	g_autoptr(JList) operations = NULL;
+	guint64 nbytes = 0;
+
+	operation.write.object = object;
+	operation.write.data = data;
+	operation.write.length = length;
+	operation.write.offset = offset;
+	operation.write.bytes_written = &nbytes;
+	operation.write.bytes_cached = 0;
+	operation.write.bytes_replicated = 0;
+
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
+
+	return j_distributed_object_write_send(operations, semantics);
+}
+
 static gboolean
-j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
 	gboolean ret = TRUE;
 
-	JBackend* object_backend;
-	g_autoptr(JListIterator) it = NULL;
-	g_autofree JMessage** messages = NULL;
-	gchar const* namespace = NULL;
-	gsize namespace_len = 0;
-	guint32 server_count = 0;
+	g_autoptr(JList) direct = NULL;
+	g_autofree gchar* key = NULL;
+	JDistributedObject* object;
 
 	g_return_val_if_fail(operations != NULL, FALSE);
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
 	{
 		JDistributedObjectOperation* operation = j_list_get_first(operations);
-		JDistributedObject* object = operation->status.object;
-
 		g_assert(operation != NULL);
+
+		object = operation->write.object;
 		g_assert(object != NULL);
+	}
+
+	key = j_object_cache_key(G_MAXUINT32, object->namespace, object->name);
+
+	// Cached blocks are updated so that later reads see the new data.
+	for (guint i = 0; i < j_list_length(operations); i++)
+	{
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, i);
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
+		j_object_cache_write(key, operation->write.data, operation->write.length, operation->write.offset);
 	}
 
-	it = j_list_iterator_new(operations);
-	object_backend = j_object_get_backend();
+	if (j_object_get_backend() != NULL || !j_object_write_buffer_enabled(semantics))
+	{
+		// Writes buffered with other semantics have to be written first.
+		if (j_object_write_buffer_pending())
+		{
+			ret = j_object_write_buffer_flush(key) && ret;
+		}
 
-	if (object_backend == NULL)
+		return j_distributed_object_write_send(operations, semantics) && ret;
+	}
+
+	direct = j_list_new(NULL);
+
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
-		messages = g_new(JMessage*, server_count);
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, i);
 
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
+		// Buffering might write previously buffered data, which has to happen after the preceding direct writes.
+		if (j_list_length(direct) > 0 && operation->write.length < j_object_write_buffer_get_size())
+		{
+			ret = j_distributed_object_write_send(direct, semantics) && ret;
+			j_list_delete_all(direct);
+		}
+
+		if (j_object_write_buffer_add(key, object, j_distributed_object_write_buffered, (JObjectWriteBufferRefFunc)j_distributed_object_ref, (GDestroyNotify)j_distributed_object_unref, semantics, operation->write.data, operation->write.length, operation->write.offset))
+		{
+			// Buffered writes are not acknowledged, just like other writes with a safety semantics of none.
+			j_helper_atomic_add(operation->write.bytes_written, operation->write.length);
+		}
+		else
 		{
-			messages[i] = j_message_new(J_MESSAGE_OBJECT_STATUS, namespace_len);
-			j_message_set_semantics(messages[i], semantics);
-			j_message_append_n(messages[i], namespace, namespace_len);
+			// Large writes are not buffered but must not overtake buffered data.
+			ret = j_object_write_buffer_flush(key) && ret;
+			j_list_append(direct, operation);
 		}
 	}
 
-	while (j_list_iterator_next(it))
+	if (j_list_length(direct) > 0)
+	{
+		ret = j_distributed_object_write_send(direct, semantics) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FIXME check return value for messages
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autofree JMessage** messages = NULL;
+	g_autofree JList** server_operations = NULL;
+	guint32 server_count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new0(JMessage*, server_count);
+		server_operations = g_new0(JList*, server_count);
+	}
+
+	for (guint j = 0; j < j_list_length(operations); j++)
 	{
-		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
 		JDistributedObject* object = operation->status.object;
 		gint64* modification_time = operation->status.modification_time;
 		guint64* size = operation->status.size;
 
+		ret = j_distributed_object_flush_buffered(object) && ret;
+
 		if (modification_time != NULL)
 		{
 			*modification_time = 0;
@@ -1163,15 +2360,22 @@ j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 		}
 		else
 		{
-			gsize name_len;
+			g_autoptr(GArray) servers = NULL;
 
-			name_len = strlen(object->name) + 1;
+			servers = j_distributed_object_get_servers(object);
+			j_distributed_object_add_operation(messages, servers, J_MESSAGE_OBJECT_STATUS, semantics, object);
 
-			// FIXME use actual distribution
-			for (guint i = 0; i < server_count; i++)
+			// Replies only contain the operations sent to the respective server.
+			for (guint i = 0; i < servers->len; i++)
 			{
-				j_message_add_operation(messages[i], name_len);
-				j_message_append_n(messages[i], object->name, name_len);
+				guint index = g_array_index(servers, guint, i);
+
+				if (server_operations[index] == NULL)
+				{
+					server_operations[index] = j_list_new(NULL);
+				}
+
+				j_list_append(server_operations[index], operation);
 			}
 		}
 	}
@@ -1182,21 +2386,34 @@ j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 
 		background_data = g_new(gpointer, server_count);
 
-		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			if (messages[i] == NULL)
+			{
+				background_data[i] = NULL;
+				continue;
+			}
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
-			data->operations = operations;
+			data->operations = server_operations[i];
 			data->semantics = semantics;
 
 			background_data[i] = data;
 		}
 
 		j_helper_execute_parallel(j_distributed_object_status_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			if (server_operations[i] != NULL)
+			{
+				j_list_unref(server_operations[i]);
+			}
+		}
 	}
 
 	return ret;
@@ -1211,48 +2428,27 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autofree JMessage** messages = NULL;
-	gchar const* namespace = NULL;
-	gsize namespace_len = 0;
 	guint32 server_count = 0;
 
 	g_return_val_if_fail(operations != NULL, FALSE);
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
-	{
-		JDistributedObjectOperation* operation = j_list_get_first(operations);
-		JDistributedObject* object = operation->sync.object;
-
-		g_assert(operation != NULL);
-		g_assert(object != NULL);
-
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-	}
-
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend == NULL)
 	{
 		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
-		messages = g_new(JMessage*, server_count);
-
-		// FIXME use actual distribution
-		for (guint i = 0; i < server_count; i++)
-		{
-			messages[i] = j_message_new(J_MESSAGE_OBJECT_SYNC, namespace_len);
-			j_message_set_semantics(messages[i], semantics);
-			j_message_append_n(messages[i], namespace, namespace_len);
-		}
+		messages = g_new0(JMessage*, server_count);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint j = 0; j < j_list_length(operations); j++)
 	{
-		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObjectOperation* operation = j_list_get_nth(operations, j);
 		JDistributedObject* object = operation->sync.object;
 
+		ret = j_distributed_object_flush_buffered(object) && ret;
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -1263,16 +2459,10 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
 		}
 		else
 		{
-			gsize name_len;
+			g_autoptr(GArray) servers = NULL;
 
-			name_len = strlen(object->name) + 1;
-
-			// FIXME use actual distribution
-			for (guint i = 0; i < server_count; i++)
-			{
-				j_message_add_operation(messages[i], name_len);
-				j_message_append_n(messages[i], object->name, name_len);
-			}
+			servers = j_distributed_object_get_servers(object);
+			j_distributed_object_add_operation(messages, servers, J_MESSAGE_OBJECT_SYNC, semantics, object);
 		}
 	}
 
@@ -1282,15 +2472,20 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
 
 		background_data = g_new(gpointer, server_count);
 
-		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			if (messages[i] == NULL)
+			{
+				background_data[i] = NULL;
+				continue;
+			}
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
-			data->operations = operations;
+			data->operations = NULL;
 			data->semantics = semantics;
 
 			background_data[i] = data;
@@ -1333,6 +2528,7 @@ j_distributed_object_new(gchar const* namespace, gchar const* name, JDistributio
 	object->namespace = g_strdup(namespace);
 	object->name = g_strdup(name);
 	object->distribution = j_distribution_ref(distribution);
+	object->size = G_MAXUINT64;
 	object->ref_count = 1;
 
 	return object;
@@ -1412,11 +2608,13 @@ j_distributed_object_create(JDistributedObject* object, JBatch* batch)
 	g_return_if_fail(object != NULL);
 
 	operation = j_operation_new();
-	// FIXME key = index + namespace
 	operation->key = object;
+	operation->key_hash = j_distributed_object_key_hash;
+	operation->key_equal = j_distributed_object_key_equal;
 	operation->data = j_distributed_object_ref(object);
 	operation->exec_func = j_distributed_object_create_exec;
 	operation->free_func = j_distributed_object_create_free;
+	operation->cache_func = j_distributed_object_cache;
 
 	j_batch_add(batch, operation);
 }
@@ -1441,9 +2639,12 @@ j_distributed_object_delete(JDistributedObject* object, JBatch* batch)
 
 	operation = j_operation_new();
 	operation->key = object;
+	operation->key_hash = j_distributed_object_key_hash;
+	operation->key_equal = j_distributed_object_key_equal;
 	operation->data = j_distributed_object_ref(object);
 	operation->exec_func = j_distributed_object_delete_exec;
 	operation->free_func = j_distributed_object_delete_free;
+	operation->cache_func = j_distributed_object_cache;
 
 	j_batch_add(batch, operation);
 }
@@ -1493,6 +2694,8 @@ j_distributed_object_read(JDistributedObject* object, gpointer data, guint64 len
 
 		operation = j_operation_new();
 		operation->key = object;
+		operation->key_hash = j_distributed_object_key_hash;
+		operation->key_equal = j_distributed_object_key_equal;
 		operation->data = iop;
 		operation->exec_func = j_distributed_object_read_exec;
 		operation->free_func = j_distributed_object_read_free;
@@ -1552,12 +2755,16 @@ j_distributed_object_write(JDistributedObject* object, gconstpointer data, guint
 		iop->write.length = chunk_size;
 		iop->write.offset = offset;
 		iop->write.bytes_written = bytes_written;
+		iop->write.bytes_replicated = 0;
 
 		operation = j_operation_new();
 		operation->key = object;
+		operation->key_hash = j_distributed_object_key_hash;
+		operation->key_equal = j_distributed_object_key_equal;
 		operation->data = iop;
 		operation->exec_func = j_distributed_object_write_exec;
 		operation->free_func = j_distributed_object_write_free;
+	operation->cache_func = j_distributed_object_write_cache;
 
 		j_batch_add(batch, operation);
 
@@ -1595,6 +2802,8 @@ j_distributed_object_status(JDistributedObject* object, gint64* modification_tim
 
 	operation = j_operation_new();
 	operation->key = object;
+	operation->key_hash = j_distributed_object_key_hash;
+	operation->key_equal = j_distributed_object_key_equal;
 	operation->data = iop;
 	operation->exec_func = j_distributed_object_status_exec;
 	operation->free_func = j_distributed_object_status_free;
@@ -1626,6 +2835,8 @@ j_distributed_object_sync(JDistributedObject* object, JBatch* batch)
 
 	operation = j_operation_new();
 	operation->key = object;
+	operation->key_hash = j_distributed_object_key_hash;
+	operation->key_equal = j_distributed_object_key_equal;
 	operation->data = iop;
 	operation->exec_func = j_distributed_object_sync_exec;
 	operation->free_func = j_distributed_object_sync_free;
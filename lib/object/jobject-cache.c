@@ -0,0 +1,906 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <object/jobject-cache.h>
+#include <object/jobject-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JObjectCache Object Cache
+ *
+ * Caches object data on clients in fixed-size blocks.
+ * Blocks are valid for the whole session with a consistency semantics of none and for a configurable time with eventual consistency.
+ * Immediate consistency bypasses the cache.
+ *
+ * Sequential reads are detected per object and the following blocks are prefetched into the cache.
+ * Similar to Linux's read-ahead, the prefetch window starts small and doubles whenever the reader catches up with it.
+ * The amount of data being prefetched at the same time is limited to half of the cache's size.
+ *
+ * @{
+ **/
+
+/**
+ * The size of a cached block.
+ **/
+#define J_OBJECT_CACHE_BLOCK_SIZE (64 * 1024)
+
+/**
+ * The maximum number of tracked streams.
+ **/
+#define J_OBJECT_CACHE_MAX_STREAMS 1024
+
+struct JObjectCacheObject;
+
+/**
+ * A cached block.
+ **/
+struct JObjectCacheBlock
+{
+	/** The object the block belongs to. **/
+	struct JObjectCacheObject* object;
+	/** The block's index within the object. **/
+	guint64 index;
+	/** The data. **/
+	gchar* data;
+	/** The number of valid bytes, less than the block size if the object ends within the block. **/
+	guint64 length;
+	/** The time the block was read from the server. **/
+	gint64 time;
+	/** The block's position in the LRU list. **/
+	GList link;
+};
+
+typedef struct JObjectCacheBlock JObjectCacheBlock;
+
+/**
+ * A cached object.
+ **/
+struct JObjectCacheObject
+{
+	/** The object's key. **/
+	gchar* key;
+	/** The cached blocks, indexed by their index. **/
+	GHashTable* blocks;
+	/** The block containing the object's end, if cached. **/
+	JObjectCacheBlock* end;
+};
+
+typedef struct JObjectCacheObject JObjectCacheObject;
+
+/**
+ * The access pattern of an object.
+ **/
+struct JObjectCacheStream
+{
+	/** The offset a sequential read would start at. **/
+	guint64 next_offset;
+	/** The size of the read-ahead window, 0 if the reads are not sequential. **/
+	guint64 window;
+	/** The end of the prefetched data. **/
+	guint64 prefetch_end;
+	/** Changed on every write to detect outdated prefetches. **/
+	guint64 generation;
+};
+
+typedef struct JObjectCacheStream JObjectCacheStream;
+
+/**
+ * The object cache.
+ **/
+struct JObjectCache
+{
+	/** The mutex protecting the cache. **/
+	GMutex mutex[1];
+	/** The cached objects, indexed by their key. **/
+	GHashTable* objects;
+	/** The access patterns, indexed by the objects' keys. **/
+	GHashTable* streams;
+	/** The cached blocks, most recently used first. **/
+	GQueue lru[1];
+	/** The size of all cached blocks. **/
+	guint64 size;
+	/** The maximum size, 0 if the cache is disabled. **/
+	guint64 max_size;
+	/** The time in microseconds blocks stay valid for eventual consistency. **/
+	gint64 ttl;
+	/** The maximum size of the read-ahead window. **/
+	guint64 readahead_size;
+	/** The last generation handed out, shared by all streams so that recreated streams never reuse one. **/
+	guint64 generation;
+	/** The size of all prefetches in progress. **/
+	guint64 prefetching;
+	/** The number of prefetches that have been started. **/
+	guint64 prefetches;
+	/** The number of reads served from the cache. **/
+	guint64 hits;
+	/** The number of reads that had to be sent to the server. **/
+	guint64 misses;
+};
+
+typedef struct JObjectCache JObjectCache;
+
+static void
+j_object_cache_block_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCacheBlock* block = data;
+
+	g_free(block->data);
+
+	g_slice_free(JObjectCacheBlock, block);
+}
+
+static void
+j_object_cache_object_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCacheObject* object = data;
+
+	g_hash_table_unref(object->blocks);
+	g_free(object->key);
+
+	g_slice_free(JObjectCacheObject, object);
+}
+
+static void
+j_object_cache_stream_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_slice_free(JObjectCacheStream, data);
+}
+
+/**
+ * Returns the object cache.
+ *
+ * \private
+ *
+ * \return The object cache.
+ **/
+static JObjectCache*
+j_object_cache_get(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static JObjectCache* cache = NULL;
+
+	if (g_once_init_enter(&cache))
+	{
+		JObjectCache* new_cache;
+
+		new_cache = g_slice_new(JObjectCache);
+		g_mutex_init(new_cache->mutex);
+		new_cache->objects = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, j_object_cache_object_free);
+		new_cache->streams = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, j_object_cache_stream_free);
+		g_queue_init(new_cache->lru);
+		new_cache->size = 0;
+		new_cache->max_size = j_configuration_get_object_cache_size(j_configuration());
+		new_cache->ttl = (gint64)j_configuration_get_object_cache_ttl(j_configuration()) * G_TIME_SPAN_MILLISECOND;
+		// Leave room for the blocks that are currently being read.
+		new_cache->readahead_size = MIN(j_configuration_get_object_readahead_size(j_configuration()), new_cache->max_size / 4);
+		new_cache->readahead_size = MIN(new_cache->readahead_size, j_configuration_get_max_operation_size(j_configuration()));
+		new_cache->readahead_size -= new_cache->readahead_size % J_OBJECT_CACHE_BLOCK_SIZE;
+		new_cache->generation = 0;
+		new_cache->prefetching = 0;
+		new_cache->prefetches = 0;
+		new_cache->hits = 0;
+		new_cache->misses = 0;
+
+		g_once_init_leave(&cache, new_cache);
+	}
+
+	return cache;
+}
+
+/**
+ * Removes a block from the cache.
+ * The cache's mutex has to be held.
+ *
+ * \private
+ *
+ * \param cache The object cache.
+ * \param block A block.
+ **/
+static void
+j_object_cache_remove_block(JObjectCache* cache, JObjectCacheBlock* block)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCacheObject* object = block->object;
+
+	g_queue_unlink(cache->lru, &(block->link));
+	cache->size -= J_OBJECT_CACHE_BLOCK_SIZE;
+
+	if (object->end == block)
+	{
+		object->end = NULL;
+	}
+
+	g_hash_table_remove(object->blocks, &(block->index));
+
+	if (g_hash_table_size(object->blocks) == 0)
+	{
+		g_hash_table_remove(cache->objects, object->key);
+	}
+}
+
+/**
+ * Stores a block in the cache, evicting the least recently used blocks if necessary.
+ * The cache's mutex has to be held.
+ *
+ * \private
+ *
+ * \param cache  The object cache.
+ * \param key    The object's key.
+ * \param index  The block's index.
+ * \param data   The block's data.
+ * \param length The number of valid bytes.
+ **/
+static void
+j_object_cache_insert_block(JObjectCache* cache, gchar const* key, guint64 index, gconstpointer data, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCacheObject* object;
+	JObjectCacheBlock* block = NULL;
+
+	object = g_hash_table_lookup(cache->objects, key);
+
+	if (object != NULL)
+	{
+		block = g_hash_table_lookup(object->blocks, &index);
+	}
+
+	if (block == NULL)
+	{
+		while (cache->size + J_OBJECT_CACHE_BLOCK_SIZE > cache->max_size && cache->lru->tail != NULL)
+		{
+			JObjectCacheBlock* lru_block = cache->lru->tail->data;
+
+			// The object might be freed together with its last block.
+			if (lru_block->object == object && g_hash_table_size(object->blocks) == 1)
+			{
+				object = NULL;
+			}
+
+			j_object_cache_remove_block(cache, lru_block);
+		}
+
+		if (object == NULL)
+		{
+			object = g_slice_new(JObjectCacheObject);
+			object->key = g_strdup(key);
+			object->blocks = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, j_object_cache_block_free);
+			object->end = NULL;
+
+			g_hash_table_insert(cache->objects, object->key, object);
+		}
+
+		block = g_slice_new(JObjectCacheBlock);
+		block->object = object;
+		block->index = index;
+		block->data = g_malloc0(J_OBJECT_CACHE_BLOCK_SIZE);
+		block->link.data = block;
+		block->link.prev = NULL;
+		block->link.next = NULL;
+
+		g_hash_table_insert(object->blocks, &(block->index), block);
+		cache->size += J_OBJECT_CACHE_BLOCK_SIZE;
+	}
+	else
+	{
+		g_queue_unlink(cache->lru, &(block->link));
+	}
+
+	memcpy(block->data, data, length);
+	memset(block->data + length, 0, J_OBJECT_CACHE_BLOCK_SIZE - length);
+	block->length = length;
+	block->time = g_get_monotonic_time();
+
+	if (length < J_OBJECT_CACHE_BLOCK_SIZE)
+	{
+		object->end = block;
+	}
+	else if (object->end == block)
+	{
+		object->end = NULL;
+	}
+
+	g_queue_push_head_link(cache->lru, &(block->link));
+}
+
+/**
+ * Returns the key identifying an object in the cache.
+ *
+ * \private
+ *
+ * \param index     The object's server index, G_MAXUINT32 for distributed objects.
+ * \param namespace The object's namespace.
+ * \param name      The object's name.
+ *
+ * \return A new key. Should be freed with g_free().
+ **/
+gchar*
+j_object_cache_key(guint32 index, gchar const* namespace, gchar const* name)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+	g_return_val_if_fail(name != NULL, NULL);
+
+	// The namespace's length keeps keys unique even if names contain the separator.
+	return g_strdup_printf("%u/%u/%s/%s", index, (guint)strlen(namespace), namespace, name);
+}
+
+/**
+ * Returns whether reads with the given semantics use the cache.
+ *
+ * \private
+ *
+ * \param semantics The semantics.
+ *
+ * \return TRUE if the cache is used, FALSE otherwise.
+ **/
+gboolean
+j_object_cache_enabled(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	return (j_object_cache_get()->max_size >= J_OBJECT_CACHE_BLOCK_SIZE && j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) != J_SEMANTICS_CONSISTENCY_IMMEDIATE);
+}
+
+/**
+ * Serves a read from the cache.
+ * The read is only served if all of its blocks are cached and valid.
+ *
+ * \private
+ *
+ * \param key        The object's key.
+ * \param semantics  The semantics.
+ * \param data       A buffer.
+ * \param length     A length.
+ * \param offset     An offset.
+ * \param bytes_read Number of bytes read.
+ *
+ * \return TRUE if the read was served from the cache, FALSE otherwise.
+ **/
+gboolean
+j_object_cache_read(gchar const* key, JSemantics* semantics, gpointer data, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+	JObjectCacheObject* object;
+	gboolean ret = TRUE;
+	gint64 now;
+	guint64 end = offset + length;
+	guint64 nbytes = 0;
+
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(bytes_read != NULL, FALSE);
+
+	cache = j_object_cache_get();
+	now = g_get_monotonic_time();
+
+	g_mutex_lock(cache->mutex);
+
+	object = g_hash_table_lookup(cache->objects, key);
+
+	for (guint64 position = offset; position < end;)
+	{
+		JObjectCacheBlock* block = NULL;
+		guint64 index = position / J_OBJECT_CACHE_BLOCK_SIZE;
+		guint64 displacement = position % J_OBJECT_CACHE_BLOCK_SIZE;
+		guint64 block_length;
+
+		if (object != NULL)
+		{
+			block = g_hash_table_lookup(object->blocks, &index);
+		}
+
+		if (block != NULL && j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_EVENTUAL && now - block->time > cache->ttl)
+		{
+			// The object might be freed together with its last block.
+			if (g_hash_table_size(object->blocks) == 1)
+			{
+				object = NULL;
+			}
+
+			j_object_cache_remove_block(cache, block);
+			block = NULL;
+		}
+
+		if (block == NULL)
+		{
+			ret = FALSE;
+			break;
+		}
+
+		g_queue_unlink(cache->lru, &(block->link));
+		g_queue_push_head_link(cache->lru, &(block->link));
+
+		// The object ends within this block.
+		if (block->length <= displacement)
+		{
+			break;
+		}
+
+		block_length = MIN(end - position, block->length - displacement);
+		memcpy((gchar*)data + (position - offset), block->data + displacement, block_length);
+
+		position += block_length;
+		nbytes += block_length;
+	}
+
+	if (ret)
+	{
+		cache->hits++;
+	}
+	else
+	{
+		cache->misses++;
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	if (ret)
+	{
+		j_helper_atomic_add(bytes_read, nbytes);
+	}
+
+	return ret;
+}
+
+/**
+ * Stores complete blocks of a read in the cache.
+ * The cache's mutex has to be held.
+ *
+ * \private
+ *
+ * \param cache      The object cache.
+ * \param key        The object's key.
+ * \param data       The buffer that has been read into.
+ * \param length     The requested length.
+ * \param offset     The requested offset.
+ * \param bytes_read The number of bytes that have been read.
+ **/
+static void
+j_object_cache_insert_blocks(JObjectCache* cache, gchar const* key, gconstpointer data, guint64 length, guint64 offset, guint64 bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 end = offset + length;
+	guint64 valid_end = offset + bytes_read;
+
+	for (guint64 index = (offset + J_OBJECT_CACHE_BLOCK_SIZE - 1) / J_OBJECT_CACHE_BLOCK_SIZE; index * J_OBJECT_CACHE_BLOCK_SIZE < end; index++)
+	{
+		guint64 block_offset = index * J_OBJECT_CACHE_BLOCK_SIZE;
+		guint64 block_length;
+
+		if (block_offset > valid_end)
+		{
+			break;
+		}
+
+		// Blocks extending beyond the read are only complete if the object ends within them.
+		if (block_offset + J_OBJECT_CACHE_BLOCK_SIZE > end && valid_end == end)
+		{
+			break;
+		}
+
+		block_length = MIN(J_OBJECT_CACHE_BLOCK_SIZE, valid_end - block_offset);
+		j_object_cache_insert_block(cache, key, index, (gchar const*)data + (block_offset - offset), block_length);
+
+		if (block_length < J_OBJECT_CACHE_BLOCK_SIZE)
+		{
+			break;
+		}
+	}
+}
+
+/**
+ * Stores the result of a read in the cache.
+ * Only blocks that are completely covered by the read are stored, as well as the block containing the object's end.
+ *
+ * \private
+ *
+ * \param key        The object's key.
+ * \param data       The buffer that has been read into.
+ * \param length     The requested length.
+ * \param offset     The requested offset.
+ * \param bytes_read The number of bytes that have been read.
+ **/
+void
+j_object_cache_fill(gchar const* key, gconstpointer data, guint64 length, guint64 offset, guint64 bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+
+	g_return_if_fail(key != NULL);
+	g_return_if_fail(data != NULL);
+	g_return_if_fail(bytes_read <= length);
+
+	cache = j_object_cache_get();
+
+	g_mutex_lock(cache->mutex);
+	j_object_cache_insert_blocks(cache, key, data, length, offset, bytes_read);
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Updates cached blocks with written data.
+ *
+ * \private
+ *
+ * \param key    The object's key.
+ * \param data   The written data.
+ * \param length A length.
+ * \param offset An offset.
+ **/
+void
+j_object_cache_write(gchar const* key, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+	JObjectCacheObject* object;
+	JObjectCacheStream* stream;
+	guint64 end = offset + length;
+
+	g_return_if_fail(key != NULL);
+	g_return_if_fail(data != NULL);
+
+	cache = j_object_cache_get();
+
+	if (cache->max_size == 0 || length == 0)
+	{
+		return;
+	}
+
+	g_mutex_lock(cache->mutex);
+
+	stream = g_hash_table_lookup(cache->streams, key);
+
+	if (stream != NULL)
+	{
+		// Prefetched data is discarded, so it has to be requested again.
+		stream->generation = ++cache->generation;
+		stream->prefetch_end = 0;
+	}
+
+	object = g_hash_table_lookup(cache->objects, key);
+
+	if (object != NULL)
+	{
+		// The object grows beyond its cached end, which turns the rest of the block into a hole.
+		if (object->end != NULL && (object->end->index + 1) * J_OBJECT_CACHE_BLOCK_SIZE <= offset)
+		{
+			object->end->length = J_OBJECT_CACHE_BLOCK_SIZE;
+			object->end = NULL;
+		}
+
+		for (guint64 index = offset / J_OBJECT_CACHE_BLOCK_SIZE; index * J_OBJECT_CACHE_BLOCK_SIZE < end; index++)
+		{
+			JObjectCacheBlock* block;
+			guint64 block_offset = index * J_OBJECT_CACHE_BLOCK_SIZE;
+			guint64 from;
+			guint64 to;
+
+			block = g_hash_table_lookup(object->blocks, &index);
+
+			if (block == NULL)
+			{
+				continue;
+			}
+
+			from = MAX(offset, block_offset);
+			to = MIN(end, block_offset + J_OBJECT_CACHE_BLOCK_SIZE);
+
+			memcpy(block->data + (from - block_offset), (gchar const*)data + (from - offset), to - from);
+			block->length = MAX(block->length, to - block_offset);
+
+			if (object->end == block && block->length == J_OBJECT_CACHE_BLOCK_SIZE)
+			{
+				object->end = NULL;
+			}
+		}
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Removes all cached blocks of an object.
+ *
+ * \private
+ *
+ * \param key The object's key.
+ **/
+void
+j_object_cache_remove(gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+	JObjectCacheObject* object;
+
+	g_return_if_fail(key != NULL);
+
+	cache = j_object_cache_get();
+
+	if (cache->max_size == 0)
+	{
+		return;
+	}
+
+	g_mutex_lock(cache->mutex);
+
+	g_hash_table_remove(cache->streams, key);
+	object = g_hash_table_lookup(cache->objects, key);
+
+	if (object != NULL)
+	{
+		GHashTableIter iter;
+		JObjectCacheBlock* block;
+
+		g_hash_table_iter_init(&iter, object->blocks);
+
+		while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&block))
+		{
+			g_queue_unlink(cache->lru, &(block->link));
+			cache->size -= J_OBJECT_CACHE_BLOCK_SIZE;
+		}
+
+		g_hash_table_remove(cache->objects, key);
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Records a read and decides whether data should be prefetched.
+ * Prefetched data has to be passed to j_object_cache_prefetched().
+ *
+ * \private
+ *
+ * \param key             The object's key.
+ * \param length          The read's length.
+ * \param offset          The read's offset.
+ * \param prefetch_length Returns the length to prefetch.
+ * \param prefetch_offset Returns the offset to prefetch from.
+ * \param generation      Returns the object's generation.
+ *
+ * \return TRUE if data should be prefetched, FALSE otherwise.
+ **/
+gboolean
+j_object_cache_readahead(gchar const* key, guint64 length, guint64 offset, guint64* prefetch_length, guint64* prefetch_offset, guint64* generation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+	JObjectCacheStream* stream;
+	gboolean ret = FALSE;
+	guint64 end = offset + length;
+	guint64 aligned_end;
+
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(prefetch_length != NULL, FALSE);
+	g_return_val_if_fail(prefetch_offset != NULL, FALSE);
+	g_return_val_if_fail(generation != NULL, FALSE);
+
+	cache = j_object_cache_get();
+
+	if (cache->readahead_size == 0 || length == 0)
+	{
+		return FALSE;
+	}
+
+	aligned_end = (end + J_OBJECT_CACHE_BLOCK_SIZE - 1) / J_OBJECT_CACHE_BLOCK_SIZE * J_OBJECT_CACHE_BLOCK_SIZE;
+
+	g_mutex_lock(cache->mutex);
+
+	stream = g_hash_table_lookup(cache->streams, key);
+
+	if (stream == NULL)
+	{
+		// Forget all access patterns instead of tracking them in another LRU list.
+		if (g_hash_table_size(cache->streams) >= J_OBJECT_CACHE_MAX_STREAMS)
+		{
+			g_hash_table_remove_all(cache->streams);
+		}
+
+		stream = g_slice_new(JObjectCacheStream);
+		stream->next_offset = 0;
+		stream->window = 0;
+		stream->prefetch_end = 0;
+		stream->generation = ++cache->generation;
+
+		g_hash_table_insert(cache->streams, g_strdup(key), stream);
+	}
+
+	// Reads starting at the beginning are treated as sequential to prefetch as early as possible.
+	if (offset == stream->next_offset || offset == 0)
+	{
+		if (stream->window == 0 || offset != stream->next_offset)
+		{
+			// The initial window is twice the read's size.
+			// Data prefetched before restarting at the beginning is kept, repeated reads would prefetch it again otherwise.
+			stream->window = MIN(MAX(2 * (aligned_end - offset), J_OBJECT_CACHE_BLOCK_SIZE), cache->readahead_size);
+		}
+		else if (stream->prefetch_end < end + stream->window / 2)
+		{
+			// The reader has consumed half of the window, grow it and prefetch further ahead.
+			stream->window = MIN(2 * stream->window, cache->readahead_size);
+		}
+
+		if (stream->prefetch_end < end + stream->window / 2)
+		{
+			*prefetch_offset = MAX(stream->prefetch_end, aligned_end);
+			*prefetch_length = aligned_end + stream->window - *prefetch_offset;
+			*generation = stream->generation;
+
+			// Prefetches are shortened or skipped while too much data is being prefetched.
+			if (cache->prefetching + *prefetch_length > cache->max_size / 2)
+			{
+				*prefetch_length = cache->max_size / 2 - MIN(cache->prefetching, cache->max_size / 2);
+				*prefetch_length -= *prefetch_length % J_OBJECT_CACHE_BLOCK_SIZE;
+			}
+
+			if (*prefetch_length > 0)
+			{
+				stream->prefetch_end = *prefetch_offset + *prefetch_length;
+				cache->prefetching += *prefetch_length;
+				cache->prefetches++;
+
+				ret = TRUE;
+			}
+		}
+	}
+	else
+	{
+		stream->window = 0;
+		stream->prefetch_end = 0;
+	}
+
+	stream->next_offset = end;
+
+	g_mutex_unlock(cache->mutex);
+
+	return ret;
+}
+
+/**
+ * Stores prefetched data in the cache.
+ * The data is discarded if the object has been written since the prefetch was started.
+ * This has to be called for every prefetch, even if it failed.
+ *
+ * \private
+ *
+ * \param key        The object's key.
+ * \param generation The generation returned by j_object_cache_readahead().
+ * \param data       The prefetched data, NULL if the prefetch failed.
+ * \param length     The prefetched length.
+ * \param offset     The prefetched offset.
+ * \param bytes_read The number of bytes that have been read.
+ **/
+void
+j_object_cache_prefetched(gchar const* key, guint64 generation, gconstpointer data, guint64 length, guint64 offset, guint64 bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+	JObjectCacheStream* stream;
+
+	g_return_if_fail(key != NULL);
+	g_return_if_fail(bytes_read <= length);
+
+	cache = j_object_cache_get();
+
+	g_mutex_lock(cache->mutex);
+
+	cache->prefetching -= length;
+
+	stream = g_hash_table_lookup(cache->streams, key);
+
+	if (data != NULL && stream != NULL && stream->generation == generation)
+	{
+		j_object_cache_insert_blocks(cache, key, data, length, offset, bytes_read);
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Returns the object cache's statistics.
+ *
+ * \code
+ * guint64 hits;
+ * guint64 misses;
+ *
+ * j_object_cache_get_statistics(&hits, &misses);
+ * \endcode
+ *
+ * \param hits   Returns the number of reads served from the cache.
+ * \param misses Returns the number of reads that had to be sent to the servers.
+ **/
+void
+j_object_cache_get_statistics(guint64* hits, guint64* misses)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+
+	g_return_if_fail(hits != NULL);
+	g_return_if_fail(misses != NULL);
+
+	cache = j_object_cache_get();
+
+	g_mutex_lock(cache->mutex);
+	*hits = cache->hits;
+	*misses = cache->misses;
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Returns the number of prefetches that have been started.
+ *
+ * \code
+ * guint64 prefetches;
+ *
+ * j_object_cache_get_readahead_statistics(&prefetches);
+ * \endcode
+ *
+ * \param prefetches Returns the number of prefetches.
+ **/
+void
+j_object_cache_get_readahead_statistics(guint64* prefetches)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+
+	g_return_if_fail(prefetches != NULL);
+
+	cache = j_object_cache_get();
+
+	g_mutex_lock(cache->mutex);
+	*prefetches = cache->prefetches;
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * @}
+ **/
@@ -0,0 +1,592 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <string.h>
+
+#include <object/jobject-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JObjectExtents Object Extents
+ *
+ * Coalesces contiguous reads and writes into larger operations.
+ *
+ * @{
+ **/
+
+/**
+ * A part of an extent, corresponding to a single read or write.
+ **/
+struct JObjectExtentPart
+{
+	/** The buffer to read into. **/
+	gpointer read_data;
+	/** The buffer to write from. **/
+	gconstpointer write_data;
+	/** The length. **/
+	guint64 length;
+	/** The offset. **/
+	guint64 offset;
+	/** The number of bytes read or written. **/
+	guint64* bytes;
+};
+
+typedef struct JObjectExtentPart JObjectExtentPart;
+
+/**
+ * A contiguous extent that is transferred as a single operation.
+ **/
+struct JObjectExtent
+{
+	/** The length. **/
+	guint64 length;
+	/** The offset. **/
+	guint64 offset;
+	/** Whether parts overlap. **/
+	gboolean overlapping;
+	/** The parts, in the order they were added. **/
+	GArray* parts;
+};
+
+typedef struct JObjectExtent JObjectExtent;
+
+/**
+ * A list of extents.
+ **/
+struct JObjectExtents
+{
+	/** The extents. **/
+	GArray* extents;
+	/** Whether overlapping parts may be merged. **/
+	gboolean overlap;
+	/** The maximum length of an extent. **/
+	guint64 max_length;
+};
+
+static void
+j_object_extent_clear(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectExtent* extent = data;
+
+	g_array_unref(extent->parts);
+}
+
+static void
+j_object_extents_add(JObjectExtents* extents, JObjectExtentPart const* part)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectExtent* extent = NULL;
+
+	if (extents->extents->len > 0)
+	{
+		extent = &g_array_index(extents->extents, JObjectExtent, extents->extents->len - 1);
+	}
+
+	if (extent != NULL)
+	{
+		guint64 end;
+		guint64 new_end;
+
+		end = extent->offset + extent->length;
+		new_end = MAX(end, part->offset + part->length);
+
+		// Parts are only appended to keep the order of operations intact.
+		if ((part->offset == end || (extents->overlap && part->offset >= extent->offset && part->offset < end)) && new_end - extent->offset <= extents->max_length)
+		{
+			extent->overlapping = extent->overlapping || part->offset < end;
+			extent->length = new_end - extent->offset;
+			g_array_append_val(extent->parts, *part);
+
+			return;
+		}
+	}
+
+	{
+		JObjectExtent new_extent;
+
+		new_extent.length = part->length;
+		new_extent.offset = part->offset;
+		new_extent.overlapping = FALSE;
+		new_extent.parts = g_array_new(FALSE, FALSE, sizeof(JObjectExtentPart));
+		g_array_append_val(new_extent.parts, *part);
+
+		g_array_append_val(extents->extents, new_extent);
+	}
+}
+
+/**
+ * Creates a new list of extents.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param overlap Whether overlapping parts may be merged, which is only possible for reads.
+ *
+ * \return A new list of extents. Should be freed with j_object_extents_free().
+ **/
+JObjectExtents*
+j_object_extents_new(gboolean overlap)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectExtents* extents;
+
+	extents = g_slice_new(JObjectExtents);
+	extents->extents = g_array_new(FALSE, FALSE, sizeof(JObjectExtent));
+	extents->overlap = overlap;
+	extents->max_length = j_configuration_get_max_operation_size(j_configuration());
+
+	g_array_set_clear_func(extents->extents, j_object_extent_clear);
+
+	return extents;
+}
+
+/**
+ * Frees a list of extents.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents A list of extents.
+ **/
+void
+j_object_extents_free(JObjectExtents* extents)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(extents != NULL);
+
+	g_array_unref(extents->extents);
+
+	g_slice_free(JObjectExtents, extents);
+}
+
+/**
+ * Adds a read.
+ * It is merged with the previous read if their extents are adjacent or overlapping.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents    A list of extents.
+ * \param data       A buffer to hold the read data.
+ * \param length     Number of bytes to read.
+ * \param offset     An offset.
+ * \param bytes_read Number of bytes read.
+ **/
+void
+j_object_extents_add_read(JObjectExtents* extents, gpointer data, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectExtentPart part;
+
+	g_return_if_fail(extents != NULL);
+
+	part.read_data = data;
+	part.write_data = NULL;
+	part.length = length;
+	part.offset = offset;
+	part.bytes = bytes_read;
+
+	j_object_extents_add(extents, &part);
+}
+
+/**
+ * Adds a write.
+ * It is merged with the previous write if their extents are adjacent.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents       A list of extents.
+ * \param data          A buffer holding the data to write.
+ * \param length        Number of bytes to write.
+ * \param offset        An offset.
+ * \param bytes_written Number of bytes written.
+ **/
+void
+j_object_extents_add_write(JObjectExtents* extents, gconstpointer data, guint64 length, guint64 offset, guint64* bytes_written)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectExtentPart part;
+
+	g_return_if_fail(extents != NULL);
+
+	part.read_data = NULL;
+	part.write_data = data;
+	part.length = length;
+	part.offset = offset;
+	part.bytes = bytes_written;
+
+	j_object_extents_add(extents, &part);
+}
+
+/**
+ * Returns the number of extents.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents A list of extents.
+ *
+ * \return The number of extents.
+ **/
+guint
+j_object_extents_get_count(JObjectExtents* extents)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(extents != NULL, 0);
+
+	return extents->extents->len;
+}
+
+/**
+ * Returns the total length of all extents.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents A list of extents.
+ *
+ * \return The total length.
+ **/
+guint64
+j_object_extents_get_length(JObjectExtents* extents)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 length = 0;
+
+	g_return_val_if_fail(extents != NULL, 0);
+
+	for (guint i = 0; i < extents->extents->len; i++)
+	{
+		length += g_array_index(extents->extents, JObjectExtent, i).length;
+	}
+
+	return length;
+}
+
+/**
+ * Splits a list of extents into lists of roughly equal length.
+ * Parts are split at the boundaries, overlapping extents are kept intact.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents A list of extents.
+ * \param count   The number of lists.
+ *
+ * \return An array of new lists of extents, contains JObjectExtents elements that should be freed with j_object_extents_free().
+ **/
+GPtrArray*
+j_object_extents_split(JObjectExtents* extents, guint count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GPtrArray* split;
+	JObjectExtents* current = NULL;
+	guint64 target;
+	guint64 current_length = 0;
+
+	g_return_val_if_fail(extents != NULL, NULL);
+	g_return_val_if_fail(count > 0, NULL);
+
+	split = g_ptr_array_new();
+	target = (j_object_extents_get_length(extents) + count - 1) / count;
+
+	for (guint i = 0; i < extents->extents->len; i++)
+	{
+		JObjectExtent* extent = &g_array_index(extents->extents, JObjectExtent, i);
+
+		for (guint j = 0; j < extent->parts->len; j++)
+		{
+			JObjectExtentPart part = g_array_index(extent->parts, JObjectExtentPart, j);
+
+			do
+			{
+				JObjectExtentPart piece = part;
+
+				if (current == NULL || (current_length >= target && split->len < count))
+				{
+					current = g_slice_new(JObjectExtents);
+					current->extents = g_array_new(FALSE, FALSE, sizeof(JObjectExtent));
+					current->overlap = extents->overlap;
+					current->max_length = extents->max_length;
+					g_array_set_clear_func(current->extents, j_object_extent_clear);
+
+					g_ptr_array_add(split, current);
+					current_length = 0;
+				}
+
+				if (!extent->overlapping && current_length + part.length > target && split->len < count)
+				{
+					piece.length = target - current_length;
+				}
+
+				j_object_extents_add(current, &piece);
+				current_length += piece.length;
+
+				part.length -= piece.length;
+				part.offset += piece.length;
+
+				if (part.read_data != NULL)
+				{
+					part.read_data = (gchar*)part.read_data + piece.length;
+				}
+
+				if (part.write_data != NULL)
+				{
+					part.write_data = (gchar const*)part.write_data + piece.length;
+				}
+			} while (part.length > 0);
+		}
+	}
+
+	return split;
+}
+
+/**
+ * Appends one operation per extent to a message.
+ * For writes, the parts' buffers are gathered without copying them.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents A list of extents.
+ * \param message A message.
+ **/
+void
+j_object_extents_append(JObjectExtents* extents, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(extents != NULL);
+	g_return_if_fail(message != NULL);
+
+	for (guint i = 0; i < extents->extents->len; i++)
+	{
+		JObjectExtent* extent = &g_array_index(extents->extents, JObjectExtent, i);
+
+		j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
+		j_message_append_8(message, &(extent->length));
+		j_message_append_8(message, &(extent->offset));
+
+		for (guint j = 0; j < extent->parts->len; j++)
+		{
+			JObjectExtentPart* part = &g_array_index(extent->parts, JObjectExtentPart, j);
+
+			if (part->write_data != NULL && part->length > 0)
+			{
+				j_message_add_send(message, part->write_data, part->length);
+			}
+		}
+	}
+}
+
+/**
+ * Distributes the number of bytes written per extent to the parts.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents A list of extents.
+ * \param reply   A reply containing one result per extent.
+ *
+ * \return TRUE if the reply contains a result for every extent, FALSE otherwise.
+ **/
+gboolean
+j_object_extents_write_reply(JObjectExtents* extents, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(extents != NULL, FALSE);
+	g_return_val_if_fail(reply != NULL, FALSE);
+
+	// Rejected messages are answered without any results.
+	if (j_message_get_count(reply) < extents->extents->len)
+	{
+		return FALSE;
+	}
+
+	for (guint i = 0; i < extents->extents->len; i++)
+	{
+		JObjectExtent* extent = &g_array_index(extents->extents, JObjectExtent, i);
+		guint64 nbytes;
+
+		nbytes = j_message_get_8(reply);
+
+		for (guint j = 0; j < extent->parts->len; j++)
+		{
+			JObjectExtentPart* part = &g_array_index(extent->parts, JObjectExtentPart, j);
+			guint64 part_nbytes;
+
+			part_nbytes = MIN(part->length, nbytes);
+			j_helper_atomic_add(part->bytes, part_nbytes);
+			nbytes -= part_nbytes;
+		}
+	}
+
+	return TRUE;
+}
+
+static void
+j_object_extent_read(JObjectExtent* extent, guint64 nbytes, JMessage* reply, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (!extent->overlapping)
+	{
+		// Parts are adjacent, so the data can be read directly into their buffers.
+		for (guint i = 0; i < extent->parts->len && nbytes > 0; i++)
+		{
+			JObjectExtentPart* part = &g_array_index(extent->parts, JObjectExtentPart, i);
+			guint64 part_nbytes;
+
+			part_nbytes = MIN(part->length, nbytes);
+			j_message_receive_data(reply, connection, part->read_data, part_nbytes);
+			j_helper_atomic_add(part->bytes, part_nbytes);
+			nbytes -= part_nbytes;
+		}
+	}
+	else
+	{
+		g_autofree gchar* buffer = NULL;
+
+		buffer = g_malloc(nbytes);
+		j_message_receive_data(reply, connection, buffer, nbytes);
+
+		for (guint i = 0; i < extent->parts->len; i++)
+		{
+			JObjectExtentPart* part = &g_array_index(extent->parts, JObjectExtentPart, i);
+			guint64 part_offset;
+			guint64 part_nbytes = 0;
+
+			part_offset = part->offset - extent->offset;
+
+			if (nbytes > part_offset)
+			{
+				part_nbytes = MIN(part->length, nbytes - part_offset);
+				memcpy(part->read_data, buffer + part_offset, part_nbytes);
+			}
+
+			j_helper_atomic_add(part->bytes, part_nbytes);
+		}
+	}
+}
+
+/**
+ * Receives the replies to a read message and scatters the data into the parts' buffers.
+ *
+ * \private
+ *
+ * \code
+ * \endcode
+ *
+ * \param extents    A list of extents.
+ * \param message    The read message.
+ * \param connection The connection the message was sent on.
+ *
+ * \return TRUE on success, FALSE if the replies could not be received.
+ **/
+gboolean
+j_object_extents_read_reply(JObjectExtents* extents, JMessage* message, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) reply = NULL;
+	guint32 operations_done;
+	guint32 operation_count;
+
+	g_return_val_if_fail(extents != NULL, FALSE);
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	reply = j_message_new_reply(message);
+
+	operations_done = 0;
+	operation_count = j_message_get_count(message);
+
+	/**
+	 * This extra loop is necessary because the server might send multiple
+	 * replies per message. The same reply object can be used to receive
+	 * multiple times.
+	 */
+	while (operations_done < operation_count)
+	{
+		guint32 reply_operation_count;
+
+		if (!j_message_receive(reply, connection))
+		{
+			return FALSE;
+		}
+
+		reply_operation_count = j_message_get_count(reply);
+
+		for (guint i = 0; i < reply_operation_count && operations_done + i < extents->extents->len; i++)
+		{
+			JObjectExtent* extent = &g_array_index(extents->extents, JObjectExtent, operations_done + i);
+			guint64 nbytes;
+
+			nbytes = j_message_get_8(reply);
+			j_object_extent_read(extent, nbytes, reply, connection);
+		}
+
+		operations_done += reply_operation_count;
+	}
+
+	return TRUE;
+}
+
+/**
+ * @}
+ **/
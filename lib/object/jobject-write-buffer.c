@@ -0,0 +1,777 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <object/jobject-write-buffer.h>
+#include <object/jobject-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JObjectWriteBuffer Object Write Buffer
+ *
+ * Aggregates small contiguous writes to the same object on clients.
+ * Writes are only buffered with a safety semantics of none, because they are not acknowledged anyway, and a consistency semantics other than immediate, because other clients do not have to see them at the end of the batch.
+ * Buffered writes are sent as a single write when the buffer is full, when a write does not continue the buffered data, and before the object is read, synced or its status is queried.
+ * Writes buffered with a consistency semantics of eventual are also sent at the end of each batch.
+ * Additionally, a background thread sends all writes that have been buffered for longer than the configured interval.
+ *
+ * @{
+ **/
+
+/**
+ * The maximum number of objects with buffered writes.
+ **/
+#define J_OBJECT_WRITE_BUFFER_MAX_OBJECTS 64
+
+/**
+ * The buffered writes of an object.
+ **/
+struct JObjectWriteBufferEntry
+{
+	/** The object's key. **/
+	gchar* key;
+	/** The object. **/
+	gpointer object;
+	/** The function writing the buffered data. **/
+	JObjectWriteBufferFunc func;
+	/** The function releasing the object. **/
+	GDestroyNotify object_free;
+	/** The semantics of the first buffered write. **/
+	JSemantics* semantics;
+	/** The buffered data. **/
+	gchar* data;
+	/** The length of the buffered data. **/
+	guint64 length;
+	/** The offset of the buffered data. **/
+	guint64 offset;
+	/** The time the entry has been created. **/
+	gint64 time;
+	/** The entry's position in the list of entries. **/
+	GList link;
+};
+
+typedef struct JObjectWriteBufferEntry JObjectWriteBufferEntry;
+
+/**
+ * The write buffer.
+ **/
+struct JObjectWriteBuffer
+{
+	/** The mutex protecting the buffer. **/
+	GMutex mutex[1];
+	/** The entries, indexed by the objects' keys. **/
+	GHashTable* entries;
+	/** The entries, oldest first. **/
+	GQueue queue[1];
+	/** The size of each entry's buffer, 0 if the write buffer is disabled. **/
+	guint64 size;
+	/** The time in microseconds after which entries are written. **/
+	gint64 interval;
+	/** The number of entries that are being written, indexed by the objects' keys. **/
+	GHashTable* in_flight;
+	/** The condition signaled when an entry has been written. **/
+	GCond written[1];
+	/** The condition signaled when the flush thread has to check the entries. **/
+	GCond timer[1];
+	/** The thread writing old entries. **/
+	GThread* thread;
+	/** Whether the flush thread is running. **/
+	gboolean running;
+	/** The number of buffered writes. **/
+	guint64 writes;
+	/** The number of writes sent for buffered data. **/
+	guint64 flushes;
+};
+
+typedef struct JObjectWriteBuffer JObjectWriteBuffer;
+
+static JObjectWriteBuffer* j_object_write_buffer = NULL;
+
+/**
+ * Whether the current thread is writing buffered data.
+ **/
+static GPrivate j_object_write_buffer_writing;
+
+static gpointer j_object_write_buffer_thread(gpointer);
+static gboolean j_object_write_buffer_batch_flush(JSemantics*);
+
+/**
+ * Returns the write buffer.
+ *
+ * \private
+ *
+ * \return The write buffer.
+ **/
+static JObjectWriteBuffer*
+j_object_write_buffer_get(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (g_once_init_enter(&j_object_write_buffer))
+	{
+		JObjectWriteBuffer* new_buffer;
+
+		new_buffer = g_slice_new(JObjectWriteBuffer);
+		g_mutex_init(new_buffer->mutex);
+		new_buffer->entries = g_hash_table_new(g_str_hash, g_str_equal);
+		g_queue_init(new_buffer->queue);
+		// Writes are split into operations of at most this size anyway.
+		new_buffer->size = MIN(j_configuration_get_object_write_buffer_size(j_configuration()), j_configuration_get_max_operation_size(j_configuration()));
+		new_buffer->interval = j_configuration_get_object_write_buffer_interval(j_configuration()) * G_TIME_SPAN_MILLISECOND;
+		new_buffer->in_flight = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		g_cond_init(new_buffer->written);
+		g_cond_init(new_buffer->timer);
+		new_buffer->thread = NULL;
+		new_buffer->running = (new_buffer->size > 0);
+		new_buffer->writes = 0;
+		new_buffer->flushes = 0;
+
+		if (new_buffer->running)
+		{
+			new_buffer->thread = g_thread_new("j-object-write-buffer", j_object_write_buffer_thread, new_buffer);
+			j_batch_add_flush_func(j_object_write_buffer_batch_flush);
+		}
+
+		g_once_init_leave(&j_object_write_buffer, new_buffer);
+	}
+
+	return j_object_write_buffer;
+}
+
+/**
+ * Removes an entry from the write buffer.
+ * The buffer's mutex has to be held.
+ *
+ * \private
+ *
+ * \param buffer The write buffer.
+ * \param entry  An entry.
+ * \param write  Whether the entry's data is going to be written.
+ **/
+static void
+j_object_write_buffer_detach(JObjectWriteBuffer* buffer, JObjectWriteBufferEntry* entry, gboolean write)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_hash_table_remove(buffer->entries, entry->key);
+	g_queue_unlink(buffer->queue, &(entry->link));
+
+	// Other threads must not overtake the write, so it is tracked until it has been sent.
+	if (write)
+	{
+		guint count;
+
+		count = GPOINTER_TO_UINT(g_hash_table_lookup(buffer->in_flight, entry->key));
+		g_hash_table_insert(buffer->in_flight, g_strdup(entry->key), GUINT_TO_POINTER(count + 1));
+	}
+}
+
+/**
+ * Waits until no buffered data of an object is being written.
+ * The buffer's mutex has to be held.
+ *
+ * \private
+ *
+ * \param buffer The write buffer.
+ * \param key    The object's key.
+ **/
+static void
+j_object_write_buffer_wait(JObjectWriteBuffer* buffer, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Writing buffered data might require reading the object, which must not wait for the write itself.
+	if (g_private_get(&j_object_write_buffer_writing) != NULL)
+	{
+		return;
+	}
+
+	while (g_hash_table_contains(buffer->in_flight, key))
+	{
+		g_cond_wait(buffer->written, buffer->mutex);
+	}
+}
+
+/**
+ * Writes an entry's data and frees the entry.
+ * The buffer's mutex must not be held because writing might flush other entries.
+ *
+ * \private
+ *
+ * \param entry An entry.
+ * \param write Whether to write the data or to discard it.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_write_buffer_entry_free(JObjectWriteBufferEntry* entry, gboolean write)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	if (write)
+	{
+		JObjectWriteBuffer* buffer = j_object_write_buffer;
+		guint count;
+
+		if (entry->length > 0)
+		{
+			g_private_set(&j_object_write_buffer_writing, GUINT_TO_POINTER(1));
+			ret = entry->func(entry->object, entry->semantics, entry->data, entry->length, entry->offset);
+			g_private_set(&j_object_write_buffer_writing, NULL);
+		}
+
+		g_mutex_lock(buffer->mutex);
+
+		buffer->flushes++;
+		count = GPOINTER_TO_UINT(g_hash_table_lookup(buffer->in_flight, entry->key));
+
+		if (count > 1)
+		{
+			g_hash_table_insert(buffer->in_flight, g_strdup(entry->key), GUINT_TO_POINTER(count - 1));
+		}
+		else
+		{
+			g_hash_table_remove(buffer->in_flight, entry->key);
+		}
+
+		g_cond_broadcast(buffer->written);
+		g_mutex_unlock(buffer->mutex);
+	}
+
+	entry->object_free(entry->object);
+	j_semantics_unref(entry->semantics);
+	g_free(entry->data);
+	g_free(entry->key);
+
+	g_slice_free(JObjectWriteBufferEntry, entry);
+
+	return ret;
+}
+
+/**
+ * Writes entries that have been buffered for longer than the configured interval.
+ *
+ * \private
+ *
+ * \param data The write buffer.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_object_write_buffer_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer = data;
+
+	g_mutex_lock(buffer->mutex);
+
+	while (buffer->running)
+	{
+		JObjectWriteBufferEntry* entry;
+
+		if (buffer->queue->head == NULL)
+		{
+			g_cond_wait(buffer->timer, buffer->mutex);
+			continue;
+		}
+
+		// Entries are queued in the order they have been created, so the first one is the oldest.
+		entry = buffer->queue->head->data;
+
+		if (entry->time + buffer->interval > g_get_monotonic_time())
+		{
+			g_cond_wait_until(buffer->timer, buffer->mutex, entry->time + buffer->interval);
+			continue;
+		}
+
+		j_object_write_buffer_detach(buffer, entry, TRUE);
+
+		g_mutex_unlock(buffer->mutex);
+
+		if (!j_object_write_buffer_entry_free(entry, TRUE))
+		{
+			g_warning("Could not write buffered data.");
+		}
+
+		g_mutex_lock(buffer->mutex);
+	}
+
+	g_mutex_unlock(buffer->mutex);
+
+	return NULL;
+}
+
+/**
+ * Writes the entries that have not been buffered with a consistency semantics of none.
+ * This is called at the end of each batch.
+ *
+ * \private
+ *
+ * \param semantics The batch's semantics.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_write_buffer_batch_flush(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer = j_object_write_buffer;
+	gboolean ret = TRUE;
+
+	if (j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_NONE)
+	{
+		return TRUE;
+	}
+
+	while (TRUE)
+	{
+		JObjectWriteBufferEntry* entry = NULL;
+
+		g_mutex_lock(buffer->mutex);
+
+		for (GList* link = buffer->queue->head; link != NULL; link = link->next)
+		{
+			JObjectWriteBufferEntry* candidate = link->data;
+
+			if (j_semantics_get(candidate->semantics, J_SEMANTICS_CONSISTENCY) != J_SEMANTICS_CONSISTENCY_NONE)
+			{
+				entry = candidate;
+				j_object_write_buffer_detach(buffer, entry, TRUE);
+				break;
+			}
+		}
+
+		g_mutex_unlock(buffer->mutex);
+
+		if (entry == NULL)
+		{
+			break;
+		}
+
+		ret = j_object_write_buffer_entry_free(entry, TRUE) && ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Returns whether writes with the given semantics are buffered.
+ *
+ * \private
+ *
+ * \param semantics The semantics.
+ *
+ * \return TRUE if writes are buffered, FALSE otherwise.
+ **/
+gboolean
+j_object_write_buffer_enabled(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	return (j_object_write_buffer_get()->size > 0 && j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE && j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) != J_SEMANTICS_CONSISTENCY_IMMEDIATE);
+}
+
+/**
+ * Returns the size of the write buffer.
+ * Writes of this size or larger are not buffered.
+ *
+ * \private
+ *
+ * \return The size.
+ **/
+guint64
+j_object_write_buffer_get_size(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_object_write_buffer_get()->size;
+}
+
+/**
+ * Returns whether any writes are buffered.
+ * This allows callers to skip flushing without creating keys.
+ *
+ * \private
+ *
+ * \return TRUE if writes are buffered, FALSE otherwise.
+ **/
+gboolean
+j_object_write_buffer_pending(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer;
+	gboolean ret;
+
+	buffer = j_object_write_buffer_get();
+
+	if (buffer->size == 0)
+	{
+		return FALSE;
+	}
+
+	g_mutex_lock(buffer->mutex);
+	ret = (buffer->queue->length > 0 || g_hash_table_size(buffer->in_flight) > 0);
+	g_mutex_unlock(buffer->mutex);
+
+	return ret;
+}
+
+/**
+ * Buffers a write.
+ * If the write does not continue the object's buffered data, the buffered data is written first.
+ *
+ * \private
+ *
+ * \param key         The object's key.
+ * \param object      The object.
+ * \param func        The function writing buffered data.
+ * \param object_ref  The function referencing the object.
+ * \param object_free The function releasing the object.
+ * \param semantics   The semantics.
+ * \param data        The data.
+ * \param length      A length.
+ * \param offset      An offset.
+ *
+ * \return TRUE if the write has been buffered, FALSE if it is too large and has to be written directly.
+ **/
+gboolean
+j_object_write_buffer_add(gchar const* key, gpointer object, JObjectWriteBufferFunc func, JObjectWriteBufferRefFunc object_ref, GDestroyNotify object_free, JSemantics* semantics, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer;
+	JObjectWriteBufferEntry* entry;
+	JObjectWriteBufferEntry* filled_entry = NULL;
+	JObjectWriteBufferEntry* old_entry = NULL;
+	JObjectWriteBufferEntry* previous_entry = NULL;
+
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(object != NULL, FALSE);
+	g_return_val_if_fail(func != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	buffer = j_object_write_buffer_get();
+
+	if (length >= buffer->size)
+	{
+		return FALSE;
+	}
+
+	g_mutex_lock(buffer->mutex);
+
+	j_object_write_buffer_wait(buffer, key);
+	buffer->writes++;
+
+	entry = g_hash_table_lookup(buffer->entries, key);
+
+	if (entry != NULL && (entry->offset + entry->length != offset || entry->length + length > buffer->size))
+	{
+		j_object_write_buffer_detach(buffer, entry, TRUE);
+		previous_entry = entry;
+		entry = NULL;
+	}
+
+	if (entry == NULL)
+	{
+		if (buffer->queue->length >= J_OBJECT_WRITE_BUFFER_MAX_OBJECTS)
+		{
+			old_entry = buffer->queue->head->data;
+			j_object_write_buffer_detach(buffer, old_entry, TRUE);
+		}
+		else if (buffer->queue->length == 0)
+		{
+			// The flush thread waits indefinitely while the buffer is empty.
+			g_cond_signal(buffer->timer);
+		}
+
+		entry = g_slice_new(JObjectWriteBufferEntry);
+		entry->key = g_strdup(key);
+		entry->object = object_ref(object);
+		entry->func = func;
+		entry->object_free = object_free;
+		entry->semantics = j_semantics_ref(semantics);
+		entry->data = g_malloc(buffer->size);
+		entry->length = 0;
+		entry->offset = offset;
+		entry->time = g_get_monotonic_time();
+		entry->link.data = entry;
+		entry->link.prev = NULL;
+		entry->link.next = NULL;
+
+		g_hash_table_insert(buffer->entries, entry->key, entry);
+		g_queue_push_tail_link(buffer->queue, &(entry->link));
+	}
+
+	memcpy(entry->data + entry->length, data, length);
+	entry->length += length;
+
+	if (entry->length == buffer->size)
+	{
+		j_object_write_buffer_detach(buffer, entry, TRUE);
+		filled_entry = entry;
+	}
+
+	g_mutex_unlock(buffer->mutex);
+
+	if (old_entry != NULL)
+	{
+		j_object_write_buffer_entry_free(old_entry, TRUE);
+	}
+
+	// The previously buffered data has to be written before the new data.
+	if (previous_entry != NULL)
+	{
+		j_object_write_buffer_entry_free(previous_entry, TRUE);
+	}
+
+	if (filled_entry != NULL)
+	{
+		j_object_write_buffer_entry_free(filled_entry, TRUE);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Writes an object's buffered data.
+ *
+ * \private
+ *
+ * \param key The object's key.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_object_write_buffer_flush(gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer;
+	JObjectWriteBufferEntry* entry;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	buffer = j_object_write_buffer_get();
+
+	if (buffer->size == 0)
+	{
+		return TRUE;
+	}
+
+	g_mutex_lock(buffer->mutex);
+
+	entry = g_hash_table_lookup(buffer->entries, key);
+
+	if (entry != NULL)
+	{
+		j_object_write_buffer_detach(buffer, entry, TRUE);
+	}
+
+	g_mutex_unlock(buffer->mutex);
+
+	if (entry != NULL)
+	{
+		ret = j_object_write_buffer_entry_free(entry, TRUE);
+	}
+
+	// Writes sent by other threads have to arrive before the caller continues.
+	g_mutex_lock(buffer->mutex);
+	j_object_write_buffer_wait(buffer, key);
+	g_mutex_unlock(buffer->mutex);
+
+	return ret;
+}
+
+/**
+ * Discards an object's buffered data, for instance, because the object is deleted.
+ *
+ * \private
+ *
+ * \param key The object's key.
+ **/
+void
+j_object_write_buffer_discard(gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer;
+	JObjectWriteBufferEntry* entry;
+
+	g_return_if_fail(key != NULL);
+
+	buffer = j_object_write_buffer_get();
+
+	if (buffer->size == 0)
+	{
+		return;
+	}
+
+	g_mutex_lock(buffer->mutex);
+
+	// Writes sent by other threads must not recreate the object after it has been deleted.
+	j_object_write_buffer_wait(buffer, key);
+	entry = g_hash_table_lookup(buffer->entries, key);
+
+	if (entry != NULL)
+	{
+		j_object_write_buffer_detach(buffer, entry, FALSE);
+	}
+
+	g_mutex_unlock(buffer->mutex);
+
+	if (entry != NULL)
+	{
+		j_object_write_buffer_entry_free(entry, FALSE);
+	}
+}
+
+/**
+ * Writes all buffered data.
+ *
+ * \private
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_object_write_buffer_flush_all(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer;
+	gboolean ret = TRUE;
+
+	// Nothing has been buffered if the buffer has not been created yet.
+	buffer = g_atomic_pointer_get(&j_object_write_buffer);
+
+	if (buffer == NULL || buffer->size == 0)
+	{
+		return TRUE;
+	}
+
+	while (TRUE)
+	{
+		JObjectWriteBufferEntry* entry = NULL;
+
+		g_mutex_lock(buffer->mutex);
+
+		if (buffer->queue->head != NULL)
+		{
+			entry = buffer->queue->head->data;
+			j_object_write_buffer_detach(buffer, entry, TRUE);
+		}
+
+		g_mutex_unlock(buffer->mutex);
+
+		if (entry == NULL)
+		{
+			break;
+		}
+
+		ret = j_object_write_buffer_entry_free(entry, TRUE) && ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Stops the flush thread and writes all buffered data.
+ * Failures are reported because they can not be returned to the application anymore.
+ *
+ * \private
+ **/
+void
+j_object_write_buffer_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer;
+
+	buffer = g_atomic_pointer_get(&j_object_write_buffer);
+
+	if (buffer == NULL || buffer->thread == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(buffer->mutex);
+	buffer->running = FALSE;
+	g_cond_signal(buffer->timer);
+	g_mutex_unlock(buffer->mutex);
+
+	g_thread_join(buffer->thread);
+	buffer->thread = NULL;
+
+	if (!j_object_write_buffer_flush_all())
+	{
+		g_warning("Could not write buffered data.");
+	}
+}
+
+/**
+ * Returns the write buffer's statistics.
+ *
+ * \code
+ * guint64 writes;
+ * guint64 flushes;
+ *
+ * j_object_write_buffer_get_statistics(&writes, &flushes);
+ * \endcode
+ *
+ * \param writes  Returns the number of buffered writes.
+ * \param flushes Returns the number of writes sent for buffered data.
+ **/
+void
+j_object_write_buffer_get_statistics(guint64* writes, guint64* flushes)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteBuffer* buffer;
+
+	g_return_if_fail(writes != NULL);
+	g_return_if_fail(flushes != NULL);
+
+	buffer = j_object_write_buffer_get();
+
+	g_mutex_lock(buffer->mutex);
+	*writes = buffer->writes;
+	*flushes = buffer->flushes;
+	g_mutex_unlock(buffer->mutex);
+}
+
+/**
+ * @}
+ **/
@@ -71,12 +71,49 @@ struct JObjectOperation
 			guint64 length;
 			guint64 offset;
 			guint64* bytes_written;
+			guint64 bytes_cached;
 		} write;
 	};
 };
 
 typedef struct JObjectOperation JObjectOperation;
 
+/**
+ * A prefetch of sequentially read data.
+ **/
+struct JObjectPrefetch
+{
+	/** The object. **/
+	JObject* object;
+	/** The semantics of the triggering read. **/
+	JSemantics* semantics;
+	/** The object's cache key. **/
+	gchar* key;
+	/** The object's cache generation. **/
+	guint64 generation;
+	/** The buffer to read into. **/
+	gpointer data;
+	/** The length to read. **/
+	guint64 length;
+	/** The offset to read from. **/
+	guint64 offset;
+};
+
+typedef struct JObjectPrefetch JObjectPrefetch;
+
+/**
+ * A deferred write reply.
+ **/
+struct JObjectWriteReply
+{
+	/** The extents that have been written. **/
+	JObjectExtents* extents;
+	/** The object's cache key. **/
+	gchar* key;
+};
+
+typedef struct JObjectWriteReply JObjectWriteReply;
+
 /**
  * A JObject.
  **/
@@ -144,6 +181,10 @@ j_object_init(void)
 static void
 j_object_fini(void)
 {
+	// Buffered writes of all objects, including distributed ones, would be lost otherwise.
+	// Applications should not rely on this, since failures can only be reported as warnings here.
+	j_object_write_buffer_fini();
+
 	if (j_object_backend == NULL && j_object_module == NULL)
 	{
 		return;
@@ -162,6 +203,23 @@ j_object_fini(void)
 	}
 }
 
+static guint
+j_object_key_hash(gconstpointer key)
+{
+	JObject const* object = key;
+
+	return g_str_hash(object->namespace) ^ g_str_hash(object->name);
+}
+
+static gboolean
+j_object_key_equal(gconstpointer a, gconstpointer b)
+{
+	JObject const* object_a = a;
+	JObject const* object_b = b;
+
+	return (object_a->index == object_b->index && g_str_equal(object_a->namespace, object_b->namespace) && g_str_equal(object_a->name, object_b->name));
+}
+
 static void
 j_object_create_free(gpointer data)
 {
@@ -230,16 +288,101 @@ j_object_write_free(gpointer data)
 	g_slice_free(JObjectOperation, operation);
 }
 
+static guint64
+j_object_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+	(void)buffer;
+
+	// The operation only references the object, which is kept alive by the operation itself.
+	return 0;
+}
+
+static guint64
+j_object_write_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	if (buffer != NULL)
+	{
+		memcpy(buffer, operation->write.data, operation->write.length);
+		operation->write.data = buffer;
+
+		// The caller is told that all data has been written, the actual result is discarded.
+		*(operation->write.bytes_written) += operation->write.length;
+		operation->write.bytes_cached = 0;
+		operation->write.bytes_written = &(operation->write.bytes_cached);
+	}
+
+	return operation->write.length;
+}
+
+/**
+ * Writes an object's buffered data.
+ *
+ * \private
+ *
+ * \param object An object.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_flush_buffered(JObject* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+
+	if (!j_object_write_buffer_pending())
+	{
+		return TRUE;
+	}
+
+	key = j_object_cache_key(object->index, object->namespace, object->name);
+
+	return j_object_write_buffer_flush(key);
+}
+
+/**
+ * Checks the statuses contained in a reply to a create or delete message.
+ *
+ * \private
+ *
+ * \param reply A reply.
+ * \param count The number of operations contained in the reply.
+ * \param data  Unused.
+ *
+ * \return TRUE if all operations succeeded, FALSE otherwise.
+ **/
+static gboolean
+j_object_modify_reply(JMessage* reply, guint32 count, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	(void)data;
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		ret = (j_message_get_4(reply) == 1) && ret;
+	}
+
+	return ret;
+}
+
 static gboolean
 j_object_create_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
 	gchar const* namespace;
 	gsize namespace_len;
@@ -259,7 +402,6 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 		index = object->index;
 	}
 
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend == NULL)
@@ -272,14 +414,24 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 		 * - The second operation is executed first and fails because the item does not exist.
 		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
 		 **/
-		message = j_message_new(J_MESSAGE_OBJECT_CREATE, namespace_len);
+		gsize length = namespace_len;
+
+		// Precompute the exact message size to avoid resizing the message while appending operations.
+		for (guint i = 0; i < j_list_length(operations); i++)
+		{
+			JObject* object = j_list_get_nth(operations, i);
+
+			length += strlen(object->name) + 1;
+		}
+
+		message = j_message_new(J_MESSAGE_OBJECT_CREATE, length);
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JObject* object = j_list_iterator_get(it);
+		JObject* object = j_list_get_nth(operations, i);
 
 		if (object_backend != NULL)
 		{
@@ -307,16 +459,31 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 
 		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
-		j_message_send(message, object_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		if ((safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE) && j_configuration_get_coalesce_replies(j_configuration()))
 		{
-			g_autoptr(JMessage) reply = NULL;
+			// Failures reported by the reply are returned when the batch collects its replies.
+			ret = j_message_send_deferred(message, object_connection, j_object_modify_reply, NULL) && ret;
+		}
+		else
+		{
+			ret = j_message_send(message, object_connection) && ret;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, object_connection);
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				g_autoptr(JMessage) reply = NULL;
 
-			/* FIXME do something with reply */
+				reply = j_message_new_reply(message);
+
+				if (j_message_receive(reply, object_connection))
+				{
+					ret = j_object_modify_reply(reply, j_message_get_count(reply), NULL) && ret;
+				}
+				else
+				{
+					ret = FALSE;
+				}
+			}
 		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
@@ -330,11 +497,9 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	g_autoptr(JListIterator) it = NULL;
 	g_autoptr(JMessage) message = NULL;
 	gchar const* namespace;
 	gsize namespace_len;
@@ -354,19 +519,33 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 		index = object->index;
 	}
 
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend == NULL)
 	{
-		message = j_message_new(J_MESSAGE_OBJECT_DELETE, namespace_len);
+		gsize length = namespace_len;
+
+		// Precompute the exact message size to avoid resizing the message while appending operations.
+		for (guint i = 0; i < j_list_length(operations); i++)
+		{
+			JObject* object = j_list_get_nth(operations, i);
+
+			length += strlen(object->name) + 1;
+		}
+
+		message = j_message_new(J_MESSAGE_OBJECT_DELETE, length);
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JObject* object = j_list_iterator_get(it);
+		JObject* object = j_list_get_nth(operations, i);
+		g_autofree gchar* key = NULL;
+
+		key = j_object_cache_key(object->index, object->namespace, object->name);
+		j_object_cache_remove(key);
+		j_object_write_buffer_discard(key);
 
 		if (object_backend != NULL)
 		{
@@ -394,16 +573,31 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 
 		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
-		j_message_send(message, object_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		if ((safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE) && j_configuration_get_coalesce_replies(j_configuration()))
 		{
-			g_autoptr(JMessage) reply = NULL;
+			// Failures reported by the reply are returned when the batch collects its replies.
+			ret = j_message_send_deferred(message, object_connection, j_object_modify_reply, NULL) && ret;
+		}
+		else
+		{
+			ret = j_message_send(message, object_connection) && ret;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, object_connection);
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				g_autoptr(JMessage) reply = NULL;
+
+				reply = j_message_new_reply(message);
 
-			/* FIXME do something with reply */
+				if (j_message_receive(reply, object_connection))
+				{
+					ret = j_object_modify_reply(reply, j_message_get_count(reply), NULL) && ret;
+				}
+				else
+				{
+					ret = FALSE;
+				}
+			}
 		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
@@ -412,8 +606,134 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+/**
+ * A part of a transfer that is striped across multiple connections.
+ **/
+struct JObjectStripe
+{
+	/** The object. **/
+	JObject* object;
+	/** The message type. **/
+	JMessageType type;
+	/** The semantics. **/
+	JSemantics* semantics;
+	/** The extents to transfer. **/
+	JObjectExtents* extents;
+	/** Whether the transfer succeeded. **/
+	gboolean ret;
+};
+
+typedef struct JObjectStripe JObjectStripe;
+
+static gpointer
+j_object_stripe_exec(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectStripe* stripe = data;
+	JObject* object = stripe->object;
+
+	g_autoptr(JMessage) message = NULL;
+	gpointer object_connection;
+	gsize name_len;
+	gsize namespace_len;
+
+	namespace_len = strlen(object->namespace) + 1;
+	name_len = strlen(object->name) + 1;
+
+	message = j_message_new(stripe->type, namespace_len + name_len);
+	j_message_set_semantics(message, stripe->semantics);
+	j_message_append_n(message, object->namespace, namespace_len);
+	j_message_append_n(message, object->name, name_len);
+
+	j_object_extents_append(stripe->extents, message);
+
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+	j_message_send(message, object_connection);
+
+	if (stripe->type == J_MESSAGE_OBJECT_READ)
+	{
+		stripe->ret = j_object_extents_read_reply(stripe->extents, message, object_connection);
+	}
+	else
+	{
+		JSemanticsSafety safety;
+
+		safety = j_semantics_get(stripe->semantics, J_SEMANTICS_SAFETY);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			stripe->ret = j_message_receive(reply, object_connection) && j_object_extents_write_reply(stripe->extents, reply);
+		}
+	}
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+
+	return stripe;
+}
+
+/**
+ * Stripes a large transfer across multiple connections to the object's server.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param type      The message type, either J_MESSAGE_OBJECT_READ or J_MESSAGE_OBJECT_WRITE.
+ * \param semantics The semantics.
+ * \param extents   The extents to transfer.
+ * \param ret       Is set to FALSE if a stripe could not be transferred.
+ *
+ * \return TRUE if the transfer has been striped, FALSE if it is too small.
+ **/
 static gboolean
-j_object_read_exec(JList* operations, JSemantics* semantics)
+j_object_stripe(JObject* object, JMessageType type, JSemantics* semantics, JObjectExtents* extents, gboolean* ret)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) split = NULL;
+	g_autofree JObjectStripe* stripes = NULL;
+	g_autofree gpointer* data = NULL;
+	guint streams;
+
+	streams = j_configuration_get_stripe_streams(j_configuration());
+
+	if (streams <= 1 || j_object_extents_get_length(extents) < j_configuration_get_stripe_threshold(j_configuration()))
+	{
+		return FALSE;
+	}
+
+	split = j_object_extents_split(extents, streams);
+	stripes = g_new(JObjectStripe, split->len);
+	data = g_new(gpointer, split->len);
+
+	for (guint i = 0; i < split->len; i++)
+	{
+		stripes[i].object = object;
+		stripes[i].type = type;
+		stripes[i].semantics = semantics;
+		stripes[i].extents = g_ptr_array_index(split, i);
+		stripes[i].ret = TRUE;
+
+		data[i] = &(stripes[i]);
+	}
+
+	// Each stripe uses its own connection, so the server can process them concurrently.
+	j_helper_execute_parallel(j_object_stripe_exec, data, split->len);
+
+	for (guint i = 0; i < split->len; i++)
+	{
+		*ret = stripes[i].ret && *ret;
+		j_object_extents_free(stripes[i].extents);
+	}
+
+	return TRUE;
+}
+
+static gboolean
+j_object_read_fetch(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -421,8 +741,8 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	JListIterator* it;
 	g_autoptr(JMessage) message = NULL;
+	JObjectExtents* extents = NULL;
 	JObject* object;
 	gpointer object_handle;
 
@@ -441,7 +761,8 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 		g_assert(object != NULL);
 	}
 
-	it = j_list_iterator_new(operations);
+	ret = j_object_flush_buffered(object) && ret;
+
 	object_backend = j_object_get_backend();
 
 	if (object_backend != NULL)
@@ -456,10 +777,14 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 		namespace_len = strlen(object->namespace) + 1;
 		name_len = strlen(object->name) + 1;
 
-		message = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+		// Every operation needs at most its length and offset, merging operations only reduces the size.
+		message = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len + j_list_length(operations) * (sizeof(guint64) + sizeof(guint64)));
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, object->namespace, namespace_len);
 		j_message_append_n(message, object->name, name_len);
+
+		// Adjacent and overlapping reads are merged into a single operation.
+		extents = j_object_extents_new(TRUE);
 	}
 
 	/*
@@ -469,9 +794,9 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 	}
 	*/
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JObjectOperation* operation = j_list_iterator_get(it);
+		JObjectOperation* operation = j_list_get_nth(operations, i);
 		gpointer data = operation->read.data;
 		guint64 length = operation->read.length;
 		guint64 offset = operation->read.offset;
@@ -488,102 +813,229 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 		}
 		else
 		{
-			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
-			j_message_append_8(message, &length);
-			j_message_append_8(message, &offset);
+			j_object_extents_add_read(extents, data, length, offset, bytes_read);
 		}
 
 		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
 	}
 
-	j_list_iterator_free(it);
-
 	if (object_backend != NULL)
 	{
 		ret = j_backend_object_close(object_backend, object_handle) && ret;
 	}
 	else
 	{
-		g_autoptr(JMessage) reply = NULL;
-		gpointer object_connection;
-		guint32 operations_done;
-		guint32 operation_count;
+		if (!j_object_stripe(object, J_MESSAGE_OBJECT_READ, semantics, extents, &ret))
+		{
+			gpointer object_connection;
 
-		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
-		j_message_send(message, object_connection);
+			j_object_extents_append(extents, message);
 
-		reply = j_message_new_reply(message);
+			object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+			j_message_send(message, object_connection);
 
-		operations_done = 0;
-		operation_count = j_message_get_count(message);
+			ret = j_object_extents_read_reply(extents, message, object_connection) && ret;
 
-		it = j_list_iterator_new(operations);
+			j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+		}
 
-		/**
-		 * This extra loop is necessary because the server might send multiple
-		 * replies per message. The same reply object can be used to receive
-		 * multiple times.
-		 */
-		while (operations_done < operation_count)
-		{
-			guint32 reply_operation_count;
+		j_object_extents_free(extents);
+	}
+
+	/*
+	if (lock != NULL)
+	{
+		// FIXME busy wait
+		while (!j_lock_acquire(lock));
 
-			j_message_receive(reply, object_connection);
+		j_lock_free(lock);
+	}
+	*/
 
-			reply_operation_count = j_message_get_count(reply);
+	return ret;
+}
 
-			for (guint i = 0; i < reply_operation_count && j_list_iterator_next(it); i++)
-			{
-				JObjectOperation* operation = j_list_iterator_get(it);
-				gpointer data = operation->read.data;
-				guint64* bytes_read = operation->read.bytes_read;
+/**
+ * Reads prefetched data in the background and stores it in the object cache.
+ *
+ * \private
+ *
+ * \param data A prefetch.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_object_prefetch_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-				guint64 nbytes;
+	JObjectPrefetch* prefetch = data;
+	JObjectOperation operation;
+	g_autoptr(JList) operations = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
 
-				nbytes = j_message_get_8(reply);
-				j_helper_atomic_add(bytes_read, nbytes);
+	operation.read.object = prefetch->object;
+	operation.read.data = prefetch->data;
+	operation.read.length = prefetch->length;
+	operation.read.offset = prefetch->offset;
+	operation.read.bytes_read = &nbytes;
 
-				if (nbytes > 0)
-				{
-					GInputStream* input;
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
 
-					input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
-					g_input_stream_read_all(input, data, nbytes, NULL, NULL, NULL);
-				}
-			}
+	// Failed prefetches still have to be reported to release their share of the prefetch limit.
+	ret = j_object_read_fetch(operations, prefetch->semantics);
+	j_object_cache_prefetched(prefetch->key, prefetch->generation, (ret) ? prefetch->data : NULL, prefetch->length, prefetch->offset, (ret) ? nbytes : 0);
+
+	j_object_unref(prefetch->object);
+	j_semantics_unref(prefetch->semantics);
+	g_free(prefetch->key);
+	g_free(prefetch->data);
+
+	g_slice_free(JObjectPrefetch, prefetch);
+
+	return NULL;
+}
+
+static gboolean
+j_object_read_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JList) misses = NULL;
+	g_autoptr(GPtrArray) bytes_read = NULL;
+	g_autofree gchar* key = NULL;
+	g_autofree guint64* nbytes = NULL;
+	JObject* object;
+	guint i;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	if (!j_object_cache_enabled(semantics))
+	{
+		return j_object_read_fetch(operations, semantics);
+	}
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->read.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	key = j_object_cache_key(object->index, object->namespace, object->name);
+	misses = j_list_new(NULL);
+	bytes_read = g_ptr_array_new();
+
+	for (guint j = 0; j < j_list_length(operations); j++)
+	{
+		JObjectOperation* operation = j_list_get_nth(operations, j);
+		guint64 prefetch_length;
+		guint64 prefetch_offset;
+		guint64 generation;
+
+		// Sequential reads prefetch the following blocks in the background, there is no benefit with a local backend.
+		if (j_object_get_backend() == NULL && j_object_cache_readahead(key, operation->read.length, operation->read.offset, &prefetch_length, &prefetch_offset, &generation))
+		{
+			JObjectPrefetch* prefetch;
+			JBackgroundOperation* background_operation;
+
+			prefetch = g_slice_new(JObjectPrefetch);
+			prefetch->object = j_object_ref(object);
+			prefetch->semantics = j_semantics_ref(semantics);
+			prefetch->key = g_strdup(key);
+			prefetch->generation = generation;
+			prefetch->data = g_malloc(prefetch_length);
+			prefetch->length = prefetch_length;
+			prefetch->offset = prefetch_offset;
+
+			background_operation = j_background_operation_new(j_object_prefetch_background_operation, prefetch);
+			j_background_operation_unref(background_operation);
+		}
 
-			operations_done += reply_operation_count;
+		if (!j_object_cache_read(key, semantics, operation->read.data, operation->read.length, operation->read.offset, operation->read.bytes_read))
+		{
+			j_list_append(misses, operation);
+			g_ptr_array_add(bytes_read, operation->read.bytes_read);
 		}
+	}
+
+	if (j_list_length(misses) == 0)
+	{
+		return ret;
+	}
 
-		j_list_iterator_free(it);
+	// Count the bytes per operation to know which parts of the buffers are valid.
+	nbytes = g_new0(guint64, j_list_length(misses));
 
-		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	for (i = 0; i < j_list_length(misses); i++)
+	{
+		JObjectOperation* operation = j_list_get_nth(misses, i);
+
+		operation->read.bytes_read = &(nbytes[i]);
 	}
 
-	/*
-	if (lock != NULL)
+	ret = j_object_read_fetch(misses, semantics);
+
+	for (i = 0; i < j_list_length(misses); i++)
 	{
-		// FIXME busy wait
-		while (!j_lock_acquire(lock));
+		JObjectOperation* operation = j_list_get_nth(misses, i);
 
-		j_lock_free(lock);
+		if (ret)
+		{
+			j_object_cache_fill(key, operation->read.data, operation->read.length, operation->read.offset, nbytes[i]);
+		}
+
+		operation->read.bytes_read = g_ptr_array_index(bytes_read, i);
+		j_helper_atomic_add(operation->read.bytes_read, nbytes[i]);
 	}
-	*/
 
 	return ret;
 }
 
 static gboolean
-j_object_write_exec(JList* operations, JSemantics* semantics)
+j_object_write_reply(JMessage* reply, guint32 count, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectWriteReply* write_reply = data;
+
+	gboolean ret;
+
+	(void)count;
+
+	ret = j_object_extents_write_reply(write_reply->extents, reply);
+
+	// Cached blocks have been updated before sending and might contain data that has not been written.
+	if (!ret)
+	{
+		j_object_cache_remove(write_reply->key);
+	}
+
+	j_object_extents_free(write_reply->extents);
+	g_free(write_reply->key);
+	g_slice_free(JObjectWriteReply, write_reply);
+
+	return ret;
+}
+
+static gboolean
+j_object_write_send(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	JListIterator* it;
 	g_autoptr(JMessage) message = NULL;
+	g_autofree gchar* key = NULL;
+	JObjectExtents* extents = NULL;
 	JObject* object;
 	gpointer object_handle;
 
@@ -602,7 +1054,6 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 		g_assert(object != NULL);
 	}
 
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend != NULL)
@@ -617,10 +1068,14 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 		namespace_len = strlen(object->namespace) + 1;
 		name_len = strlen(object->name) + 1;
 
-		message = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
+		// Every operation needs at most its length and offset, merging operations only reduces the size.
+		message = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len + j_list_length(operations) * (sizeof(guint64) + sizeof(guint64)));
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, object->namespace, namespace_len);
 		j_message_append_n(message, object->name, name_len);
+
+		// Adjacent writes are merged into a single operation.
+		extents = j_object_extents_new(FALSE);
 	}
 
 	/*
@@ -630,9 +1085,9 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	}
 	*/
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JObjectOperation* operation = j_list_iterator_get(it);
+		JObjectOperation* operation = j_list_get_nth(operations, i);
 		gconstpointer data = operation->write.data;
 		guint64 length = operation->write.length;
 		guint64 offset = operation->write.offset;
@@ -656,10 +1111,7 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 		}
 		else
 		{
-			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
-			j_message_append_8(message, &length);
-			j_message_append_8(message, &offset);
-			j_message_add_send(message, data, length);
+			j_object_extents_add_write(extents, data, length, offset, bytes_written);
 
 			// Fake bytes_written here instead of doing another loop further down
 			if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE)
@@ -671,8 +1123,6 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
 	}
 
-	j_list_iterator_free(it);
-
 	if (object_backend != NULL)
 	{
 		ret = j_backend_object_close(object_backend, object_handle) && ret;
@@ -684,32 +1134,65 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 		gpointer object_connection;
 
 		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
-		j_message_send(message, object_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		if (j_object_stripe(object, J_MESSAGE_OBJECT_WRITE, semantics, extents, &ret))
 		{
-			g_autoptr(JMessage) reply = NULL;
-			guint64 nbytes;
+			j_object_extents_free(extents);
+		}
+		else
+		{
+			j_object_extents_append(extents, message);
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, object_connection);
+			object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+
+			if (object_connection == NULL)
+			{
+				ret = FALSE;
+				j_object_extents_free(extents);
+			}
+			else if ((safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE) && j_configuration_get_coalesce_replies(j_configuration()))
+			{
+				JObjectWriteReply* write_reply;
 
-			it = j_list_iterator_new(operations);
+				// The operations are freed before the reply arrives, the extents remember where to store the results.
+				write_reply = g_slice_new(JObjectWriteReply);
+				write_reply->extents = extents;
+				write_reply->key = j_object_cache_key(object->index, object->namespace, object->name);
 
-			while (j_list_iterator_next(it))
+				ret = j_message_send_deferred(message, object_connection, j_object_write_reply, write_reply) && ret;
+			}
+			else
 			{
-				JObjectOperation* operation = j_list_iterator_get(it);
-				guint64* bytes_written = operation->write.bytes_written;
+				if (j_message_send(message, object_connection))
+				{
+					if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+					{
+						g_autoptr(JMessage) reply = NULL;
 
-				nbytes = j_message_get_8(reply);
-				j_helper_atomic_add(bytes_written, nbytes);
+						reply = j_message_new_reply(message);
+						ret = j_message_receive(reply, object_connection) && j_object_extents_write_reply(extents, reply) && ret;
+					}
+				}
+				else
+				{
+					ret = FALSE;
+				}
+
+				j_object_extents_free(extents);
 			}
 
-			j_list_iterator_free(it);
+			if (object_connection != NULL)
+			{
+				j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+			}
 		}
+	}
 
-		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	// Cached blocks have been updated before sending and might contain data that has not been written.
+	if (!ret)
+	{
+		key = j_object_cache_key(object->index, object->namespace, object->name);
+		j_object_cache_remove(key);
 	}
 
 	/*
@@ -725,6 +1208,119 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+/**
+ * Writes buffered data.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param semantics The semantics.
+ * \param data      The buffered data.
+ * \param length    A length.
+ * \param offset    An offset.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_write_buffered(gpointer object, JSemantics* semantics, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation operation;
+	g_autoptr(JList) operations = NULL;
+	guint64 nbytes = 0;
+
+	operation.write.object = object;
+	operation.write.data = data;
+	operation.write.length = length;
+	operation.write.offset = offset;
+	operation.write.bytes_written = &nbytes;
+	operation.write.bytes_cached = 0;
+
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
+
+	return j_object_write_send(operations, semantics);
+}
+
+static gboolean
+j_object_write_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JList) direct = NULL;
+	g_autofree gchar* key = NULL;
+	JObject* object;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->write.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	key = j_object_cache_key(object->index, object->namespace, object->name);
+
+	// Cached blocks are updated so that later reads see the new data.
+	for (guint i = 0; i < j_list_length(operations); i++)
+	{
+		JObjectOperation* operation = j_list_get_nth(operations, i);
+
+		j_object_cache_write(key, operation->write.data, operation->write.length, operation->write.offset);
+	}
+
+	if (j_object_get_backend() != NULL || !j_object_write_buffer_enabled(semantics))
+	{
+		// Writes buffered with other semantics have to be written first.
+		if (j_object_write_buffer_pending())
+		{
+			ret = j_object_write_buffer_flush(key) && ret;
+		}
+
+		return j_object_write_send(operations, semantics) && ret;
+	}
+
+	direct = j_list_new(NULL);
+
+	for (guint i = 0; i < j_list_length(operations); i++)
+	{
+		JObjectOperation* operation = j_list_get_nth(operations, i);
+
+		// Buffering might write previously buffered data, which has to happen after the preceding direct writes.
+		if (j_list_length(direct) > 0 && operation->write.length < j_object_write_buffer_get_size())
+		{
+			ret = j_object_write_send(direct, semantics) && ret;
+			j_list_delete_all(direct);
+		}
+
+		if (j_object_write_buffer_add(key, object, j_object_write_buffered, (JObjectWriteBufferRefFunc)j_object_ref, (GDestroyNotify)j_object_unref, semantics, operation->write.data, operation->write.length, operation->write.offset))
+		{
+			// Buffered writes are not acknowledged, just like other writes with a safety semantics of none.
+			j_helper_atomic_add(operation->write.bytes_written, operation->write.length);
+		}
+		else
+		{
+			// Large writes are not buffered but must not overtake buffered data.
+			ret = j_object_write_buffer_flush(key) && ret;
+			j_list_append(direct, operation);
+		}
+	}
+
+	if (j_list_length(direct) > 0)
+	{
+		ret = j_object_write_send(direct, semantics) && ret;
+	}
+
+	return ret;
+}
+
 static gboolean
 j_object_status_exec(JList* operations, JSemantics* semantics)
 {
@@ -734,7 +1330,6 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	JListIterator* it;
 	g_autoptr(JMessage) message = NULL;
 	gchar const* namespace;
 	gsize namespace_len;
@@ -755,23 +1350,34 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 		index = object->index;
 	}
 
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend == NULL)
 	{
-		message = j_message_new(J_MESSAGE_OBJECT_STATUS, namespace_len);
+		gsize length = namespace_len;
+
+		// Precompute the exact message size to avoid resizing the message while appending operations.
+		for (guint i = 0; i < j_list_length(operations); i++)
+		{
+			JObjectOperation* operation = j_list_get_nth(operations, i);
+
+			length += strlen(operation->status.object->name) + 1;
+		}
+
+		message = j_message_new(J_MESSAGE_OBJECT_STATUS, length);
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JObjectOperation* operation = j_list_iterator_get(it);
+		JObjectOperation* operation = j_list_get_nth(operations, i);
 		JObject* object = operation->status.object;
 		gint64* modification_time = operation->status.modification_time;
 		guint64* size = operation->status.size;
 
+		ret = j_object_flush_buffered(object) && ret;
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -791,8 +1397,6 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 		}
 	}
 
-	j_list_iterator_free(it);
-
 	if (object_backend == NULL)
 	{
 		g_autoptr(JMessage) reply = NULL;
@@ -802,33 +1406,35 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 		j_message_send(message, object_connection);
 
 		reply = j_message_new_reply(message);
-		j_message_receive(reply, object_connection);
 
-		it = j_list_iterator_new(operations);
-
-		while (j_list_iterator_next(it))
+		if (j_message_receive(reply, object_connection))
 		{
-			JObjectOperation* operation = j_list_iterator_get(it);
-			gint64* modification_time = operation->status.modification_time;
-			guint64* size = operation->status.size;
-			gint64 modification_time_;
-			guint64 size_;
+			for (guint i = 0; i < j_list_length(operations); i++)
+			{
+				JObjectOperation* operation = j_list_get_nth(operations, i);
+				gint64* modification_time = operation->status.modification_time;
+				guint64* size = operation->status.size;
+				gint64 modification_time_;
+				guint64 size_;
 
-			modification_time_ = j_message_get_8(reply);
-			size_ = j_message_get_8(reply);
+				modification_time_ = j_message_get_8(reply);
+				size_ = j_message_get_8(reply);
 
-			if (modification_time != NULL)
-			{
-				*modification_time = modification_time_;
-			}
+				if (modification_time != NULL)
+				{
+					*modification_time = modification_time_;
+				}
 
-			if (size != NULL)
-			{
-				*size = size_;
+				if (size != NULL)
+				{
+					*size = size_;
+				}
 			}
 		}
-
-		j_list_iterator_free(it);
+		else
+		{
+			ret = FALSE;
+		}
 
 		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
 	}
@@ -845,7 +1451,6 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
-	JListIterator* it;
 	g_autoptr(JMessage) message = NULL;
 	gchar const* namespace;
 	gsize namespace_len;
@@ -866,7 +1471,6 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 		index = object->index;
 	}
 
-	it = j_list_iterator_new(operations);
 	object_backend = j_object_get_backend();
 
 	if (object_backend == NULL)
@@ -876,11 +1480,13 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
-	while (j_list_iterator_next(it))
+	for (guint i = 0; i < j_list_length(operations); i++)
 	{
-		JObjectOperation* operation = j_list_iterator_get(it);
+		JObjectOperation* operation = j_list_get_nth(operations, i);
 		JObject* object = operation->sync.object;
 
+		ret = j_object_flush_buffered(object) && ret;
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -900,8 +1506,6 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 		}
 	}
 
-	j_list_iterator_free(it);
-
 	if (object_backend == NULL)
 	{
 		JSemanticsSafety safety;
@@ -916,7 +1520,7 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 			g_autoptr(JMessage) reply = NULL;
 
 			reply = j_message_new_reply(message);
-			j_message_receive(reply, object_connection);
+			ret = j_message_receive(reply, object_connection) && ret;
 
 			// FIXME do something with reply
 		}
@@ -1069,11 +1673,13 @@ j_object_create(JObject* object, JBatch* batch)
 	g_return_if_fail(object != NULL);
 
 	operation = j_operation_new();
-	// FIXME key = index + namespace
 	operation->key = object;
+	operation->key_hash = j_object_key_hash;
+	operation->key_equal = j_object_key_equal;
 	operation->data = j_object_ref(object);
 	operation->exec_func = j_object_create_exec;
 	operation->free_func = j_object_create_free;
+	operation->cache_func = j_object_cache;
 
 	j_batch_add(batch, operation);
 }
@@ -1098,9 +1704,12 @@ j_object_delete(JObject* object, JBatch* batch)
 
 	operation = j_operation_new();
 	operation->key = object;
+	operation->key_hash = j_object_key_hash;
+	operation->key_equal = j_object_key_equal;
 	operation->data = j_object_ref(object);
 	operation->exec_func = j_object_delete_exec;
 	operation->free_func = j_object_delete_free;
+	operation->cache_func = j_object_cache;
 
 	j_batch_add(batch, operation);
 }
@@ -1150,6 +1759,8 @@ j_object_read(JObject* object, gpointer data, guint64 length, guint64 offset, gu
 
 		operation = j_operation_new();
 		operation->key = object;
+		operation->key_hash = j_object_key_hash;
+		operation->key_equal = j_object_key_equal;
 		operation->data = iop;
 		operation->exec_func = j_object_read_exec;
 		operation->free_func = j_object_read_free;
@@ -1212,9 +1823,12 @@ j_object_write(JObject* object, gconstpointer data, guint64 length, guint64 offs
 
 		operation = j_operation_new();
 		operation->key = object;
+		operation->key_hash = j_object_key_hash;
+		operation->key_equal = j_object_key_equal;
 		operation->data = iop;
 		operation->exec_func = j_object_write_exec;
 		operation->free_func = j_object_write_free;
+	operation->cache_func = j_object_write_cache;
 
 		j_batch_add(batch, operation);
 
@@ -1252,6 +1866,8 @@ j_object_status(JObject* object, gint64* modification_time, guint64* size, JBatc
 
 	operation = j_operation_new();
 	operation->key = object;
+	operation->key_hash = j_object_key_hash;
+	operation->key_equal = j_object_key_equal;
 	operation->data = iop;
 	operation->exec_func = j_object_status_exec;
 	operation->free_func = j_object_status_free;
@@ -1283,6 +1899,8 @@ j_object_sync(JObject* object, JBatch* batch)
 
 	operation = j_operation_new();
 	operation->key = object;
+	operation->key_hash = j_object_key_hash;
+	operation->key_equal = j_object_key_equal;
 	operation->data = iop;
 	operation->exec_func = j_object_sync_exec;
 	operation->free_func = j_object_sync_free;
@@ -0,0 +1,295 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// madvise() is not part of POSIX.
+#define _DEFAULT_SOURCE
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+enum
+{
+	/**
+	 * The alignment of buffers, suitable for O_DIRECT.
+	 */
+	JD_BUFFER_POOL_ALIGNMENT = 4096,
+
+	/**
+	 * The alignment of buffers backed by huge pages.
+	 */
+	JD_BUFFER_POOL_HUGEPAGE_ALIGNMENT = 2 * 1024 * 1024
+};
+
+/**
+ * A pool of buffers shared by all connections.
+ */
+struct JdBufferPool
+{
+	/**
+	 * The size of each buffer.
+	 */
+	guint64 buffer_size;
+
+	/**
+	 * The maximum number of buffers.
+	 */
+	guint max_count;
+
+	/**
+	 * The number of allocated buffers.
+	 */
+	guint count;
+
+	/**
+	 * The unused buffers, linked through their first bytes.
+	 */
+	gpointer free;
+
+	/**
+	 * Whether buffers should be backed by huge pages.
+	 */
+	gboolean hugepages;
+
+	/**
+	 * Whether buffers should be locked into memory.
+	 */
+	gboolean lock;
+
+	/**
+	 * The mutex.
+	 */
+	GMutex mutex[1];
+
+	/**
+	 * Signaled when a buffer is released.
+	 */
+	GCond cond[1];
+};
+
+typedef struct JdBufferPool JdBufferPool;
+
+static JdBufferPool* jd_buffer_pool = NULL;
+
+static gpointer
+jd_buffer_pool_pop(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer buffer = jd_buffer_pool->free;
+
+	if (buffer != NULL)
+	{
+		jd_buffer_pool->free = *(gpointer*)buffer;
+	}
+
+	return buffer;
+}
+
+static gpointer
+jd_buffer_pool_alloc(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer buffer = NULL;
+	gsize alignment = JD_BUFFER_POOL_ALIGNMENT;
+
+	if (jd_buffer_pool->hugepages)
+	{
+		alignment = JD_BUFFER_POOL_HUGEPAGE_ALIGNMENT;
+	}
+
+	if (posix_memalign(&buffer, alignment, jd_buffer_pool->buffer_size) != 0)
+	{
+		return NULL;
+	}
+
+#ifdef HAVE_MADV_HUGEPAGE
+	if (jd_buffer_pool->hugepages)
+	{
+		// Huge pages are only a hint, the buffer is usable either way.
+		madvise(buffer, jd_buffer_pool->buffer_size, MADV_HUGEPAGE);
+	}
+#endif
+
+	if (jd_buffer_pool->lock && mlock(buffer, jd_buffer_pool->buffer_size) != 0)
+	{
+		g_warning("Could not lock buffer into memory, disabling locking.");
+		jd_buffer_pool->lock = FALSE;
+	}
+
+	return buffer;
+}
+
+/**
+ * Initializes the buffer pool.
+ *
+ * \param max_size    The maximum number of bytes allocated for buffers.
+ * \param buffer_size The size of each buffer.
+ * \param hugepages   Whether buffers should be backed by huge pages.
+ * \param lock        Whether buffers should be locked into memory.
+ */
+void
+jd_buffer_pool_init(guint64 max_size, guint64 buffer_size, gboolean hugepages, gboolean lock)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(jd_buffer_pool == NULL);
+	g_return_if_fail(buffer_size > 0);
+
+	// Round up to the alignment, so that all buffers can be used with O_DIRECT.
+	buffer_size = (buffer_size + JD_BUFFER_POOL_ALIGNMENT - 1) / JD_BUFFER_POOL_ALIGNMENT * JD_BUFFER_POOL_ALIGNMENT;
+
+	jd_buffer_pool = g_slice_new(JdBufferPool);
+	jd_buffer_pool->buffer_size = buffer_size;
+	// At least one buffer is required to make progress.
+	jd_buffer_pool->max_count = MAX(max_size / buffer_size, 1);
+	jd_buffer_pool->count = 0;
+	jd_buffer_pool->free = NULL;
+	jd_buffer_pool->hugepages = hugepages;
+	jd_buffer_pool->lock = lock;
+
+	g_mutex_init(jd_buffer_pool->mutex);
+	g_cond_init(jd_buffer_pool->cond);
+}
+
+/**
+ * Frees all buffers and shuts down the buffer pool.
+ */
+void
+jd_buffer_pool_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer buffer;
+
+	if (jd_buffer_pool == NULL)
+	{
+		return;
+	}
+
+	while ((buffer = jd_buffer_pool_pop()) != NULL)
+	{
+		if (jd_buffer_pool->lock)
+		{
+			munlock(buffer, jd_buffer_pool->buffer_size);
+		}
+
+		free(buffer);
+	}
+
+	g_cond_clear(jd_buffer_pool->cond);
+	g_mutex_clear(jd_buffer_pool->mutex);
+
+	g_slice_free(JdBufferPool, jd_buffer_pool);
+	jd_buffer_pool = NULL;
+}
+
+/**
+ * Returns the size of the buffers handed out by the buffer pool.
+ *
+ * \return The buffer size.
+ */
+guint64
+jd_buffer_pool_get_buffer_size(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(jd_buffer_pool != NULL, 0);
+
+	return jd_buffer_pool->buffer_size;
+}
+
+/**
+ * Borrows a buffer from the buffer pool.
+ * If all buffers are in use and the pool has reached its maximum size, blocks until a buffer is released.
+ *
+ * \return A buffer of jd_buffer_pool_get_buffer_size() bytes. Should be returned with jd_buffer_pool_release().
+ */
+gpointer
+jd_buffer_pool_acquire(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer buffer = NULL;
+
+	g_return_val_if_fail(jd_buffer_pool != NULL, NULL);
+
+	g_mutex_lock(jd_buffer_pool->mutex);
+
+	while ((buffer = jd_buffer_pool_pop()) == NULL)
+	{
+		if (jd_buffer_pool->count < jd_buffer_pool->max_count)
+		{
+			// Allocate outside of the lock, the slot is reserved by incrementing count.
+			jd_buffer_pool->count++;
+			g_mutex_unlock(jd_buffer_pool->mutex);
+
+			buffer = jd_buffer_pool_alloc();
+
+			g_mutex_lock(jd_buffer_pool->mutex);
+
+			if (buffer != NULL)
+			{
+				break;
+			}
+
+			jd_buffer_pool->count--;
+
+			if (jd_buffer_pool->count == 0)
+			{
+				g_mutex_unlock(jd_buffer_pool->mutex);
+				g_critical("Could not allocate buffer.");
+				return NULL;
+			}
+		}
+
+		g_cond_wait(jd_buffer_pool->cond, jd_buffer_pool->mutex);
+	}
+
+	g_mutex_unlock(jd_buffer_pool->mutex);
+
+	return buffer;
+}
+
+/**
+ * Returns a buffer to the buffer pool.
+ *
+ * \param buffer A buffer returned by jd_buffer_pool_acquire().
+ */
+void
+jd_buffer_pool_release(gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(jd_buffer_pool != NULL);
+	g_return_if_fail(buffer != NULL);
+
+	g_mutex_lock(jd_buffer_pool->mutex);
+	*(gpointer*)buffer = jd_buffer_pool->free;
+	jd_buffer_pool->free = buffer;
+	g_cond_signal(jd_buffer_pool->cond);
+	g_mutex_unlock(jd_buffer_pool->mutex);
+}
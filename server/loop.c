@@ -22,14 +22,230 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <string.h>
+
 #include <julea.h>
 
 #include "server.h"
 
 static guint jd_thread_num = 0;
 
+static gchar const* const jd_replies_key = "julea-replies";
+
+gboolean
+jd_pending_replies(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return (g_object_get_data(G_OBJECT(connection), jd_replies_key) != NULL);
+}
+
+void
+jd_send_replies(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* replies;
+
+	replies = g_object_steal_data(G_OBJECT(connection), jd_replies_key);
+
+	if (replies != NULL)
+	{
+		j_message_send(replies, connection);
+		j_message_unref(replies);
+	}
+}
+
+/**
+ * Sends a reply.
+ * Replies to messages that allow deferring are collected and sent in a single acknowledgement.
+ * Pending replies are always sent before any other reply to keep them in order.
+ **/
+static void
+jd_send_reply(JMessage* message, JMessage* reply, GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (j_message_get_flags(message) & J_MESSAGE_FLAGS_DEFERRED_REPLY)
+	{
+		JMessage* replies;
+
+		replies = g_object_get_data(G_OBJECT(connection), jd_replies_key);
+
+		if (replies == NULL)
+		{
+			replies = j_message_new(J_MESSAGE_ACKNOWLEDGE, 0);
+			g_object_set_data_full(G_OBJECT(connection), jd_replies_key, replies, (GDestroyNotify)j_message_unref);
+		}
+
+		j_message_add_reply(replies, reply);
+
+		if (j_message_get_count(replies) >= j_configuration_get_reply_count(jd_configuration))
+		{
+			jd_send_replies(connection);
+		}
+
+		return;
+	}
+
+	jd_send_replies(connection);
+	j_message_send(reply, connection);
+}
+
+/**
+ * Returns the backend a message is handled by.
+ *
+ * \return TRUE if the message requires a backend, FALSE otherwise.
+ **/
+static gboolean
+jd_message_get_backend(JMessageType type, JBackendType* backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	switch (type)
+	{
+		case J_MESSAGE_OBJECT_CREATE:
+		case J_MESSAGE_OBJECT_DELETE:
+		case J_MESSAGE_OBJECT_READ:
+		case J_MESSAGE_OBJECT_STATUS:
+		case J_MESSAGE_OBJECT_SYNC:
+		case J_MESSAGE_OBJECT_WRITE:
+			*backend = J_BACKEND_TYPE_OBJECT;
+			return TRUE;
+		case J_MESSAGE_KV_PUT:
+		case J_MESSAGE_KV_DELETE:
+		case J_MESSAGE_KV_GET:
+		case J_MESSAGE_KV_GET_ALL:
+		case J_MESSAGE_KV_GET_BY_PREFIX:
+			*backend = J_BACKEND_TYPE_KV;
+			return TRUE;
+		case J_MESSAGE_DB_SCHEMA_CREATE:
+		case J_MESSAGE_DB_SCHEMA_GET:
+		case J_MESSAGE_DB_SCHEMA_DELETE:
+		case J_MESSAGE_DB_INSERT:
+		case J_MESSAGE_DB_UPDATE:
+		case J_MESSAGE_DB_DELETE:
+		case J_MESSAGE_DB_QUERY:
+			*backend = J_BACKEND_TYPE_DB;
+			return TRUE;
+		case J_MESSAGE_NONE:
+		case J_MESSAGE_PING:
+		case J_MESSAGE_STATISTICS:
+		case J_MESSAGE_ACKNOWLEDGE:
+		default:
+			return FALSE;
+	}
+}
+
+/**
+ * Rejects a message whose backend is not available.
+ * Creating and deleting report a failed status per operation, which also works for deferred replies.
+ * All other messages are answered with a failed reply without any operations if the client expects a reply.
+ **/
+static void
+jd_reject_message(JMessage* message, GSocketConnection* connection, JSemanticsSafety safety)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) reply = NULL;
+	gboolean safe;
+
+	safe = (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE);
+
+	g_warning("Rejecting message of type %d because its backend is not available.", j_message_get_type(message));
+
+	switch (j_message_get_type(message))
+	{
+		case J_MESSAGE_OBJECT_CREATE:
+		case J_MESSAGE_OBJECT_DELETE:
+		case J_MESSAGE_KV_PUT:
+		case J_MESSAGE_KV_DELETE:
+			if (safe)
+			{
+				guint32 const status = 0;
+
+				reply = j_message_new_reply(message);
+
+				for (guint i = 0; i < j_message_get_count(message); i++)
+				{
+					j_message_add_operation(reply, sizeof(guint32));
+					j_message_append_4(reply, &status);
+				}
+			}
+			break;
+		case J_MESSAGE_OBJECT_WRITE:
+		case J_MESSAGE_OBJECT_SYNC:
+			if (j_message_get_type(message) == J_MESSAGE_OBJECT_WRITE)
+			{
+				GInputStream* input;
+
+				input = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+
+				// The data is sent after the message and has to be skipped.
+				j_message_get_string(message);
+				j_message_get_string(message);
+
+				for (guint i = 0; i < j_message_get_count(message); i++)
+				{
+					guint64 length;
+
+					length = j_message_get_8(message);
+					j_message_get_8(message);
+
+					while (length > 0)
+					{
+						gssize skipped;
+
+						skipped = g_input_stream_skip(input, length, NULL, NULL);
+
+						if (skipped <= 0)
+						{
+							break;
+						}
+
+						length -= skipped;
+					}
+				}
+			}
+
+			if (safe)
+			{
+				reply = j_message_new_reply(message);
+				j_message_add_flags(reply, J_MESSAGE_FLAGS_FAILED);
+			}
+			break;
+		case J_MESSAGE_OBJECT_READ:
+		case J_MESSAGE_OBJECT_STATUS:
+		case J_MESSAGE_KV_GET:
+		case J_MESSAGE_KV_GET_ALL:
+		case J_MESSAGE_KV_GET_BY_PREFIX:
+		case J_MESSAGE_DB_SCHEMA_CREATE:
+		case J_MESSAGE_DB_SCHEMA_GET:
+		case J_MESSAGE_DB_SCHEMA_DELETE:
+		case J_MESSAGE_DB_INSERT:
+		case J_MESSAGE_DB_UPDATE:
+		case J_MESSAGE_DB_DELETE:
+		case J_MESSAGE_DB_QUERY:
+			reply = j_message_new_reply(message);
+			j_message_add_flags(reply, J_MESSAGE_FLAGS_FAILED);
+			break;
+		case J_MESSAGE_NONE:
+		case J_MESSAGE_PING:
+		case J_MESSAGE_STATISTICS:
+		case J_MESSAGE_ACKNOWLEDGE:
+		default:
+			g_warn_if_reached();
+			break;
+	}
+
+	if (reply != NULL)
+	{
+		jd_send_reply(message, reply, connection);
+	}
+}
+
 gboolean
-jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size, JStatistics* statistics)
+jd_handle_message(JMessage* message, GSocketConnection* connection, JStatistics* statistics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -41,12 +257,20 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 	g_autoptr(JSemantics) semantics = NULL;
 	JSemanticsSafety safety;
 	gboolean message_matched = FALSE;
+	JBackendType backend_type;
 	guint i;
 
 	operation_count = j_message_get_count(message);
 	semantics = j_message_get_semantics(message);
 	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
 
+	// Backends are initialized while the server is already accepting connections.
+	if (jd_message_get_backend(j_message_get_type(message), &backend_type) && !jd_backend_wait(backend_type))
+	{
+		jd_reject_message(message, connection, safety);
+		return FALSE;
+	}
+
 	switch (j_message_get_type(message))
 	{
 		case J_MESSAGE_NONE:
@@ -65,9 +289,15 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			for (i = 0; i < operation_count; i++)
 			{
+				gboolean ret;
+
 				path = j_message_get_string(message);
 
-				if (j_backend_object_create(jd_object_backend, namespace, path, &object))
+				jd_write_back_flush(namespace, path);
+
+				ret = j_backend_object_create(jd_object_backend, namespace, path, &object);
+
+				if (ret)
 				{
 					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
 
@@ -77,18 +307,22 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 						j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
 					}
 
-					j_backend_object_close(jd_object_backend, object);
+					ret = j_backend_object_close(jd_object_backend, object);
 				}
 
 				if (reply != NULL)
 				{
-					j_message_add_operation(reply, 0);
+					guint32 dummy;
+
+					dummy = (ret) ? 1 : 0;
+					j_message_add_operation(reply, 4);
+					j_message_append_4(reply, &dummy);
 				}
 			}
 
 			if (reply != NULL)
 			{
-				j_message_send(reply, connection);
+				jd_send_reply(message, reply, connection);
 			}
 		}
 		break;
@@ -106,38 +340,58 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			for (i = 0; i < operation_count; i++)
 			{
+				gboolean ret;
+
 				path = j_message_get_string(message);
 
-				if (j_backend_object_open(jd_object_backend, namespace, path, &object)
-				    && j_backend_object_delete(jd_object_backend, object))
+				jd_write_back_discard(namespace, path);
+
+				ret = j_backend_object_open(jd_object_backend, namespace, path, &object)
+				      && j_backend_object_delete(jd_object_backend, object);
+
+				if (ret)
 				{
 					j_statistics_add(statistics, J_STATISTICS_FILES_DELETED, 1);
 				}
 
 				if (reply != NULL)
 				{
-					j_message_add_operation(reply, 0);
+					guint32 dummy;
+
+					dummy = (ret) ? 1 : 0;
+					j_message_add_operation(reply, 4);
+					j_message_append_4(reply, &dummy);
 				}
 			}
 
 			if (reply != NULL)
 			{
-				j_message_send(reply, connection);
+				jd_send_reply(message, reply, connection);
 			}
 		}
 		break;
 		case J_MESSAGE_OBJECT_READ:
 		{
 			JMessage* reply;
+			JMemoryChunk* memory_chunk;
+			gpointer buffer;
+			guint64 memory_chunk_size;
 			gpointer object;
+			gboolean opened;
 
 			namespace = j_message_get_string(message);
 			path = j_message_get_string(message);
 
 			reply = j_message_new_reply(message);
 
-			// FIXME return value
-			j_backend_object_open(jd_object_backend, namespace, path, &object);
+			buffer = jd_buffer_pool_acquire();
+			memory_chunk_size = jd_buffer_pool_get_buffer_size();
+			memory_chunk = j_memory_chunk_new_for_data(buffer, memory_chunk_size);
+
+			jd_write_back_flush(namespace, path);
+
+			// Stripes of distributed objects might not exist, which is reported as reading nothing.
+			opened = j_backend_object_open(jd_object_backend, namespace, path, &object);
 
 			for (i = 0; i < operation_count; i++)
 			{
@@ -162,7 +416,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				if (buf == NULL)
 				{
 					// FIXME ugly
-					j_message_send(reply, connection);
+					jd_send_reply(message, reply, connection);
 					j_message_unref(reply);
 
 					reply = j_message_new_reply(message);
@@ -171,8 +425,11 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 					buf = j_memory_chunk_get(memory_chunk, length);
 				}
 
-				j_backend_object_read(jd_object_backend, object, buf, length, offset, &bytes_read);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read);
+				if (opened)
+				{
+					j_backend_object_read(jd_object_backend, object, buf, length, offset, &bytes_read);
+					j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read);
+				}
 
 				j_message_add_operation(reply, sizeof(guint64));
 				j_message_append_8(reply, &bytes_read);
@@ -185,18 +442,26 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, bytes_read);
 			}
 
-			j_backend_object_close(jd_object_backend, object);
+			if (opened)
+			{
+				j_backend_object_close(jd_object_backend, object);
+			}
 
-			j_message_send(reply, connection);
+			jd_send_reply(message, reply, connection);
 			j_message_unref(reply);
 
-			j_memory_chunk_reset(memory_chunk);
+			j_memory_chunk_free(memory_chunk);
+			jd_buffer_pool_release(buffer);
 		}
 		break;
 		case J_MESSAGE_OBJECT_WRITE:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer object;
+			JMemoryChunk* memory_chunk;
+			gpointer buffer;
+			guint64 memory_chunk_size;
+			gpointer object = NULL;
+			gboolean opened = FALSE;
 
 			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 			{
@@ -206,8 +471,32 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			namespace = j_message_get_string(message);
 			path = j_message_get_string(message);
 
-			// FIXME return value
-			j_backend_object_open(jd_object_backend, namespace, path, &object);
+			// Distributed objects are created lazily on the first write to one of their stripes.
+			if (j_message_get_flags(message) & J_MESSAGE_FLAGS_CREATE)
+			{
+				jd_write_back_flush(namespace, path);
+
+				if (j_backend_object_open(jd_object_backend, namespace, path, &object))
+				{
+					opened = TRUE;
+				}
+				else if (j_backend_object_create(jd_object_backend, namespace, path, &object))
+				{
+					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
+					opened = TRUE;
+				}
+
+				// Writes can still be buffered once the object exists.
+				if (opened && safety == J_SEMANTICS_SAFETY_NONE)
+				{
+					j_backend_object_close(jd_object_backend, object);
+					opened = FALSE;
+				}
+			}
+
+			buffer = jd_buffer_pool_acquire();
+			memory_chunk_size = jd_buffer_pool_get_buffer_size();
+			memory_chunk = j_memory_chunk_new_for_data(buffer, memory_chunk_size);
 
 			for (i = 0; i < operation_count; i++)
 			{
@@ -236,7 +525,25 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				g_input_stream_read_all(input, buf, length, NULL, NULL, NULL);
 				j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
 
-				j_backend_object_write(jd_object_backend, object, buf, length, offset, &bytes_written);
+				// Without safety guarantees, writes can be buffered and coalesced in the background.
+				if (safety == J_SEMANTICS_SAFETY_NONE && !opened && jd_write_back_write(namespace, path, buf, length, offset))
+				{
+					bytes_written = length;
+				}
+				else
+				{
+					if (!opened)
+					{
+						jd_write_back_flush(namespace, path);
+
+						// FIXME return value
+						j_backend_object_open(jd_object_backend, namespace, path, &object);
+						opened = TRUE;
+					}
+
+					j_backend_object_write(jd_object_backend, object, buf, length, offset, &bytes_written);
+				}
+
 				j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
 
 				if (reply != NULL)
@@ -248,20 +555,24 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				j_memory_chunk_reset(memory_chunk);
 			}
 
-			if (safety == J_SEMANTICS_SAFETY_STORAGE)
+			if (opened)
 			{
-				j_backend_object_sync(jd_object_backend, object);
-				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
-			}
+				if (safety == J_SEMANTICS_SAFETY_STORAGE)
+				{
+					j_backend_object_sync(jd_object_backend, object);
+					j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+				}
 
-			j_backend_object_close(jd_object_backend, object);
+				j_backend_object_close(jd_object_backend, object);
+			}
 
 			if (reply != NULL)
 			{
-				j_message_send(reply, connection);
+				jd_send_reply(message, reply, connection);
 			}
 
-			j_memory_chunk_reset(memory_chunk);
+			j_memory_chunk_free(memory_chunk);
+			jd_buffer_pool_release(buffer);
 		}
 		break;
 		case J_MESSAGE_OBJECT_STATUS:
@@ -280,22 +591,25 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 				path = j_message_get_string(message);
 
-				// FIXME return value
-				j_backend_object_open(jd_object_backend, namespace, path, &object);
+				jd_write_back_flush(namespace, path);
 
-				if (j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+				// Stripes of distributed objects might not have been created yet.
+				if (j_backend_object_open(jd_object_backend, namespace, path, &object))
 				{
-					j_statistics_add(statistics, J_STATISTICS_FILES_STATED, 1);
+					if (j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+					{
+						j_statistics_add(statistics, J_STATISTICS_FILES_STATED, 1);
+					}
+
+					j_backend_object_close(jd_object_backend, object);
 				}
 
 				j_message_add_operation(reply, sizeof(gint64) + sizeof(guint64));
 				j_message_append_8(reply, &modification_time);
 				j_message_append_8(reply, &size);
-
-				j_backend_object_close(jd_object_backend, object);
 			}
 
-			j_message_send(reply, connection);
+			jd_send_reply(message, reply, connection);
 		}
 		break;
 		case J_MESSAGE_OBJECT_SYNC:
@@ -314,6 +628,8 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			{
 				path = j_message_get_string(message);
 
+				jd_write_back_flush(namespace, path);
+
 				if (j_backend_object_open(jd_object_backend, namespace, path, &object))
 				{
 					j_backend_object_sync(jd_object_backend, object);
@@ -329,7 +645,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 			{
-				j_message_send(reply, connection);
+				jd_send_reply(message, reply, connection);
 			}
 		}
 		break;
@@ -374,7 +690,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				g_mutex_unlock(jd_statistics_mutex);
 			}
 
-			j_message_send(reply, connection);
+			jd_send_reply(message, reply, connection);
 		}
 		break;
 		case J_MESSAGE_PING:
@@ -382,6 +698,16 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			g_autoptr(JMessage) reply = NULL;
 			guint num;
 
+			struct
+			{
+				JBackendType type;
+				gchar const* name;
+			} const backends[] = {
+				{ J_BACKEND_TYPE_OBJECT, "object" },
+				{ J_BACKEND_TYPE_KV, "kv" },
+				{ J_BACKEND_TYPE_DB, "db" }
+			};
+
 			num = g_atomic_int_add(&jd_thread_num, 1);
 
 			(void)num;
@@ -389,19 +715,33 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			reply = j_message_new_reply(message);
 
-			if (jd_object_backend != NULL)
+			// Backends are reported with their state, operations on backends that are still initializing wait until they are ready.
+			for (guint j = 0; j < G_N_ELEMENTS(backends); j++)
 			{
-				j_message_add_operation(reply, 7);
-				j_message_append_string(reply, "object");
-			}
+				guint32 state;
 
-			if (jd_kv_backend != NULL)
-			{
-				j_message_add_operation(reply, 3);
-				j_message_append_string(reply, "kv");
+				switch (jd_backend_get_state(backends[j].type))
+				{
+					case JD_BACKEND_STATE_INITIALIZING:
+						state = J_BACKEND_STATE_INITIALIZING;
+						break;
+					case JD_BACKEND_STATE_READY:
+						state = J_BACKEND_STATE_READY;
+						break;
+					case JD_BACKEND_STATE_FAILED:
+						state = J_BACKEND_STATE_FAILED;
+						break;
+					case JD_BACKEND_STATE_NONE:
+					default:
+						continue;
+				}
+
+				j_message_add_operation(reply, strlen(backends[j].name) + 1 + sizeof(guint32));
+				j_message_append_string(reply, backends[j].name);
+				j_message_append_4(reply, &state);
 			}
 
-			j_message_send(reply, connection);
+			jd_send_reply(message, reply, connection);
 		}
 		break;
 		case J_MESSAGE_KV_PUT:
@@ -443,7 +783,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			if (reply != NULL)
 			{
-				j_message_send(reply, connection);
+				jd_send_reply(message, reply, connection);
 			}
 		}
 		break;
@@ -482,7 +822,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			if (reply != NULL)
 			{
-				j_message_send(reply, connection);
+				jd_send_reply(message, reply, connection);
 			}
 		}
 		break;
@@ -521,7 +861,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			j_backend_kv_batch_execute(jd_kv_backend, batch);
 
-			j_message_send(reply, connection);
+			jd_send_reply(message, reply, connection);
 		}
 		break;
 		case J_MESSAGE_KV_GET_ALL:
@@ -552,7 +892,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			j_message_add_operation(reply, 4);
 			j_message_append_4(reply, &zero);
 
-			j_message_send(reply, connection);
+			jd_send_reply(message, reply, connection);
 		}
 		break;
 		case J_MESSAGE_KV_GET_BY_PREFIX:
@@ -585,7 +925,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			j_message_add_operation(reply, 4);
 			j_message_append_4(reply, &zero);
 
-			j_message_send(reply, connection);
+			jd_send_reply(message, reply, connection);
 		}
 		break;
 		case J_MESSAGE_DB_SCHEMA_CREATE:
@@ -772,9 +1112,17 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 						g_warn_if_reached();
 				}
 
-				j_message_send(reply, connection);
+				jd_send_reply(message, reply, connection);
 			}
 			break;
+		case J_MESSAGE_ACKNOWLEDGE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			jd_send_reply(message, reply, connection);
+		}
+		break;
 		default:
 			g_warn_if_reached();
 			break;
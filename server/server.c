@@ -33,6 +33,8 @@
 
 #include "server.h"
 
+JConfiguration* jd_configuration = NULL;
+
 JStatistics* jd_statistics = NULL;
 GMutex jd_statistics_mutex[1] = { 0 };
 
@@ -40,7 +42,37 @@ JBackend* jd_object_backend = NULL;
 JBackend* jd_kv_backend = NULL;
 JBackend* jd_db_backend = NULL;
 
-static JConfiguration* jd_configuration = NULL;
+/**
+ * Data for initializing a backend in its own thread.
+ **/
+struct JdBackendInit
+{
+	/** The backend type. **/
+	JBackendType type;
+	/** The backend type's name. **/
+	gchar const* type_name;
+	/** The backend name. **/
+	gchar const* name;
+	/** The backend component. **/
+	gchar const* component;
+	/** The backend path. **/
+	gchar* path;
+	/** The backend module. **/
+	GModule* module;
+	/** The backend. **/
+	JBackend** backend;
+	/** The thread initializing the backend. **/
+	GThread* thread;
+	/** The main loop to quit if initialization fails. **/
+	GMainLoop* main_loop;
+};
+
+typedef struct JdBackendInit JdBackendInit;
+
+static JdBackendState jd_backend_state[3] = { JD_BACKEND_STATE_NONE, JD_BACKEND_STATE_NONE, JD_BACKEND_STATE_NONE };
+static GMutex jd_backend_mutex[1] = { 0 };
+static GCond jd_backend_cond[1] = { 0 };
+static gboolean jd_backend_failed = FALSE;
 
 static gboolean
 jd_signal(gpointer data)
@@ -57,15 +89,131 @@ jd_signal(gpointer data)
 	return FALSE;
 }
 
+JdBackendState
+jd_backend_get_state(JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdBackendState state;
+
+	g_return_val_if_fail(backend == J_BACKEND_TYPE_OBJECT || backend == J_BACKEND_TYPE_KV || backend == J_BACKEND_TYPE_DB, JD_BACKEND_STATE_NONE);
+
+	g_mutex_lock(jd_backend_mutex);
+	state = jd_backend_state[backend];
+	g_mutex_unlock(jd_backend_mutex);
+
+	return state;
+}
+
+gboolean
+jd_backend_wait(JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend == J_BACKEND_TYPE_OBJECT || backend == J_BACKEND_TYPE_KV || backend == J_BACKEND_TYPE_DB, FALSE);
+
+	g_mutex_lock(jd_backend_mutex);
+
+	while (jd_backend_state[backend] == JD_BACKEND_STATE_INITIALIZING)
+	{
+		g_cond_wait(jd_backend_cond, jd_backend_mutex);
+	}
+
+	// Backends that failed to initialize or are not handled by this server can not be used.
+	ret = (jd_backend_state[backend] == JD_BACKEND_STATE_READY);
+
+	g_mutex_unlock(jd_backend_mutex);
+
+	return ret;
+}
+
+static void
+jd_backend_set_state(JBackendType backend, JdBackendState state)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(jd_backend_mutex);
+	jd_backend_state[backend] = state;
+	g_cond_broadcast(jd_backend_cond);
+	g_mutex_unlock(jd_backend_mutex);
+}
+
+/**
+ * Loads and initializes a backend.
+ * Backends are initialized concurrently while the server is already accepting connections.
+ **/
+static gpointer
+jd_backend_init_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdBackendInit* init = data;
+	gboolean ret = FALSE;
+
+	if (!j_backend_load_server(init->name, init->component, init->type, &(init->module), init->backend))
+	{
+		// Behave as if the server was not responsible for this backend.
+		jd_backend_set_state(init->type, JD_BACKEND_STATE_NONE);
+		return NULL;
+	}
+
+	if (*(init->backend) != NULL)
+	{
+		switch (init->type)
+		{
+			case J_BACKEND_TYPE_OBJECT:
+				ret = j_backend_object_init(*(init->backend), init->path);
+				break;
+			case J_BACKEND_TYPE_KV:
+				ret = j_backend_kv_init(*(init->backend), init->path);
+				break;
+			case J_BACKEND_TYPE_DB:
+				ret = j_backend_db_init(*(init->backend), init->path);
+				break;
+			default:
+				g_assert_not_reached();
+		}
+	}
+
+	if (!ret)
+	{
+		g_warning("Could not initialize %s backend %s.", init->type_name, init->name);
+
+		// The backend pointer is reset to keep it from being finalized.
+		*(init->backend) = NULL;
+
+		g_mutex_lock(jd_backend_mutex);
+		jd_backend_failed = TRUE;
+		g_mutex_unlock(jd_backend_mutex);
+
+		jd_backend_set_state(init->type, JD_BACKEND_STATE_FAILED);
+		g_idle_add(jd_signal, init->main_loop);
+
+		return NULL;
+	}
+
+	if (init->type == J_BACKEND_TYPE_OBJECT)
+	{
+		jd_write_back_init(*(init->backend), j_configuration_get_write_back_size(jd_configuration), j_configuration_get_max_operation_size(jd_configuration), j_configuration_get_write_back_threads(jd_configuration));
+	}
+
+	g_debug("Initialized %s backend %s.", init->type_name, init->name);
+
+	jd_backend_set_state(init->type, JD_BACKEND_STATE_READY);
+
+	return NULL;
+}
+
 static gboolean
 jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JMemoryChunk* memory_chunk;
 	g_autoptr(JMessage) message = NULL;
 	JStatistics* statistics;
-	guint64 memory_chunk_size;
+	gint64 reply_window;
 
 	(void)service;
 	(void)source_object;
@@ -74,14 +222,24 @@ jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObjec
 	j_helper_set_nodelay(connection, TRUE);
 
 	statistics = j_statistics_new(TRUE);
-	memory_chunk_size = j_configuration_get_max_operation_size(jd_configuration);
-	memory_chunk = j_memory_chunk_new(memory_chunk_size);
+	reply_window = j_configuration_get_reply_window(jd_configuration);
 
 	message = j_message_new(J_MESSAGE_NONE, 0);
 
-	while (j_message_receive(message, connection))
+	while (TRUE)
 	{
-		jd_handle_message(message, connection, memory_chunk, memory_chunk_size, statistics);
+		// Send coalesced replies if no further message arrives within the reply window.
+		if (jd_pending_replies(connection) && !g_socket_condition_timed_wait(g_socket_connection_get_socket(connection), G_IO_IN, reply_window, NULL, NULL))
+		{
+			jd_send_replies(connection);
+		}
+
+		if (!j_message_receive(message, connection))
+		{
+			break;
+		}
+
+		jd_handle_message(message, connection, statistics);
 	}
 
 	{
@@ -107,7 +265,6 @@ jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObjec
 		g_mutex_unlock(jd_statistics_mutex);
 	}
 
-	j_memory_chunk_free(memory_chunk);
 	j_statistics_free(statistics);
 
 	return TRUE;
@@ -209,22 +366,12 @@ main(int argc, char** argv)
 	JTrace* trace;
 	GError* error = NULL;
 	g_autoptr(GMainLoop) main_loop = NULL;
-	GModule* object_module = NULL;
-	GModule* kv_module = NULL;
-	GModule* db_module = NULL;
 	g_autoptr(GOptionContext) context = NULL;
 	g_autoptr(GSocketService) socket_service = NULL;
-	gchar const* object_backend;
-	gchar const* object_component;
-	g_autofree gchar* object_path = NULL;
-	gchar const* kv_backend;
-	gchar const* kv_component;
-	g_autofree gchar* kv_path = NULL;
-	gchar const* db_backend;
-	gchar const* db_component;
-	g_autofree gchar* db_path = NULL;
+	JdBackendInit backend_init[3];
 	g_autofree gchar* port_str = NULL;
 	guint listen_retries = 0;
+	gboolean failed;
 
 	GOptionEntry entries[] = {
 		{ "daemon", 0, 0, G_OPTION_ARG_NONE, &opt_daemon, "Run as daemon", NULL },
@@ -311,61 +458,50 @@ main(int argc, char** argv)
 
 	port_str = g_strdup_printf("%d", opt_port);
 
-	object_backend = j_configuration_get_backend(jd_configuration, J_BACKEND_TYPE_OBJECT);
-	object_component = j_configuration_get_backend_component(jd_configuration, J_BACKEND_TYPE_OBJECT);
-	object_path = j_helper_str_replace(j_configuration_get_backend_path(jd_configuration, J_BACKEND_TYPE_OBJECT), "{PORT}", port_str);
+	backend_init[J_BACKEND_TYPE_OBJECT].type_name = "object";
+	backend_init[J_BACKEND_TYPE_OBJECT].backend = &jd_object_backend;
+	backend_init[J_BACKEND_TYPE_KV].type_name = "kv";
+	backend_init[J_BACKEND_TYPE_KV].backend = &jd_kv_backend;
+	backend_init[J_BACKEND_TYPE_DB].type_name = "db";
+	backend_init[J_BACKEND_TYPE_DB].backend = &jd_db_backend;
 
-	kv_backend = j_configuration_get_backend(jd_configuration, J_BACKEND_TYPE_KV);
-	kv_component = j_configuration_get_backend_component(jd_configuration, J_BACKEND_TYPE_KV);
-	kv_path = j_helper_str_replace(j_configuration_get_backend_path(jd_configuration, J_BACKEND_TYPE_KV), "{PORT}", port_str);
-
-	db_backend = j_configuration_get_backend(jd_configuration, J_BACKEND_TYPE_DB);
-	db_component = j_configuration_get_backend_component(jd_configuration, J_BACKEND_TYPE_DB);
-	db_path = j_helper_str_replace(j_configuration_get_backend_path(jd_configuration, J_BACKEND_TYPE_DB), "{PORT}", port_str);
-
-	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_OBJECT)
-	    && j_backend_load_server(object_backend, object_component, J_BACKEND_TYPE_OBJECT, &object_module, &jd_object_backend))
-	{
-		if (jd_object_backend == NULL || !j_backend_object_init(jd_object_backend, object_path))
-		{
-			g_warning("Could not initialize object backend %s.", object_backend);
-			return 1;
-		}
-
-		g_debug("Initialized object backend %s.", object_backend);
-	}
+	main_loop = g_main_loop_new(NULL, FALSE);
 
-	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_KV)
-	    && j_backend_load_server(kv_backend, kv_component, J_BACKEND_TYPE_KV, &kv_module, &jd_kv_backend))
+	for (guint i = 0; i < G_N_ELEMENTS(backend_init); i++)
 	{
-		if (jd_kv_backend == NULL || !j_backend_kv_init(jd_kv_backend, kv_path))
-		{
-			g_warning("Could not initialize kv backend %s.", kv_backend);
-			return 1;
-		}
+		JBackendType type = (JBackendType)i;
 
-		g_debug("Initialized kv backend %s.", kv_backend);
-	}
+		backend_init[i].type = type;
+		backend_init[i].name = j_configuration_get_backend(jd_configuration, type);
+		backend_init[i].component = j_configuration_get_backend_component(jd_configuration, type);
+		backend_init[i].path = j_helper_str_replace(j_configuration_get_backend_path(jd_configuration, type), "{PORT}", port_str);
+		backend_init[i].module = NULL;
+		backend_init[i].thread = NULL;
+		backend_init[i].main_loop = main_loop;
 
-	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_DB)
-	    && j_backend_load_server(db_backend, db_component, J_BACKEND_TYPE_DB, &db_module, &jd_db_backend))
-	{
-		if (jd_db_backend == NULL || !j_backend_db_init(jd_db_backend, db_path))
+		if (jd_is_server_for_backend(opt_host, opt_port, type))
 		{
-			g_warning("Could not initialize db backend %s.", db_backend);
-			return 1;
+			jd_backend_state[type] = JD_BACKEND_STATE_INITIALIZING;
 		}
-
-		g_debug("Initialized db backend %s.", db_backend);
 	}
 
 	jd_statistics = j_statistics_new(FALSE);
 	g_mutex_init(jd_statistics_mutex);
 
+	// Buffers for object operations are shared by all connections and allocated on demand.
+	jd_buffer_pool_init(j_configuration_get_buffer_pool_size(jd_configuration), j_configuration_get_max_operation_size(jd_configuration), j_configuration_get_buffer_pool_hugepages(jd_configuration), j_configuration_get_buffer_pool_lock(jd_configuration));
+
+	// Accept connections right away, handlers wait for their backends to become ready.
 	g_socket_service_start(socket_service);
 	g_signal_connect(socket_service, "run", G_CALLBACK(jd_on_run), NULL);
 
-	main_loop = g_main_loop_new(NULL, FALSE);
+	for (guint i = 0; i < G_N_ELEMENTS(backend_init); i++)
+	{
+		if (jd_backend_state[i] == JD_BACKEND_STATE_INITIALIZING)
+		{
+			backend_init[i].thread = g_thread_new("julea-server-init", jd_backend_init_thread, &(backend_init[i]));
+		}
+	}
 
 	g_unix_signal_add(SIGHUP, jd_signal, main_loop);
 	g_unix_signal_add(SIGINT, jd_signal, main_loop);
@@ -375,9 +511,20 @@ main(int argc, char** argv)
 
 	g_socket_service_stop(socket_service);
 
+	for (guint i = 0; i < G_N_ELEMENTS(backend_init); i++)
+	{
+		if (backend_init[i].thread != NULL)
+		{
+			g_thread_join(backend_init[i].thread);
+		}
+	}
+
 	g_mutex_clear(jd_statistics_mutex);
 	j_statistics_free(jd_statistics);
 
+	jd_write_back_fini();
+	jd_buffer_pool_fini();
+
 	if (jd_db_backend != NULL)
 	{
 		j_backend_db_fini(jd_db_backend);
@@ -393,20 +540,19 @@ main(int argc, char** argv)
 		j_backend_object_fini(jd_object_backend);
 	}
 
-	if (db_module != NULL)
+	for (guint i = G_N_ELEMENTS(backend_init); i > 0; i--)
 	{
-		g_module_close(db_module);
-	}
+		if (backend_init[i - 1].module != NULL)
+		{
+			g_module_close(backend_init[i - 1].module);
+		}
 
-	if (kv_module != NULL)
-	{
-		g_module_close(kv_module);
+		g_free(backend_init[i - 1].path);
 	}
 
-	if (object_module)
-	{
-		g_module_close(object_module);
-	}
+	g_mutex_lock(jd_backend_mutex);
+	failed = jd_backend_failed;
+	g_mutex_unlock(jd_backend_mutex);
 
 	j_configuration_unref(jd_configuration);
 
@@ -414,5 +560,5 @@ main(int argc, char** argv)
 
 	j_trace_fini();
 
-	return 0;
+	return (failed) ? 1 : 0;
 }
@@ -23,10 +23,23 @@
 #include <gio/gio.h>
 
 #include <jbackend.h>
+#include <jconfiguration.h>
 #include <jmemory-chunk.h>
 #include <jmessage.h>
 #include <jstatistics.h>
 
+enum JdBackendState
+{
+	JD_BACKEND_STATE_NONE,
+	JD_BACKEND_STATE_INITIALIZING,
+	JD_BACKEND_STATE_READY,
+	JD_BACKEND_STATE_FAILED
+};
+
+typedef enum JdBackendState JdBackendState;
+
+G_GNUC_INTERNAL extern JConfiguration* jd_configuration;
+
 G_GNUC_INTERNAL extern JStatistics* jd_statistics;
 G_GNUC_INTERNAL extern GMutex jd_statistics_mutex[1];
 
@@ -34,6 +47,27 @@ G_GNUC_INTERNAL extern JBackend* jd_object_backend;
 G_GNUC_INTERNAL extern JBackend* jd_kv_backend;
 G_GNUC_INTERNAL extern JBackend* jd_db_backend;
 
-G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, GSocketConnection*, JMemoryChunk*, guint64, JStatistics*);
+G_GNUC_INTERNAL JdBackendState jd_backend_get_state(JBackendType);
+G_GNUC_INTERNAL gboolean jd_backend_wait(JBackendType);
+
+G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, GSocketConnection*, JStatistics*);
+
+G_GNUC_INTERNAL gboolean jd_pending_replies(GSocketConnection*);
+G_GNUC_INTERNAL void jd_send_replies(GSocketConnection*);
+
+G_GNUC_INTERNAL void jd_buffer_pool_init(guint64, guint64, gboolean, gboolean);
+G_GNUC_INTERNAL void jd_buffer_pool_fini(void);
+
+G_GNUC_INTERNAL guint64 jd_buffer_pool_get_buffer_size(void);
+
+G_GNUC_INTERNAL gpointer jd_buffer_pool_acquire(void);
+G_GNUC_INTERNAL void jd_buffer_pool_release(gpointer);
+
+G_GNUC_INTERNAL void jd_write_back_init(JBackend*, guint64, guint64, guint);
+G_GNUC_INTERNAL void jd_write_back_fini(void);
+
+G_GNUC_INTERNAL gboolean jd_write_back_write(gchar const*, gchar const*, gconstpointer, guint64, guint64);
+G_GNUC_INTERNAL void jd_write_back_flush(gchar const*, gchar const*);
+G_GNUC_INTERNAL void jd_write_back_discard(gchar const*, gchar const*);
 
 #endif
@@ -0,0 +1,776 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * A buffered extent of an object.
+ */
+struct JdWriteBackExtent
+{
+	/**
+	 * The offset within the object.
+	 */
+	guint64 offset;
+
+	/**
+	 * The number of valid bytes in #data.
+	 */
+	guint64 length;
+
+	/**
+	 * The number of bytes allocated for #data.
+	 */
+	guint64 capacity;
+
+	/**
+	 * The data.
+	 */
+	gchar* data;
+};
+
+typedef struct JdWriteBackExtent JdWriteBackExtent;
+
+/**
+ * An object with buffered extents.
+ */
+struct JdWriteBackObject
+{
+	/**
+	 * The key, consisting of namespace and path.
+	 */
+	gchar* key;
+
+	/**
+	 * The namespace.
+	 */
+	gchar* namespace;
+
+	/**
+	 * The path.
+	 */
+	gchar* path;
+
+	/**
+	 * The extents, sorted by offset and neither overlapping nor adjacent.
+	 */
+	GList* extents;
+
+	/**
+	 * The number of bytes allocated for #extents.
+	 */
+	guint64 size;
+
+	/**
+	 * The time at which the first extent was buffered.
+	 */
+	gint64 dirty_time;
+
+	/**
+	 * Whether the object is in the flush queue.
+	 */
+	gboolean queued;
+
+	/**
+	 * Whether extents of the object are currently being written.
+	 */
+	gboolean flushing;
+};
+
+typedef struct JdWriteBackObject JdWriteBackObject;
+
+/**
+ * The write-back buffer.
+ */
+struct JdWriteBack
+{
+	/**
+	 * The backend to flush to.
+	 */
+	JBackend* backend;
+
+	/**
+	 * The maximum number of buffered bytes.
+	 */
+	guint64 max_size;
+
+	/**
+	 * The number of buffered bytes after which an object is flushed.
+	 */
+	guint64 flush_size;
+
+	/**
+	 * The number of buffered bytes.
+	 */
+	guint64 size;
+
+	/**
+	 * The objects with buffered extents.
+	 */
+	GHashTable* objects;
+
+	/**
+	 * The objects waiting to be flushed.
+	 */
+	GQueue* queue;
+
+	/**
+	 * The flush threads.
+	 */
+	GThread** threads;
+
+	/**
+	 * The number of flush threads.
+	 */
+	guint thread_count;
+
+	/**
+	 * Whether the flush threads should keep running.
+	 */
+	gboolean running;
+
+	/**
+	 * The mutex protecting all other members.
+	 */
+	GMutex mutex[1];
+
+	/**
+	 * Signaled when objects have been queued.
+	 */
+	GCond queue_cond[1];
+
+	/**
+	 * Signaled when a flush has finished.
+	 */
+	GCond flush_cond[1];
+};
+
+typedef struct JdWriteBack JdWriteBack;
+
+/**
+ * Objects are flushed after they have been dirty for this long.
+ */
+static gint64 const jd_write_back_interval = 100 * G_TIME_SPAN_MILLISECOND;
+
+static JdWriteBack* jd_write_back = NULL;
+
+static void
+jd_write_back_extent_free(gpointer data)
+{
+	JdWriteBackExtent* extent = data;
+
+	g_free(extent->data);
+	g_slice_free(JdWriteBackExtent, extent);
+}
+
+static void
+jd_write_back_object_free(gpointer data)
+{
+	JdWriteBackObject* object = data;
+
+	g_list_free_full(object->extents, jd_write_back_extent_free);
+	g_free(object->key);
+	g_free(object->namespace);
+	g_free(object->path);
+	g_slice_free(JdWriteBackObject, object);
+}
+
+static JdWriteBackObject*
+jd_write_back_lookup(gchar const* namespace, gchar const* path)
+{
+	g_autofree gchar* key = NULL;
+
+	key = g_strdup_printf("%s:%s", namespace, path);
+
+	return g_hash_table_lookup(jd_write_back->objects, key);
+}
+
+/**
+ * Looks up an object, waiting for running flushes of it to finish.
+ * Has to be called with the mutex held.
+ */
+static JdWriteBackObject*
+jd_write_back_lookup_idle(gchar const* namespace, gchar const* path)
+{
+	JdWriteBackObject* object;
+
+	while (TRUE)
+	{
+		// The object might have been freed while waiting, look it up again.
+		object = jd_write_back_lookup(namespace, path);
+
+		if (object == NULL || !object->flushing)
+		{
+			break;
+		}
+
+		g_cond_wait(jd_write_back->flush_cond, jd_write_back->mutex);
+	}
+
+	return object;
+}
+
+/**
+ * Buffers an extent, merging it with all overlapping and adjacent extents.
+ * Newer data takes precedence over older data.
+ *
+ * \return The change in the number of allocated bytes.
+ */
+static gint64
+jd_write_back_object_insert(JdWriteBackObject* object, gconstpointer data, guint64 length, guint64 offset)
+{
+	JdWriteBackExtent* merged = NULL;
+	GList* link;
+	guint64 end;
+	gint64 old_size;
+
+	end = offset + length;
+	old_size = object->size;
+	link = object->extents;
+
+	while (link != NULL && ((JdWriteBackExtent*)link->data)->offset + ((JdWriteBackExtent*)link->data)->length < offset)
+	{
+		link = link->next;
+	}
+
+	while (link != NULL && ((JdWriteBackExtent*)link->data)->offset <= end)
+	{
+		JdWriteBackExtent* extent = link->data;
+		GList* next = link->next;
+
+		if (merged == NULL)
+		{
+			merged = extent;
+		}
+		else
+		{
+			guint64 extent_end;
+
+			extent_end = extent->offset + extent->length;
+
+			// Only the part behind the new data has to be preserved.
+			if (extent_end > end)
+			{
+				guint64 skip;
+				guint64 new_length;
+
+				skip = end - extent->offset;
+				new_length = extent_end - merged->offset;
+
+				if (new_length > merged->capacity)
+				{
+					object->size += new_length - merged->capacity;
+					merged->data = g_realloc(merged->data, new_length);
+					merged->capacity = new_length;
+				}
+
+				memcpy(merged->data + (end - merged->offset), extent->data + skip, extent->length - skip);
+				merged->length = new_length;
+			}
+
+			object->size -= extent->capacity;
+			jd_write_back_extent_free(extent);
+			object->extents = g_list_delete_link(object->extents, link);
+		}
+
+		link = next;
+	}
+
+	if (merged == NULL)
+	{
+		merged = g_slice_new(JdWriteBackExtent);
+		merged->offset = offset;
+		merged->length = length;
+		merged->capacity = length;
+		merged->data = g_malloc(length);
+
+		memcpy(merged->data, data, length);
+
+		object->size += length;
+		object->extents = g_list_insert_before(object->extents, link, merged);
+	}
+	else
+	{
+		guint64 start;
+		guint64 new_length;
+
+		start = MIN(merged->offset, offset);
+		new_length = MAX(merged->offset + merged->length, end) - start;
+
+		if (start < merged->offset)
+		{
+			gchar* buf;
+
+			// Prepending requires moving the existing data anyway.
+			buf = g_malloc(new_length);
+			memcpy(buf + (merged->offset - start), merged->data, merged->length);
+
+			object->size += new_length - merged->capacity;
+			g_free(merged->data);
+
+			merged->data = buf;
+			merged->offset = start;
+			merged->capacity = new_length;
+		}
+		else if (new_length > merged->capacity)
+		{
+			guint64 capacity;
+
+			// Grow exponentially to make sequential appends cheap.
+			capacity = MAX(new_length, MIN(2 * merged->capacity, jd_write_back->flush_size));
+
+			object->size += capacity - merged->capacity;
+			merged->data = g_realloc(merged->data, capacity);
+			merged->capacity = capacity;
+		}
+
+		memcpy(merged->data + (offset - start), data, length);
+		merged->length = MAX(merged->length, new_length);
+	}
+
+	return (gint64)object->size - old_size;
+}
+
+/**
+ * Queues an object for flushing.
+ * Has to be called with the mutex held.
+ */
+static void
+jd_write_back_queue(JdWriteBackObject* object)
+{
+	if (object->queued || object->extents == NULL)
+	{
+		return;
+	}
+
+	object->queued = TRUE;
+	g_queue_push_tail(jd_write_back->queue, object);
+	g_cond_signal(jd_write_back->queue_cond);
+}
+
+/**
+ * Takes all buffered extents of an object and marks it as being flushed.
+ * Has to be called with the mutex held.
+ */
+static GList*
+jd_write_back_take(JdWriteBackObject* object, guint64* size)
+{
+	GList* extents;
+
+	if (object->queued)
+	{
+		g_queue_remove(jd_write_back->queue, object);
+		object->queued = FALSE;
+	}
+
+	extents = object->extents;
+	*size = object->size;
+
+	object->extents = NULL;
+	object->size = 0;
+	object->flushing = TRUE;
+
+	return extents;
+}
+
+/**
+ * Finishes a flush started with jd_write_back_take().
+ * Has to be called with the mutex held.
+ */
+static void
+jd_write_back_release(JdWriteBackObject* object, guint64 size)
+{
+	object->flushing = FALSE;
+	jd_write_back->size -= size;
+
+	if (object->extents == NULL)
+	{
+		g_hash_table_remove(jd_write_back->objects, object->key);
+	}
+	else if (object->size >= jd_write_back->flush_size)
+	{
+		jd_write_back_queue(object);
+	}
+
+	g_cond_broadcast(jd_write_back->flush_cond);
+}
+
+/**
+ * Writes extents to the backend and frees them.
+ * Must not be called with the mutex held.
+ */
+static void
+jd_write_back_write_out(gchar const* namespace, gchar const* path, GList* extents)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer object;
+
+	if (j_backend_object_open(jd_write_back->backend, namespace, path, &object))
+	{
+		for (GList* l = extents; l != NULL; l = l->next)
+		{
+			JdWriteBackExtent* extent = l->data;
+			guint64 bytes_written = 0;
+
+			j_backend_object_write(jd_write_back->backend, object, extent->data, extent->length, extent->offset, &bytes_written);
+		}
+
+		j_backend_object_close(jd_write_back->backend, object);
+	}
+	else
+	{
+		g_warning("Could not flush buffered writes to %s/%s.", namespace, path);
+	}
+
+	g_list_free_full(extents, jd_write_back_extent_free);
+}
+
+/**
+ * Flushes an object that is neither being flushed nor empty.
+ * Has to be called with the mutex held, which is released temporarily.
+ */
+static void
+jd_write_back_flush_object(JdWriteBackObject* object)
+{
+	GList* extents;
+	guint64 size;
+
+	extents = jd_write_back_take(object, &size);
+
+	g_mutex_unlock(jd_write_back->mutex);
+	// object cannot be freed while it is being flushed.
+	jd_write_back_write_out(object->namespace, object->path, extents);
+	g_mutex_lock(jd_write_back->mutex);
+
+	jd_write_back_release(object, size);
+}
+
+static JdWriteBackObject*
+jd_write_back_find_expired(gint64 now)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init(&iter, jd_write_back->objects);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		JdWriteBackObject* object = value;
+
+		if (!object->flushing && object->extents != NULL && now - object->dirty_time >= jd_write_back_interval)
+		{
+			return object;
+		}
+	}
+
+	return NULL;
+}
+
+static gpointer
+jd_write_back_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+
+	g_mutex_lock(jd_write_back->mutex);
+
+	while (jd_write_back->running)
+	{
+		JdWriteBackObject* object;
+
+		object = g_queue_pop_head(jd_write_back->queue);
+
+		if (object != NULL)
+		{
+			object->queued = FALSE;
+		}
+		else
+		{
+			gint64 end_time;
+
+			end_time = g_get_monotonic_time() + jd_write_back_interval;
+
+			if (g_cond_wait_until(jd_write_back->queue_cond, jd_write_back->mutex, end_time))
+			{
+				continue;
+			}
+
+			object = jd_write_back_find_expired(g_get_monotonic_time());
+		}
+
+		// Objects being flushed by another thread are requeued by jd_write_back_release() if necessary.
+		if (object == NULL || object->flushing || object->extents == NULL)
+		{
+			continue;
+		}
+
+		jd_write_back_flush_object(object);
+	}
+
+	g_mutex_unlock(jd_write_back->mutex);
+
+	return NULL;
+}
+
+/**
+ * Initializes the write-back buffer.
+ *
+ * \param backend      The object backend to flush to.
+ * \param max_size     The maximum number of buffered bytes, 0 to disable write-back.
+ * \param flush_size   The number of bytes after which an object is flushed.
+ * \param thread_count The number of flush threads.
+ */
+void
+jd_write_back_init(JBackend* backend, guint64 max_size, guint64 flush_size, guint thread_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(jd_write_back == NULL);
+	g_return_if_fail(thread_count > 0);
+
+	if (backend == NULL || max_size == 0)
+	{
+		return;
+	}
+
+	jd_write_back = g_slice_new(JdWriteBack);
+	jd_write_back->backend = backend;
+	jd_write_back->max_size = max_size;
+	jd_write_back->flush_size = MIN(flush_size, max_size);
+	jd_write_back->size = 0;
+	jd_write_back->objects = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, jd_write_back_object_free);
+	jd_write_back->queue = g_queue_new();
+	jd_write_back->threads = g_new(GThread*, thread_count);
+	jd_write_back->thread_count = thread_count;
+	jd_write_back->running = TRUE;
+
+	g_mutex_init(jd_write_back->mutex);
+	g_cond_init(jd_write_back->queue_cond);
+	g_cond_init(jd_write_back->flush_cond);
+
+	for (guint i = 0; i < thread_count; i++)
+	{
+		jd_write_back->threads[i] = g_thread_new("julea-write-back", jd_write_back_thread, NULL);
+	}
+}
+
+/**
+ * Flushes all buffered data and shuts down the write-back buffer.
+ */
+void
+jd_write_back_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GHashTableIter iter;
+	gpointer value;
+
+	if (jd_write_back == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_write_back->mutex);
+	jd_write_back->running = FALSE;
+	g_cond_broadcast(jd_write_back->queue_cond);
+	g_mutex_unlock(jd_write_back->mutex);
+
+	for (guint i = 0; i < jd_write_back->thread_count; i++)
+	{
+		g_thread_join(jd_write_back->threads[i]);
+	}
+
+	// No other threads are running anymore.
+	g_hash_table_iter_init(&iter, jd_write_back->objects);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		JdWriteBackObject* object = value;
+
+		jd_write_back_write_out(object->namespace, object->path, object->extents);
+		object->extents = NULL;
+	}
+
+	g_hash_table_unref(jd_write_back->objects);
+	g_queue_free(jd_write_back->queue);
+	g_free(jd_write_back->threads);
+
+	g_cond_clear(jd_write_back->flush_cond);
+	g_cond_clear(jd_write_back->queue_cond);
+	g_mutex_clear(jd_write_back->mutex);
+
+	g_slice_free(JdWriteBack, jd_write_back);
+	jd_write_back = NULL;
+}
+
+/**
+ * Buffers a write.
+ * Blocks while the write-back buffer is full.
+ *
+ * \param namespace The namespace.
+ * \param path      The path.
+ * \param data      The data.
+ * \param length    The length.
+ * \param offset    The offset.
+ *
+ * \return TRUE if the write has been buffered, FALSE if it has to be performed directly.
+ */
+gboolean
+jd_write_back_write(gchar const* namespace, gchar const* path, gconstpointer data, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdWriteBackObject* object;
+
+	if (jd_write_back == NULL || length > jd_write_back->max_size / 2)
+	{
+		return FALSE;
+	}
+
+	if (length == 0)
+	{
+		return TRUE;
+	}
+
+	g_mutex_lock(jd_write_back->mutex);
+
+	while (jd_write_back->size + length > jd_write_back->max_size)
+	{
+		GHashTableIter iter;
+		gpointer value;
+
+		// Make sure that all buffered data is on its way to the backend.
+		g_hash_table_iter_init(&iter, jd_write_back->objects);
+
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			jd_write_back_queue(value);
+		}
+
+		g_cond_wait(jd_write_back->flush_cond, jd_write_back->mutex);
+	}
+
+	object = jd_write_back_lookup(namespace, path);
+
+	if (object == NULL)
+	{
+		object = g_slice_new(JdWriteBackObject);
+		object->key = g_strdup_printf("%s:%s", namespace, path);
+		object->namespace = g_strdup(namespace);
+		object->path = g_strdup(path);
+		object->extents = NULL;
+		object->size = 0;
+		object->queued = FALSE;
+		object->flushing = FALSE;
+
+		g_hash_table_insert(jd_write_back->objects, object->key, object);
+	}
+
+	if (object->extents == NULL)
+	{
+		object->dirty_time = g_get_monotonic_time();
+	}
+
+	jd_write_back->size += jd_write_back_object_insert(object, data, length, offset);
+
+	if (object->size >= jd_write_back->flush_size)
+	{
+		jd_write_back_queue(object);
+	}
+
+	g_mutex_unlock(jd_write_back->mutex);
+
+	return TRUE;
+}
+
+/**
+ * Writes all buffered data of an object to the backend.
+ * Has to be called before accessing the object directly.
+ *
+ * \param namespace The namespace.
+ * \param path      The path.
+ */
+void
+jd_write_back_flush(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdWriteBackObject* object;
+
+	if (jd_write_back == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_write_back->mutex);
+
+	object = jd_write_back_lookup_idle(namespace, path);
+
+	if (object != NULL && object->extents != NULL)
+	{
+		jd_write_back_flush_object(object);
+	}
+
+	g_mutex_unlock(jd_write_back->mutex);
+}
+
+/**
+ * Drops all buffered data of an object.
+ * Has to be called before deleting the object.
+ *
+ * \param namespace The namespace.
+ * \param path      The path.
+ */
+void
+jd_write_back_discard(gchar const* namespace, gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdWriteBackObject* object;
+
+	if (jd_write_back == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(jd_write_back->mutex);
+
+	object = jd_write_back_lookup_idle(namespace, path);
+
+	if (object != NULL)
+	{
+		GList* extents;
+		guint64 size;
+
+		extents = jd_write_back_take(object, &size);
+		g_list_free_full(extents, jd_write_back_extent_free);
+		jd_write_back_release(object, size);
+	}
+
+	g_mutex_unlock(jd_write_back->mutex);
+}
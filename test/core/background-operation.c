@@ -56,9 +56,86 @@ test_background_operation_wait(void)
 	j_background_operation_unref(background_operation);
 }
 
+static gpointer
+on_background_operation_increment(gpointer data)
+{
+	guint* counter = data;
+
+	g_atomic_int_inc(counter);
+
+	return data;
+}
+
+static gpointer
+on_background_operation_nested(gpointer data)
+{
+	guint* counter = data;
+	gpointer nested[4];
+
+	for (guint i = 0; i < G_N_ELEMENTS(nested); i++)
+	{
+		nested[i] = counter;
+	}
+
+	// Waiting from within a worker must not deadlock, even if all workers are busy.
+	j_helper_execute_parallel(on_background_operation_increment, nested, G_N_ELEMENTS(nested));
+
+	return data;
+}
+
+static void
+test_background_operation_many(void)
+{
+	guint const n = 1000;
+
+	JBackgroundOperation* background_operations[1000];
+	guint counter = 0;
+
+	for (guint i = 0; i < n; i++)
+	{
+		background_operations[i] = j_background_operation_new(on_background_operation_increment, &counter);
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		gpointer result;
+
+		result = j_background_operation_wait(background_operations[i]);
+		g_assert_true(result == &counter);
+		j_background_operation_unref(background_operations[i]);
+	}
+
+	g_assert_cmpuint(counter, ==, n);
+}
+
+static void
+test_background_operation_execute_parallel(void)
+{
+	guint const n = 64;
+
+	gpointer data[64];
+	guint counter = 0;
+
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = &counter;
+	}
+
+	j_helper_execute_parallel(on_background_operation_nested, data, n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_assert_true(data[i] == &counter);
+	}
+
+	g_assert_cmpuint(counter, ==, n * 4);
+}
+
 void
 test_core_background_operation(void)
 {
 	g_test_add_func("/core/background_operation/new_ref_unref", test_background_operation_new_ref_unref);
 	g_test_add_func("/core/background_operation/wait", test_background_operation_wait);
+	g_test_add_func("/core/background_operation/many", test_background_operation_many);
+	g_test_add_func("/core/background_operation/execute_parallel", test_background_operation_execute_parallel);
 }
@@ -20,8 +20,12 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-item.h>
+#include <julea-kv.h>
+#include <julea-object.h>
 
 #include "test.h"
 
@@ -115,6 +119,286 @@ test_batch_execute_async(void)
 	_test_batch_execute(TRUE);
 }
 
+static void
+_test_batch_execute_reordered(JSemanticsOrdering ordering)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JObject) object_a = NULL;
+	g_autoptr(JObject) object_a2 = NULL;
+	g_autoptr(JObject) object_b = NULL;
+	gchar buffer_a[2] = { 'a', 'A' };
+	gchar buffer_b[2] = { 'b', 'B' };
+	gchar read_a[2] = { 0 };
+	gchar read_b[2] = { 0 };
+	guint64 nbytes[6] = { 0 };
+	guint64 operations;
+	guint64 executions;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, ordering);
+	batch = j_batch_new(semantics);
+
+	object_a = j_object_new("test", "batch-reordered-a");
+	object_b = j_object_new("test", "batch-reordered-b");
+	// A second handle for the same object shares its key.
+	object_a2 = j_object_new("test", "batch-reordered-a");
+
+	operations = j_batch_get_statistics(J_BATCH_STATISTICS_OPERATIONS);
+	executions = j_batch_get_statistics(J_BATCH_STATISTICS_EXECUTIONS);
+
+	// Interleaved operations have to keep their order per object.
+	j_object_create(object_a, batch);
+	j_object_create(object_b, batch);
+	j_object_write(object_a, buffer_a, 1, 0, &nbytes[0], batch);
+	j_object_write(object_b, buffer_b, 1, 0, &nbytes[1], batch);
+	j_object_write(object_a2, buffer_a + 1, 1, 1, &nbytes[2], batch);
+	j_object_write(object_b, buffer_b + 1, 1, 1, &nbytes[3], batch);
+	j_object_read(object_a, read_a, 2, 0, &nbytes[4], batch);
+	j_object_read(object_b, read_b, 2, 0, &nbytes[5], batch);
+	j_object_delete(object_a, batch);
+	j_object_delete(object_b, batch);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// The two writes per object are merged, so only eight groups are executed instead of ten.
+	g_assert_cmpuint(j_batch_get_statistics(J_BATCH_STATISTICS_OPERATIONS) - operations, ==, 10);
+	g_assert_cmpuint(j_batch_get_statistics(J_BATCH_STATISTICS_EXECUTIONS) - executions, ==, 8);
+
+	g_assert_cmpuint(nbytes[0] + nbytes[2], ==, 2);
+	g_assert_cmpuint(nbytes[1] + nbytes[3], ==, 2);
+	g_assert_cmpuint(nbytes[4], ==, 2);
+	g_assert_cmpuint(nbytes[5], ==, 2);
+	g_assert_cmpmem(read_a, 2, buffer_a, 2);
+	g_assert_cmpmem(read_b, 2, buffer_b, 2);
+}
+
+static void
+test_batch_execute_relaxed(void)
+{
+	_test_batch_execute_reordered(J_SEMANTICS_ORDERING_RELAXED);
+}
+
+static void
+test_batch_execute_semi_relaxed(void)
+{
+	_test_batch_execute_reordered(J_SEMANTICS_ORDERING_SEMI_RELAXED);
+}
+
+static void
+test_batch_execute_chains(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JObject) missing = NULL;
+	JObject* objects[4];
+	gchar buffer[4] = { 'a', 'b', 'c', 'd' };
+	gchar read[2] = { 0 };
+	guint64 nbytes[4] = { 0 };
+	guint64 nbytes_read = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, J_SEMANTICS_ORDERING_RELAXED);
+	batch = j_batch_new(semantics);
+
+	// Each object forms an independent chain of groups that is executed concurrently.
+	for (guint i = 0; i < G_N_ELEMENTS(objects); i++)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("batch-chains-%u", i);
+		objects[i] = j_object_new("test", name);
+
+		j_object_create(objects[i], batch);
+		j_object_write(objects[i], buffer + i, 1, 0, &nbytes[i], batch);
+	}
+
+	// A failing chain must not affect the others but has to be reported.
+	missing = j_object_new("test", "batch-chains-missing");
+	j_object_delete(missing, batch);
+
+	// The read depends on the groups of the first object and has to see its write.
+	j_object_read(objects[0], read, 2, 0, &nbytes_read, batch);
+
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+
+	for (guint i = 0; i < G_N_ELEMENTS(objects); i++)
+	{
+		g_assert_cmpuint(nbytes[i], ==, 1);
+	}
+
+	g_assert_cmpuint(nbytes_read, ==, 1);
+	g_assert_cmpint(read[0], ==, 'a');
+
+	// Without failing chains, the combined result is successful.
+	for (guint i = 0; i < G_N_ELEMENTS(objects); i++)
+	{
+		j_object_delete(objects[i], batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < G_N_ELEMENTS(objects); i++)
+	{
+		j_object_unref(objects[i]);
+	}
+}
+
+static void
+test_batch_execute_eventual(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) eventual_batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JObject) object = NULL;
+	gchar buffer[4] = { 'a', 'b', 'c', 'd' };
+	gchar read[4] = { 0 };
+	guint64 nbytes[2] = { 0 };
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_PERSISTENCY, J_SEMANTICS_PERSISTENCY_EVENTUAL);
+	eventual_batch = j_batch_new(semantics);
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	object = j_object_new("test", "batch-eventual");
+
+	j_object_create(object, eventual_batch);
+	j_object_write(object, buffer, 4, 0, &nbytes[0], eventual_batch);
+
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes[0], ==, 4);
+
+	// The written data has been copied into the cache.
+	memset(buffer, 0, 4);
+
+	// Reading has to wait for the cached operations to be flushed.
+	j_object_read(object, read, 4, 0, &nbytes[1], batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes[1], ==, 4);
+	g_assert_cmpmem(read, 4, "abcd", 4);
+
+	j_object_delete(object, eventual_batch);
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+}
+
+static void
+test_batch_execute_eventual_strict(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) eventual_batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JObject) object2 = NULL;
+	gchar buffer[4] = { 'a', 'b', 'c', 'd' };
+	gchar buffer2[4] = { 'e', 'f', 'g', 'h' };
+	gchar read[4] = { 0 };
+	gpointer value = NULL;
+	guint32 value_len = 0;
+	guint64 nbytes[3] = { 0 };
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_PERSISTENCY, J_SEMANTICS_PERSISTENCY_EVENTUAL);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, J_SEMANTICS_ORDERING_STRICT);
+	eventual_batch = j_batch_new(semantics);
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	// Two handles for the same object have different keys and must not be reordered.
+	object = j_object_new("test", "batch-eventual-strict");
+	object2 = j_object_new("test", "batch-eventual-strict");
+	kv = j_kv_new("test", "batch-eventual-strict");
+
+	j_object_create(object, eventual_batch);
+	j_object_write(object, buffer, 4, 0, &nbytes[0], eventual_batch);
+	j_kv_put(kv, g_strdup("abcd"), 5, g_free, eventual_batch);
+	j_object_write(object2, buffer2, 4, 0, &nbytes[1], eventual_batch);
+
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+
+	j_object_read(object, read, 4, 0, &nbytes[2], batch);
+	j_kv_get(kv, &value, &value_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes[2], ==, 4);
+	g_assert_cmpmem(read, 4, "efgh", 4);
+	g_assert_cmpuint(value_len, ==, 5);
+	g_assert_cmpstr(value, ==, "abcd");
+
+	g_free(value);
+
+	j_object_delete(object, eventual_batch);
+	j_kv_delete(kv, eventual_batch);
+	ret = j_batch_execute(eventual_batch);
+	g_assert_true(ret);
+}
+
+static void
+test_batch_execute_deferred(void)
+{
+	guint const n = 1000;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) missing = NULL;
+	JObject** objects;
+	JKV** kvs;
+	gboolean ret;
+
+	// Alternating operations are not merged, each one is sent in its own message.
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
+	objects = g_new(JObject*, n);
+	kvs = g_new(JKV*, n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("batch-deferred-%u", i);
+		objects[i] = j_object_new("test", name);
+		kvs[i] = j_kv_new("test", name);
+
+		j_object_create(objects[i], batch);
+		j_kv_put(kvs[i], g_strdup(name), strlen(name) + 1, g_free, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		j_object_delete(objects[i], batch);
+		j_kv_delete(kvs[i], batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Failures have to be reported even if replies are coalesced.
+	missing = j_object_new("test", "batch-deferred-missing");
+	j_object_delete(missing, batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		j_object_unref(objects[i]);
+		j_kv_unref(kvs[i]);
+	}
+
+	g_free(objects);
+	g_free(kvs);
+}
+
 void
 test_core_batch(void)
 {
@@ -122,4 +406,10 @@ test_core_batch(void)
 	g_test_add_func("/core/batch/semantics", test_batch_semantics);
 	g_test_add_func("/core/batch/execute", test_batch_execute);
 	g_test_add_func("/core/batch/execute_async", test_batch_execute_async);
+	g_test_add_func("/core/batch/execute_relaxed", test_batch_execute_relaxed);
+	g_test_add_func("/core/batch/execute_semi_relaxed", test_batch_execute_semi_relaxed);
+	g_test_add_func("/core/batch/execute_chains", test_batch_execute_chains);
+	g_test_add_func("/core/batch/execute_eventual", test_batch_execute_eventual);
+	g_test_add_func("/core/batch/execute_eventual_strict", test_batch_execute_eventual_strict);
+	g_test_add_func("/core/batch/execute_deferred", test_batch_execute_deferred);
 }
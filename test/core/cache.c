@@ -20,6 +20,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 
 #include <jcache.h>
@@ -81,10 +83,114 @@ test_cache_release(void)
 	j_cache_free(cache);
 }
 
+static void
+test_cache_sizes(void)
+{
+	JCache* cache;
+	gpointer ret[24];
+
+	cache = j_cache_new(64 * 1024 * 1024);
+
+	// Covers all size classes as well as large segments.
+	for (guint i = 0; i < G_N_ELEMENTS(ret); i++)
+	{
+		ret[i] = j_cache_get(cache, 1 << i);
+		g_assert_true(ret[i] != NULL);
+		memset(ret[i], i, 1 << i);
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(ret); i++)
+	{
+		g_assert_cmpuint(((guchar*)ret[i])[0], ==, i);
+		g_assert_cmpuint(((guchar*)ret[i])[(1 << i) - 1], ==, i);
+		j_cache_release(cache, ret[i]);
+	}
+
+	j_cache_free(cache);
+}
+
+static void
+test_cache_small(void)
+{
+	JCache* cache;
+	guint64 const lengths[] = { 1, 48, 200, 1000 };
+
+	cache = j_cache_new(1024);
+
+	// Small caches only use small slabs, larger segments are allocated individually.
+	for (guint j = 0; j < G_N_ELEMENTS(lengths); j++)
+	{
+		gpointer ret[16];
+		guint count = MIN(G_N_ELEMENTS(ret), 1024 / lengths[j]);
+
+		for (guint i = 0; i < count; i++)
+		{
+			ret[i] = j_cache_get(cache, lengths[j]);
+			g_assert_true(ret[i] != NULL);
+			memset(ret[i], i, lengths[j]);
+		}
+
+		for (guint i = 0; i < count; i++)
+		{
+			g_assert_cmpuint(((guchar*)ret[i])[lengths[j] - 1], ==, i);
+			j_cache_release(cache, ret[i]);
+		}
+	}
+
+	j_cache_free(cache);
+}
+
+static gpointer
+test_cache_thread(gpointer data)
+{
+	JCache* cache = data;
+
+	for (guint i = 0; i < 10000; i++)
+	{
+		gpointer ret;
+
+		ret = j_cache_get(cache, 1 << (i % 10));
+		g_assert_true(ret != NULL);
+		j_cache_release(cache, ret);
+	}
+
+	return NULL;
+}
+
+static void
+test_cache_threads(void)
+{
+	JCache* cache;
+	GThread* threads[4];
+	gpointer ret;
+
+	cache = j_cache_new(G_N_ELEMENTS(threads) * 512);
+
+	for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+	{
+		threads[i] = g_thread_new("test-cache", test_cache_thread, cache);
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+	{
+		g_thread_join(threads[i]);
+	}
+
+	// All segments have been released.
+	ret = j_cache_get(cache, G_N_ELEMENTS(threads) * 512);
+	g_assert_true(ret != NULL);
+	j_cache_release(cache, ret);
+
+	j_cache_free(cache);
+}
+
 void
 test_core_cache(void)
 {
 	g_test_add_func("/core/cache/new_free", test_cache_new_free);
 	g_test_add_func("/core/cache/get", test_cache_get);
 	g_test_add_func("/core/cache/release", test_cache_release);
+	g_test_add_func("/core/cache/sizes", test_cache_sizes);
+	g_test_add_func("/core/cache/small", test_cache_small);
+	g_test_add_func("/core/cache/threads", test_cache_threads);
 }
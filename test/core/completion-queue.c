@@ -0,0 +1,210 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+#include <julea-object.h>
+
+#include "test.h"
+
+static void
+test_completion_queue_new_free(void)
+{
+	g_autoptr(JCompletionQueue) queue = NULL;
+
+	queue = j_completion_queue_new();
+	g_assert_true(queue != NULL);
+	g_assert_cmpuint(j_completion_queue_get_outstanding(queue), ==, 0);
+}
+
+static void
+test_completion_queue_empty(void)
+{
+	g_autoptr(JCompletionQueue) queue = NULL;
+	JBatch* batch = NULL;
+
+	queue = j_completion_queue_new();
+
+	g_assert_false(j_completion_queue_poll(queue, &batch, NULL, NULL));
+	g_assert_false(j_completion_queue_wait(queue, &batch, NULL, NULL));
+	g_assert_true(batch == NULL);
+}
+
+static void
+test_completion_queue_submit(void)
+{
+	guint const n = 32;
+
+	g_autoptr(JCompletionQueue) queue = NULL;
+	gboolean seen[32] = { FALSE };
+	JBatch* batch;
+	gboolean ret;
+	gpointer user_data;
+	guint completed = 0;
+
+	queue = j_completion_queue_new();
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JBatch) submit_batch = NULL;
+		g_autoptr(JObject) object = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("completion-queue-%u", i);
+		submit_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		object = j_object_new("test", name);
+
+		j_object_create(object, submit_batch);
+		j_object_delete(object, submit_batch);
+
+		j_completion_queue_submit(queue, submit_batch, GUINT_TO_POINTER(i + 1));
+	}
+
+	g_assert_cmpuint(j_completion_queue_get_outstanding(queue), ==, n);
+
+	while (j_completion_queue_wait(queue, &batch, &ret, &user_data))
+	{
+		guint i = GPOINTER_TO_UINT(user_data) - 1;
+
+		g_assert_true(batch != NULL);
+		g_assert_true(ret);
+		g_assert_cmpuint(i, <, n);
+		g_assert_false(seen[i]);
+
+		seen[i] = TRUE;
+		completed++;
+
+		j_batch_unref(batch);
+	}
+
+	g_assert_cmpuint(completed, ==, n);
+	g_assert_cmpuint(j_completion_queue_get_outstanding(queue), ==, 0);
+	g_assert_false(j_completion_queue_poll(queue, NULL, NULL, NULL));
+}
+
+static void
+test_completion_queue_unref_outstanding(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	JCompletionQueue* queue;
+
+	queue = j_completion_queue_new();
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	object = j_object_new("test", "completion-queue-unref");
+
+	j_object_create(object, batch);
+	j_object_delete(object, batch);
+
+	// The batch keeps the queue alive until it has been executed.
+	j_completion_queue_submit(queue, batch, NULL);
+	j_completion_queue_unref(queue);
+}
+
+static void
+test_completion_queue_coalesced_subprocess(void)
+{
+	guint const n = 64;
+
+	g_autoptr(JCompletionQueue) queue = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	JBatch* completed_batch;
+	gboolean ret;
+	guint completed = 0;
+
+	g_assert_cmpuint(j_configuration_get_completion_queue_threads(j_configuration()), ==, 1);
+	g_assert_true(j_configuration_get_coalesce_replies(j_configuration()));
+
+	queue = j_completion_queue_new();
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_SAFETY, J_SEMANTICS_SAFETY_NETWORK);
+
+	// Replies are received by the event loop, so a single thread is enough for all batches.
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JBatch) submit_batch = NULL;
+		g_autoptr(JObject) object = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("completion-queue-coalesced-%u", i);
+		submit_batch = j_batch_new(semantics);
+		object = j_object_new("test", name);
+
+		j_object_create(object, submit_batch);
+		j_completion_queue_submit(queue, submit_batch, NULL);
+	}
+
+	while (j_completion_queue_wait(queue, &completed_batch, &ret, NULL))
+	{
+		g_assert_true(ret);
+		completed++;
+
+		j_batch_unref(completed_batch);
+	}
+
+	g_assert_cmpuint(completed, ==, n);
+
+	// The objects have to exist once their batches have completed.
+	batch = j_batch_new(semantics);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JObject) object = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("completion-queue-coalesced-%u", i);
+		object = j_object_new("test", name);
+
+		j_object_delete(object, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_completion_queue_coalesced(void)
+{
+	g_autoptr(GKeyFile) key_file = NULL;
+
+	if (g_test_subprocess())
+	{
+		test_completion_queue_coalesced_subprocess();
+		return;
+	}
+
+	key_file = test_key_file();
+	g_key_file_set_integer(key_file, "clients", "completion-queue-threads", 1);
+	g_key_file_set_boolean(key_file, "clients", "coalesce-replies", TRUE);
+
+	test_trap_subprocess(key_file);
+}
+
+void
+test_core_completion_queue(void)
+{
+	g_test_add_func("/core/completion_queue/new_free", test_completion_queue_new_free);
+	g_test_add_func("/core/completion_queue/empty", test_completion_queue_empty);
+	g_test_add_func("/core/completion_queue/submit", test_completion_queue_submit);
+	g_test_add_func("/core/completion_queue/unref_outstanding", test_completion_queue_unref_outstanding);
+	g_test_add_func("/core/completion_queue/coalesced", test_completion_queue_coalesced);
+}
@@ -0,0 +1,155 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+static void
+test_connection_pool_pop_push(void)
+{
+	gpointer connection;
+	gpointer connection2;
+	guint64 cached;
+	guint64 stolen;
+
+	if (j_configuration_get_multiplex_connections(j_configuration()) > 0)
+	{
+		g_test_skip("Connections are shared");
+		return;
+	}
+
+	connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_nonnull(connection);
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, 0, connection);
+
+	cached = j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_CACHED);
+	stolen = j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_STOLEN);
+
+	// The connection should be taken from the thread's cache.
+	connection2 = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_true(connection2 == connection);
+	g_assert_cmpuint(j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_CACHED), ==, cached + 1);
+	g_assert_cmpuint(j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_STOLEN), ==, stolen);
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, 0, connection2);
+}
+
+static gpointer
+test_connection_pool_thread(gpointer data)
+{
+	gpointer connection;
+
+	(void)data;
+
+	connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_nonnull(connection);
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, 0, connection);
+
+	return NULL;
+}
+
+static void
+test_connection_pool_threads(void)
+{
+	guint const n = 16;
+
+	GThread* threads[16];
+
+	for (guint i = 0; i < n; i++)
+	{
+		threads[i] = g_thread_new("test", test_connection_pool_thread, NULL);
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_thread_join(threads[i]);
+	}
+
+	// Connections cached by finished threads have to remain available.
+	test_connection_pool_thread(NULL);
+}
+
+static void
+test_connection_pool_steal(void)
+{
+	GThread* thread;
+	gpointer connection;
+	gpointer connection2;
+	guint64 created;
+	guint64 stolen;
+
+	if (j_configuration_get_multiplex_connections(j_configuration()) > 0)
+	{
+		g_test_skip("Connections are shared");
+		return;
+	}
+
+	if (j_configuration_get_max_connections(j_configuration()) < 2)
+	{
+		g_test_skip("Stealing requires at least two connections");
+		return;
+	}
+
+	// Keep the current thread's cache empty, so that the other thread's connection ends up in its own cache.
+	connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_nonnull(connection);
+
+	thread = g_thread_new("test", test_connection_pool_thread, NULL);
+	g_thread_join(thread);
+
+	created = j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_CREATED);
+	stolen = j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_STOLEN);
+
+	// The idle connection is reused instead of establishing a new one.
+	connection2 = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_nonnull(connection2);
+	g_assert_cmpuint(j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_CREATED), ==, created);
+	g_assert_cmpuint(j_connection_pool_get_statistics(J_CONNECTION_POOL_STATISTICS_STOLEN), <=, stolen + 1);
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, 0, connection2);
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, 0, connection);
+}
+
+static void
+test_connection_pool_backend_state(void)
+{
+	JBackendState state;
+
+	if (g_strcmp0(j_configuration_get_backend_component(j_configuration(), J_BACKEND_TYPE_OBJECT), "server") != 0)
+	{
+		g_test_skip("Backend states are only reported by servers");
+		return;
+	}
+
+	// Servers report backends that are still initializing, operations wait until they are ready.
+	state = j_connection_pool_get_backend_state(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_true(state == J_BACKEND_STATE_INITIALIZING || state == J_BACKEND_STATE_READY);
+}
+
+void
+test_core_connection_pool(void)
+{
+	g_test_add_func("/core/connection-pool/pop_push", test_connection_pool_pop_push);
+	g_test_add_func("/core/connection-pool/threads", test_connection_pool_threads);
+	g_test_add_func("/core/connection-pool/steal", test_connection_pool_steal);
+	g_test_add_func("/core/connection-pool/backend_state", test_connection_pool_backend_state);
+}
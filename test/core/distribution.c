@@ -91,6 +91,9 @@ test_distribution_distribute(JDistributionType type, JConfiguration** configurat
 			j_distribution_set2(distribution, "weight", 0, 1);
 			j_distribution_set2(distribution, "weight", 1, 2);
 			break;
+		case J_DISTRIBUTION_CONSISTENT_HASH:
+		case J_DISTRIBUTION_REPLICATED:
+		case J_DISTRIBUTION_ERASURE:
 		default:
 			g_warn_if_reached();
 	}
@@ -213,10 +216,284 @@ test_distribution_weighted(JConfiguration** configuration, gconstpointer data)
 	test_distribution_distribute(J_DISTRIBUTION_WEIGHTED, configuration, data);
 }
 
+static void
+test_distribution_get_servers(JConfiguration** configuration, gconstpointer data)
+{
+	g_autoptr(JDistribution) round_robin = NULL;
+	g_autoptr(JDistribution) single_server = NULL;
+	g_autoptr(JDistribution) weighted = NULL;
+	GArray* servers;
+	guint64 block_size;
+
+	(void)data;
+
+	block_size = j_configuration_get_stripe_size(*configuration);
+
+	round_robin = j_distribution_new_for_configuration(J_DISTRIBUTION_ROUND_ROBIN, *configuration);
+	j_distribution_set(round_robin, "start-index", 1);
+
+	servers = j_distribution_get_servers(round_robin, 1);
+	g_assert_cmpuint(servers->len, ==, 1);
+	g_assert_cmpuint(g_array_index(servers, guint, 0), ==, 1);
+	g_array_unref(servers);
+
+	servers = j_distribution_get_servers(round_robin, block_size + 1);
+	g_assert_cmpuint(servers->len, ==, 2);
+	g_assert_cmpuint(g_array_index(servers, guint, 0), ==, 1);
+	g_assert_cmpuint(g_array_index(servers, guint, 1), ==, 0);
+	g_array_unref(servers);
+
+	single_server = j_distribution_new_for_configuration(J_DISTRIBUTION_SINGLE_SERVER, *configuration);
+	j_distribution_set(single_server, "index", 1);
+
+	servers = j_distribution_get_servers(single_server, G_MAXUINT64);
+	g_assert_cmpuint(servers->len, ==, 1);
+	g_assert_cmpuint(g_array_index(servers, guint, 0), ==, 1);
+	g_array_unref(servers);
+
+	// Servers without weight never store any data.
+	weighted = j_distribution_new_for_configuration(J_DISTRIBUTION_WEIGHTED, *configuration);
+	j_distribution_set2(weighted, "weight", 0, 0);
+	j_distribution_set2(weighted, "weight", 1, 2);
+
+	servers = j_distribution_get_servers(weighted, G_MAXUINT64);
+	g_assert_cmpuint(servers->len, ==, 1);
+	g_assert_cmpuint(g_array_index(servers, guint, 0), ==, 1);
+	g_array_unref(servers);
+}
+
+static void
+test_distribution_consistent_hash(JConfiguration** configuration, gconstpointer data)
+{
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistribution) grown = NULL;
+	g_autoptr(JDistribution) deserialized = NULL;
+	bson_t* b;
+	bson_iter_t iterator;
+	guint64 block_size;
+	guint moved = 0;
+	guint per_server[3] = { 0, 0, 0 };
+
+	(void)data;
+
+	block_size = j_configuration_get_stripe_size(*configuration);
+
+	distribution = j_distribution_new_for_configuration(J_DISTRIBUTION_CONSISTENT_HASH, *configuration);
+	j_distribution_set(distribution, "object-id", 42);
+	j_distribution_set(distribution, "virtual-nodes", 4);
+
+	grown = j_distribution_new_for_configuration(J_DISTRIBUTION_CONSISTENT_HASH, *configuration);
+	j_distribution_set(grown, "object-id", 42);
+	j_distribution_set(grown, "virtual-nodes", 4);
+	j_distribution_set(grown, "server-count", 3);
+
+	b = j_distribution_serialize(distribution);
+	deserialized = j_distribution_new_from_bson(b);
+	bson_destroy(b);
+
+	g_assert_cmpint(j_distribution_get_type(deserialized), ==, J_DISTRIBUTION_CONSISTENT_HASH);
+
+	b = j_distribution_serialize(deserialized);
+	g_assert_true(bson_iter_init_find(&iterator, b, "object_id"));
+	g_assert_cmpint(bson_iter_int64(&iterator), ==, 42);
+	bson_destroy(b);
+
+	for (guint64 block = 0; block < 1000; block++)
+	{
+		guint64 block_id;
+		guint64 length;
+		guint64 offset;
+		guint index;
+		guint grown_index;
+
+		j_distribution_reset(distribution, block_size, block * block_size);
+		g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+		g_assert_cmpuint(length, ==, block_size);
+		g_assert_cmpuint(offset, ==, block * block_size);
+		g_assert_cmpuint(block_id, ==, block);
+
+		j_distribution_reset(grown, block_size, block * block_size);
+		g_assert_true(j_distribution_distribute(grown, &grown_index, &length, &offset, &block_id));
+
+		// Adding a server only moves blocks to the new server.
+		if (index != grown_index)
+		{
+			g_assert_cmpuint(grown_index, ==, 2);
+			moved++;
+		}
+
+		per_server[grown_index]++;
+	}
+
+	// Roughly a third of all blocks should move.
+	g_assert_cmpuint(moved, >, 200);
+	g_assert_cmpuint(moved, <, 470);
+
+	for (guint i = 0; i < G_N_ELEMENTS(per_server); i++)
+	{
+		g_assert_cmpuint(per_server[i], >, 200);
+	}
+}
+
+static void
+test_distribution_replicated(JConfiguration** configuration, gconstpointer data)
+{
+	g_autoptr(JDistribution) distribution = NULL;
+	GArray* servers;
+	guint64 block_size;
+	guint64 block_id;
+	guint64 length;
+	guint64 offset;
+	guint index;
+
+	(void)data;
+
+	block_size = j_configuration_get_stripe_size(*configuration);
+
+	distribution = j_distribution_new_for_configuration(J_DISTRIBUTION_REPLICATED, *configuration);
+	j_distribution_set(distribution, "start-index", 1);
+	j_distribution_set(distribution, "replicas", 2);
+
+	g_assert_cmpuint(j_distribution_get_replica_count(distribution), ==, 2);
+
+	j_distribution_reset(distribution, 2 * block_size, 0);
+
+	g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+	g_assert_cmpuint(index, ==, 1);
+	g_assert_cmpuint(length, ==, block_size);
+	g_assert_cmpuint(offset, ==, 0);
+	g_assert_cmpuint(j_distribution_get_replica(distribution, block_id, 0), ==, 1);
+	g_assert_cmpuint(j_distribution_get_replica(distribution, block_id, 1), ==, 0);
+
+	g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+	g_assert_cmpuint(index, ==, 0);
+	g_assert_cmpuint(offset, ==, block_size);
+	g_assert_cmpuint(j_distribution_get_replica(distribution, block_id, 1), ==, 1);
+
+	g_assert_false(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+
+	// Even a single block is stored on both servers.
+	servers = j_distribution_get_servers(distribution, 1);
+	g_assert_cmpuint(servers->len, ==, 2);
+	g_array_unref(servers);
+}
+
+static void
+test_distribution_erasure(JConfiguration** configuration, gconstpointer data)
+{
+	g_autoptr(JDistribution) distribution = NULL;
+	GArray* servers;
+	guint64 block_size;
+	guint64 block_id;
+	guint64 length;
+	guint64 offset;
+	guint64 erasure_block_size;
+	guint data_blocks;
+	guint parity_blocks;
+	guint index;
+
+	(void)data;
+
+	block_size = j_configuration_get_stripe_size(*configuration);
+
+	distribution = j_distribution_new_for_configuration(J_DISTRIBUTION_ERASURE, *configuration);
+	j_distribution_set(distribution, "start-index", 0);
+	j_distribution_set(distribution, "data-blocks", 1);
+	j_distribution_set(distribution, "parity-blocks", 1);
+
+	g_assert_true(j_distribution_get_erasure_code(distribution, &data_blocks, &parity_blocks, &erasure_block_size));
+	g_assert_cmpuint(data_blocks, ==, 1);
+	g_assert_cmpuint(parity_blocks, ==, 1);
+	g_assert_cmpuint(erasure_block_size, ==, block_size);
+
+	j_distribution_reset(distribution, 2 * block_size, 0);
+
+	g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+	g_assert_cmpuint(index, ==, 0);
+	g_assert_cmpuint(length, ==, block_size);
+	g_assert_cmpuint(offset, ==, 0);
+	g_assert_cmpuint(j_distribution_get_stripe_server(distribution, block_id, 1), ==, 1);
+
+	// Stripes rotate, so parity is spread across all servers.
+	g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+	g_assert_cmpuint(index, ==, 1);
+	g_assert_cmpuint(offset, ==, block_size);
+	g_assert_cmpuint(j_distribution_get_stripe_server(distribution, block_id, 1), ==, 0);
+
+	g_assert_false(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+
+	// A single block requires its parity server, too.
+	servers = j_distribution_get_servers(distribution, 1);
+	g_assert_cmpuint(servers->len, ==, 2);
+	g_array_unref(servers);
+}
+
+static void
+test_distribution_size_hint(JConfiguration** configuration, gconstpointer data)
+{
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistribution) deserialized = NULL;
+	bson_t* b;
+	guint64 max_operation_size;
+	guint64 stripe_size;
+	guint64 block_id;
+	guint64 length;
+	guint64 offset;
+	guint index;
+
+	(void)data;
+
+	max_operation_size = j_configuration_get_max_operation_size(*configuration);
+	stripe_size = j_configuration_get_stripe_size(*configuration);
+
+	distribution = j_distribution_new_for_configuration(J_DISTRIBUTION_ROUND_ROBIN, *configuration);
+	g_assert_cmpuint(j_distribution_get_block_size(distribution), ==, j_configuration_get_stripe_size(*configuration));
+
+	// Without a hint, the configured stripe size is kept.
+	j_distribution_set_size_hint(distribution, 0);
+	g_assert_cmpuint(j_distribution_get_block_size(distribution), ==, j_configuration_get_stripe_size(*configuration));
+
+	// Small data is kept in a single block on a single server.
+	j_distribution_set_size_hint(distribution, 1);
+	g_assert_cmpuint(j_distribution_get_block_size(distribution), ==, stripe_size);
+
+	j_distribution_set_size_hint(distribution, stripe_size - 1);
+	g_assert_cmpuint(j_distribution_get_block_size(distribution), ==, stripe_size);
+
+	j_distribution_reset(distribution, stripe_size - 1, 0);
+	g_assert_true(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+	g_assert_cmpuint(length, ==, stripe_size - 1);
+	g_assert_false(j_distribution_distribute(distribution, &index, &length, &offset, &block_id));
+
+	// Data that fits into one stripe per server still uses a single block.
+	j_distribution_set_size_hint(distribution, stripe_size + 1);
+	g_assert_cmpuint(j_distribution_get_block_size(distribution), ==, MIN(2 * stripe_size, max_operation_size));
+
+	// Larger data is spread across both servers.
+	j_distribution_set_size_hint(distribution, 4 * stripe_size);
+	g_assert_cmpuint(j_distribution_get_block_size(distribution), ==, MIN(2 * stripe_size, max_operation_size));
+
+	j_distribution_set_size_hint(distribution, G_GUINT64_CONSTANT(1024) * 1024 * 1024 * 1024);
+	g_assert_cmpuint(j_distribution_get_block_size(distribution), ==, max_operation_size);
+
+	j_distribution_set_size_hint(distribution, 4 * stripe_size);
+
+	b = j_distribution_serialize(distribution);
+	deserialized = j_distribution_new_from_bson(b);
+	bson_destroy(b);
+
+	g_assert_cmpuint(j_distribution_get_block_size(deserialized), ==, MIN(2 * stripe_size, max_operation_size));
+}
+
 void
 test_core_distribution(void)
 {
 	g_test_add("/core/distribution/round_robin", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_round_robin, test_distribution_fixture_teardown);
 	g_test_add("/core/distribution/single_server", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_single_server, test_distribution_fixture_teardown);
 	g_test_add("/core/distribution/weighted", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_weighted, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/get_servers", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_get_servers, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/consistent_hash", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_consistent_hash, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/replicated", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_replicated, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/erasure", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_erasure, test_distribution_fixture_teardown);
+	g_test_add("/core/distribution/size_hint", JConfiguration*, NULL, test_distribution_fixture_setup, test_distribution_size_hint, test_distribution_fixture_teardown);
 }
@@ -20,6 +20,8 @@
 
 #include <glib.h>
 
+#include <stdlib.h>
+
 #include <julea.h>
 
 #include "test.h"
@@ -113,6 +115,51 @@ test_list_get(JList** list, gconstpointer data)
 	g_assert_cmpstr(s, ==, "0");
 	s = j_list_get_last(*list);
 	g_assert_cmpstr(s, ==, "-1");
+	s = j_list_get_nth(*list, 2);
+	g_assert_cmpstr(s, ==, "-2");
+	s = j_list_get_nth(*list, 4);
+	g_assert_null(s);
+}
+
+static void
+test_list_order(JList** list, gconstpointer data)
+{
+	guint const n = 100;
+
+	g_autoptr(JListIterator) iterator = NULL;
+	gint expected;
+
+	(void)data;
+
+	// Results in -n, ..., -1, 0, ..., n - 1.
+	for (guint i = 0; i < n; i++)
+	{
+		j_list_append(*list, g_strdup_printf("%d", i));
+		j_list_prepend(*list, g_strdup_printf("%d", -(gint)i - 1));
+	}
+
+	g_assert_cmpuint(j_list_length(*list), ==, 2 * n);
+
+	iterator = j_list_iterator_new(*list);
+	expected = -(gint)n;
+
+	while (j_list_iterator_next(iterator))
+	{
+		gchar const* s = j_list_iterator_get(iterator);
+
+		g_assert_cmpint(atoi(s), ==, expected);
+		expected++;
+	}
+
+	g_assert_cmpint(expected, ==, (gint)n);
+
+	// Indexed access has to return the same order without allocating an iterator.
+	for (guint i = 0; i < j_list_length(*list); i++)
+	{
+		gchar const* s = j_list_get_nth(*list, i);
+
+		g_assert_cmpint(atoi(s), ==, (gint)i - (gint)n);
+	}
 }
 
 void
@@ -123,4 +170,5 @@ test_core_list(void)
 	g_test_add("/core/list/append", JList*, NULL, test_list_fixture_setup, test_list_append, test_list_fixture_teardown);
 	g_test_add("/core/list/prepend", JList*, NULL, test_list_fixture_setup, test_list_prepend, test_list_fixture_teardown);
 	g_test_add("/core/list/get", JList*, NULL, test_list_fixture_setup, test_list_get, test_list_fixture_teardown);
+	g_test_add("/core/list/order", JList*, NULL, test_list_fixture_setup, test_list_order, test_list_fixture_teardown);
 }
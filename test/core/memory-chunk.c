@@ -80,10 +80,37 @@ test_memory_chunk_reset(void)
 	j_memory_chunk_free(memory_chunk);
 }
 
+static void
+test_memory_chunk_new_for_data(void)
+{
+	JMemoryChunk* memory_chunk;
+	gchar buffer[2];
+	gpointer ret;
+
+	memory_chunk = j_memory_chunk_new_for_data(buffer, sizeof(buffer));
+	g_assert_true(memory_chunk != NULL);
+
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret == buffer);
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret == buffer + 1);
+	ret = j_memory_chunk_get(memory_chunk, 1);
+	g_assert_true(ret == NULL);
+
+	j_memory_chunk_reset(memory_chunk);
+
+	ret = j_memory_chunk_get(memory_chunk, 2);
+	g_assert_true(ret == buffer);
+
+	// The memory is not freed.
+	j_memory_chunk_free(memory_chunk);
+}
+
 void
 test_core_memory_chunk(void)
 {
 	g_test_add_func("/core/memory-chunk/new_free", test_memory_chunk_new_free);
 	g_test_add_func("/core/memory-chunk/get", test_memory_chunk_get);
 	g_test_add_func("/core/memory-chunk/reset", test_memory_chunk_reset);
+	g_test_add_func("/core/memory-chunk/new_for_data", test_memory_chunk_new_for_data);
 }
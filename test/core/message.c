@@ -165,6 +165,59 @@ test_message_write_read(void)
 	g_assert_cmpstr(dummy_str, ==, "42");
 }
 
+static void
+test_message_write_read_send(void)
+{
+	g_autoptr(JMessage) message_recv = NULL;
+	g_autoptr(JMessage) message_send = NULL;
+	g_autoptr(GOutputStream) output = NULL;
+	g_autoptr(GInputStream) input = NULL;
+	g_autofree gchar* large = NULL;
+	gboolean ret;
+	gchar segments[10][8];
+	gchar buffer[8];
+	gsize large_size = 100 * 1024;
+
+	output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+	input = g_memory_input_stream_new();
+
+	message_send = j_message_new(J_MESSAGE_NONE, 0);
+	message_recv = j_message_new(J_MESSAGE_NONE, 0);
+
+	// Grow the message beyond all buffer size classes.
+	large = g_malloc0(large_size);
+	j_message_add_operation(message_send, large_size);
+	ret = j_message_append_n(message_send, large, large_size);
+	g_assert_true(ret);
+
+	// Use more segments than are stored inline.
+	for (guint i = 0; i < G_N_ELEMENTS(segments); i++)
+	{
+		memset(segments[i], i, sizeof(segments[i]));
+		j_message_add_send(message_send, segments[i], sizeof(segments[i]));
+	}
+
+	ret = j_message_write(message_send, output);
+	g_assert_true(ret);
+
+	g_memory_input_stream_add_data(
+		G_MEMORY_INPUT_STREAM(input),
+		g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(output)),
+		g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(output)),
+		NULL);
+
+	ret = j_message_read(message_recv, input);
+	g_assert_true(ret);
+	g_assert_cmpuint(j_message_get_count(message_recv), ==, 1);
+
+	for (guint i = 0; i < G_N_ELEMENTS(segments); i++)
+	{
+		ret = g_input_stream_read_all(input, buffer, sizeof(buffer), NULL, NULL, NULL);
+		g_assert_true(ret);
+		g_assert_true(memcmp(buffer, segments[i], sizeof(buffer)) == 0);
+	}
+}
+
 static void
 test_message_semantics(void)
 {
@@ -198,5 +251,6 @@ test_core_message(void)
 	g_test_add_func("/core/message/header", test_message_header);
 	g_test_add_func("/core/message/append", test_message_append);
 	g_test_add_func("/core/message/write_read", test_message_write_read);
+	g_test_add_func("/core/message/write_read_send", test_message_write_read_send);
 	g_test_add_func("/core/message/semantics", test_message_semantics);
 }
@@ -0,0 +1,133 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include <jreed-solomon.h>
+
+#include "test.h"
+
+static void
+test_reed_solomon_new_free(void)
+{
+	JReedSolomon* rs;
+
+	rs = j_reed_solomon_new(4, 2);
+	g_assert_true(rs != NULL);
+
+	j_reed_solomon_free(rs);
+}
+
+static void
+test_reed_solomon_decode(void)
+{
+	guint const k = 5;
+	guint const m = 3;
+	gsize const length = 1000;
+
+	JReedSolomon* rs;
+	g_autofree guint8* original = NULL;
+	g_autofree guint8* buffer = NULL;
+	g_autofree guint8** blocks = NULL;
+	g_autofree gboolean* present = NULL;
+
+	rs = j_reed_solomon_new(k, m);
+	original = g_malloc(k * length);
+	buffer = g_malloc((k + m) * length);
+	blocks = g_new(guint8*, k + m);
+	present = g_new(gboolean, k + m);
+
+	for (guint i = 0; i < k * length; i++)
+	{
+		original[i] = g_random_int();
+	}
+
+	for (guint i = 0; i < k + m; i++)
+	{
+		blocks[i] = buffer + i * length;
+	}
+
+	memcpy(buffer, original, k * length);
+	j_reed_solomon_encode(rs, (guint8 const* const*)blocks, blocks + k, length);
+
+	// Parity is only complete if all data blocks can be reconstructed from any k blocks.
+	for (guint i = 0; i < k + m; i++)
+	{
+		for (guint j = i + 1; j < k + m; j++)
+		{
+			for (guint l = 0; l < k + m; l++)
+			{
+				present[l] = (l != i && l != j && l != (i + j) % (k + m));
+			}
+
+			for (guint l = 0; l < k; l++)
+			{
+				if (!present[l])
+				{
+					memset(blocks[l], 0, length);
+				}
+			}
+
+			g_assert_true(j_reed_solomon_decode(rs, blocks, present, length));
+			g_assert_cmpmem(buffer, k * length, original, k * length);
+		}
+	}
+
+	// More than m missing blocks cannot be reconstructed.
+	for (guint l = 0; l < k + m; l++)
+	{
+		present[l] = (l > m);
+	}
+
+	g_assert_false(j_reed_solomon_decode(rs, blocks, present, length));
+
+	j_reed_solomon_free(rs);
+}
+
+static void
+test_reed_solomon_no_parity(void)
+{
+	JReedSolomon* rs;
+	guint8 data[] = { 1, 2, 3 };
+	guint8* blocks[] = { data };
+	gboolean present[] = { TRUE };
+
+	rs = j_reed_solomon_new(1, 0);
+
+	g_assert_true(j_reed_solomon_decode(rs, blocks, present, sizeof(data)));
+	g_assert_cmpuint(data[2], ==, 3);
+
+	present[0] = FALSE;
+	g_assert_false(j_reed_solomon_decode(rs, blocks, present, sizeof(data)));
+
+	j_reed_solomon_free(rs);
+}
+
+void
+test_core_reed_solomon(void)
+{
+	g_test_add_func("/core/reed-solomon/new_free", test_reed_solomon_new_free);
+	g_test_add_func("/core/reed-solomon/decode", test_reed_solomon_decode);
+	g_test_add_func("/core/reed-solomon/no_parity", test_reed_solomon_no_parity);
+}
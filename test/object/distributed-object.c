@@ -160,6 +160,171 @@ test_object_read_write(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_replicated(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	gint64 modification_time = 0;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(3 * 1024);
+	buffer2 = g_malloc0(3 * 1024);
+	memset(buffer, 'j', 3 * 1024);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_REPLICATED);
+	j_distribution_set_block_size(distribution, 1024);
+	object = j_distributed_object_new("test", "test-distributed-object-replicated", distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Replicas must not be counted multiple times.
+	j_distributed_object_write(object, buffer, 3 * 1024, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 3 * 1024);
+
+	for (guint i = 0; i < 4; i++)
+	{
+		j_distributed_object_read(object, buffer2, 3 * 1024, 0, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, 3 * 1024);
+		g_assert_cmpmem(buffer, 3 * 1024, buffer2, 3 * 1024);
+	}
+
+	j_distributed_object_status(object, &modification_time, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 3 * 1024);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+/**
+ * Returns the erasure coded test object.
+ * Its distribution only depends on the server count, so subprocesses can access it, too.
+ **/
+static JDistributedObject*
+test_object_erasure_new(void)
+{
+	g_autoptr(JDistribution) distribution = NULL;
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ERASURE);
+	j_distribution_set_block_size(distribution, 1024);
+	j_distribution_set(distribution, "start-index", 0);
+
+	return j_distributed_object_new("test", "test-distributed-object-erasure", distribution);
+}
+
+static void
+test_object_erasure_subprocess(guint64 length)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	// Connecting to the unreachable server emits a warning.
+	g_log_set_always_fatal(G_LOG_FATAL_MASK);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(length);
+	buffer2 = g_malloc0(length);
+	memset(buffer, 'j', length);
+	memset(buffer + 1000, 'u', 100);
+	memset(buffer + length - 50, 0, 50);
+
+	object = test_object_erasure_new();
+
+	j_distributed_object_read(object, buffer2, length, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, length);
+	g_assert_cmpmem(buffer, length, buffer2, length);
+}
+
+static void
+test_object_erasure(void)
+{
+	guint64 const length = 3 * 1024 + 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autoptr(GKeyFile) key_file = NULL;
+	g_auto(GStrv) servers = NULL;
+	g_autofree gchar* buffer = NULL;
+	gsize count;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	if (j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT) < 2)
+	{
+		g_test_skip("Erasure coding requires at least two object servers");
+		return;
+	}
+
+	if (g_test_subprocess())
+	{
+		test_object_erasure_subprocess(length);
+		return;
+	}
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(length);
+	memset(buffer, 'j', length);
+	// Reconstructed blocks must not lose data that ends in zeros.
+	memset(buffer + length - 50, 0, 50);
+
+	object = test_object_erasure_new();
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_distributed_object_write(object, buffer, length, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, length);
+
+	// Partial writes have to update the stripe's parity.
+	memset(buffer + 1000, 'u', 100);
+	nbytes = 0;
+	j_distributed_object_write(object, buffer + 1000, 100, 1000, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 100);
+
+	// Take the second server offline by replacing it with an address nobody listens on.
+	key_file = test_key_file();
+	servers = g_key_file_get_string_list(key_file, "servers", "object", &count, NULL);
+	g_free(servers[1]);
+	servers[1] = g_strdup("127.0.0.1:1");
+	g_key_file_set_string_list(key_file, "servers", "object", (gchar const* const*)servers, count);
+	g_key_file_set_integer(key_file, "clients", "connect-attempts", 1);
+
+	test_trap_subprocess(key_file);
+	g_test_trap_assert_stderr("*Can not connect to 127.0.0.1:1*");
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 test_object_status(void)
 {
@@ -240,6 +405,8 @@ test_object_distributed_object(void)
 	g_test_add_func("/object/distributed-object/new_free", test_object_new_free);
 	g_test_add_func("/object/distributed-object/create_delete", test_object_create_delete);
 	g_test_add_func("/object/distributed-object/read_write", test_object_read_write);
+	g_test_add_func("/object/distributed-object/replicated", test_object_replicated);
+	g_test_add_func("/object/distributed-object/erasure", test_object_erasure);
 	g_test_add_func("/object/distributed-object/status", test_object_status);
 	g_test_add_func("/object/distributed-object/sync", test_object_sync);
 }
@@ -20,6 +20,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-object.h>
 
@@ -153,6 +155,83 @@ test_object_read_write(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_read_write_contiguous(void)
+{
+	guint const n = 64;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	g_autofree guint64* nbytes = NULL;
+	guint64 nbytes_overlap[2] = { 0, 0 };
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(n);
+	buffer2 = g_malloc0(n + n / 2);
+	nbytes = g_new0(guint64, n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		buffer[i] = 'a' + (i % 26);
+	}
+
+	object = j_object_new("test", "test-object-rw-contiguous");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Adjacent writes are merged into a single operation.
+	for (guint i = 0; i < n; i++)
+	{
+		j_object_write(object, buffer + i, 1, i, &nbytes[i], batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_assert_cmpuint(nbytes[i], ==, 1);
+		nbytes[i] = 0;
+	}
+
+	// Adjacent reads are merged and scattered into the individual buffers.
+	for (guint i = 0; i < n; i++)
+	{
+		j_object_read(object, buffer2 + i, 1, i, &nbytes[i], batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_assert_cmpuint(nbytes[i], ==, 1);
+	}
+
+	g_assert_cmpmem(buffer2, n, buffer, n);
+
+	// Overlapping reads are merged, reads beyond the end of the object are short.
+	memset(buffer2, 0, n + n / 2);
+	j_object_read(object, buffer2, n / 2, 0, &nbytes_overlap[0], batch);
+	j_object_read(object, buffer2 + n / 2, n, n / 4, &nbytes_overlap[1], batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes_overlap[0], ==, n / 2);
+	g_assert_cmpuint(nbytes_overlap[1], ==, n - n / 4);
+	g_assert_cmpmem(buffer2, n / 2, buffer, n / 2);
+	g_assert_cmpmem(buffer2 + n / 2, n - n / 4, buffer + n / 4, n - n / 4);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 test_object_status(void)
 {
@@ -190,6 +269,88 @@ test_object_status(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_write_back(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) unsafe_batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* read_buffer = NULL;
+	guint64 const record_size = 1000;
+	guint64 const record_count = 16;
+	gint64 modification_time = 0;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	// Servers buffer these writes if write-back-size is set, the results have to be the same either way.
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_SAFETY, J_SEMANTICS_SAFETY_NONE);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	unsafe_batch = j_batch_new(semantics);
+	buffer = g_malloc(record_count * record_size);
+	read_buffer = g_malloc0(record_count * record_size);
+
+	object = j_object_new("test", "test-object-write-back");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < record_count; i++)
+	{
+		memset(buffer + i * record_size, 'a' + i, record_size);
+		j_object_write(object, buffer + i * record_size, record_size, i * record_size, &nbytes, unsafe_batch);
+		ret = j_batch_execute(unsafe_batch);
+		g_assert_true(ret);
+	}
+
+	// Getting the status has to include buffered data.
+	j_object_status(object, &modification_time, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, record_count * record_size);
+
+	// Overwritten data has to be visible to reads immediately.
+	memset(buffer + record_size / 2, 'z', record_size);
+	j_object_write(object, buffer + record_size / 2, record_size, record_size / 2, &nbytes, unsafe_batch);
+	ret = j_batch_execute(unsafe_batch);
+	g_assert_true(ret);
+
+	j_object_read(object, read_buffer, record_count * record_size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, record_count * record_size);
+	g_assert_cmpmem(read_buffer, record_count * record_size, buffer, record_count * record_size);
+
+	// Deleting an object has to discard its buffered data.
+	j_object_write(object, buffer, record_size, record_count * record_size, &nbytes, unsafe_batch);
+	ret = j_batch_execute(unsafe_batch);
+	g_assert_true(ret);
+
+	j_object_delete(object, batch);
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Syncing writes all buffered data of the object, which must not include the discarded data.
+	j_object_sync(object, batch);
+	j_object_status(object, &modification_time, &size, batch);
+	j_object_read(object, read_buffer, record_size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 0);
+	g_assert_cmpuint(nbytes, ==, 0);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 test_object_sync(void)
 {
@@ -223,12 +384,494 @@ test_object_sync(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_cache_subprocess(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 const size = 128 * 1024;
+	guint64 hits;
+	guint64 hits_before;
+	guint64 misses;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	g_assert_cmpuint(j_configuration_get_object_cache_size(j_configuration()), ==, 16 * 1024 * 1024);
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_CONSISTENCY, J_SEMANTICS_CONSISTENCY_NONE);
+
+	batch = j_batch_new(semantics);
+	buffer = g_malloc(size);
+
+	object = j_object_new("test", "test-object-cache");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	memset(buffer, 'a', size);
+	j_object_write(object, buffer, size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+
+	memset(buffer, 0, size);
+	j_object_read(object, buffer, size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+	g_assert_cmpint(buffer[size - 1], ==, 'a');
+
+	j_object_cache_get_statistics(&hits_before, &misses);
+
+	// Writes have to update the cached blocks.
+	memset(buffer, 'b', size / 2);
+	j_object_write(object, buffer, size / 2, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	memset(buffer, 0, size);
+	j_object_read(object, buffer, size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+	g_assert_cmpint(buffer[0], ==, 'b');
+	g_assert_cmpint(buffer[size - 1], ==, 'a');
+
+	j_object_cache_get_statistics(&hits, &misses);
+	g_assert_cmpuint(hits, ==, hits_before + 1);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_cache(void)
+{
+	g_autoptr(GKeyFile) key_file = NULL;
+
+	if (g_test_subprocess())
+	{
+		test_object_cache_subprocess();
+		return;
+	}
+
+	key_file = test_key_file();
+	g_key_file_set_uint64(key_file, "clients", "object-cache-size", 16 * 1024 * 1024);
+
+	test_trap_subprocess(key_file);
+}
+
+static void
+test_object_readahead_subprocess(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 const record_size = 16 * 1024;
+	guint64 const record_count = 64;
+	guint64 prefetches_before = 0;
+	guint64 prefetches = 0;
+	guint64 prefetches_after = 0;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	g_assert_cmpuint(j_configuration_get_object_cache_size(j_configuration()), ==, 16 * 1024 * 1024);
+	g_assert_cmpuint(j_configuration_get_object_readahead_size(j_configuration()), ==, 1024 * 1024);
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_CONSISTENCY, J_SEMANTICS_CONSISTENCY_NONE);
+
+	batch = j_batch_new(semantics);
+	buffer = g_malloc(record_size);
+
+	object = j_object_new("test", "test-object-readahead");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+
+	for (guint64 i = 0; i < record_count; i++)
+	{
+		memset(buffer, 'a' + (i % 26), record_size);
+		j_object_write(object, buffer, record_size, i * record_size, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	j_object_cache_get_readahead_statistics(&prefetches_before);
+
+	// Small sequential reads trigger prefetches that must not change the results.
+	for (guint64 i = 0; i < record_count; i++)
+	{
+		gchar const expected = 'a' + (i % 26);
+
+		memset(buffer, 0, record_size);
+		j_object_read(object, buffer, record_size, i * record_size, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, record_size);
+		g_assert_cmpint(buffer[0], ==, expected);
+		g_assert_cmpint(buffer[record_size - 1], ==, expected);
+	}
+
+	j_object_cache_get_readahead_statistics(&prefetches);
+	g_assert_cmpuint(prefetches, >, prefetches_before);
+
+	// Repeatedly reading the beginning must not prefetch the same data again.
+	for (guint i = 0; i < 4; i++)
+	{
+		j_object_read(object, buffer, record_size, 0, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, record_size);
+		g_assert_cmpint(buffer[0], ==, 'a');
+	}
+
+	j_object_cache_get_readahead_statistics(&prefetches_after);
+	g_assert_cmpuint(prefetches_after, ==, prefetches);
+
+	// Reading beyond the end returns nothing even if it has been prefetched.
+	j_object_read(object, buffer, record_size, record_count * record_size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 0);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_readahead(void)
+{
+	g_autoptr(GKeyFile) key_file = NULL;
+
+	if (g_test_subprocess())
+	{
+		test_object_readahead_subprocess();
+		return;
+	}
+
+	// Client-side backends are accessed directly and do not prefetch.
+	if (g_strcmp0(j_configuration_get_backend_component(j_configuration(), J_BACKEND_TYPE_OBJECT), "server") != 0)
+	{
+		g_test_skip("Read-ahead requires a server-side object backend");
+		return;
+	}
+
+	// The read-ahead window is limited to a quarter of the cache and has to hold at least one block.
+	key_file = test_key_file();
+	g_key_file_set_uint64(key_file, "clients", "object-cache-size", 16 * 1024 * 1024);
+	g_key_file_set_uint64(key_file, "clients", "object-readahead-size", 1024 * 1024);
+
+	test_trap_subprocess(key_file);
+}
+
+static void
+test_object_write_buffer_subprocess(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 const record_size = 100;
+	guint64 const record_count = 100;
+	gint64 modification_time = 0;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	guint64 writes_before = 0;
+	guint64 writes_after = 0;
+	guint64 flushes_before = 0;
+	guint64 flushes_after = 0;
+	gboolean ret;
+
+	g_assert_cmpuint(j_configuration_get_object_write_buffer_size(j_configuration()), ==, 64 * 1024);
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_SAFETY, J_SEMANTICS_SAFETY_NONE);
+	// Buffered data is kept across batches only without consistency guarantees.
+	j_semantics_set(semantics, J_SEMANTICS_CONSISTENCY, J_SEMANTICS_CONSISTENCY_NONE);
+
+	batch = j_batch_new(semantics);
+	buffer = g_malloc(record_count * record_size);
+
+	object = j_object_new("test", "test-object-write-buffer");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_write_buffer_get_statistics(&writes_before, &flushes_before);
+
+	// Small appends are buffered on the client.
+	for (guint64 i = 0; i < record_count; i++)
+	{
+		memset(buffer, 'a' + (i % 26), record_size);
+		j_object_write(object, buffer, record_size, i * record_size, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, record_size);
+	}
+
+	// Getting the status and reading have to see all buffered writes.
+	j_object_status(object, &modification_time, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, record_count * record_size);
+
+	j_object_write_buffer_get_statistics(&writes_after, &flushes_after);
+
+	// All appends have been buffered and sent using fewer write operations.
+	g_assert_cmpuint(writes_after - writes_before, ==, record_count);
+	g_assert_cmpuint(flushes_after - flushes_before, >, 0);
+	g_assert_cmpuint(flushes_after - flushes_before, <, record_count);
+
+	memset(buffer, 0, record_count * record_size);
+	j_object_read(object, buffer, record_count * record_size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, record_count * record_size);
+
+	for (guint64 i = 0; i < record_count; i++)
+	{
+		gchar const expected = 'a' + (i % 26);
+
+		g_assert_cmpint(buffer[i * record_size], ==, expected);
+		g_assert_cmpint(buffer[(i + 1) * record_size - 1], ==, expected);
+	}
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_write_buffer(void)
+{
+	g_autoptr(GKeyFile) key_file = NULL;
+
+	if (g_test_subprocess())
+	{
+		test_object_write_buffer_subprocess();
+		return;
+	}
+
+	// Client-side backends are accessed directly and do not buffer writes.
+	if (g_strcmp0(j_configuration_get_backend_component(j_configuration(), J_BACKEND_TYPE_OBJECT), "server") != 0)
+	{
+		g_test_skip("Write buffering requires a server-side object backend");
+		return;
+	}
+
+	key_file = test_key_file();
+	g_key_file_set_uint64(key_file, "clients", "object-write-buffer-size", 64 * 1024);
+
+	test_trap_subprocess(key_file);
+}
+
+static void
+test_object_stripe_subprocess(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autofree gchar* buffer2 = NULL;
+	guint64 const size = 1024 * 1024 + 123;
+	gint64 modification_time = 0;
+	guint64 nbytes = 0;
+	guint64 nbytes2 = 0;
+	guint64 object_size = 0;
+	gboolean ret;
+
+	g_assert_cmpuint(j_configuration_get_stripe_threshold(j_configuration()), ==, 64 * 1024);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(size);
+	buffer2 = g_malloc(size + 4096);
+
+	for (guint64 i = 0; i < size; i++)
+	{
+		buffer[i] = i % 251;
+	}
+
+	object = j_object_new("test", "test-object-stripe");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Large transfers are split into stripes whose byte counts have to add up.
+	j_object_write(object, buffer, size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+
+	j_object_status(object, &modification_time, &object_size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(object_size, ==, size);
+
+	// Reading beyond the end only returns the existing data.
+	memset(buffer2, 0, size + 4096);
+	j_object_read(object, buffer2, size + 4096, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+	g_assert_true(memcmp(buffer, buffer2, size) == 0);
+
+	// Several operations within one batch are striped together.
+	memset(buffer + 1000, 'a', 300 * 1024);
+	memset(buffer + 500 * 1024, 'b', 400 * 1024);
+
+	j_object_write(object, buffer + 1000, 300 * 1024, 1000, &nbytes, batch);
+	j_object_write(object, buffer + 500 * 1024, 400 * 1024, 500 * 1024, &nbytes2, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 300 * 1024);
+	g_assert_cmpuint(nbytes2, ==, 400 * 1024);
+
+	memset(buffer2, 0, size + 4096);
+	j_object_read(object, buffer2, 500 * 1024, 0, &nbytes, batch);
+	j_object_read(object, buffer2 + 500 * 1024, size - 500 * 1024, 500 * 1024, &nbytes2, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 500 * 1024);
+	g_assert_cmpuint(nbytes2, ==, size - 500 * 1024);
+	g_assert_true(memcmp(buffer, buffer2, size) == 0);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_stripe(void)
+{
+	g_autoptr(GKeyFile) key_file = NULL;
+
+	if (g_test_subprocess())
+	{
+		test_object_stripe_subprocess();
+		return;
+	}
+
+	// Stripe all transfers larger than 64 KiB.
+	key_file = test_key_file();
+	g_key_file_set_integer(key_file, "clients", "stripe-streams", 4);
+	g_key_file_set_uint64(key_file, "clients", "stripe-threshold", 64 * 1024);
+
+	test_trap_subprocess(key_file);
+}
+
+static gpointer
+test_object_multiplex_thread(gpointer data)
+{
+	guint const id = GPOINTER_TO_UINT(data);
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autofree gchar* name = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 const size = 1000 + id * 100;
+	gchar const expected = 'a' + id;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(size);
+
+	name = g_strdup_printf("test-object-multiplex-%u", id);
+	object = j_object_new("test", name);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	memset(buffer, expected, size);
+	j_object_write(object, buffer, size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+
+	// Every thread has to receive the replies to its own messages.
+	for (guint i = 0; i < n; i++)
+	{
+		gint64 modification_time = 0;
+		guint64 object_size = 0;
+
+		j_object_status(object, &modification_time, &object_size, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(object_size, ==, size);
+
+		memset(buffer, 0, size);
+		j_object_read(object, buffer, size, 0, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, size);
+		g_assert_cmpint(buffer[0], ==, expected);
+		g_assert_cmpint(buffer[size - 1], ==, expected);
+	}
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	return NULL;
+}
+
+static void
+test_object_multiplex(void)
+{
+	g_autoptr(GKeyFile) key_file = NULL;
+
+	if (g_test_subprocess())
+	{
+		GThread* threads[8];
+
+		g_assert_cmpuint(j_configuration_get_multiplex_connections(j_configuration()), ==, 1);
+		g_assert_false(j_configuration_get_coalesce_replies(j_configuration()));
+
+		for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+		{
+			threads[i] = g_thread_new("test-object-multiplex", test_object_multiplex_thread, GUINT_TO_POINTER(i));
+		}
+
+		for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+		{
+			g_thread_join(threads[i]);
+		}
+
+		return;
+	}
+
+	// Share a single connection per server among all threads, which also disables reply coalescing.
+	key_file = test_key_file();
+	g_key_file_set_integer(key_file, "clients", "multiplex-connections", 1);
+	g_key_file_set_boolean(key_file, "clients", "coalesce-replies", TRUE);
+
+	test_trap_subprocess(key_file);
+}
+
 void
 test_object_object(void)
 {
 	g_test_add_func("/object/object/new_free", test_object_new_free);
 	g_test_add_func("/object/object/create_delete", test_object_create_delete);
 	g_test_add_func("/object/object/read_write", test_object_read_write);
+	g_test_add_func("/object/object/read_write_contiguous", test_object_read_write_contiguous);
 	g_test_add_func("/object/object/status", test_object_status);
+	g_test_add_func("/object/object/write_back", test_object_write_back);
 	g_test_add_func("/object/object/sync", test_object_sync);
+	g_test_add_func("/object/object/cache", test_object_cache);
+	g_test_add_func("/object/object/readahead", test_object_readahead);
+	g_test_add_func("/object/object/write_buffer", test_object_write_buffer);
+	g_test_add_func("/object/object/stripe", test_object_stripe);
+	g_test_add_func("/object/object/multiplex", test_object_multiplex);
 }
@@ -19,6 +19,7 @@
 #include <julea-config.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #include <locale.h>
 
@@ -26,6 +27,80 @@
 
 #include "test.h"
 
+/**
+ * Returns configuration data using the current servers and backends.
+ **/
+GKeyFile*
+test_key_file(void)
+{
+	JConfiguration* configuration;
+	JBackendType const types[] = { J_BACKEND_TYPE_OBJECT, J_BACKEND_TYPE_KV, J_BACKEND_TYPE_DB };
+	gchar const* const groups[] = { "object", "kv", "db" };
+	GKeyFile* key_file;
+
+	configuration = j_configuration();
+	key_file = g_key_file_new();
+
+	for (guint i = 0; i < G_N_ELEMENTS(types); i++)
+	{
+		g_autofree gchar const** servers = NULL;
+		guint32 count;
+
+		count = j_configuration_get_server_count(configuration, types[i]);
+		servers = g_new(gchar const*, count);
+
+		for (guint32 j = 0; j < count; j++)
+		{
+			servers[j] = j_configuration_get_server(configuration, types[i], j);
+		}
+
+		g_key_file_set_string_list(key_file, "servers", groups[i], servers, count);
+		g_key_file_set_string(key_file, groups[i], "backend", j_configuration_get_backend(configuration, types[i]));
+		g_key_file_set_string(key_file, groups[i], "component", j_configuration_get_backend_component(configuration, types[i]));
+		g_key_file_set_string(key_file, groups[i], "path", j_configuration_get_backend_path(configuration, types[i]));
+	}
+
+	g_key_file_set_uint64(key_file, "core", "max-operation-size", j_configuration_get_max_operation_size(configuration));
+
+	return key_file;
+}
+
+/**
+ * Runs the current test in a subprocess using the given configuration data.
+ * The configuration is loaded on startup, so changing it requires a new process.
+ **/
+void
+test_trap_subprocess(GKeyFile* key_file)
+{
+	g_autofree gchar* path = NULL;
+	g_autofree gchar* config = NULL;
+	gint fd;
+
+	fd = g_file_open_tmp("julea-test-XXXXXX", &path, NULL);
+	g_assert_cmpint(fd, !=, -1);
+	g_close(fd, NULL);
+
+	g_assert_true(g_key_file_save_to_file(key_file, path, NULL));
+
+	config = g_strdup(g_getenv("JULEA_CONFIG"));
+
+	g_setenv("JULEA_CONFIG", path, TRUE);
+	g_test_trap_subprocess(NULL, 0, 0);
+
+	if (config != NULL)
+	{
+		g_setenv("JULEA_CONFIG", config, TRUE);
+	}
+	else
+	{
+		g_unsetenv("JULEA_CONFIG");
+	}
+
+	g_unlink(path);
+
+	g_test_trap_assert_passed();
+}
+
 int
 main(int argc, char** argv)
 {
@@ -40,13 +115,16 @@ main(int argc, char** argv)
 	test_core_background_operation();
 	test_core_batch();
 	test_core_cache();
+	test_core_completion_queue();
 	test_core_configuration();
+	test_core_connection_pool();
 	test_core_credentials();
 	test_core_distribution();
 	test_core_list();
 	test_core_list_iterator();
 	test_core_memory_chunk();
 	test_core_message();
+	test_core_reed_solomon();
 	test_core_semantics();
 
 	// Object client
@@ -19,16 +19,24 @@
 #ifndef JULEA_TEST_T
 #define JULEA_TEST_T
 
+#include <glib.h>
+
+GKeyFile* test_key_file(void);
+void test_trap_subprocess(GKeyFile*);
+
 void test_core_background_operation(void);
 void test_core_batch(void);
 void test_core_cache(void);
+void test_core_completion_queue(void);
 void test_core_configuration(void);
+void test_core_connection_pool(void);
 void test_core_credentials(void);
 void test_core_distribution(void);
 void test_core_list(void);
 void test_core_list_iterator(void);
 void test_core_memory_chunk(void);
 void test_core_message(void);
+void test_core_reed_solomon(void);
 void test_core_semantics(void);
 
 void test_object_distributed_object(void);
@@ -44,6 +44,27 @@ static gchar const* opt_db_path = NULL;
 static gint64 opt_max_operation_size = 0;
 static gint opt_max_connections = 0;
 static gint64 opt_stripe_size = 0;
+static gint64 opt_write_back_size = 0;
+static gint opt_write_back_threads = 0;
+static gboolean opt_coalesce_replies = FALSE;
+static gint64 opt_reply_window = 0;
+static gint opt_reply_count = 0;
+static gint opt_multiplex_connections = 0;
+static gint opt_prewarm_connections = 0;
+static gint opt_connect_attempts = 0;
+static gint opt_stripe_streams = 0;
+static gint64 opt_stripe_threshold = 0;
+static gint64 opt_operation_cache_size = 0;
+static gint opt_operation_cache_threads = 0;
+static gint64 opt_buffer_pool_size = 0;
+static gboolean opt_buffer_pool_hugepages = FALSE;
+static gboolean opt_buffer_pool_lock = FALSE;
+static gint64 opt_object_cache_size = 0;
+static gint opt_object_cache_ttl = 0;
+static gint64 opt_object_readahead_size = 0;
+static gint64 opt_object_write_buffer_size = 0;
+static gint64 opt_object_write_buffer_interval = 0;
+static gint opt_completion_queue_threads = 0;
 
 static gchar**
 string_split(gchar const* string)
@@ -107,12 +128,33 @@ write_config(gchar* path)
 	g_key_file_set_int64(key_file, "core", "max-operation-size", opt_stripe_size);
 	g_key_file_set_integer(key_file, "clients", "max-connections", opt_max_connections);
 	g_key_file_set_int64(key_file, "clients", "stripe-size", opt_stripe_size);
+	g_key_file_set_boolean(key_file, "clients", "coalesce-replies", opt_coalesce_replies);
+	g_key_file_set_int64(key_file, "core", "reply-window", opt_reply_window);
+	g_key_file_set_integer(key_file, "core", "reply-count", opt_reply_count);
+	g_key_file_set_integer(key_file, "clients", "multiplex-connections", opt_multiplex_connections);
+	g_key_file_set_integer(key_file, "clients", "prewarm-connections", opt_prewarm_connections);
+	g_key_file_set_integer(key_file, "clients", "connect-attempts", opt_connect_attempts);
+	g_key_file_set_integer(key_file, "clients", "stripe-streams", opt_stripe_streams);
+	g_key_file_set_int64(key_file, "clients", "stripe-threshold", opt_stripe_threshold);
+	g_key_file_set_int64(key_file, "clients", "operation-cache-size", opt_operation_cache_size);
+	g_key_file_set_integer(key_file, "clients", "operation-cache-threads", opt_operation_cache_threads);
+	g_key_file_set_int64(key_file, "object", "buffer-pool-size", opt_buffer_pool_size);
+	g_key_file_set_boolean(key_file, "object", "buffer-pool-hugepages", opt_buffer_pool_hugepages);
+	g_key_file_set_boolean(key_file, "object", "buffer-pool-lock", opt_buffer_pool_lock);
+	g_key_file_set_int64(key_file, "clients", "object-cache-size", opt_object_cache_size);
+	g_key_file_set_integer(key_file, "clients", "object-cache-ttl", opt_object_cache_ttl);
+	g_key_file_set_int64(key_file, "clients", "object-readahead-size", opt_object_readahead_size);
+	g_key_file_set_int64(key_file, "clients", "object-write-buffer-size", opt_object_write_buffer_size);
+	g_key_file_set_int64(key_file, "clients", "object-write-buffer-interval", opt_object_write_buffer_interval);
+	g_key_file_set_integer(key_file, "clients", "completion-queue-threads", opt_completion_queue_threads);
 	g_key_file_set_string_list(key_file, "servers", "object", (gchar const* const*)servers_object, g_strv_length(servers_object));
 	g_key_file_set_string_list(key_file, "servers", "kv", (gchar const* const*)servers_kv, g_strv_length(servers_kv));
 	g_key_file_set_string_list(key_file, "servers", "db", (gchar const* const*)servers_db, g_strv_length(servers_db));
 	g_key_file_set_string(key_file, "object", "backend", opt_object_backend);
 	g_key_file_set_string(key_file, "object", "component", opt_object_component);
 	g_key_file_set_string(key_file, "object", "path", opt_object_path);
+	g_key_file_set_int64(key_file, "object", "write-back-size", opt_write_back_size);
+	g_key_file_set_integer(key_file, "object", "write-back-threads", opt_write_back_threads);
 	g_key_file_set_string(key_file, "kv", "backend", opt_kv_backend);
 	g_key_file_set_string(key_file, "kv", "component", opt_kv_component);
 	g_key_file_set_string(key_file, "kv", "path", opt_kv_path);
@@ -167,6 +209,27 @@ main(gint argc, gchar** argv)
 		{ "max-operation-size", 0, 0, G_OPTION_ARG_INT64, &opt_max_operation_size, "Maximum size of an operation", "0" },
 		{ "max-connections", 0, 0, G_OPTION_ARG_INT, &opt_max_connections, "Maximum number of connections", "0" },
 		{ "stripe-size", 0, 0, G_OPTION_ARG_INT64, &opt_stripe_size, "Default stripe size", "0" },
+		{ "write-back-size", 0, 0, G_OPTION_ARG_INT64, &opt_write_back_size, "Size of the server's write-back buffer", "0" },
+		{ "write-back-threads", 0, 0, G_OPTION_ARG_INT, &opt_write_back_threads, "Number of threads flushing the write-back buffer", "0" },
+		{ "coalesce-replies", 0, 0, G_OPTION_ARG_NONE, &opt_coalesce_replies, "Let servers coalesce replies, disabled by multiplexing", NULL },
+		{ "reply-window", 0, 0, G_OPTION_ARG_INT64, &opt_reply_window, "Time in microseconds after which coalesced replies are sent", "0" },
+		{ "reply-count", 0, 0, G_OPTION_ARG_INT, &opt_reply_count, "Number of replies after which coalesced replies are sent", "0" },
+		{ "multiplex-connections", 0, 0, G_OPTION_ARG_INT, &opt_multiplex_connections, "Number of shared connections per server, disables reply coalescing", "0" },
+		{ "prewarm-connections", 0, 0, G_OPTION_ARG_INT, &opt_prewarm_connections, "Number of connections per server to establish during initialization", "0" },
+		{ "connect-attempts", 0, 0, G_OPTION_ARG_INT, &opt_connect_attempts, "Number of attempts to connect to a server", "5" },
+		{ "stripe-streams", 0, 0, G_OPTION_ARG_INT, &opt_stripe_streams, "Number of connections large transfers are striped across", "0" },
+		{ "stripe-threshold", 0, 0, G_OPTION_ARG_INT64, &opt_stripe_threshold, "Minimum size of striped transfers", "0" },
+		{ "operation-cache-size", 0, 0, G_OPTION_ARG_INT64, &opt_operation_cache_size, "Size of the operation cache", "0" },
+		{ "operation-cache-threads", 0, 0, G_OPTION_ARG_INT, &opt_operation_cache_threads, "Number of threads flushing the operation cache", "0" },
+		{ "buffer-pool-size", 0, 0, G_OPTION_ARG_INT64, &opt_buffer_pool_size, "Maximum size of the server's buffer pool", "0" },
+		{ "buffer-pool-hugepages", 0, 0, G_OPTION_ARG_NONE, &opt_buffer_pool_hugepages, "Use huge pages for the server's buffer pool", NULL },
+		{ "buffer-pool-lock", 0, 0, G_OPTION_ARG_NONE, &opt_buffer_pool_lock, "Lock the server's buffer pool into memory", NULL },
+		{ "object-cache-size", 0, 0, G_OPTION_ARG_INT64, &opt_object_cache_size, "Maximum size of the client's object block cache", "0" },
+		{ "object-cache-ttl", 0, 0, G_OPTION_ARG_INT, &opt_object_cache_ttl, "Time in milliseconds cached blocks stay valid for eventual consistency", "0" },
+		{ "object-readahead-size", 0, 0, G_OPTION_ARG_INT64, &opt_object_readahead_size, "Maximum size of the read-ahead window for sequential object reads", "0" },
+		{ "object-write-buffer-size", 0, 0, G_OPTION_ARG_INT64, &opt_object_write_buffer_size, "Size of the client's per-object write buffers", "0" },
+		{ "object-write-buffer-interval", 0, 0, G_OPTION_ARG_INT64, &opt_object_write_buffer_interval, "Time in milliseconds after which buffered writes are sent", "100" },
+		{ "completion-queue-threads", 0, 0, G_OPTION_ARG_INT, &opt_completion_queue_threads, "Number of threads executing batches submitted to completion queues", "0" },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -193,7 +256,25 @@ main(gint argc, gchar** argv)
 	    || (!opt_read && (opt_servers_object == NULL || opt_servers_kv == NULL || opt_servers_db == NULL || opt_object_backend == NULL || opt_object_component == NULL || opt_object_path == NULL || opt_kv_backend == NULL || opt_kv_component == NULL || opt_kv_path == NULL || opt_db_backend == NULL || opt_db_component == NULL || opt_db_path == NULL))
 	    || opt_max_operation_size < 0
 	    || opt_max_connections < 0
-	    || opt_stripe_size < 0)
+	    || opt_stripe_size < 0
+	    || opt_write_back_size < 0
+	    || opt_write_back_threads < 0
+	    || opt_reply_window < 0
+	    || opt_reply_count < 0
+	    || opt_multiplex_connections < 0
+	    || opt_prewarm_connections < 0
+	    || opt_connect_attempts < 0
+	    || opt_stripe_streams < 0
+	    || opt_stripe_threshold < 0
+	    || opt_operation_cache_size < 0
+	    || opt_operation_cache_threads < 0
+	    || opt_buffer_pool_size < 0
+	    || opt_object_cache_size < 0
+	    || opt_object_cache_ttl < 0
+	    || opt_object_readahead_size < 0
+	    || opt_object_write_buffer_size < 0
+	    || opt_object_write_buffer_interval < 0
+	    || opt_completion_queue_threads < 0)
 	{
 		g_autofree gchar* help = NULL;
 
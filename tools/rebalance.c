@@ -0,0 +1,378 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <locale.h>
+
+#include <bson.h>
+
+#include <julea.h>
+#include <julea-kv.h>
+#include <julea-object.h>
+
+static gchar* opt_namespace = NULL;
+static gchar* opt_collection = NULL;
+static gint opt_old_servers = 0;
+static gint64 opt_object_id = 0;
+static gint64 opt_block_size = 0;
+static gint opt_virtual_nodes = 1;
+static gboolean opt_dry_run = FALSE;
+
+/**
+ * Returns the server storing a block.
+ *
+ * \param distribution A distribution.
+ * \param block_size   The block size.
+ * \param block        A block ID.
+ *
+ * \return The server index.
+ **/
+static guint
+rebalance_get_server(JDistribution* distribution, guint64 block_size, guint64 block)
+{
+	guint64 block_id;
+	guint64 new_length;
+	guint64 new_offset;
+	guint index = 0;
+
+	j_distribution_reset(distribution, block_size, block * block_size);
+	j_distribution_distribute(distribution, &index, &new_length, &new_offset, &block_id);
+
+	return index;
+}
+
+/**
+ * Returns the distributions of an item as stored in its metadata.
+ *
+ * \param path             The item's path.
+ * \param old_distribution Returns the distribution before servers were added.
+ *
+ * \return The current distribution, NULL if the item does not exist or does not use a consistent hash distribution.
+ **/
+static JDistribution*
+rebalance_get_item_distribution(gchar const* path, JDistribution** old_distribution)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autofree gpointer value = NULL;
+	JDistribution* distribution = NULL;
+	bson_t b[1];
+	bson_iter_t iterator;
+	guint32 len = 0;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	kv = j_kv_new("items", path);
+
+	j_kv_get(kv, &value, &len, batch);
+
+	if (!j_batch_execute(batch) || value == NULL || !bson_init_static(b, value, len))
+	{
+		return NULL;
+	}
+
+	if (bson_iter_init_find(&iterator, b, "distribution") && BSON_ITER_HOLDS_DOCUMENT(&iterator))
+	{
+		bson_t b_distribution[1];
+		guint8 const* data;
+		guint32 data_len;
+
+		bson_iter_document(&iterator, &data_len, &data);
+		bson_init_static(b_distribution, data, data_len);
+
+		// Object ID, block size and virtual nodes are all part of the serialized distribution.
+		distribution = j_distribution_new_from_bson(b_distribution);
+
+		if (j_distribution_get_type(distribution) == J_DISTRIBUTION_CONSISTENT_HASH)
+		{
+			*old_distribution = j_distribution_new_from_bson(b_distribution);
+			j_distribution_set(*old_distribution, "server-count", opt_old_servers);
+		}
+		else
+		{
+			g_clear_pointer(&distribution, j_distribution_unref);
+		}
+	}
+
+	bson_destroy(b);
+
+	return distribution;
+}
+
+/**
+ * Moves all blocks of an object whose server changed from the old to the new distribution.
+ * Blocks whose server did not change are not touched.
+ * Moved blocks can not be removed from their old servers individually, so the old copies remain until the object is deleted.
+ * Only objects on old servers that do not store any block anymore are deleted.
+ *
+ * \param namespace        The objects' namespace.
+ * \param name             An object name.
+ * \param old_distribution The distribution before servers were added.
+ * \param distribution     The current distribution.
+ * \param old_server_count The old server count.
+ * \param server_count     The current server count.
+ * \param moved            Returns the number of moved blocks.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+rebalance_object(gchar const* namespace, gchar const* name, JDistribution* old_distribution, JDistribution* distribution, guint old_server_count, guint server_count, guint64* moved)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autofree JObject** objects = NULL;
+	g_autofree gboolean* created = NULL;
+	g_autofree guint64* sizes = NULL;
+	g_autofree guint64* remaining = NULL;
+	g_autofree gint64* modification_times = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 block_size;
+	guint64 size = 0;
+	gboolean ret = TRUE;
+
+	block_size = j_distribution_get_block_size(distribution);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	objects = g_new(JObject*, server_count);
+	created = g_new0(gboolean, server_count);
+	sizes = g_new0(guint64, old_server_count);
+	remaining = g_new0(guint64, old_server_count);
+	modification_times = g_new0(gint64, old_server_count);
+	buffer = g_malloc(block_size);
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		objects[i] = j_object_new_for_index(i, namespace, name);
+	}
+
+	// Blocks keep their offsets, so the largest stripe determines the object's size.
+	for (guint i = 0; i < old_server_count; i++)
+	{
+		j_object_status(objects[i], &(modification_times[i]), &(sizes[i]), batch);
+	}
+
+	ret = j_batch_execute(batch) && ret;
+
+	for (guint i = 0; i < old_server_count; i++)
+	{
+		size = MAX(size, sizes[i]);
+	}
+
+	for (guint64 block = 0; ret && block * block_size < size; block++)
+	{
+		guint64 bytes_read = 0;
+		guint64 bytes_written = 0;
+		guint old_index;
+		guint index;
+
+		old_index = rebalance_get_server(old_distribution, block_size, block);
+		index = rebalance_get_server(distribution, block_size, block);
+
+		if (old_index == index)
+		{
+			remaining[old_index]++;
+			continue;
+		}
+
+		// Only servers that have been added receive blocks, so their stripes have to be created first.
+		g_assert(index >= old_server_count);
+
+		(*moved)++;
+
+		if (opt_dry_run)
+		{
+			continue;
+		}
+
+		if (!created[index])
+		{
+			j_object_create(objects[index], batch);
+			created[index] = TRUE;
+		}
+
+		j_object_read(objects[old_index], buffer, block_size, block * block_size, &bytes_read, batch);
+		ret = j_batch_execute(batch) && ret;
+
+		// Holes do not have to be moved.
+		if (bytes_read == 0)
+		{
+			continue;
+		}
+
+		j_object_write(objects[index], buffer, bytes_read, block * block_size, &bytes_written, batch);
+		ret = j_batch_execute(batch) && ret;
+
+		if (bytes_written != bytes_read)
+		{
+			ret = FALSE;
+		}
+	}
+
+	// Old servers whose blocks have all been moved do not need their stripes anymore.
+	for (guint i = 0; ret && !opt_dry_run && i < old_server_count; i++)
+	{
+		if (sizes[i] > 0 && remaining[i] == 0)
+		{
+			j_object_delete(objects[i], batch);
+			ret = j_batch_execute(batch) && ret;
+		}
+	}
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		j_object_unref(objects[i]);
+	}
+
+	return ret;
+}
+
+int
+main(int argc, char** argv)
+{
+	GError* error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistribution) old_distribution = NULL;
+	guint server_count;
+	gboolean ret = TRUE;
+
+	GOptionEntry entries[] = {
+		{ "namespace", 0, 0, G_OPTION_ARG_STRING, &opt_namespace, "Namespace of the object", "namespace" },
+		{ "collection", 0, 0, G_OPTION_ARG_STRING, &opt_collection, "Collection of the items, their distributions are read from their metadata", "collection" },
+		{ "old-servers", 0, 0, G_OPTION_ARG_INT, &opt_old_servers, "Number of object servers before servers were added", "0" },
+		{ "object-id", 0, 0, G_OPTION_ARG_INT64, &opt_object_id, "Object ID of the object's distribution", "0" },
+		{ "block-size", 0, 0, G_OPTION_ARG_INT64, &opt_block_size, "Block size of the object's distribution", "0" },
+		{ "virtual-nodes", 0, 0, G_OPTION_ARG_INT, &opt_virtual_nodes, "Number of virtual nodes per server of the object's distribution", "1" },
+		{ "dry-run", 0, 0, G_OPTION_ARG_NONE, &opt_dry_run, "Only count the blocks that would be moved", NULL },
+		{ NULL, 0, 0, 0, NULL, NULL, NULL }
+	};
+
+	// Explicitly enable UTF-8 since functions such as g_format_size might return UTF-8 characters.
+	setlocale(LC_ALL, "C.UTF-8");
+
+	context = g_option_context_new("OBJECT | ITEM…");
+	g_option_context_set_summary(context, "Moves the blocks of objects using a consistent hash distribution after object servers have been added.\n"
+	                                      "\n"
+	                                      "Every object has its own object ID, so only a single object can be given together with --namespace.\n"
+	                                      "With --collection, the distributions of any number of items are read from their metadata.\n"
+	                                      "\n"
+	                                      "Moved blocks are copied, their old copies keep using capacity until the object is deleted.\n"
+	                                      "Only stripes on old servers that do not store any block anymore are deleted.");
+	g_option_context_add_main_entries(context, entries, NULL);
+
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		if (error)
+		{
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		}
+
+		return 1;
+	}
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+
+	if (opt_block_size <= 0)
+	{
+		opt_block_size = j_configuration_get_stripe_size(j_configuration());
+	}
+
+	if ((opt_namespace == NULL) == (opt_collection == NULL) || argc < 2 || opt_old_servers <= 0 || opt_virtual_nodes <= 0)
+	{
+		g_autofree gchar* help = NULL;
+
+		help = g_option_context_get_help(context, TRUE, NULL);
+		g_print("%s", help);
+
+		return 1;
+	}
+
+	// The object ID is chosen randomly for every distribution, so it can not be shared by multiple objects.
+	if (opt_namespace != NULL && argc > 2)
+	{
+		g_printerr("Only a single object can be rebalanced at a time, use --collection for multiple items.\n");
+
+		return 1;
+	}
+
+	// Blocks only move to new servers when servers are appended, removing servers is not supported.
+	if ((guint)opt_old_servers > server_count)
+	{
+		g_printerr("Removing object servers is not supported.\n");
+
+		return 1;
+	}
+
+	if (opt_namespace != NULL)
+	{
+		guint64 moved = 0;
+
+		distribution = j_distribution_new(J_DISTRIBUTION_CONSISTENT_HASH);
+		j_distribution_set_block_size(distribution, opt_block_size);
+		j_distribution_set(distribution, "object-id", opt_object_id);
+		j_distribution_set(distribution, "virtual-nodes", opt_virtual_nodes);
+
+		old_distribution = j_distribution_new(J_DISTRIBUTION_CONSISTENT_HASH);
+		j_distribution_set_block_size(old_distribution, opt_block_size);
+		j_distribution_set(old_distribution, "object-id", opt_object_id);
+		j_distribution_set(old_distribution, "virtual-nodes", opt_virtual_nodes);
+		j_distribution_set(old_distribution, "server-count", opt_old_servers);
+
+		if (!rebalance_object(opt_namespace, argv[1], old_distribution, distribution, opt_old_servers, server_count, &moved))
+		{
+			g_printerr("Could not rebalance %s.\n", argv[1]);
+			ret = FALSE;
+		}
+
+		g_print("%s: %" G_GUINT64_FORMAT " blocks %s\n", argv[1], moved, (opt_dry_run) ? "to move" : "moved");
+	}
+
+	for (gint i = 1; opt_collection != NULL && i < argc; i++)
+	{
+		g_autoptr(JDistribution) item_distribution = NULL;
+		g_autoptr(JDistribution) item_old_distribution = NULL;
+		g_autofree gchar* path = NULL;
+		guint64 moved = 0;
+
+		// Items store their data in distributed objects named after their path.
+		path = g_build_path("/", opt_collection, argv[i], NULL);
+		item_distribution = rebalance_get_item_distribution(path, &item_old_distribution);
+
+		if (item_distribution == NULL)
+		{
+			g_printerr("Could not get consistent hash distribution of %s.\n", path);
+			ret = FALSE;
+			continue;
+		}
+
+		if (!rebalance_object("item", path, item_old_distribution, item_distribution, opt_old_servers, server_count, &moved))
+		{
+			g_printerr("Could not rebalance %s.\n", path);
+			ret = FALSE;
+		}
+
+		g_print("%s: %" G_GUINT64_FORMAT " blocks %s\n", path, moved, (opt_dry_run) ? "to move" : "moved");
+	}
+
+	g_free(opt_collection);
+	g_free(opt_namespace);
+
+	return (ret) ? 0 : 1;
+}